@@ -0,0 +1,91 @@
+#!/bin/bash
+# Differential test of the C optimisation level
+# - Builds libstd and the run-pass tests at a baseline level and at the level under test, then compares which tests
+#   pass and what they print.
+# - With `--rustc`, also bootstraps rustc at both levels (up to the stage-1 `hello_world`) and compares the results.
+#
+# Usage: TestOptLevels.sh [--rustc] [<level> [<baseline level>]]
+#   e.g. `./TestOptLevels.sh 3` compares -O3 against -O1
+set -e  # Quit script on error
+set -u  # Error on unset variables
+
+cd $(dirname $0)
+
+WITH_RUSTC=0
+if [[ "${1-}" == "--rustc" ]]; then
+    WITH_RUSTC=1
+    shift
+fi
+LEVEL=${1-2}
+BASE_LEVEL=${2-1}
+
+RUSTC_VERSION_DEF=$(cat rust-version)
+RUSTC_VERSION=${RUSTC_VERSION:-${RUSTC_VERSION_DEF}}
+if [[ "$RUSTC_VERSION" == "$RUSTC_VERSION_DEF" ]]; then
+    VER_SUF=""
+else
+    VER_SUF=-${RUSTC_VERSION}
+fi
+MAKE_ARGS="RUSTC_VERSION=${RUSTC_VERSION} PARLEVEL=${PARLEVEL:-1}"
+
+make all
+make -C tools/minicargo
+make -C tools/testrunner
+
+for L in $BASE_LEVEL $LEVEL; do
+    echo "=== Building libstd and run-pass tests with -C opt-level=$L"
+    make -f minicargo.mk $MAKE_ARGS OPT_LEVEL=$L LIBS
+    # Test failures are compared below, so don't stop here
+    make -f minicargo.mk $MAKE_ARGS OPT_LEVEL=$L RUST_TESTS_run-pass || true
+done
+
+test_status() {
+    if [[ -e "$1/$2.out" ]]; then
+        echo "pass"
+    elif [[ -e "$1/$2.out_failed" ]]; then
+        echo "run-fail"
+    else
+        echo "build-fail"
+    fi
+}
+
+BASE_DIR=output${VER_SUF}-O${BASE_LEVEL}/rust_tests/run-pass
+TEST_DIR=output${VER_SUF}-O${LEVEL}/rust_tests/run-pass
+N_DIFF=0
+N_SAME=0
+for NAME in $( (ls $BASE_DIR $TEST_DIR | grep '\.exe-build\.log$' | sed 's/\.exe-build\.log$//') | sort -u ); do
+    S_BASE=$(test_status $BASE_DIR $NAME)
+    S_TEST=$(test_status $TEST_DIR $NAME)
+    if [[ "$S_BASE" != "$S_TEST" ]]; then
+        echo "DIFF $NAME: $S_BASE at -O$BASE_LEVEL, $S_TEST at -O$LEVEL"
+        N_DIFF=$((N_DIFF + 1))
+    elif [[ "$S_BASE" == "pass" ]] && ! cmp -s $BASE_DIR/$NAME.out $TEST_DIR/$NAME.out; then
+        echo "DIFF $NAME: output differs (see $BASE_DIR/$NAME.out and $TEST_DIR/$NAME.out)"
+        N_DIFF=$((N_DIFF + 1))
+    else
+        N_SAME=$((N_SAME + 1))
+    fi
+done
+echo "=== run-pass: $N_SAME same, $N_DIFF different"
+
+if [[ $WITH_RUSTC == 1 ]]; then
+    for L in $BASE_LEVEL $LEVEL; do
+        echo "=== Bootstrapping rustc with -C opt-level=$L"
+        # NOTE: `OUTDIR_SUF` is overridden so run_rustc and minicargo.mk agree on the output directory
+        make -C run_rustc $MAKE_ARGS OUTDIR_SUF=${VER_SUF}-O$L OPT_LEVEL=$L output${VER_SUF}-O$L/prefix-s/bin/hello_world
+        ./run_rustc/output${VER_SUF}-O$L/prefix-s/bin/hello_world > run_rustc/output${VER_SUF}-O$L/hello_world_out.txt
+    done
+    if ! cmp -s run_rustc/output${VER_SUF}-O${BASE_LEVEL}/hello_world_out.txt run_rustc/output${VER_SUF}-O${LEVEL}/hello_world_out.txt; then
+        echo "DIFF rustc: hello_world output differs"
+        N_DIFF=$((N_DIFF + 1))
+    fi
+    # Both compilers are built from the same source, so the libraries they produce should match
+    for F in run_rustc/output${VER_SUF}-O${BASE_LEVEL}/prefix-s/lib/rustlib/*/lib/*.rlib; do
+        F_TEST=${F/output${VER_SUF}-O${BASE_LEVEL}/output${VER_SUF}-O${LEVEL}}
+        if ! cmp -s $F $F_TEST; then
+            echo "NOTE rustc: $(basename $F) differs (may just be embedded paths)"
+        fi
+    done
+fi
+
+[[ $N_DIFF == 0 ]]
@@ -32,6 +32,10 @@ RUSTC_CHANNEL ?= stable
 PARLEVEL ?= 1
 # Additional flags for `minicargo` (e.g. library paths)
 MINICARGO_FLAGS ?=
+# Additional flags for `testrunner` (e.g. `-C` options)
+TESTRUNNER_FLAGS ?=
+# OPT_LEVEL : Optimisation level for the generated C (empty for the default of `-O`)
+OPT_LEVEL ?=
 # RUST_TESTS_FINAL_STAGE : Final stage for tests run as part of the rust_tests target.
 #  VALID OPTIONS: parse, expand, mir, ALL
 RUST_TESTS_FINAL_STAGE ?= ALL
@@ -56,6 +60,32 @@ ifneq ($(MMIR),)
   OUTDIR_SUF := $(OUTDIR_SUF)-mmir
   MINICARGO_FLAGS += -Z emit-mmir
 endif
+# C optimisation level (separate output directory, used by TestOptLevels.sh)
+ifneq ($(OPT_LEVEL),)
+  OUTDIR_SUF := $(OUTDIR_SUF)-O$(OPT_LEVEL)
+  MINICARGO_FLAGS += --opt-level $(OPT_LEVEL)
+  TESTRUNNER_FLAGS += -C opt-level=$(OPT_LEVEL)
+endif
+# Cross-crate link-time optimisation (separate output directory, as the objects differ)
+ifneq ($(LTO),)
+  OUTDIR_SUF := $(OUTDIR_SUF)-lto
+  MINICARGO_FLAGS += --lto
+endif
+# Unwinding panics through landing pads (separate output directory, every crate must use the same panic mechanism)
+ifneq ($(LANDING_PADS),)
+  OUTDIR_SUF := $(OUTDIR_SUF)-lp
+  MINICARGO_FLAGS += --landing-pads
+  TESTRUNNER_FLAGS += -C landing-pads
+endif
+# Profile-guided optimisation: build with `PGO_GENERATE=<dir>`, run the training workload, then rebuild with `PGO_USE=<dir>`
+ifneq ($(PGO_GENERATE),)
+  OUTDIR_SUF := $(OUTDIR_SUF)-pgogen
+  MINICARGO_FLAGS += --profile-generate $(abspath $(PGO_GENERATE))
+endif
+ifneq ($(PGO_USE),)
+  OUTDIR_SUF := $(OUTDIR_SUF)-pgouse
+  MINICARGO_FLAGS += --profile-use $(abspath $(PGO_USE))
+endif
 # Job count
 ifneq ($(PARLEVEL),1)
   MINICARGO_FLAGS += -j $(PARLEVEL)
@@ -354,7 +384,7 @@ $(OUTDIR)rust/test_run-pass_hello_out.txt: $(OUTDIR)rust/test_run-pass_hello
 RUST_TESTS: RUST_TESTS_run-pass
 RUST_TESTS_run-pass: output$(OUTDIR_SUF)/test/librust_test_helpers.a LIBS bin/testrunner$(EXESUF)
 	@mkdir -p $(OUTDIR)rust_tests/run-pass
-	./bin/testrunner$(EXESUF) -L $(OUTDIR) -L $(OUTDIR)test -o $(OUTDIR)rust_tests/run-pass $(SRCDIR_RUST_TESTS)run-pass --exceptions disabled_tests_run-pass.txt
+	./bin/testrunner$(EXESUF) -L $(OUTDIR) -L $(OUTDIR)test -o $(OUTDIR)rust_tests/run-pass $(SRCDIR_RUST_TESTS)run-pass --exceptions disabled_tests_run-pass.txt $(TESTRUNNER_FLAGS)
 $(OUTDIR)test/librust_test_helpers.a: $(OUTDIR)test/rust_test_helpers.o
 	@mkdir -p $(dir $@)
 	ar cur $@ $<
@@ -374,7 +404,10 @@ output$(OUTDIR_SUF)/test/rust_test_helpers.o: $(RUST_TEST_HELPERS_C)
 local_tests: $(TEST_DEPS)
 	@$(MAKE) -C tools/testrunner
 	@mkdir -p output$(OUTDIR_SUF)/local_tests
-	./bin/testrunner -o output$(OUTDIR_SUF)/local_tests -L output$(OUTDIR_SUF) samples/test
+	./bin/testrunner -o output$(OUTDIR_SUF)/local_tests -L output$(OUTDIR_SUF) samples/test $(TESTRUNNER_FLAGS)
+ifneq ($(LANDING_PADS),)
+	./bin/testrunner -o output$(OUTDIR_SUF)/local_tests -L output$(OUTDIR_SUF) samples/test/landing_pads $(TESTRUNNER_FLAGS)
+endif
 
 #
 # Testing
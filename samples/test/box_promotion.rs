@@ -0,0 +1,104 @@
+// compile-flags: --test
+
+// `box` allocations that the optimiser may move to the stack (see `MIR_Optimise_PromoteBoxes`), and ones that must
+// stay on the heap
+use std::cell::Cell;
+
+struct Log<'a>(&'a Cell<u32>, u32);
+impl<'a> Drop for Log<'a> {
+    fn drop(&mut self) {
+        self.0.set(self.0.get() * 10 + self.1);
+    }
+}
+
+struct Count<'a>(&'a Cell<u32>, u32);
+impl<'a> Drop for Count<'a> {
+    fn drop(&mut self) {
+        self.0.set(self.0.get() + 1);
+    }
+}
+
+#[test]
+fn box_in_loop()
+{
+    let drops = Cell::new(0);
+    let mut sum = 0;
+    for i in 0 .. 100 {
+        let b = Box::new(Count(&drops, i));
+        sum += b.1;
+    }
+    assert_eq!(sum, 4950);
+    assert_eq!(drops.get(), 100);
+
+    // The previous box is still alive when the next one is allocated, so they can't share a slot
+    let mut prev = Box::new(0u32);
+    for i in 1 .. 10 {
+        let next = Box::new(i);
+        assert_eq!(*prev + 1, *next);
+        prev = next;
+    }
+    assert_eq!(*prev, 9);
+}
+
+#[test]
+fn deep_and_shallow_drop()
+{
+    let log = Cell::new(0);
+    {
+        let b = Box::new(Log(&log, 1));
+        drop(b);
+        log.set(log.get() * 10 + 2);
+    }
+    assert_eq!(log.get(), 12);
+
+    // Moving the value out leaves only a shallow drop for the box, the value is dropped when `inner` is
+    log.set(0);
+    {
+        let b = Box::new(Log(&log, 1));
+        let inner = *b;
+        log.set(log.get() * 10 + 2);
+        drop(inner);
+        log.set(log.get() * 10 + 3);
+    }
+    assert_eq!(log.get(), 213);
+}
+
+struct Node {
+    next: Option<Box<Node>>,
+    val: u32,
+}
+
+fn make_array(v: u32) -> Box<[u32; 4]> {
+    let b = Box::new([v; 4]);
+    b
+}
+
+#[test]
+fn escaping_boxes()
+{
+    // Returned from the allocating function
+    let a = make_array(3);
+    let b = make_array(5);
+    assert_eq!(a.iter().sum::<u32>(), 12);
+    assert_eq!(b[3], 5);
+
+    // Stored in a collection
+    let mut v = Vec::new();
+    for i in 0 .. 10 {
+        v.push(Box::new(i * 2));
+    }
+    assert_eq!(v.iter().map(|b| **b).sum::<u32>(), 90);
+
+    // Stored in another allocation
+    let mut head = None;
+    for i in 0 .. 5 {
+        head = Some(Box::new(Node { next: head, val: i }));
+    }
+    let mut total = 0;
+    let mut cur = &head;
+    while let Some(ref n) = *cur {
+        total = total * 10 + n.val;
+        cur = &n.next;
+    }
+    assert_eq!(total, 43210);
+}
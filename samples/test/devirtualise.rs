@@ -0,0 +1,65 @@
+// compile-flags: --test
+
+// Calls through `Box<dyn Trait>` that the optimiser may turn into direct calls (see `MIR_Optimise_Devirtualise`)
+
+mod single {
+    // Only one implementor in the program, calls are guarded by a vtable comparison
+    pub trait Shape {
+        fn area(&self) -> u32;
+        fn scale(&mut self, by: u32);
+    }
+    pub struct Square(pub u32);
+    impl Shape for Square {
+        fn area(&self) -> u32 { self.0 * self.0 }
+        fn scale(&mut self, by: u32) { self.0 *= by; }
+    }
+}
+
+mod multiple {
+    // Two implementors, so a call through an unknown vtable has to stay indirect
+    pub trait Op {
+        fn apply(&self, v: i32) -> i32;
+    }
+    pub struct Add(pub i32);
+    pub struct Mul(pub i32);
+    impl Op for Add {
+        fn apply(&self, v: i32) -> i32 { v + self.0 }
+    }
+    impl Op for Mul {
+        fn apply(&self, v: i32) -> i32 { v * self.0 }
+    }
+}
+
+#[test]
+fn single_implementor()
+{
+    use single::Shape;
+    fn total(shapes: &mut [Box<dyn Shape>]) -> u32 {
+        for s in shapes.iter_mut() {
+            s.scale(2);
+        }
+        shapes.iter().map(|s| s.area()).sum()
+    }
+    let mut shapes: Vec<Box<dyn Shape>> = vec![ Box::new(single::Square(1)), Box::new(single::Square(3)) ];
+    assert_eq!(total(&mut shapes), 4 + 36);
+
+    // Known at the point of creation
+    let b: Box<dyn Shape> = Box::new(single::Square(5));
+    assert_eq!(b.area(), 25);
+}
+
+#[test]
+fn two_implementors()
+{
+    use multiple::Op;
+    fn run(ops: &[Box<dyn Op>], v: i32) -> i32 {
+        ops.iter().fold(v, |v, op| op.apply(v))
+    }
+    let ops: Vec<Box<dyn Op>> = vec![ Box::new(multiple::Add(3)), Box::new(multiple::Mul(4)), Box::new(multiple::Add(-2)) ];
+    assert_eq!(run(&ops, 1), 14);
+    assert_eq!(run(&ops[1..], 5), 18);
+
+    // Known at the point of creation
+    let b: Box<dyn Op> = Box::new(multiple::Mul(6));
+    assert_eq!(b.apply(7), 42);
+}
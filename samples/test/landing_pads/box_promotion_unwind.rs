@@ -0,0 +1,35 @@
+// Unwinding through a `box` that may have been moved to the stack (see `MIR_Optimise_PromoteBoxes`), the contents must
+// be dropped exactly once and the box not freed
+// - Only run in the `LANDING_PADS=1` configuration (see `local_tests` in minicargo.mk)
+use std::cell::Cell;
+use std::panic;
+
+struct Log<'a>(&'a Cell<u32>, u32);
+impl<'a> Drop for Log<'a> {
+    fn drop(&mut self) {
+        self.0.set(self.0.get() * 10 + self.1);
+    }
+}
+
+fn check(v: u32) {
+    if v == 1 {
+        panic!("unwind");
+    }
+}
+
+fn boxed(log: &Cell<u32>, v: u32) {
+    let b = Box::new(Log(log, v));
+    check(b.1);
+    log.set(log.get() * 10 + 9);
+}
+
+fn main() {
+    let log = Cell::new(0);
+    boxed(&log, 2);
+    assert_eq!(log.get(), 92);
+
+    log.set(0);
+    let r = panic::catch_unwind(panic::AssertUnwindSafe(|| boxed(&log, 1)));
+    assert!(r.is_err());
+    assert_eq!(log.get(), 1);
+}
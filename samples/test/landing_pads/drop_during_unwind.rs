@@ -0,0 +1,41 @@
+// Drops that run while unwinding, including one that panics and catches the panic itself.
+// - The outer panic must still be the one that reaches `catch_unwind` in `main`
+// - Only run in the `LANDING_PADS=1` configuration (see `local_tests` in minicargo.mk), without landing pads panics
+//   don't run drops
+use std::cell::Cell;
+use std::panic;
+
+struct Log<'a>(&'a Cell<u32>, u32);
+impl<'a> Drop for Log<'a> {
+    fn drop(&mut self) {
+        self.0.set(self.0.get() * 10 + self.1);
+    }
+}
+
+struct CatchInDrop<'a>(&'a Cell<u32>);
+impl<'a> Drop for CatchInDrop<'a> {
+    fn drop(&mut self) {
+        let log = self.0;
+        let r = panic::catch_unwind(panic::AssertUnwindSafe(|| {
+            let _l = Log(log, 3);
+            panic!("inner");
+        }));
+        assert_eq!(r.unwrap_err().downcast_ref::<&str>(), Some(&"inner"));
+        log.set(log.get() * 10 + 2);
+    }
+}
+
+#[inline(never)]
+fn outer(log: &Cell<u32>) {
+    let _a = Log(log, 1);
+    let _c = CatchInDrop(log);
+    panic!("outer");
+}
+
+fn main() {
+    panic::set_hook(Box::new(|_| {}));
+    let log = Cell::new(0);
+    let r = panic::catch_unwind(panic::AssertUnwindSafe(|| outer(&log)));
+    assert_eq!(r.unwrap_err().downcast_ref::<&str>(), Some(&"outer"));
+    assert_eq!(log.get(), 321);
+}
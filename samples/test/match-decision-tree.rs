@@ -0,0 +1,89 @@
+// compile-flags: --test
+
+// Guarded arms fall through to the remaining (compatible) arms when the guard fails
+#[test]
+fn guard_fallthrough()
+{
+    fn test(v: Option<u32>, flag: bool) -> u32 {
+        match v {
+            Some(0) => 1,
+            Some(x) if flag && x > 10 => 2,
+            Some(5) => 3,
+            None if flag => 4,
+            Some(_) => 5,
+            None => 6,
+        }
+    }
+
+    assert_eq!( test(Some(0), true), 1 );
+    assert_eq!( test(Some(11), true), 2 );
+    assert_eq!( test(Some(11), false), 5 );
+    assert_eq!( test(Some(5), true), 3 );
+    assert_eq!( test(Some(5), false), 3 );
+    assert_eq!( test(None, true), 4 );
+    assert_eq!( test(None, false), 6 );
+}
+
+// Multiple patterns on a guarded arm each get their own guard failure path
+#[test]
+fn guard_multiple_patterns()
+{
+    fn test(v: (u8, u8), limit: u8) -> u32 {
+        match v {
+            (0, x) | (x, 0) if x < limit => 1,
+            (0, _) => 2,
+            (_, 0) => 3,
+            _ => 4,
+        }
+    }
+
+    assert_eq!( test((0, 1), 5), 1 );
+    assert_eq!( test((1, 0), 5), 1 );
+    assert_eq!( test((0, 9), 5), 2 );
+    assert_eq!( test((9, 0), 5), 3 );
+    assert_eq!( test((1, 1), 5), 4 );
+}
+
+// Disjoint ranges (mixed with values) are dispatched by bisection
+#[test]
+fn range_bisect()
+{
+    fn class(c: char) -> u32 {
+        match c {
+            '0' ..= '9' => 1,
+            'a' ..= 'z' => 2,
+            'A' ..= 'Z' => 3,
+            '_' => 4,
+            ' ' | '\t' => 5,
+            '\u{80}' ..= '\u{10FFFF}' => 6,
+            _ => 0,
+        }
+    }
+    fn signed(v: i32) -> u32 {
+        match v {
+            i32::MIN ..= -100 => 1,
+            -99 ..= -1 => 2,
+            0 => 3,
+            1 ..= 99 => 4,
+            100 ..= i32::MAX => 5,
+        }
+    }
+
+    assert_eq!( class('0'), 1 );
+    assert_eq!( class('9'), 1 );
+    assert_eq!( class('a'), 2 );
+    assert_eq!( class('z'), 2 );
+    assert_eq!( class('M'), 3 );
+    assert_eq!( class('_'), 4 );
+    assert_eq!( class('\t'), 5 );
+    assert_eq!( class('é'), 6 );
+    assert_eq!( class('['), 0 );
+    assert_eq!( class('/'), 0 );
+
+    assert_eq!( signed(i32::MIN), 1 );
+    assert_eq!( signed(-100), 1 );
+    assert_eq!( signed(-99), 2 );
+    assert_eq!( signed(0), 3 );
+    assert_eq!( signed(99), 4 );
+    assert_eq!( signed(i32::MAX), 5 );
+}
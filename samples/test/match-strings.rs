@@ -0,0 +1,64 @@
+// compile-flags: --test
+
+// Enough arms to use the length/byte bucketed string dispatch
+#[test]
+fn keywords()
+{
+    fn kw(s: &str) -> u32 {
+        match s {
+            "" => 1,
+            "as" => 2,
+            "fn" => 3,
+            "if" => 4,
+            "in" => 5,
+            "let" => 6,
+            "mut" => 7,
+            "for" => 8,
+            "loop" => 9,
+            "while" => 10,
+            "match" => 11,
+            _ => 0,
+        }
+    }
+
+    assert_eq!( kw(""), 1 );
+    assert_eq!( kw("as"), 2 );
+    assert_eq!( kw("fn"), 3 );
+    assert_eq!( kw("if"), 4 );
+    assert_eq!( kw("in"), 5 );
+    assert_eq!( kw("let"), 6 );
+    assert_eq!( kw("mut"), 7 );
+    assert_eq!( kw("for"), 8 );
+    assert_eq!( kw("loop"), 9 );
+    assert_eq!( kw("while"), 10 );
+    assert_eq!( kw("match"), 11 );
+    assert_eq!( kw("i"), 0 );
+    assert_eq!( kw("is"), 0 );
+    assert_eq!( kw("matches"), 0 );
+    assert_eq!( kw("whale"), 0 );
+}
+
+#[test]
+fn byte_strings()
+{
+    fn cmd(s: &[u8]) -> u32 {
+        match s {
+            b"GET" => 1,
+            b"PUT" => 2,
+            b"POST" => 3,
+            b"HEAD" => 4,
+            b"DELETE" => 5,
+            b"\x00\xFF" => 6,
+            _ => 0,
+        }
+    }
+
+    assert_eq!( cmd(b"GET"), 1 );
+    assert_eq!( cmd(b"PUT"), 2 );
+    assert_eq!( cmd(b"POST"), 3 );
+    assert_eq!( cmd(b"HEAD"), 4 );
+    assert_eq!( cmd(b"DELETE"), 5 );
+    assert_eq!( cmd(b"\x00\xFF"), 6 );
+    assert_eq!( cmd(b"GOT"), 0 );
+    assert_eq!( cmd(b"\x00\x00"), 0 );
+}
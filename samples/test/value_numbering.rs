@@ -0,0 +1,76 @@
+// compile-flags: --test
+
+// Values the optimiser may merge or hoist (see `MIR_Optimise_ValueNumbering`), and ones it must not
+use std::cell::Cell;
+
+#[test]
+fn repeated_bounds_check()
+{
+    fn sum_pairs(v: &[u32], i: usize) -> u32 {
+        v[i] + v[i] * 2 + v[i + 1]
+    }
+    let v = [1, 2, 3, 4];
+    assert_eq!(sum_pairs(&v, 0), 1 + 2 + 2);
+    assert_eq!(sum_pairs(&v, 2), 3 + 6 + 4);
+    // The second index is still checked after the first is merged
+    let r = ::std::panic::catch_unwind(|| sum_pairs(&v, 3));
+    assert!(r.is_err());
+}
+
+#[test]
+fn invariant_load_through_shared_borrow()
+{
+    struct Params { scale: u32, offset: u32 }
+    fn apply(p: &Params, v: &mut [u32]) {
+        for x in v.iter_mut() {
+            *x = *x * p.scale + p.offset;
+        }
+    }
+    let p = Params { scale: 3, offset: 1 };
+    let mut v = [1, 2, 3];
+    apply(&p, &mut v);
+    assert_eq!(v, [4, 7, 10]);
+}
+
+#[test]
+fn cell_field_not_merged()
+{
+    struct Counter { hits: Cell<u32>, limit: u32 }
+    fn bump(c: &Counter) -> u32 {
+        let before = c.hits.get();
+        c.hits.set(before + 1);
+        // Same expression as `before`, but the cell has been written through a shared borrow
+        let after = c.hits.get();
+        before * 10 + after
+    }
+    fn count_to_limit(c: &Counter) -> u32 {
+        let mut n = 0;
+        // `c.hits` can't be hoisted out of the loop
+        while c.hits.get() < c.limit {
+            c.hits.set(c.hits.get() + 1);
+            n += 1;
+        }
+        n
+    }
+    let c = Counter { hits: Cell::new(4), limit: 10 };
+    assert_eq!(bump(&c), 45);
+    assert_eq!(count_to_limit(&c), 5);
+    assert_eq!(c.hits.get(), 10);
+}
+
+#[test]
+fn nan_comparison()
+{
+    fn self_eq(x: f64) -> bool {
+        x == x
+    }
+    fn not_less_is_ge(a: f32, b: f32) -> (bool, bool) {
+        (!(a < b), a >= b)
+    }
+    let nan = 0.0f64 / 0.0;
+    assert!(self_eq(1.5));
+    assert!(!self_eq(nan));
+    assert!(nan != nan);
+    assert_eq!(not_less_is_ge(2.0, 1.0), (true, true));
+    assert_eq!(not_less_is_ge(0.0 / 0.0, 1.0), (true, false));
+}
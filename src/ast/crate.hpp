@@ -75,6 +75,8 @@ public:
 
     /// Files loaded using things like include! and include_str!
     mutable ::std::vector<::std::string>    m_extra_files;
+    /// Environment variables read by env! and option_env!, as `NAME=value` (or just `NAME` if it wasn't set)
+    mutable ::std::vector<::std::string>    m_env_reads;
 
     // Procedural macros!
     ::std::vector<ProcMacroDef> m_proc_macros;
@@ -13,58 +13,134 @@
 #include <iomanip>
 #include <common.hpp>   // FmtEscaped
 #include <cstring>	// strchr
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <map>
 
 // TODO: Inline debug filter/caching
 // - Cache messages for the current phase, clearing the cache (dropping) when various signatures match
 //  > Similar to the `log_get_last_function.py` script
 
-int g_debug_indent_level = 0;
+thread_local int g_debug_indent_level = 0;
 bool g_debug_enabled = true;
+bool g_trace_json_enabled = false;
 ::std::string g_cur_phase;
 ::std::set< ::std::string>    g_debug_disable_map;
 
-TraceLog::TraceLog(const char* tag, ::std::function<void(::std::ostream&)> info_cb, ::std::function<void(::std::ostream&)> ret):
-    m_tag(tag),
-    m_ret(ret)
+::std::ostream& TraceLog::enter_output()
 {
-    if(debug_enabled() && m_tag) {
-        auto& os = debug_output(g_debug_indent_level, m_tag);
-        os << ">> (";
-        info_cb(os);
-        os << ")" << ::std::endl;
+    auto& os = debug_output(g_debug_indent_level, m_tag);
+    os << ">> (";
+    return os;
+}
+void TraceLog::enter_finish(::std::ostream& os)
+{
+    os << ")" << ::std::endl;
+}
+void TraceLog::exit_output()
+{
+    auto& os = debug_output(g_debug_indent_level, m_tag);
+    os << "<< (";
+    if(m_ret_fcn) {
+        m_ret_fcn(m_ret_ptr, os);
+    }
+    os << ")" << ::std::endl;
+}
+
+namespace {
+    struct TraceJsonState {
+        ::std::mutex    lock;
+        ::std::ofstream os;
+        bool    first = true;
+        ::std::chrono::steady_clock::time_point base;
+        ::std::map< ::std::thread::id, unsigned>    thread_ids;
+
+        ~TraceJsonState() {
+            if( os.is_open() ) {
+                os << "\n]}\n";
+            }
+        }
+    };
+    TraceJsonState& trace_json_state() {
+        static TraceJsonState   s;
+        return s;
+    }
+    void json_escape(::std::ostream& os, const char* s, size_t len) {
+        for(size_t i = 0; i < len; i ++) {
+            char c = s[i];
+            switch(c)
+            {
+            case '"':   os << "\\\"";    break;
+            case '\\':  os << "\\\\";   break;
+            case '\n':  os << "\\n";    break;
+            default:
+                if( static_cast<unsigned char>(c) < ' ' ) {
+                    os << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+                }
+                else {
+                    os << c;
+                }
+                break;
+            }
+        }
     }
-    INDENT();
 }
-TraceLog::TraceLog(const char* tag, ::std::function<void(::std::ostream&)> info_cb):
-    m_tag(tag),
-    m_ret([](const auto&){})
+
+void TraceSpan::open(const char* filename)
 {
-    if(debug_enabled() && m_tag) {
-        auto& os = debug_output(g_debug_indent_level, m_tag);
-        os << ">> (";
-        info_cb(os);
-        os << ")" << ::std::endl;
+    auto& s = trace_json_state();
+    s.os.open(filename);
+    if( !s.os.good() ) {
+        ::std::cerr << "WARN: Unable to open trace output '" << filename << "'" << ::std::endl;
+        return ;
     }
-    INDENT();
+    s.base = ::std::chrono::steady_clock::now();
+    s.os << "{\"traceEvents\":[";
+    g_trace_json_enabled = true;
+}
+unsigned long long TraceSpan::now_us()
+{
+    auto& s = trace_json_state();
+    return ::std::chrono::duration_cast< ::std::chrono::microseconds>(::std::chrono::steady_clock::now() - s.base).count();
 }
-TraceLog::TraceLog(const char* tag):
-    m_tag(tag),
-    m_ret([](const auto&){})
+void TraceSpan::emit(const char* name, const ::std::string& detail, unsigned long long start, unsigned long long end)
 {
-    if(debug_enabled() && m_tag) {
-        auto& os = debug_output(g_debug_indent_level, m_tag);
-        os << ">>" << ::std::endl;
+    auto& s = trace_json_state();
+    ::std::lock_guard< ::std::mutex>    lh(s.lock);
+    auto tid = s.thread_ids.insert(::std::make_pair(::std::this_thread::get_id(), static_cast<unsigned>(s.thread_ids.size()+1))).first->second;
+    s.os << (s.first ? "\n" : ",\n");
+    s.first = false;
+    s.os << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << start << ",\"dur\":" << (end - start) << ",\"name\":\"";
+    json_escape(s.os, name, strlen(name));
+    s.os << "\"";
+    if( !detail.empty() ) {
+        s.os << ",\"args\":{\"detail\":\"";
+        json_escape(s.os, detail.data(), detail.size());
+        s.os << "\"}";
     }
-    INDENT();
+    s.os << "}";
 }
-TraceLog::~TraceLog() {
-    UNINDENT();
-    if(debug_enabled() && m_tag) {
-        auto& os = debug_output(g_debug_indent_level, m_tag);
-        os << "<< (";
-        m_ret(os);
-        os << ")" << ::std::endl;
+
+bool debug_file_filter(const char* file)
+{
+    // `MRUSTC_DEBUG_FILES` - colon separated list of source path suffixes (e.g. `typeck/expr_cs.cpp:mir/optimise.cpp`)
+    static const char* filter = ::std::getenv("MRUSTC_DEBUG_FILES");
+    if( !filter || !filter[0] )
+        return true;
+    size_t file_len = strlen(file);
+    for(const char* ent = filter; ; )
+    {
+        const char* end = strchr(ent, ':');
+        size_t len = end ? end - ent : strlen(ent);
+        if( len > 0 && len <= file_len && ::std::strncmp(file + file_len - len, ent, len) == 0 )
+            return true;
+        if( !end )
+            break;
+        ent = end + 1;
     }
+    return false;
 }
 
 
@@ -77,10 +153,6 @@ bool debug_enabled_update() {
         return true;
     }
 }
-bool debug_enabled()
-{
-    return g_debug_enabled;
-}
 ::std::ostream& debug_output(int indent, const char* function)
 {
     return ::std::cout << g_cur_phase << "- " << RepeatLitStr { " ", indent } << function << ": ";
@@ -92,6 +164,9 @@ DebugTimedPhase::DebugTimedPhase(const char* name):
     ::std::cout << m_name << ": V V V" << ::std::endl;
     g_cur_phase = m_name;
     g_debug_enabled = debug_enabled_update();
+    if( g_trace_json_enabled ) {
+        m_span_start = TraceSpan::now_us();
+    }
     m_start = clock();
 }
 DebugTimedPhase::~DebugTimedPhase()
@@ -99,6 +174,9 @@ DebugTimedPhase::~DebugTimedPhase()
     auto end = clock();
     g_cur_phase = "";
     g_debug_enabled = debug_enabled_update();
+    if( g_trace_json_enabled ) {
+        TraceSpan::emit(m_name, "", m_span_start, TraceSpan::now_us());
+    }
 
     // TODO: Show wall time too?
     ::std::cout << "(" << ::std::fixed << ::std::setprecision(2) << static_cast<double>(end - m_start) / static_cast<double>(CLOCKS_PER_SEC) << " s) ";
@@ -108,6 +186,11 @@ DebugTimedPhase::~DebugTimedPhase()
 
 extern void debug_init_phases(const char* env_var_name, std::initializer_list<const char*> il)
 {
+    if( const char* trace_file = ::std::getenv("MRUSTC_TRACE_JSON") )
+    {
+        TraceSpan::open(trace_file);
+    }
+
     for(const char* e : il)
     {
         g_debug_disable_map.insert(e);
@@ -30,6 +30,12 @@ namespace {
         }
         return mv$( string_np->m_value );
     }
+    // Read an environment variable, recording it (and its value) for the incremental cache key
+    const char* read_env(const AST::Crate& crate, const ::std::string& varname) {
+        const char* rv = getenv(varname.c_str());
+        crate.m_env_reads.push_back( rv ? varname + "=" + rv : varname );
+        return rv;
+    }
 }
 
 class CExpanderEnv:
@@ -39,7 +45,7 @@ class CExpanderEnv:
     {
         ::std::string   varname = get_string(sp, crate, mod,  tt);
 
-        const char* var_val_cstr = getenv(varname.c_str());
+        const char* var_val_cstr = read_env(crate, varname);
         if( !var_val_cstr ) {
             ERROR(sp, E0000, "Environment variable '" << varname << "' not defined");
         }
@@ -55,7 +61,7 @@ class CExpanderOptionEnv:
         ::std::string   varname = get_string(sp, crate, mod,  tt);
         ::std::vector< TokenTree>   rv;
 
-        const char* var_val_cstr = getenv(varname.c_str());
+        const char* var_val_cstr = read_env(crate, varname);
         if( !var_val_cstr ) {
             rv.reserve(7);
             rv.push_back( Token(TOK_IDENT, RcString::new_interned("None")) );
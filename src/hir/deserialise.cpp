@@ -42,6 +42,9 @@ namespace {
         ::std::vector<HIR::TypeRef> m_types;
         ::HIR::serialise::Reader&   m_in;
     public:
+        // Set when loading data saved from the current crate (crate-local paths keep their empty crate name)
+        bool m_is_local = false;
+
         HirDeserialiser(::HIR::serialise::Reader& in):
             m_in(in)
         {}
@@ -363,7 +366,7 @@ namespace {
                 mp.crate = m_in.read_istring();
                 mp.ents = deserialise_vec<RcString>();
 
-                if(mp.crate == "")
+                if(mp.crate == "" && !m_is_local)
                 {
                     assert(m_crate_name != "");
                     mp.crate = m_crate_name;
@@ -825,6 +828,8 @@ namespace {
             ::HIR::Function::Markings rv;
             rv.rustc_legacy_const_generics = deserialise_vec<unsigned>();
             rv.track_caller = m_in.read_bool();
+            rv.inline_type = static_cast<::HIR::Function::Markings::Inline>(m_in.read_tag());
+            rv.is_cold = m_in.read_bool();
             return rv;
         }
         ::std::vector< ::std::pair< ::HIR::Pattern, ::HIR::TypeRef> >   deserialise_fcnargs()
@@ -1181,7 +1186,7 @@ namespace {
         TRACE_FUNCTION;
         auto rv = ::HIR::SimplePath { deserialise_thinvec< RcString>() };
         // HACK! If the read crate name is empty, replace it with the name we're loaded with
-        if( rv.crate_name() == "" && rv.components().size() > 0)
+        if( rv.crate_name() == "" && rv.components().size() > 0 && !m_is_local)
         {
             assert(m_crate_name != "");
             rv.update_crate_name( m_crate_name );
@@ -1746,6 +1751,7 @@ namespace {
         g_vis_private = ::HIR::Publicity::new_priv(::HIR::SimplePath(this->m_crate_name));
         rv.m_crate_name = this->m_crate_name;
         rv.m_edition = static_cast<AST::Edition>(m_in.read_tag());
+        rv.m_unwind_mode = static_cast< ::HIR::Crate::UnwindMode>(m_in.read_tag());
         rv.m_root_module = deserialise_module();
 
         rv.m_type_impls = D< ::HIR::Crate::ImplGroup<std::unique_ptr<::HIR::TypeImpl>> >::des(*this);
@@ -1757,6 +1763,25 @@ namespace {
         //rv.m_proc_macro_reexports = deserialise_istrumap< ::HIR::Crate::MacroImport>();
         rv.m_lang_items = deserialise_strumap< ::HIR::SimplePath>();
 
+        {
+            size_t n = m_in.read_count();
+            for(size_t i = 0; i < n; i ++)
+            {
+                auto path = deserialise_path();
+                ::HIR::FunctionSummary  fs;
+                fs.no_unwind = m_in.read_bool();
+                fs.is_pure = m_in.read_bool();
+                fs.returns_arg = static_cast<unsigned>(m_in.read_count());
+                fs.has_const_return = m_in.read_bool();
+                if( fs.has_const_return ) {
+                    fs.const_return_ty = static_cast< ::HIR::CoreType>(m_in.read_tag());
+                    fs.const_return_val = m_in.read_u128();
+                }
+                fs.is_exported = true;
+                rv.m_function_summaries.insert( ::std::make_pair(mv$(path), mv$(fs)) );
+            }
+        }
+
         {
             size_t n = m_in.read_count();
             for(size_t i = 0; i < n; i ++)
@@ -1807,6 +1832,44 @@ namespace {
     #endif
 }
 
+::MIR::FunctionPointer HIR_Deserialise_Mir(const ::std::string& filename, ::std::vector< ::std::pair< ::std::string, uint64_t> >& deps)
+{
+    ::HIR::serialise::Reader    in{ filename };
+    HirDeserialiser  s { in };
+    s.m_is_local = true;
+
+    size_t n_deps = in.read_count();
+    deps.reserve(n_deps);
+    for(size_t i = 0; i < n_deps; i ++)
+    {
+        auto name = in.read_string();
+        auto fp = in.read_u64();
+        deps.push_back(::std::make_pair(mv$(name), fp));
+    }
+    return s.deserialise_mir();
+}
+
+bool HIR_Deserialise_ConstValue(const ::std::string& filename, const ::std::string& key, EncodedLiteral& value, ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >& statics)
+{
+    ::HIR::serialise::Reader    in{ filename };
+    HirDeserialiser  s { in };
+    s.m_is_local = true;
+
+    if( in.read_string() != key )
+        return false;
+    size_t n_statics = in.read_count();
+    statics.reserve(n_statics);
+    for(size_t i = 0; i < n_statics; i ++)
+    {
+        auto p = s.deserialise_path();
+        auto ty = s.deserialise_type();
+        auto v = s.deserialise_encodedliteral();
+        statics.push_back(::std::make_tuple(mv$(p), mv$(ty), mv$(v)));
+    }
+    value = s.deserialise_encodedliteral();
+    return true;
+}
+
 RcString HIR_Deserialise_JustName(const ::std::string& filename)
 {
     try
@@ -21,6 +21,9 @@ namespace {
         unsigned int    m_indent_level;
 
     public:
+        /// Omit function bodies (leaving just the crate's interface)
+        bool    m_skip_bodies = false;
+
         TreeVisitor(::std::ostream& os):
             m_os(os),
             m_indent_level(0)
@@ -245,6 +248,18 @@ namespace {
         void visit_function(::HIR::ItemPath p, ::HIR::Function& item) override
         {
             m_os << indent();
+            // NOTE: Markings that change how callers are optimised are part of the interface (see `HIR_Dump_Interface`)
+            switch(item.m_markings.inline_type)
+            {
+            case ::HIR::Function::Markings::Inline::Auto:   break;
+            case ::HIR::Function::Markings::Inline::Never:  m_os << "#[inline(never)] ";  break;
+            case ::HIR::Function::Markings::Inline::Normal: m_os << "#[inline] "; break;
+            case ::HIR::Function::Markings::Inline::Always: m_os << "#[inline(always)] "; break;
+            }
+            if( item.m_markings.is_cold )
+                m_os << "#[cold] ";
+            if( item.m_markings.track_caller )
+                m_os << "#[track_caller] ";
             if( item.m_const )
                 m_os << "const ";
             if( item.m_unsafe )
@@ -262,7 +277,7 @@ namespace {
                 m_os << indent() << " " << item.m_params.fmt_bounds() << "\n";
             }
 
-            if( item.m_code )
+            if( item.m_code && !m_skip_bodies )
             {
                 m_os << indent();
                 if( dynamic_cast< ::HIR::ExprNode_Block*>(&*item.m_code) ) {
@@ -846,6 +861,13 @@ void HIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate)
 
     tv.visit_crate( const_cast< ::HIR::Crate&>(crate) );
 }
+void HIR_Dump_Interface(::std::ostream& sink, const ::HIR::Crate& crate)
+{
+    TreeVisitor tv { sink };
+    tv.m_skip_bodies = true;
+
+    tv.visit_crate( const_cast< ::HIR::Crate&>(crate) );
+}
 void HIR_DumpExpr(::std::ostream& sink, const ::HIR::ExprPtr& expr)
 {
     if(!expr ) {
@@ -61,6 +61,10 @@ public:
     {}
     virtual ~ExprNode();
 
+    // Allocation goes via the active `ExprArena` (if any), see expr_ptr.cpp
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
     const char* type_name() const;
 };
 
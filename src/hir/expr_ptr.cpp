@@ -8,6 +8,102 @@
 #include <hir/expr_ptr.hpp>
 #include <hir/expr.hpp>
 #include <hir/expr_state.hpp>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+namespace {
+    const size_t ARENA_CHUNK_SIZE = 64*1024;
+    const size_t ARENA_ALIGN = alignof(::std::max_align_t);
+}
+
+thread_local ::HIR::ExprArena* HIR::ExprArena::s_current = nullptr;
+bool HIR::ExprArena::s_enabled = false;
+
+::HIR::ExprArena::ExprArena():
+    m_chunk_used(ARENA_CHUNK_SIZE),
+    m_refcount(0)
+{
+}
+::HIR::ExprArena::~ExprArena()
+{
+    for(auto* c : m_chunks)
+        ::std::free(c);
+}
+::HIR::ExprArena* HIR::ExprArena::new_arena()
+{
+    return new ExprArena();
+}
+void* HIR::ExprArena::alloc(size_t size)
+{
+    size = (size + ARENA_ALIGN-1) & ~(ARENA_ALIGN-1);
+    // Large allocations get their own chunk (inserted before the current chunk)
+    if( size > ARENA_CHUNK_SIZE / 4 )
+    {
+        auto* rv = static_cast<char*>(::std::malloc(size));
+        if( !rv )
+            throw ::std::bad_alloc();
+        m_chunks.insert(m_chunks.end() - (m_chunks.empty() ? 0 : 1), rv);
+        return rv;
+    }
+    if( m_chunk_used + size > ARENA_CHUNK_SIZE )
+    {
+        auto* c = static_cast<char*>(::std::malloc(ARENA_CHUNK_SIZE));
+        if( !c )
+            throw ::std::bad_alloc();
+        m_chunks.push_back(c);
+        m_chunk_used = 0;
+    }
+    auto* rv = m_chunks.back() + m_chunk_used;
+    m_chunk_used += size;
+    return rv;
+}
+void HIR::ExprArena::release()
+{
+    assert(m_refcount.get() > 0);
+    if( m_refcount.dec() )
+    {
+        assert(s_current != this);
+        delete this;
+    }
+}
+
+// Node allocation - a header is placed before each node to record the owning arena (or null for the heap)
+void* HIR::ExprNode::operator new(size_t size)
+{
+    static_assert(sizeof(::HIR::ExprArena*) <= ARENA_ALIGN, "");
+    auto* arena = ::HIR::ExprArena::current();
+    char* base;
+    if( arena )
+    {
+        base = static_cast<char*>(arena->alloc(ARENA_ALIGN + size));
+        arena->add_ref();
+    }
+    else
+    {
+        base = static_cast<char*>(::std::malloc(ARENA_ALIGN + size));
+        if( !base )
+            throw ::std::bad_alloc();
+    }
+    *reinterpret_cast<::HIR::ExprArena**>(base) = arena;
+    return base + ARENA_ALIGN;
+}
+void HIR::ExprNode::operator delete(void* ptr)
+{
+    if( !ptr )
+        return ;
+    auto* base = static_cast<char*>(ptr) - ARENA_ALIGN;
+    auto* arena = *reinterpret_cast<::HIR::ExprArena**>(base);
+    if( arena )
+    {
+        // Memory is reclaimed when the arena is freed
+        arena->release();
+    }
+    else
+    {
+        ::std::free(base);
+    }
+}
 
 ::HIR::ExprPtr::ExprPtr(::std::unique_ptr< ::HIR::ExprNode> v):
     node( mv$(v) )
@@ -11,6 +11,7 @@
 #include <cassert>
 
 #include <mir/mir_ptr.hpp>
+#include <refcount.hpp>
 
 struct Span;
 
@@ -21,6 +22,60 @@ class ExprNode;
 class Crate;
 class ExprState;
 
+/// Bump allocator for the expression nodes of a single body
+///
+/// Nodes are allocated from the arena that is active (see `ExprArena::Scope`) when they are created, and the
+/// backing memory is released in one go once all nodes and all `ExprArenaPtr` handles are gone.
+class ExprArena
+{
+    // NOTE: Per-thread, as bodies may be checked in parallel
+    thread_local static ExprArena*   s_current;
+
+    ::std::vector<char*>    m_chunks;
+    size_t  m_chunk_used;
+    /// Number of live nodes plus the number of handles
+    /// - Nodes can be moved to other bodies (e.g. closures), which may then be processed on another thread
+    RefCount    m_refcount;
+
+    ExprArena();
+    ~ExprArena();
+public:
+    /// Set by `-Z hir-expr-arena`, enables arena allocation during HIR lowering
+    static bool s_enabled;
+
+    static ExprArena* new_arena();
+    static ExprArena* current() { return s_current; }
+
+    void* alloc(size_t size);
+    void add_ref() { m_refcount.inc(); }
+    void release();
+
+    /// Makes the given arena (or the general heap, if null) the target of new nodes until destroyed
+    class Scope
+    {
+        ExprArena*  m_prev;
+    public:
+        Scope(ExprArena* arena): m_prev(s_current) { s_current = arena; }
+        Scope(const Scope&) = delete;
+        ~Scope() { s_current = m_prev; }
+    };
+};
+class ExprArenaPtr
+{
+    ExprArena*  ptr;
+public:
+    ExprArenaPtr(): ptr(nullptr) {}
+    explicit ExprArenaPtr(ExprArena* p): ptr(p) { if(ptr) ptr->add_ref(); }
+    ExprArenaPtr(const ExprArenaPtr& x): ExprArenaPtr(x.ptr) {}
+    ExprArenaPtr(ExprArenaPtr&& x): ptr(x.ptr) { x.ptr = nullptr; }
+    ~ExprArenaPtr() { if(ptr) ptr->release(); }
+
+    ExprArenaPtr& operator=(const ExprArenaPtr& x) { return *this = ExprArenaPtr(x); }
+    ExprArenaPtr& operator=(ExprArenaPtr&& x) { this->~ExprArenaPtr(); ptr = x.ptr; x.ptr = nullptr; return *this; }
+
+    ExprArena* get() const { return ptr; }
+};
+
 class ExprPtrInner
 {
     ::HIR::ExprNode* ptr;
@@ -83,6 +138,8 @@ public:
 class ExprPtr
 {
     //::HIR::Path m_path;
+    // NOTE: Declared before `node` so it outlives the nodes it backs
+    ::HIR::ExprArenaPtr m_arena;
     ::HIR::ExprPtrInner node;
 
 
@@ -109,6 +166,10 @@ public:
     ::HIR::ExprNode* get() const { return node.get(); }
     void reset(::HIR::ExprNode* p) { node.reset(p); }
 
+    /// Arena backing this body's nodes (if any)
+    ::HIR::ExprArena* arena() const { return m_arena.get(); }
+    void set_arena(::HIR::ExprArenaPtr arena) { m_arena = ::std::move(arena); }
+
     const Span& span() const;
           ::HIR::ExprNode& operator*()       { return *node; }
     const ::HIR::ExprNode& operator*() const { return *node; }
@@ -1853,6 +1853,7 @@ namespace {
         markings.track_caller = true;
     }
     markings.is_naked = f.m_markings.is_naked;
+    markings.is_cold = f.m_markings.is_cold;
 
     ::HIR::Linkage  linkage;
     switch(f.m_markings.linkage) {
@@ -2646,6 +2647,11 @@ public:
                 ERROR(sp, E0000, "Conflicting definitions of lang item '" << name << "'. " << path << " and " << irv.first->second);
             }
         }
+        // And the function summaries, so `get_function_summary` only needs two lookups
+        for( const auto& fs : ext_crate.second.m_hir->m_function_summaries )
+        {
+            rv.m_ext_function_summaries.insert( ::std::make_pair(fs.first.clone(), &fs.second) );
+        }
         auto p1 = ext_crate.second.m_filename.rfind('/');
         auto p2 = ext_crate.second.m_filename.rfind('\\');
         auto p = (p1 == ::std::string::npos ? p2 : (p2 == ::std::string::npos ? p1 : ::std::max(p1,p2)));
@@ -10,6 +10,7 @@
 #include <ast/expr.hpp>
 #include <ast/ast.hpp>
 #include "from_ast.hpp"
+#include "main_bindings.hpp"
 
 struct LowerHIR_ExprNode_Visitor:
     public ::AST::NodeVisitor
@@ -909,15 +910,31 @@ struct LowerHIR_ExprNode_Visitor:
     }
 };
 
+void HIR_EnableExprArena()
+{
+    ::HIR::ExprArena::s_enabled = true;
+}
+
 ::HIR::ExprPtr LowerHIR_ExprNode(const ::AST::ExprNode& e)
 {
-    LowerHIR_ExprNode_Visitor v;
+    // Allocate all of this body's nodes from a single arena (if enabled)
+    ::HIR::ExprArenaPtr arena;
+    if( ::HIR::ExprArena::s_enabled ) {
+        arena = ::HIR::ExprArenaPtr( ::HIR::ExprArena::new_arena() );
+    }
+    ::HIR::ExprPtr  rv;
+    {
+        ::HIR::ExprArena::Scope arena_scope(arena.get());
+        LowerHIR_ExprNode_Visitor v;
 
-    const_cast<::AST::ExprNode*>(&e)->visit( v );
+        const_cast<::AST::ExprNode*>(&e)->visit( v );
 
-    if( ! v.m_rv ) {
-        BUG(e.span(), typeid(e).name() << " - Yielded a nullptr HIR node");
-    }
+        if( ! v.m_rv ) {
+            BUG(e.span(), typeid(e).name() << " - Yielded a nullptr HIR node");
+        }
 
-    return ::HIR::ExprPtr( mv$( v.m_rv ) );
+        rv = ::HIR::ExprPtr( mv$( v.m_rv ) );
+    }
+    rv.set_arena( mv$(arena) );
+    return rv;
 }
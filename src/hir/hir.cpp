@@ -315,6 +315,19 @@ const ::HIR::SimplePath& ::HIR::Crate::get_lang_item_path_opt(const char* name)
     return it->second;
 }
 
+const ::HIR::FunctionSummary* ::HIR::Crate::get_function_summary(const ::HIR::Path& path) const
+{
+    auto it = m_function_summaries.find(path);
+    if( it != m_function_summaries.end() ) {
+        return &it->second;
+    }
+    auto it_ext = m_ext_function_summaries.find(path);
+    if( it_ext != m_ext_function_summaries.end() ) {
+        return it_ext->second;
+    }
+    return nullptr;
+}
+
 namespace {
     const ::HIR::Module& get_containing_module(const ::HIR::Crate& crate, const Span& sp, const ::HIR::SimplePath& path, bool ignore_crate_name, bool ignore_last_node)
     {
@@ -210,6 +210,7 @@ public:
         std::vector<unsigned> rustc_legacy_const_generics;
         bool track_caller = false;
         bool is_naked = false;
+        bool is_cold = false;   // #[cold]
         enum Inline {
             Auto,   // no annotation
             Never,  // #[inline(never)]
@@ -663,6 +664,27 @@ public:
     ::std::string   m_basename; // Just the filename (serialised)
     ::std::string   m_path; // The path used to load this crate
 };
+/// Facts about a (monomorphised) function, computed bottom-up over the call graph after MIR optimisation
+/// - Used by MIR optimisation and codegen to reason about calls without looking at the callee's body
+struct FunctionSummary
+{
+    /// Never unwinds (no calls to functions that may, and no drops)
+    bool    no_unwind = false;
+    /// No observable side-effects, always returns (no loops), so a call with an unused result can be removed
+    bool    is_pure = false;
+    /// If not ~0u, the function always returns this argument unchanged
+    unsigned    returns_arg = ~0u;
+    /// The function always returns `const_return_val` (as a `const_return_ty`)
+    bool    has_const_return = false;
+    ::HIR::CoreType const_return_ty = ::HIR::CoreType::Bool;
+    /// NOTE: Signed values are stored as their two's complement bit pattern, bools as 0/1
+    U128    const_return_val;
+
+    /// Set for summaries of non-generic functions (which downstream crates can call) - these are the only ones serialised
+    // NOT SERIALISED
+    bool    is_exported = false;
+};
+
 class ExternLibrary
 {
 public:
@@ -673,6 +695,13 @@ class Crate
 public:
     RcString   m_crate_name;
     AST::Edition    m_edition;
+    /// How panics unwind through this crate's generated code (set by `main` before serialising)
+    /// - Code using landing pads and code using setjmp/longjmp can't be mixed, see `-C landing-pads`
+    enum class UnwindMode {
+        NoCode, // No code is linked from this crate (e.g. the dump of a proc-macro crate)
+        SetJmp,
+        LandingPads,
+    } m_unwind_mode = UnwindMode::NoCode;
 
     Module  m_root_module;
 
@@ -739,6 +768,13 @@ public:
     /// Language items avaliable through this crate (includes ones from loaded externs)
     ::std::unordered_map< ::std::string, ::HIR::SimplePath> m_lang_items;
 
+    /// Summaries of functions (keyed by monomorphised path), populated by `MIR_OptimiseCrate_Inlining`
+    /// - Only the non-generic entries are serialised (generic instantiations are re-done by downstream crates)
+    mutable ::std::map< ::HIR::Path, FunctionSummary>   m_function_summaries;
+    /// Summaries from all loaded crates (pointing into their `m_function_summaries`), populated when lowering to HIR
+    // NOT SERIALISED
+    ::std::map< ::HIR::Path, const FunctionSummary*>    m_ext_function_summaries;
+
     /// Referenced crates (in load order) - Used to ensure final linking order is sane
     // NOT SERIALISED
     ::std::vector<RcString> m_ext_crates_ordered;
@@ -756,6 +792,9 @@ public:
     const ::HIR::SimplePath& get_lang_item_path(const Span& sp, const char* name) const;
     const ::HIR::SimplePath& get_lang_item_path_opt(const char* name) const;
 
+    /// Look up the summary of a (monomorphised) function in this crate, or in any loaded crate
+    const FunctionSummary* get_function_summary(const ::HIR::Path& path) const;
+
     const ::HIR::MacroItem& get_macroitem_by_path(const Span& sp, const ::HIR::SimplePath& path, bool ignore_crate_name=false, bool ignore_last_node=false) const;
 
     const ::HIR::TypeItem& get_typeitem_by_path(const Span& sp, const ::HIR::SimplePath& path, bool ignore_crate_name=false, bool ignore_last_node=false) const;
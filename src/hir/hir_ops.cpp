@@ -1189,9 +1189,7 @@ const ::MIR::Function* HIR::Crate::get_or_gen_mir(const ::HIR::ItemPath& ip, con
             // Ensure typechecked
             if( ep.m_state->stage < ::HIR::ExprState::Stage::Typecheck )
             {
-                if( ep.m_state->stage == ::HIR::ExprState::Stage::TypecheckRequest )
-                    ERROR(Span(), E0000, "Loop in constant evaluation");
-                ep.m_state->stage = ::HIR::ExprState::Stage::TypecheckRequest;
+                // NOTE: `Typecheck_Code` sets (and checks for) `TypecheckRequest`, as it's also used by the main typecheck pass
 
                 // TODO: Set debug/timing stage
                 //Debug_SetStagePre("HIR Typecheck");
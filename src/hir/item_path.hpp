@@ -149,5 +149,52 @@ public:
     }
 };
 
+/// Owned copy of an `ItemPath` (which is normally a chain of references to the visitor's stack), for when an item
+/// is processed after the visitor has moved on.
+///
+/// Names are copied, but the type/trait/path pointers are not - so they must refer to data that outlives this
+/// (e.g. the crate).
+class ItemPathOwned
+{
+    ::std::vector< ::std::string>   m_names;
+    ::std::vector<ItemPath> m_nodes;
+public:
+    ItemPathOwned(const ItemPath& p)
+    {
+        size_t n = 0;
+        for(const auto* i = &p; i; i = i->parent)
+            n ++;
+        // Reserved up-front, as the nodes point to each other and to the names
+        m_names.reserve(n * 2);
+        m_nodes.reserve(n);
+        push(p);
+    }
+    // NOTE: Moving a vector keeps the same storage, so the internal pointers stay valid
+    ItemPathOwned(ItemPathOwned&& ) = default;
+    ItemPathOwned(const ItemPathOwned& ) = delete;
+
+    const ItemPath& get() const {
+        return m_nodes.back();
+    }
+
+private:
+    const ItemPath* push(const ItemPath& p)
+    {
+        const ItemPath* parent = p.parent ? push(*p.parent) : nullptr;
+        m_nodes.push_back(p);
+        auto& rv = m_nodes.back();
+        rv.parent = parent;
+        if( p.name ) {
+            m_names.push_back(p.name);
+            rv.name = m_names.back().c_str();
+        }
+        if( p.crate_name ) {
+            m_names.push_back(p.crate_name);
+            rv.crate_name = m_names.back().c_str();
+        }
+        return &rv;
+    }
+};
+
 }
 
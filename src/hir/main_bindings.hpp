@@ -10,15 +10,39 @@
 #include "crate_ptr.hpp"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <tuple>
+#include <cstdint>
 
 class RcString;
+struct EncodedLiteral;
 namespace AST {
     class Crate;
 }
+namespace HIR {
+    class TypeRef;
+    class Path;
+}
+namespace MIR {
+    class Function;
+    class FunctionPointer;
+}
 
 extern void HIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate);
+/// Dump everything except function bodies (including the `#[inline]`/`#[cold]` markings that affect callers)
+extern void HIR_Dump_Interface(::std::ostream& sink, const ::HIR::Crate& crate);
 extern ::HIR::CratePtr  LowerHIR_FromAST(::AST::Crate crate);
+/// Allocate the expression nodes of each lowered body from a per-body arena
+extern void HIR_EnableExprArena();
 extern void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate);
 
 extern ::HIR::CratePtr HIR_Deserialise(const ::std::string& filename);
 extern RcString HIR_Deserialise_JustName(const ::std::string& filename);
+
+/// Standalone MIR for a function in the current crate, along with a list of named dependency fingerprints (used by the incremental cache)
+extern void HIR_Serialise_Mir(const ::std::string& filename, const ::MIR::Function& fcn, const ::std::vector< ::std::pair< ::std::string, uint64_t> >& deps);
+extern ::MIR::FunctionPointer HIR_Deserialise_Mir(const ::std::string& filename, ::std::vector< ::std::pair< ::std::string, uint64_t> >& deps);
+/// Standalone constant value, along with the path/type/value of each static created while evaluating it (used by the constant evaluation cache)
+extern void HIR_Serialise_ConstValue(const ::std::string& filename, const ::std::string& key, const EncodedLiteral& value, const ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >& statics);
+/// Returns false if the stored key doesn't match `key` (a hash collision)
+extern bool HIR_Deserialise_ConstValue(const ::std::string& filename, const ::std::string& key, EncodedLiteral& value, ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >& statics);
@@ -18,6 +18,10 @@
         ::std::map<std::string, size_t>    m_types;
         ::HIR::serialise::Writer&   m_out;
     public:
+        /// Allow `Const` MIR constants with concrete paths (which are only resolved after monomorphisation, so can
+        /// appear in the incremental cache but never in a crate's .hir)
+        bool    m_allow_concrete_consts = false;
+
         HirSerialiser(::HIR::serialise::Writer& out):
             m_out( out )
         {}
@@ -433,6 +437,7 @@
         {
             m_out.write_string(crate.m_crate_name);
             m_out.write_tag(static_cast<int>(crate.m_edition));
+            m_out.write_tag(static_cast<int>(crate.m_unwind_mode));
             serialise_module(crate.m_root_module);
 
             serialise(crate.m_type_impls);
@@ -453,6 +458,28 @@
                 serialise_strmap(lang_items_filtered);
             }
 
+            {
+                size_t n = 0;
+                for(const auto& ent : crate.m_function_summaries)
+                    if( ent.second.is_exported )
+                        n ++;
+                m_out.write_count(n);
+                for(const auto& ent : crate.m_function_summaries)
+                {
+                    if( !ent.second.is_exported )
+                        continue ;
+                    serialise_path(ent.first);
+                    m_out.write_bool(ent.second.no_unwind);
+                    m_out.write_bool(ent.second.is_pure);
+                    m_out.write_count(ent.second.returns_arg);
+                    m_out.write_bool(ent.second.has_const_return);
+                    if( ent.second.has_const_return ) {
+                        m_out.write_tag(static_cast<int>(ent.second.const_return_ty));
+                        m_out.write_u128(ent.second.const_return_val);
+                    }
+                }
+            }
+
             m_out.write_count(crate.m_ext_crates.size());
             for(const auto& ext : crate.m_ext_crates)
             {
@@ -1088,7 +1115,7 @@
                 m_out.write_string(e);
                 ),
             (Const,
-                ASSERT_BUG(Span(), monomorphise_path_needed(*e.p), "Unexpected Constant: " << *e.p);
+                ASSERT_BUG(Span(), m_allow_concrete_consts || monomorphise_path_needed(*e.p), "Unexpected Constant: " << *e.p);
                 serialise_path(*e.p);
                 ),
             (Generic,
@@ -1230,6 +1257,9 @@
             auto _ = m_out.open_object("HIR::Function::Markings");
             serialise_vec(m.rustc_legacy_const_generics);
             m_out.write_bool(m.track_caller);
+            // Needed by the inliner and codegen in downstream crates
+            m_out.write_tag(static_cast<int>(m.inline_type));
+            m_out.write_bool(m.is_cold);
         }
         void serialise(const ::HIR::Constant& item)
         {
@@ -1458,3 +1488,42 @@ void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate)
     s.serialise_crate(crate);
 }
 
+void HIR_Serialise_Mir(const ::std::string& filename, const ::MIR::Function& fcn, const ::std::vector< ::std::pair< ::std::string, uint64_t> >& deps)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    s.m_allow_concrete_consts = true;
+    auto write = [&]() {
+        out.write_count(deps.size());
+        for(const auto& d : deps) {
+            out.write_string(d.first);
+            out.write_u64(d.second);
+        }
+        s.serialise(fcn);
+        };
+    write();
+    s.clear();
+    out.open(filename);
+    write();
+}
+
+void HIR_Serialise_ConstValue(const ::std::string& filename, const ::std::string& key, const EncodedLiteral& value, const ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >& statics)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    auto write = [&]() {
+        out.write_string(key);
+        out.write_count(statics.size());
+        for(const auto& e : statics) {
+            s.serialise_path(::std::get<0>(e));
+            s.serialise_type(::std::get<1>(e));
+            s.serialise(::std::get<2>(e));
+        }
+        s.serialise(value);
+        };
+    write();
+    s.clear();
+    out.open(filename);
+    write();
+}
+
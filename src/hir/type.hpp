@@ -291,7 +291,7 @@ public:
     // Existing TypeRef
 
 private:
-    unsigned    m_refcount;
+    RefCount    m_refcount;
 public:
     TypeData   m_data;
 private:
@@ -313,14 +313,13 @@ inline TypeRef::TypeRef(TypeData d):
 inline TypeRef::TypeRef(const TypeRef& x):
     m_ptr(x.m_ptr)
 {
-    x.m_ptr->m_refcount += 1;
+    x.m_ptr->m_refcount.inc();
 }
 inline TypeRef::~TypeRef()
 {
     if(m_ptr)
     {
-        m_ptr->m_refcount -= 1;
-        if(m_ptr->m_refcount == 0)
+        if(m_ptr->m_refcount.dec())
         {
             delete m_ptr;
             m_ptr = nullptr;
@@ -329,7 +328,7 @@ inline TypeRef::~TypeRef()
 }
 inline const TypeData& TypeRef::data() const { assert(m_ptr); return m_ptr->m_data; }
 inline TypeData& TypeRef::data_mut() { assert(m_ptr); return m_ptr->m_data; }
-inline TypeData& TypeRef::get_unique() { assert(m_ptr); if(m_ptr->m_refcount != 1) *this = this->clone_shallow(); return m_ptr->m_data; }
+inline TypeData& TypeRef::get_unique() { assert(m_ptr); if(m_ptr->m_refcount.get() != 1) *this = this->clone_shallow(); return m_ptr->m_data; }
 
 
 inline TypeRef::TypeRef(::HIR::CoreType ct):
@@ -152,6 +152,43 @@ namespace {
         }
     }
 
+    /// Bind the types and paths within serialised MIR (from an external crate, or the incremental cache)
+    template<typename V>
+    void visit_mir(V& upper_visitor, ::MIR::Function& mir)
+    {
+        for(auto& ty : mir.locals)
+            upper_visitor.visit_type(ty);
+        struct MirVisitor: public ::MIR::visit::VisitorMut
+        {
+            V& upper_visitor;
+            MirVisitor(V& upper_visitor):
+                upper_visitor(upper_visitor)
+            {
+            }
+            void visit_type(::HIR::TypeRef& t) override {
+                upper_visitor.visit_type(t);
+            }
+            void visit_path(::HIR::Path& p) override {
+                upper_visitor.visit_path(p, ::HIR::Visitor::PathContext::VALUE);
+            }
+            bool visit_lvalue(::MIR::LValue& lv, ::MIR::visit::ValUsage u) override {
+                if( lv.m_root.is_Static() ) {
+                    upper_visitor.visit_path(lv.m_root.as_Static(), ::HIR::Visitor::PathContext::VALUE);
+                }
+                return false;
+            }
+        };
+        MirVisitor  mv(upper_visitor);
+        for(auto& block : mir.blocks)
+        {
+            for(auto& stmt : block.statements)
+            {
+                mv.visit_stmt(stmt);
+            }
+            mv.visit_terminator(block.terminator);
+        }
+    }
+
     class Visitor:
         public ::HIR::Visitor
     {
@@ -824,37 +861,7 @@ namespace {
             // External expression (has MIR)
             else if( auto* mir = expr.get_ext_mir_mut() )
             {
-                for(auto& ty : mir->locals)
-                    this->visit_type(ty);
-                struct MirVisitor: public ::MIR::visit::VisitorMut
-                {
-                    Visitor& upper_visitor;
-                    MirVisitor(Visitor& upper_visitor):
-                        upper_visitor(upper_visitor)
-                    {
-                    }
-                    void visit_type(::HIR::TypeRef& t) override {
-                        upper_visitor.visit_type(t);
-                    }
-                    void visit_path(::HIR::Path& p) override {
-                        upper_visitor.visit_path(p, ::HIR::Visitor::PathContext::VALUE);
-                    }
-                    bool visit_lvalue(::MIR::LValue& lv, ::MIR::visit::ValUsage u) override {
-                        if( lv.m_root.is_Static() ) {
-                            upper_visitor.visit_path(lv.m_root.as_Static(), ::HIR::Visitor::PathContext::VALUE);
-                        }
-                        return false;
-                    }
-                };
-                MirVisitor  mv(*this);
-                for(auto& block : mir->blocks)
-                {
-                    for(auto& stmt : block.statements)
-                    {
-                        mv.visit_stmt(stmt);
-                    }
-                    mv.visit_terminator(block.terminator);
-                }
+                visit_mir(*this, *mir);
             }
             else
             {
@@ -1327,37 +1334,7 @@ namespace {
             // External expression (has MIR)
             else if( auto* mir = expr.get_ext_mir_mut() )
             {
-                for(auto& ty : mir->locals)
-                    this->visit_type(ty);
-                struct MirVisitor: public ::MIR::visit::VisitorMut
-                {
-                    Visitor_Post& upper_visitor;
-                    MirVisitor(Visitor_Post& upper_visitor):
-                        upper_visitor(upper_visitor)
-                    {
-                    }
-                    void visit_type(::HIR::TypeRef& t) override {
-                        upper_visitor.visit_type(t);
-                    }
-                    void visit_path(::HIR::Path& p) override {
-                        upper_visitor.visit_path(p, ::HIR::Visitor::PathContext::VALUE);
-                    }
-                    bool visit_lvalue(::MIR::LValue& lv, ::MIR::visit::ValUsage u) override {
-                        if( lv.m_root.is_Static() ) {
-                            upper_visitor.visit_path(lv.m_root.as_Static(), ::HIR::Visitor::PathContext::VALUE);
-                        }
-                        return false;
-                    }
-                };
-                MirVisitor  mv(*this);
-                for(auto& block : mir->blocks)
-                {
-                    for(auto& stmt : block.statements)
-                    {
-                        mv.visit_stmt(stmt);
-                    }
-                    mv.visit_terminator(block.terminator);
-                }
+                visit_mir(*this, *mir);
             }
             else
             {
@@ -1391,3 +1368,26 @@ void ConvertHIR_Bind(::HIR::Crate& crate)
     // Populate supertrait list
     Visitor_EnumSuperTraits(crate).visit_crate(crate);
 }
+
+void ConvertHIR_Bind_Mir(const ::HIR::Crate& crate, ::MIR::Function& mir)
+{
+    {
+        Visitor v { crate };
+        visit_mir(v, mir);
+    }
+    {
+        Visitor_Post v { crate };
+        visit_mir(v, mir);
+    }
+}
+void ConvertHIR_Bind_Type(const ::HIR::Crate& crate, ::HIR::TypeRef& ty)
+{
+    {
+        Visitor v { crate };
+        v.visit_type(ty);
+    }
+    {
+        Visitor_Post v { crate };
+        v.visit_type(ty);
+    }
+}
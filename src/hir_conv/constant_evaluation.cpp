@@ -19,8 +19,10 @@
 #include <floats.hpp>
 
 #include "constant_evaluation.hpp"
+#include "consteval_cache.hpp"
 #include <trans/monomorphise.hpp>   // For handling monomorph of MIR in provided associated constants
 #include <trans/codegen.hpp>    // For encoding as part of transmute
+#include <parallel.hpp>
 
 namespace {
     static const ::HIR::TypeRef  ty_Self = ::HIR::TypeRef::new_self();
@@ -3103,7 +3105,15 @@ namespace HIR {
                             return ::HIR::LifetimeRef::new_static();
                         }
                     };
-                    auto item_path = nvs.new_static( M().monomorph_type(Span(), inner_alloc->get_type()), mv$(inner_val) );
+                    auto inner_ty = M().monomorph_type(Span(), inner_alloc->get_type());
+                    EncodedLiteral  saved_val;
+                    if( this->created_statics ) {
+                        saved_val = inner_val.clone();
+                    }
+                    auto item_path = nvs.new_static( inner_ty.clone(), mv$(inner_val) );
+                    if( this->created_statics ) {
+                        this->created_statics->push_back(::std::make_tuple( item_path.clone(), mv$(inner_ty), mv$(saved_val) ));
+                    }
 
                     rv.relocations.push_back(Reloc::new_named(r.offset, Target_GetPointerBits()/8, mv$(item_path)));
                 }
@@ -3167,6 +3177,41 @@ namespace HIR {
                 ms.self_ty = ty_Self.clone();
             }
 
+            // Check the persistent cache before running the interpreter
+            ::std::string   cache_key;
+            if( ConstEvalCache_Enabled() )
+            {
+                cache_key = ConstEvalCache_GetKey(resolve.m_crate, ip, ms, exp);
+                EncodedLiteral  cached;
+                ConstEvalCache_Statics  statics;
+                if( !cache_key.empty() && ConstEvalCache_Load(resolve.m_crate, cache_key, cached, statics) )
+                {
+                    // Re-create the statics that the value refers to, they may be given a different name by `nvs`
+                    ::std::vector< ::std::pair<const ::HIR::Path*, ::HIR::Path> >  renames;
+                    auto rename = [&](EncodedLiteral& v) {
+                        for(auto& r : v.relocations) {
+                            if( !r.p )
+                                continue ;
+                            for(const auto& n : renames) {
+                                if( *r.p == *n.first ) {
+                                    *r.p = n.second.clone();
+                                    break;
+                                }
+                            }
+                        }
+                        };
+                    for(auto& s : statics)
+                    {
+                        rename(::std::get<2>(s));
+                        auto new_path = nvs.new_static( mv$(::std::get<1>(s)), mv$(::std::get<2>(s)) );
+                        renames.push_back(::std::make_pair( &::std::get<0>(s), mv$(new_path) ));
+                    }
+                    rename(cached);
+                    DEBUG(ip << " = " << cached << " (cached)");
+                    return cached;
+                }
+            }
+
             assert( this->call_stack.empty() );
             this->num_frames = 0;
             // Note: Since this is the entrypoint, `this->resolve` has the correct GenericParams
@@ -3176,7 +3221,16 @@ namespace HIR {
             ASSERT_BUG(this->root_span, rv_raw, "evaluate_constant_mir returned null allocation");
             DEBUG(ip << " = " << ::MIR::eval::ValueRef(rv_raw));
 
-            return this->allocation_to_encoded(exp, *rv_raw);
+            ConstEvalCache_Statics  created_statics;
+            if( !cache_key.empty() ) {
+                this->created_statics = &created_statics;
+            }
+            auto rv = this->allocation_to_encoded(exp, *rv_raw);
+            this->created_statics = nullptr;
+            if( !cache_key.empty() ) {
+                ConstEvalCache_Store(cache_key, rv, created_statics);
+            }
+            return rv;
         }
         else {
             BUG(this->root_span, "Attempting to evaluate constant expression with no associated code");
@@ -3851,6 +3905,8 @@ void ConvertHIR_ConstantEvaluate_ConstGeneric( const Span& sp, const ::HIR::Crat
 {
     if( auto* cge_p = cg.opt_Unevaluated() )
     {
+        // Can be called from typecheck (which may be running in parallel), and evaluation can generate MIR for other items
+        parallel::Exclusive _excl;
         const auto& cge = *cge_p;
         const auto& e = *cge->expr;
         ASSERT_BUG(sp, e.m_state, "TODO: Should the expression state be set already?");
@@ -3926,6 +3982,8 @@ void ConvertHIR_ConstantEvaluate_MethodParams(
     {
         if(v.is_Unevaluated())
         {
+            // See `ConvertHIR_ConstantEvaluate_ConstGeneric`
+            parallel::Exclusive _excl;
             const auto& ue = *v.as_Unevaluated();
             const auto& e = *ue.expr;
             auto name = FMT("param_" << &v << "#");
@@ -1,6 +1,7 @@
 /*
  */
 #include <hir/hir.hpp>
+#include <tuple>
 
 namespace MIR {
     namespace eval {
@@ -44,6 +45,8 @@ struct Evaluator
     unsigned int num_frames;
     // Note: Pointer is needed to maintain internal reference stability
     ::std::vector<CsePtr>   call_stack;
+    /// If set, the path/type/value of each static created through `nvs` is recorded here (for the constant evaluation cache)
+    ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >*   created_statics = nullptr;
 
     static unsigned s_next_eval_index;
 
@@ -0,0 +1,453 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_conv/consteval_cache.cpp
+ * - Persistent cache of constant evaluation results (`-C incremental=<dir>`)
+ *
+ * Results are keyed on the item path, the monomorphisation parameters, the expected type, and a hash of every crate
+ * that the evaluation could depend on. If the path and parameters only name extern crates then only those crates
+ * (and their dependencies) are hashed, so a generic constant from e.g. `core` evaluated with `core` types can be
+ * reused by every crate that shares the cache directory. Anything involving the current crate is also keyed on the
+ * content of its source files (and the rest of its compiler invocation).
+ *
+ * Entries that haven't been used for `MAX_ENTRY_AGE` are removed (checked at most once per `PRUNE_INTERVAL`).
+ */
+#include "consteval_cache.hpp"
+#include "main_bindings.hpp"
+#include <hir/hir.hpp>
+#include <hir/item_path.hpp>
+#include <hir/main_bindings.hpp>    // HIR_Serialise_ConstValue
+#include <hir_typeck/common.hpp>    // visit_ty_with
+#include <hir_typeck/monomorph.hpp>
+#include <version.hpp>
+#include <sys/stat.h>
+#ifdef _WIN32
+# include <direct.h>   // _mkdir
+# include <sys/utime.h>
+# include <Windows.h>
+#else
+# include <utime.h>
+# include <dirent.h>
+#endif
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <cstdio>   // std::rename
+#include <cstring>  // strchr
+
+namespace {
+    const uint64_t FNV_BASIS = 0xcbf29ce484222325ull;
+    uint64_t fnv1a(uint64_t h, const ::std::string& s)
+    {
+        for(char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    struct State
+    {
+        bool    enabled = false;
+        ::std::string   dir;
+        uint64_t    config_hash = 0;
+        /// Hash of the content of the current crate's source files
+        uint64_t    source_hash = 0;
+
+        /// Hash of each loaded crate (including its dependencies), populated on first use
+        bool    crate_hashes_valid = false;
+        ::std::map<RcString, uint64_t>  crate_hashes;
+        /// Hash of the current crate, and everything it depends on
+        uint64_t    local_hash = 0;
+
+        /// Constants can be evaluated on worker threads (e.g. array sizes during typecheck)
+        ::std::mutex    lock;
+    } s_state;
+
+    /// Entries that haven't been loaded or stored for this long are deleted
+    const time_t MAX_ENTRY_AGE = 30*24*60*60;
+    /// Minimum time between scans of the cache directory for old entries
+    const time_t PRUNE_INTERVAL = 24*60*60;
+
+    bool file_exists(const ::std::string& path)
+    {
+        struct stat s;
+        return stat(path.c_str(), &s) == 0;
+    }
+    /// Mark an entry as recently used (pruning is based on modification time)
+    void touch_file(const ::std::string& path)
+    {
+#ifdef _WIN32
+        _utime(path.c_str(), nullptr);
+#else
+        utime(path.c_str(), nullptr);
+#endif
+    }
+
+    /// Delete entries that haven't been used recently
+    void prune_entries(const ::std::string& dir)
+    {
+        auto now = ::std::time(nullptr);
+        // Only scan the directory occasionally, using the modification time of a marker file
+        auto marker = dir + "/consteval.pruned";
+        struct stat ms;
+        if( stat(marker.c_str(), &ms) == 0 && ms.st_mtime + PRUNE_INTERVAL > now )
+            return ;
+        ::std::ofstream(marker).put('\n');
+
+        ::std::vector< ::std::string>   names;
+#ifdef _WIN32
+        WIN32_FIND_DATA find_data;
+        auto mask = dir + "\\*.lit";
+        HANDLE find_handle = FindFirstFile( mask.c_str(), &find_data );
+        if( find_handle != INVALID_HANDLE_VALUE )
+        {
+            do
+            {
+                names.push_back(find_data.cFileName);
+            } while( FindNextFile(find_handle, &find_data) );
+            FindClose(find_handle);
+        }
+#else
+        if( auto* dp = opendir(dir.c_str()) )
+        {
+            while( const auto* ent = readdir(dp) )
+            {
+                size_t len = ::std::strlen(ent->d_name);
+                if( len > 4 && ::std::strcmp(ent->d_name + len - 4, ".lit") == 0 )
+                    names.push_back(ent->d_name);
+            }
+            closedir(dp);
+        }
+#endif
+        unsigned n_removed = 0;
+        for(const auto& name : names)
+        {
+            auto path = dir + "/" + name;
+            struct stat s;
+            if( stat(path.c_str(), &s) == 0 && s.st_mtime + MAX_ENTRY_AGE < now )
+            {
+                ::std::remove(path.c_str());
+                n_removed += 1;
+            }
+        }
+        DEBUG("Pruned " << n_removed << " of " << names.size() << " cached constants");
+    }
+    /// Identity of a loaded crate's metadata file
+    uint64_t file_identity(const ::std::string& path)
+    {
+        ::std::stringstream ss;
+        ss << path;
+        struct stat s;
+        if( stat(path.c_str(), &s) == 0 ) {
+            ss << " " << s.st_size << " " << s.st_mtime;
+        }
+        return fnv1a(FNV_BASIS, ss.str());
+    }
+
+    void calculate_crate_hashes(const ::HIR::Crate& crate)
+    {
+        ::std::map<RcString, uint64_t>  identities;
+        for(const auto& ec : crate.m_ext_crates)
+        {
+            identities[ec.first] = file_identity(ec.second.m_path);
+        }
+        // NOTE: `m_ext_crates` includes all indirect dependencies, so everything a crate depends on is known here
+        for(const auto& ec : crate.m_ext_crates)
+        {
+            ::std::stringstream ss;
+            ss << ::std::hex << identities.at(ec.first);
+            for(const auto& dep : ec.second.m_data->m_ext_crates)
+            {
+                auto it = identities.find(dep.first);
+                ss << " " << dep.first << "=" << (it != identities.end() ? it->second : 0);
+            }
+            s_state.crate_hashes[ec.first] = fnv1a(FNV_BASIS, ss.str());
+        }
+
+        ::std::stringstream ss;
+        ss << ::std::hex << s_state.source_hash;
+        for(const auto& i : identities)
+        {
+            ss << " " << i.first << "=" << i.second;
+        }
+        s_state.local_hash = fnv1a(FNV_BASIS, ss.str());
+        s_state.crate_hashes_valid = true;
+    }
+
+    /// Crates named by the item path and parameters (anything local or context-dependent sets `is_local`)
+    struct CrateSet
+    {
+        ::std::set<RcString>    crates;
+        bool    is_local = false;
+
+        void add_simplepath(const ::HIR::SimplePath& p) {
+            if( p.crate_name() == "" )
+                is_local = true;
+            else
+                crates.insert(p.crate_name());
+        }
+        void add_params(const ::HIR::PathParams& pp) {
+            if( monomorphise_pathparams_needed(pp) ) {
+                is_local = true;
+                return ;
+            }
+            for(const auto& ty : pp.m_types)
+                add_type(ty);
+            for(const auto& v : pp.m_values)
+                if( !v.is_Evaluated() )
+                    is_local = true;
+        }
+        void add_genericpath(const ::HIR::GenericPath& p) {
+            add_simplepath(p.m_path);
+            add_params(p.m_params);
+        }
+        void add_path(const ::HIR::Path& p) {
+            TU_MATCH_HDRA( (p.m_data), {)
+            TU_ARMA(Generic, e) {
+                add_genericpath(e);
+                }
+            TU_ARMA(UfcsInherent, e) {
+                add_type(e.type);
+                add_params(e.params);
+                add_params(e.impl_params);
+                }
+            TU_ARMA(UfcsKnown, e) {
+                add_type(e.type);
+                add_genericpath(e.trait);
+                add_params(e.params);
+                }
+            TU_ARMA(UfcsUnknown, e) {
+                is_local = true;
+                }
+            }
+        }
+        void add_type(const ::HIR::TypeRef& ty) {
+            if( monomorphise_type_needed(ty) ) {
+                is_local = true;
+                return ;
+            }
+            visit_ty_with(ty, [&](const ::HIR::TypeRef& t)->bool {
+                TU_MATCH_HDRA( (t.data()), {)
+                default:
+                    break;
+                TU_ARMA(Path, e) {
+                    if( const auto* pe = e.path.m_data.opt_Generic() ) {
+                        add_simplepath(pe->m_path);
+                        for(const auto& v : pe->m_params.m_values)
+                            if( !v.is_Evaluated() )
+                                is_local = true;
+                    }
+                    else if( const auto* pe = e.path.m_data.opt_UfcsKnown() ) {
+                        add_simplepath(pe->trait.m_path);
+                    }
+                    }
+                TU_ARMA(TraitObject, e) {
+                    add_simplepath(e.m_trait.m_path.m_path);
+                    for(const auto& m : e.m_markers)
+                        add_simplepath(m.m_path);
+                    }
+                TU_ARMA(NamedFunction, e) {
+                    add_path(e.path);
+                    }
+                // Closures/generators (refer to nodes in the current crate), and types that aren't known yet
+                TU_ARMA(NodeType, e)    is_local = true;
+                TU_ARMA(ErasedType, e)  is_local = true;
+                TU_ARMA(Infer, e)       is_local = true;
+                }
+                return is_local;
+                });
+        }
+        void add_itempath(const ::HIR::ItemPath& ip) {
+            if( ip.wrapped ) {
+                add_path(*ip.wrapped);
+            }
+            else if( ip.parent ) {
+                add_itempath(*ip.parent);
+            }
+            else if( ip.ty ) {
+                add_type(*ip.ty);
+                if( ip.trait ) {
+                    add_simplepath(*ip.trait);
+                    if( ip.trait_params )
+                        add_params(*ip.trait_params);
+                }
+            }
+            else if( ip.trait ) {
+                add_simplepath(*ip.trait);
+            }
+            else {
+                assert(ip.crate_name);
+                if( ip.crate_name[0] == '\0' )
+                    is_local = true;
+                else
+                    crates.insert(RcString::new_interned(ip.crate_name));
+            }
+        }
+    };
+
+    ::std::string entry_filename(const ::std::string& key)
+    {
+        ::std::stringstream rv;
+        rv << s_state.dir << "/" << ::std::hex << ::std::setw(16) << ::std::setfill('0') << fnv1a(FNV_BASIS, key) << ".lit";
+        return rv.str();
+    }
+
+    /// Check if a relocation refers to a static that was generated by a different evaluation (which may not get the
+    /// same name in the next build)
+    bool refers_to_foreign_generated(const EncodedLiteral& v, const ConstEvalCache_Statics& statics)
+    {
+        for(const auto& r : v.relocations)
+        {
+            if( !r.p )
+                continue ;
+            bool is_own = false;
+            for(const auto& s : statics)
+                is_own |= (*r.p == ::std::get<0>(s));
+            if( is_own )
+                continue ;
+            if( const auto* pe = r.p->m_data.opt_Generic() ) {
+                const auto& c = pe->m_path.components();
+                if( !c.empty() && ::std::strchr(c.back().c_str(), '#') )
+                    return true;
+            }
+        }
+        return false;
+    }
+}
+
+void ConvertHIR_ConstEvalCache_Init(const ::std::string& dir, const ::std::string& config, const ::std::string& local_config, const ::std::vector< ::std::string>& source_files)
+{
+    // NOTE: Shares the directory with the MIR cache (created by whichever is initialised first)
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    if( !file_exists(dir) ) {
+        ::std::cerr << "WARN: Unable to create incremental cache directory '" << dir << "'" << ::std::endl;
+        return ;
+    }
+    s_state.enabled = true;
+    s_state.dir = dir;
+
+    ::std::stringstream ss;
+    ss << Version_GetString() << " " << gsVersion_GitHash << (gbVersion_GitDirty ? "-dirty " : " ") << gsVersion_BuildTime << "\n";
+    ss << config;
+    s_state.config_hash = fnv1a(FNV_BASIS, ss.str());
+
+    uint64_t    h = fnv1a(FNV_BASIS, local_config);
+    for(const auto& path : source_files)
+    {
+        ::std::ifstream is(path, ::std::ios::binary);
+        ::std::stringstream contents;
+        contents << is.rdbuf();
+        h = fnv1a(fnv1a(h, path), contents.str());
+    }
+    s_state.source_hash = h;
+
+    prune_entries(dir);
+}
+bool ConstEvalCache_Enabled()
+{
+    return s_state.enabled;
+}
+
+::std::string ConstEvalCache_GetKey(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, const MonomorphState& ms, const ::HIR::TypeRef& ty)
+{
+    // Anonymous expressions (array sizes, const generics) are named using the address of their node
+    for(const auto* p = &ip; p; p = p->parent)
+    {
+        if( p->name && ::std::strchr(p->name, '#') )
+            return "";
+    }
+
+    ::std::lock_guard<::std::mutex> lh(s_state.lock);
+    if( !s_state.crate_hashes_valid )
+        calculate_crate_hashes(crate);
+
+    CrateSet    cs;
+    cs.add_itempath(ip);
+    if( ms.self_ty != ::HIR::TypeRef() )
+        cs.add_type(ms.self_ty);
+    if( ms.pp_impl )
+        cs.add_params(*ms.pp_impl);
+    if( ms.pp_method )
+        cs.add_params(*ms.pp_method);
+    cs.add_type(ty);
+
+    ::std::stringstream ss;
+    ss << ::std::hex << s_state.config_hash << " ";
+    if( cs.is_local ) {
+        ss << s_state.local_hash;
+    }
+    else {
+        for(const auto& c : cs.crates)
+        {
+            auto it = s_state.crate_hashes.find(c);
+            if( it == s_state.crate_hashes.end() ) {
+                DEBUG("Unknown crate " << c << " referenced by " << ip);
+                return "";
+            }
+            ss << c << "=" << it->second << ",";
+        }
+    }
+    ss << ::std::dec << " " << ip << " " << ms << ": " << ty;
+    return ss.str();
+}
+
+bool ConstEvalCache_Load(const ::HIR::Crate& crate, const ::std::string& key, EncodedLiteral& value, ConstEvalCache_Statics& statics)
+{
+    ::std::lock_guard<::std::mutex> lh(s_state.lock);
+    auto filename = entry_filename(key);
+    if( !file_exists(filename) )
+        return false;
+    try
+    {
+        if( !HIR_Deserialise_ConstValue(filename, key, value, statics) ) {
+            DEBUG("Key mismatch in " << filename);
+            return false;
+        }
+    }
+    catch(const ::std::runtime_error& e)
+    {
+        DEBUG("Unable to load " << filename << ": " << e.what());
+        return false;
+    }
+    for(auto& s : statics)
+    {
+        ConvertHIR_Bind_Type(crate, ::std::get<1>(s));
+    }
+    touch_file(filename);
+    DEBUG("Loaded from " << filename);
+    return true;
+}
+
+void ConstEvalCache_Store(const ::std::string& key, const EncodedLiteral& value, const ConstEvalCache_Statics& statics)
+{
+    if( refers_to_foreign_generated(value, statics) ) {
+        DEBUG("Refers to a generated static, not caching");
+        return ;
+    }
+    for(const auto& s : statics)
+    {
+        if( refers_to_foreign_generated(::std::get<2>(s), statics) ) {
+            DEBUG("Refers to a generated static, not caching");
+            return ;
+        }
+    }
+
+    ::std::lock_guard<::std::mutex> lh(s_state.lock);
+    auto filename = entry_filename(key);
+    // Write to a temporary and rename, so an interrupted build can't leave a truncated entry
+    auto tmp_filename = filename + ".tmp";
+    HIR_Serialise_ConstValue(tmp_filename, key, value, statics);
+    ::std::remove(filename.c_str());
+    if( ::std::rename(tmp_filename.c_str(), filename.c_str()) != 0 ) {
+        ::std::remove(tmp_filename.c_str());
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_conv/consteval_cache.hpp
+ * - Persistent cache of constant evaluation results (`-C incremental=<dir>`)
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <tuple>
+
+namespace HIR {
+    class Crate;
+    class ItemPath;
+    class TypeRef;
+    class Path;
+}
+struct EncodedLiteral;
+struct MonomorphState;
+
+// NOTE: `ConvertHIR_ConstEvalCache_Init` is in main_bindings.hpp
+extern bool ConstEvalCache_Enabled();
+
+/// Path, type, and value of each static created by `Evaluator::Newval` during an evaluation (in creation order)
+typedef ::std::vector< ::std::tuple< ::HIR::Path, ::HIR::TypeRef, EncodedLiteral> >    ConstEvalCache_Statics;
+
+/// Get the cache key for evaluating `ip` (with the parameters in `ms`) to a value of type `ty`
+/// - Returns an empty string if the result can't be cached (e.g. anonymous expressions, which don't have a stable name)
+extern ::std::string ConstEvalCache_GetKey(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, const MonomorphState& ms, const ::HIR::TypeRef& ty);
+/// Load a cached value, and the statics that it (and those statics) refer to
+extern bool ConstEvalCache_Load(const ::HIR::Crate& crate, const ::std::string& key, EncodedLiteral& value, ConstEvalCache_Statics& statics);
+extern void ConstEvalCache_Store(const ::std::string& key, const EncodedLiteral& value, const ConstEvalCache_Statics& statics);
@@ -6,6 +6,8 @@
  * - Functions in the "HIR Conversion" group called by main
  */
 #pragma once
+#include <string>
+#include <vector>
 
 struct Span;
 namespace HIR {
@@ -21,16 +23,26 @@ namespace HIR {
     class ConstGeneric;
     class ArraySize;
 };
+namespace MIR {
+    class Function;
+}
 
 extern void ConvertHIR_LifetimeElision(::HIR::Crate& crate);
 extern void ConvertHIR_ExpandAliases(::HIR::Crate& crate);
 extern void ConvertHIR_ExpandAliases_Self(::HIR::Crate& crate);
 extern void ConvertHIR_Bind(::HIR::Crate& crate);
+/// Bind paths/types in MIR loaded after the main bind pass
+extern void ConvertHIR_Bind_Mir(const ::HIR::Crate& crate, ::MIR::Function& mir);
+extern void ConvertHIR_Bind_Type(const ::HIR::Crate& crate, ::HIR::TypeRef& ty);
 extern void ConvertHIR_ResolveUFCS_SortImpls(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS_Outer(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS(::HIR::Crate& crate);
 extern void ConvertHIR_Markings(::HIR::Crate& crate);
 extern void ConvertHIR_ConstantEvaluate(::HIR::Crate& hir_crate);
+/// Enable the persistent cache of constant values (`-C incremental=<dir>`)
+/// - `config` is the compiler configuration shared by every crate that can reuse an entry (target and cfg set)
+/// - `local_config` and `source_files` (every file read to build the current crate) only apply to local items
+extern void ConvertHIR_ConstEvalCache_Init(const ::std::string& dir, const ::std::string& config, const ::std::string& local_config, const ::std::vector< ::std::string>& source_files);
 
 extern void ConvertHIR_ResolveUFCS_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& expr_ptr);
 extern void ConvertHIR_ConstantEvaluate_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& exp);
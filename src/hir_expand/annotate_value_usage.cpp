@@ -9,6 +9,7 @@
 #include <hir/expr.hpp>
 #include <hir_typeck/static.hpp>
 #include <algorithm>
+#include <parallel.hpp>
 #include "main_bindings.hpp"
 #include <hir/expr_state.hpp>
 
@@ -1386,16 +1387,39 @@ namespace {
     {
         StaticTraitResolve   m_resolve;
     public:
+        /// Bodies are annotated independently, so are queued to be run in parallel (`-Z threads`)
+        ::parallel::OrderedQueue    m_queue;
+        bool    m_queue_bodies = true;
+
         OuterVisitor(const ::HIR::Crate& crate):
             m_resolve(crate)
         {}
 
+        void visit_constgeneric(::HIR::ConstGeneric& c) override {
+            // Unevaluated expressions are shared between copies of a path, so can't be queued (might be run twice at once)
+            auto saved = m_queue_bodies;
+            m_queue_bodies = false;
+            ::HIR::Visitor::visit_constgeneric(c);
+            m_queue_bodies = saved;
+        }
         void visit_expr(::HIR::ExprPtr& exp) override {
-            if( exp )
+            if( exp && !m_queue_bodies )
             {
                 ExprVisitor_Mark    ev { m_resolve, exp.m_bindings };
                 ev.visit_root( exp );
             }
+            else if( exp )
+            {
+                const auto& crate = m_resolve.m_crate;
+                auto generics = m_resolve.save_generics();
+                auto* exp_p = &exp;
+                m_queue.push([&crate,generics,exp_p](::parallel::OrderedQueue::Commits& ) {
+                    StaticTraitResolve  resolve { crate };
+                    resolve.set_saved_generics(generics);
+                    ExprVisitor_Mark    ev { resolve, exp_p->m_bindings };
+                    ev.visit_root( *exp_p );
+                    });
+            }
         }
 
         // ------
@@ -1456,4 +1480,5 @@ void HIR_Expand_AnnotateUsage(::HIR::Crate& crate)
 {
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
+    ov.m_queue.run();
 }
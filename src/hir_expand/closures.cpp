@@ -10,6 +10,7 @@
 #include <hir_typeck/static.hpp>
 #include <algorithm>
 #include <hir/expr_state.hpp>
+#include <parallel.hpp>
 #include "main_bindings.hpp"
 
 namespace {
@@ -1239,6 +1240,9 @@ namespace {
 
             if( node.m_is_copy )
             {
+                // Added immediately, as a later closure in this body may capture this one (and need to know it's Copy)
+                // - Stop any other workers (`-Z threads`) while the impl lists are modified
+                parallel::Exclusive _excl;
                 const auto& lang_Copy = m_resolve.m_crate.get_lang_item_path(sp, "copy");
                 auto& v = const_cast<::HIR::Crate&>(m_resolve.m_crate).m_trait_impls[lang_Copy].get_list_for_type_mut(closure_type);
                 v.push_back(box$(::HIR::TraitImpl {
@@ -1931,16 +1935,84 @@ namespace {
     private:
     };
 
+    /// Counts the types that `ExprVisitor_Extract` will create for a body (mirroring its recursion), so that their names
+    /// can be allocated in visit order before any bodies are processed.
+    class ExprVisitor_CountNewTypes:
+        public ::HIR::ExprVisitorDef
+    {
+    public:
+        unsigned    m_count = 0;
+
+        void visit(::HIR::ExprNode_Closure& node) override
+        {
+            // Already expanded (via consteval)
+            if(!node.m_code)
+                return ;
+            m_count += 1;
+            ::HIR::ExprVisitorDef::visit(node);
+        }
+        void visit(::HIR::ExprNode_Generator& node) override
+        {
+            // State index, state structure, and the generator itself
+            m_count += 3;
+            ::HIR::ExprVisitorDef::visit(node);
+        }
+        void visit(::HIR::ExprNode_AsyncBlock& node) override
+        {
+            m_count += 3;
+            ::HIR::ExprVisitorDef::visit(node);
+        }
+    };
+
     /// <summary>
     /// Top-level visitor
     /// </summary>
+    /// Bodies are queued and extracted independently (in parallel with `-Z threads`), then the new types and impls are
+    /// added to the crate in visit order.
     class OuterVisitor:
         public ::HIR::Visitor
     {
+        /// Where the new types from a set of bodies are placed, and the next index used to name them
+        struct NewTypeScope
+        {
+            ::HIR::Module*  module;
+            ::HIR::SimplePath   path;
+            /// Types from impl blocks are placed in the crate root, with an extra prefix
+            bool    is_impl;
+            unsigned    next_index;
+        };
+        /// State for a single queued body
+        struct Body
+        {
+            StaticTraitResolve::SavedGenerics   generics;
+            ::HIR::ExprPtr* code;
+            /// Type of the static (if this is a static's value)
+            ::HIR::TypeRef* value_type;
+            bool    has_self_type;
+            ::HIR::TypeRef  self_type;
+            ::std::string   new_type_suffix;
+            /// Module impls created by this body were defined in
+            ::HIR::SimplePath   src_module;
+
+            ::HIR::Module*  new_type_module;
+            ::HIR::SimplePath   new_type_path;
+            bool    new_type_is_impl;
+            unsigned    new_type_first;
+            unsigned    new_type_count;
+
+            // Outputs
+            OutState    out;
+            ::std::vector< ::std::pair<RcString, std::unique_ptr< ::HIR::VisEnt< ::HIR::TypeItem> > >>  new_types;
+        };
+
         StaticTraitResolve  m_resolve;
         OutState    m_out;
+        ::parallel::OrderedQueue    m_queue;
 
         const ::HIR::SimplePath*  m_cur_mod_path;
+        /// Source module for impls created by the current item
+        const ::HIR::SimplePath*  m_src_module = nullptr;
+        NewTypeScope*   m_new_type_scope = nullptr;
         const ::HIR::TypeRef*   m_self_type = nullptr;
     public:
         OuterVisitor(const ::HIR::Crate& crate):
@@ -1952,22 +2024,18 @@ namespace {
         {
             Span    sp;
 
-            unsigned int closure_count = 0;
             ::HIR::SimplePath   root_mod_path(crate.m_crate_name,{});
             m_cur_mod_path = &root_mod_path;
-            // Type construction helper used for impl blocks
-            m_out.new_type = [&](const char* prefix, const char* suffix, auto s)->auto {
-                auto name = RcString::new_interned(FMT(prefix << "I_" << suffix << (suffix[0] ? "_" : "") << closure_count));
-                closure_count += 1;
-                auto boxed = box$(( ::HIR::VisEnt< ::HIR::TypeItem> { ::HIR::Publicity::new_none(), mv$(s) } ));
-                auto* ret_ptr = &boxed->ent;
-                crate.m_root_module.m_mod_items.insert( ::std::make_pair(name, mv$(boxed)) );
-                return ::std::make_pair( ::HIR::SimplePath(crate.m_crate_name, {}) + name, ret_ptr );
-                };
+            // Type construction scope used for impl blocks
+            NewTypeScope    impl_scope { &crate.m_root_module, ::HIR::SimplePath(crate.m_crate_name, {}), true, 0 };
+            m_new_type_scope = &impl_scope;
 
             auto empty_counts = m_out.save_counts();
 
             ::HIR::Visitor::visit_crate(crate);
+            m_new_type_scope = nullptr;
+
+            m_queue.run();
 
             // Defensive measure
             m_out.update_source_module(empty_counts, root_mod_path);
@@ -1978,39 +2046,21 @@ namespace {
         void visit_module(::HIR::ItemPath p, ::HIR::Module& mod) override
         {
             auto saved = m_cur_mod_path;
+            auto saved_src = m_src_module;
+            auto saved_scope = m_new_type_scope;
             auto path = p.get_simple_path();
             m_cur_mod_path = &path;
+            m_src_module = &path;
 
-            ::std::vector< ::std::pair<RcString, std::unique_ptr< ::HIR::VisEnt< ::HIR::TypeItem> > >>  new_types;
-
-            auto prev_impls = m_out.save_counts();
-
-            unsigned int closure_count = 0;
-            auto saved_nt = mv$(m_out.new_type);
-            m_out.new_type = [&](const char* prefix, const char* suffix, auto s)->auto {
-                // TODO: Use a function on `mod` that adds a closure and makes the indexes be per suffix
-                auto name = RcString::new_interned( FMT(prefix << suffix << (suffix[0] ? "_" : "") << closure_count) );
-                closure_count += 1;
-                auto boxed = box$( (::HIR::VisEnt< ::HIR::TypeItem> { ::HIR::Publicity::new_none(),  mv$(s) }) );
-                auto* ret_ptr = &boxed->ent; 
-                new_types.push_back( ::std::make_pair(name, mv$(boxed)) );
-                return ::std::make_pair( (p + name).get_simple_path(), ret_ptr );
-                };
+            // TODO: Use a function on `mod` that adds a closure and makes the indexes be per suffix
+            NewTypeScope    scope { &mod, path.clone(), false, 0 };
+            m_new_type_scope = &scope;
 
             ::HIR::Visitor::visit_module(p, mod);
 
             m_cur_mod_path = saved;
-            m_out.new_type = mv$(saved_nt);
-
-            for(auto& e : new_types)
-            {
-                DEBUG(p << ": Push " << e.first);
-                mod.m_mod_items.insert( mv$(e) );
-            }
-            // Fix module paths on all impls created during this call that haven't already had a path set
-            // - Child modules will set paths on theirs
-            // - The start counts are needed to avoid setting impls from sibling items
-            m_out.update_source_module(prev_impls, path);
+            m_src_module = saved_src;
+            m_new_type_scope = saved_scope;
         }
 
         // NOTE: This is left here to ensure that any expressions that aren't handled by higher code cause a failure
@@ -2044,17 +2094,7 @@ namespace {
             {
                 assert( m_cur_mod_path );
                 DEBUG("Function code " << p);
-
-                {
-                    ExprVisitor_Extract    ev(m_resolve, m_self_type, item.m_code.m_bindings, item.m_code, m_out, p.name);
-                    ev.visit_root( *item.m_code );
-                }
-
-                {
-                    MonomorphiserNop    mm;
-                    ExprVisitor_Fixup   fixup { m_resolve.m_crate, nullptr, mm, &m_out };
-                    fixup.visit_root( item.m_code );
-                }
+                queue_body(p, item.m_code, nullptr);
             }
             else
             {
@@ -2065,15 +2105,7 @@ namespace {
             if( item.m_value )
             {
                 auto _ = this->m_resolve.set_item_generics(item.m_params);
-                ExprVisitor_Extract    ev(m_resolve, m_self_type, item.m_value.m_bindings, item.m_value, m_out, p.name);
-                ev.visit_root(*item.m_value);
-
-                {
-                    MonomorphiserNop    mm;
-                    ExprVisitor_Fixup   fixup { m_resolve.m_crate, nullptr, mm, &m_out };
-                    fixup.visit_root( item.m_value );
-                    fixup.visit_type( item.m_type );
-                }
+                queue_body(p, item.m_value, &item.m_type);
             }
         }
         void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
@@ -2120,12 +2152,11 @@ namespace {
 
             // TODO: Re-create m_new_type to store in the source module
 
-            auto prev_impls = m_out.save_counts();
+            m_src_module = &impl.m_src_module;
 
             ::HIR::Visitor::visit_type_impl(impl);
 
-            m_out.update_source_module(prev_impls, impl.m_src_module);
-
+            m_src_module = nullptr;
             m_self_type = nullptr;
         }
         void visit_trait_impl(const ::HIR::SimplePath& trait_path, ::HIR::TraitImpl& impl) override
@@ -2134,14 +2165,96 @@ namespace {
             m_self_type = &impl.m_type;
             auto _ = this->m_resolve.set_impl_generics(impl.m_type, impl.m_params);
 
-            auto prev_impls = m_out.save_counts();
+            m_src_module = &impl.m_src_module;
 
             ::HIR::Visitor::visit_trait_impl(trait_path, impl);
 
-            m_out.update_source_module(prev_impls, impl.m_src_module);
-
+            m_src_module = nullptr;
             m_self_type = nullptr;
         }
+
+    private:
+        void queue_body(const ::HIR::ItemPath& p, ::HIR::ExprPtr& code, ::HIR::TypeRef* value_type)
+        {
+            assert( m_new_type_scope );
+            assert( m_src_module );
+
+            // Allocate the names of this body's new types now, so they don't depend on when other bodies are processed
+            ExprVisitor_CountNewTypes   counter;
+            code->visit(counter);
+
+            auto body = ::std::make_shared<Body>();
+            body->generics = m_resolve.save_generics();
+            body->code = &code;
+            body->value_type = value_type;
+            body->has_self_type = (m_self_type != nullptr);
+            if( m_self_type )
+                body->self_type = m_self_type->clone();
+            body->new_type_suffix = p.get_name();
+            body->src_module = m_src_module->clone();
+            body->new_type_module = m_new_type_scope->module;
+            body->new_type_path = m_new_type_scope->path.clone();
+            body->new_type_is_impl = m_new_type_scope->is_impl;
+            body->new_type_first = m_new_type_scope->next_index;
+            body->new_type_count = counter.m_count;
+            m_new_type_scope->next_index += counter.m_count;
+
+            m_queue.push([this,body](::parallel::OrderedQueue::Commits& commits) {
+                this->extract_body(*body);
+                commits.push([this,body]() { this->commit_body(*body); });
+                });
+        }
+
+        // NOTE: Can run on a worker thread, so only touches `body`
+        void extract_body(Body& body) const
+        {
+            const auto& crate = m_resolve.m_crate;
+            StaticTraitResolve  resolve { crate };
+            resolve.set_saved_generics(body.generics);
+
+            unsigned index = body.new_type_first;
+            body.out.new_type = [&](const char* prefix, const char* suffix, auto s)->auto {
+                ASSERT_BUG(Span(), index < body.new_type_first + body.new_type_count, "More new types than counted in " << body.new_type_suffix);
+                auto name = RcString::new_interned(FMT(prefix << (body.new_type_is_impl ? "I_" : "") << suffix << (suffix[0] ? "_" : "") << index));
+                index += 1;
+                auto boxed = box$(( ::HIR::VisEnt< ::HIR::TypeItem> { ::HIR::Publicity::new_none(), mv$(s) } ));
+                auto* ret_ptr = &boxed->ent;
+                body.new_types.push_back( ::std::make_pair(name, mv$(boxed)) );
+                return ::std::make_pair( body.new_type_path + name, ret_ptr );
+                };
+
+            auto& code = *body.code;
+            {
+                ExprVisitor_Extract    ev(resolve, body.has_self_type ? &body.self_type : nullptr, code.m_bindings, code, body.out, body.new_type_suffix.c_str());
+                ev.visit_root( *code );
+            }
+
+            {
+                MonomorphiserNop    mm;
+                ExprVisitor_Fixup   fixup { crate, nullptr, mm, &body.out };
+                fixup.visit_root( code );
+                if( body.value_type )
+                    fixup.visit_type( *body.value_type );
+            }
+            body.out.new_type = new_type_cb_t();
+
+            body.out.update_source_module(OutState::Counts { 0, 0, 0 }, body.src_module);
+        }
+        // Runs on the main thread after all bodies have been extracted, in visit order
+        void commit_body(Body& body)
+        {
+            for(auto& e : body.new_types)
+            {
+                DEBUG(body.new_type_path << ": Push " << e.first);
+                body.new_type_module->m_mod_items.insert( mv$(e) );
+            }
+            for(auto& e : body.out.impls_closure)
+                m_out.impls_closure.push_back( mv$(e) );
+            for(auto& e : body.out.trait_impls)
+                m_out.trait_impls.push_back( mv$(e) );
+            for(auto& e : body.out.impls_type)
+                m_out.impls_type.push_back( mv$(e) );
+        }
     };
 }
 
@@ -9,6 +9,7 @@
 #include <hir/expr.hpp>
 #include <hir_typeck/static.hpp>
 #include <algorithm>
+#include <parallel.hpp>
 #include "main_bindings.hpp"
 
 namespace {
@@ -177,17 +178,44 @@ namespace {
     {
         const ::HIR::Crate& m_crate;
     public:
+        /// Bodies are updated independently, so are queued to be run in parallel (`-Z threads`)
+        ::parallel::OrderedQueue    m_queue;
+        bool    m_queue_bodies = true;
+
         OuterVisitor(const ::HIR::Crate& crate):
             m_crate(crate)
         {
         }
 
-        void visit_expr(::HIR::ExprPtr& exp) override {
-            if(exp)
+        void queue_body(::HIR::ExprPtr& exp) {
+            if( !m_queue_bodies )
             {
                 ExprVisitor_Mutate  ev(m_crate);
                 ev.visit_node_ptr(exp);
             }
+            else
+            {
+                const auto& crate = m_crate;
+                auto* exp_p = &exp;
+                m_queue.push([&crate,exp_p](::parallel::OrderedQueue::Commits& ) {
+                    ExprVisitor_Mutate  ev(crate);
+                    ev.visit_node_ptr(*exp_p);
+                    });
+            }
+        }
+
+        void visit_constgeneric(::HIR::ConstGeneric& c) override {
+            // Unevaluated expressions are shared between copies of a path, so can't be queued (might be run twice at once)
+            auto saved = m_queue_bodies;
+            m_queue_bodies = false;
+            ::HIR::Visitor::visit_constgeneric(c);
+            m_queue_bodies = saved;
+        }
+        void visit_expr(::HIR::ExprPtr& exp) override {
+            if(exp)
+            {
+                queue_body(exp);
+            }
         }
 
         // ------
@@ -198,8 +226,7 @@ namespace {
             if( item.m_code )
             {
                 DEBUG("Function code " << p);
-                ExprVisitor_Mutate  ev(m_crate);
-                ev.visit_node_ptr( item.m_code );
+                queue_body( item.m_code );
             }
             else
             {
@@ -219,4 +246,5 @@ void HIR_Expand_Reborrows(::HIR::Crate& crate)
 {
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
+    ov.m_queue.run();
 }
@@ -10,6 +10,7 @@
 #include <hir/expr.hpp>
 #include <hir_typeck/static.hpp>
 #include <algorithm>
+#include <parallel.hpp>
 #include "main_bindings.hpp"
 
 namespace {
@@ -750,11 +751,23 @@ namespace {
     {
         const ::HIR::Crate& m_crate;
     public:
+        /// Bodies are updated independently, so are queued to be run in parallel (`-Z threads`)
+        ::parallel::OrderedQueue    m_queue;
+
         OuterVisitor(const ::HIR::Crate& crate):
             m_crate(crate)
         {
         }
 
+        void queue_body(::HIR::ExprPtr& exp) {
+            const auto& crate = m_crate;
+            auto* exp_p = &exp;
+            m_queue.push([&crate,exp_p](::parallel::OrderedQueue::Commits& ) {
+                ExprVisitor_Mutate  ev(crate);
+                ev.visit_node_ptr(*exp_p);
+                });
+        }
+
         // NOTE: This is left here to ensure that any expressions that aren't handled by higher code cause a failure
         void visit_expr(::HIR::ExprPtr& exp) override {
             BUG(Span(), "visit_expr hit in OuterVisitor");
@@ -765,6 +778,7 @@ namespace {
             HIR::Visitor::visit_constgeneric(c);
             if( auto* e = c.opt_Unevaluated() )
             {
+                // NOTE: Not queued, as these expressions are shared between copies of a path
                 ExprVisitor_Mutate  ev(m_crate);
                 ev.visit_node_ptr( *(*e)->expr );
             }
@@ -777,8 +791,7 @@ namespace {
             if( item.m_code )
             {
                 DEBUG("Function code " << p);
-                ExprVisitor_Mutate  ev(m_crate);
-                ev.visit_node_ptr( item.m_code );
+                queue_body( item.m_code );
             }
             else
             {
@@ -788,15 +801,13 @@ namespace {
         void visit_static(::HIR::ItemPath p, ::HIR::Static& item) override {
             if( item.m_value )
             {
-                ExprVisitor_Mutate  ev(m_crate);
-                ev.visit_node_ptr(item.m_value);
+                queue_body(item.m_value);
             }
         }
         void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
             if( item.m_value )
             {
-                ExprVisitor_Mutate  ev(m_crate);
-                ev.visit_node_ptr(item.m_value);
+                queue_body(item.m_value);
             }
         }
         void visit_enum(::HIR::ItemPath p, ::HIR::Enum& item) override {
@@ -808,8 +819,7 @@ namespace {
 
                     if( var.expr )
                     {
-                        ExprVisitor_Mutate  ev(m_crate);
-                        ev.visit_node_ptr(var.expr);
+                        queue_body(var.expr);
                     }
                 }
             }
@@ -827,5 +837,6 @@ void HIR_Expand_UfcsEverything(::HIR::Crate& crate)
 {
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
+    ov.m_queue.run();
 }
 
@@ -7866,6 +7866,7 @@ namespace
 void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr)
 {
     TRACE_FUNCTION;
+    TRACE_SPAN("Typecheck_Code_CS");
 
     auto root_ptr = expr.into_unique();
     assert(!ms.m_mod_paths.empty());
@@ -10,13 +10,40 @@
 #include <hir/visitor.hpp>
 #include "expr_visit.hpp"
 #include <hir/expr_state.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+
+namespace {
+    /// Bodies being checked by the current thread (innermost last)
+    thread_local ::std::vector<const ::HIR::ExprState*>  s_bodies_in_progress;
+}
 
 void Typecheck_Code(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr) {
     if( expr.m_state->stage < ::HIR::ExprState::Stage::Typecheck )
     {
+        const auto* state = &*expr.m_state;
+        // A body part-way through checking can be requested again by constant evaluation (e.g. an array length that
+        // needs this function's MIR). Checking it again would clobber the in-progress ivars, and waiting for the other
+        // worker isn't possible (it's blocked on the `parallel::Exclusive` held by the requester).
+        if( state->stage == ::HIR::ExprState::Stage::TypecheckRequest )
+        {
+            if( ::std::find(s_bodies_in_progress.begin(), s_bodies_in_progress.end(), state) != s_bodies_in_progress.end() )
+                ERROR(expr.span(), E0000, "Loop in constant evaluation");
+            else
+                ERROR(expr.span(), E0000, "Constant evaluation needs a function that another thread is part-way through typechecking,"
+                    << " compile with `-Z threads=1`");
+        }
+        state->stage = ::HIR::ExprState::Stage::TypecheckRequest;
+        s_bodies_in_progress.push_back(state);
+
+        // Nodes inserted by typeck (e.g. auto-derefs) go into the same arena as the rest of the body
+        ::HIR::ExprArena::Scope arena_scope(expr.arena());
         //Typecheck_Code_Simple(ms, args, result_type, expr);
         Typecheck_Code_CS(ms, args, result_type, expr);
         expr.m_state->stage = ::HIR::ExprState::Stage::Typecheck;
+
+        assert(s_bodies_in_progress.back() == state);
+        s_bodies_in_progress.pop_back();
     }
 }
 
@@ -106,15 +133,56 @@ namespace typeck {
 
 namespace {
 
+    /// A body queued to be checked on a worker thread
+    struct BodyJob
+    {
+        ::typeck::ModuleState   ms;
+        /// Owned copy of the current trait path (the visitor's version is a temporary)
+        ::std::unique_ptr<::HIR::GenericPath>   current_trait;
+        t_args* args;
+        t_args  tmp_args;
+        ::HIR::TypeRef  result_type;
+        ::HIR::ExprPtr* expr;
+
+        BodyJob(const ::typeck::ModuleState& ms, t_args* args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr):
+            ms(ms),
+            args(args),
+            result_type(result_type),
+            expr(&expr)
+        {
+            if( ms.m_current_trait ) {
+                current_trait = box$( ms.m_current_trait->clone() );
+                this->ms.m_current_trait = current_trait.get();
+            }
+        }
+        void run() {
+            Typecheck_Code(ms, args ? *args : tmp_args, result_type, *expr);
+        }
+    };
 
     class OuterVisitor:
         public ::HIR::Visitor
     {
         ::typeck::ModuleState m_ms;
+        /// If non-null, bodies are collected here instead of being checked immediately
+        ::std::vector<::std::unique_ptr<BodyJob>>*  m_jobs;
     public:
-        OuterVisitor(::HIR::Crate& crate):
-            m_ms(crate)
+        OuterVisitor(::HIR::Crate& crate, ::std::vector<::std::unique_ptr<BodyJob>>* jobs=nullptr):
+            m_ms(crate),
+            m_jobs(jobs)
+        {
+        }
+
+    private:
+        void typecheck_body(t_args* args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr)
         {
+            if( m_jobs ) {
+                m_jobs->push_back(box$(BodyJob(m_ms, args, result_type, expr)));
+            }
+            else {
+                t_args  tmp;
+                Typecheck_Code(m_ms, args ? *args : tmp, result_type, expr);
+            }
         }
 
 
@@ -209,7 +277,7 @@ namespace {
             if( item.m_code )
             {
                 DEBUG("Function code " << p);
-                Typecheck_Code( m_ms, item.m_args, item.m_return, item.m_code );
+                typecheck_body( &item.m_args, item.m_return, item.m_code );
             }
             else
             {
@@ -221,8 +289,7 @@ namespace {
             if( item.m_value )
             {
                 DEBUG("Static value " << p);
-                t_args  tmp;
-                Typecheck_Code(m_ms, tmp, item.m_type, item.m_value);
+                typecheck_body(nullptr, item.m_type, item.m_value);
             }
         }
         void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
@@ -230,8 +297,7 @@ namespace {
             if( item.m_value )
             {
                 DEBUG("Const value " << p);
-                t_args  tmp;
-                Typecheck_Code(m_ms, tmp, item.m_type, item.m_value);
+                typecheck_body(nullptr, item.m_type, item.m_value);
             }
         }
         void visit_enum(::HIR::ItemPath p, ::HIR::Enum& item) override {
@@ -246,8 +312,7 @@ namespace {
                     DEBUG("Enum value " << p << " - " << var.name);
                     if( var.expr )
                     {
-                        t_args  tmp;
-                        Typecheck_Code(m_ms, tmp, enum_type, var.expr);
+                        typecheck_body(nullptr, enum_type, var.expr);
                     }
                 }
             }
@@ -257,6 +322,24 @@ namespace {
 
 void Typecheck_Expressions(::HIR::Crate& crate)
 {
-    OuterVisitor    visitor { crate };
-    visitor.visit_crate( crate );
+    if( parallel::thread_count() > 1 )
+    {
+        // Collect every body along with the module state it needs, then check them in parallel
+        // - Each body has its own inference context, and only writes to its own nodes.
+        // - Crate-wide caches written during typecheck are locked (auto trait impls, interned strings), and lazy
+        //   constant evaluation (which can typecheck and lower other bodies) stops the other workers first.
+        // - Array sizes in types are checked while collecting.
+        ::std::vector<::std::unique_ptr<BodyJob>>  jobs;
+        OuterVisitor    visitor { crate, &jobs };
+        visitor.visit_crate( crate );
+        DEBUG(jobs.size() << " bodies");
+        parallel::for_each(jobs.size(), [&](size_t i) {
+            jobs[i]->run();
+            });
+    }
+    else
+    {
+        OuterVisitor    visitor { crate };
+        visitor.visit_crate( crate );
+    }
 }
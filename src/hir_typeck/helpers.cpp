@@ -8,6 +8,8 @@
 #include "helpers.hpp"
 #include <hir_conv/main_bindings.hpp>
 #include <algorithm>
+#include <mutex>
+#include <parallel.hpp>
 
 namespace {
     // TODO: De-duplicate this with `static.cpp`
@@ -3172,6 +3174,15 @@ bool TraitResolution::find_trait_impls_bound(const Span& sp, const ::HIR::Simple
     }
     return false;
 }
+namespace {
+    /// `TraitMarkings::auto_impls` is shared by all bodies, which may be checked in parallel
+    ::std::mutex    s_auto_impls_lock;
+    ::std::unique_lock<::std::mutex> lock_auto_impls() {
+        if( parallel::in_worker() )
+            return ::std::unique_lock<::std::mutex>(s_auto_impls_lock);
+        return ::std::unique_lock<::std::mutex>();
+    }
+}
 bool TraitResolution::find_trait_impls_crate(const Span& sp,
         const ::HIR::SimplePath& trait, const ::HIR::PathParams* params_ptr,
         const ::HIR::TypeRef& type,
@@ -3213,7 +3224,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         StackHandle& operator=(const StackHandle&) = delete;
         ~StackHandle() { if(stack) stack->pop_back(); stack = nullptr; }
     };
-    static std::vector<StackEnt>    s_recurse_stack;
+    thread_local static std::vector<StackEnt>    s_recurse_stack;
     auto se = StackEnt(trait, params_ptr, type);
     // NOTE: Allow 1 level of recursion (EAT being run)
     if( std::count(s_recurse_stack.begin(), s_recurse_stack.end(), se) > 1 ) {
@@ -3227,7 +3238,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
     if( m_crate.get_trait_by_path(sp, trait).m_is_marker )
     {
         // Detect recursion and return true if detected
-        static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
+        thread_local static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
         for(const auto& ent : stack ) {
             if( *::std::get<0>(ent) != trait )
                 continue ;
@@ -3263,13 +3274,22 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         // - Cache populated after destructure
         if( markings )
         {
-            auto it = markings->auto_impls.find( trait );
-            if( it != markings->auto_impls.end() )
+            bool is_cached = false, is_impled = false;
             {
-                if( ! it->second.conditions.empty() ) {
-                    TODO(sp, "Conditional auto trait impl");
+                auto lh = lock_auto_impls();
+                auto it = markings->auto_impls.find( trait );
+                if( it != markings->auto_impls.end() )
+                {
+                    if( ! it->second.conditions.empty() ) {
+                        TODO(sp, "Conditional auto trait impl");
+                    }
+                    is_cached = true;
+                    is_impled = it->second.is_impled;
                 }
-                else if( it->second.is_impled ) {
+            }
+            if( is_cached )
+            {
+                if( is_impled ) {
                     return callback( ImplRef(&type, params_ptr, &null_assoc), ::HIR::Compare::Equal );
                 }
                 else {
@@ -3343,6 +3363,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         {
             if( markings ) {
                 ASSERT_BUG(sp, cmp == ::HIR::Compare::Equal, "Auto trait with no params returned a fuzzy match from destructure - " << trait << " for " << type);
+                auto lh = lock_auto_impls();
                 markings->auto_impls.insert( ::std::make_pair(trait, ::HIR::TraitMarkings::AutoMarking { {}, true }) );
             }
             return callback( ImplRef(&type, params_ptr, &null_assoc), cmp );
@@ -3350,6 +3371,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         else
         {
             if( markings ) {
+                auto lh = lock_auto_impls();
                 markings->auto_impls.insert( ::std::make_pair(trait, ::HIR::TraitMarkings::AutoMarking { {}, false }) );
             }
             return false;
@@ -3649,7 +3671,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
     }
     if( placeholders_needed )
     {
-        static uint64_t s_ph_counter = 0;
+        thread_local static uint64_t s_ph_counter = 0;
         // NOTE: Not using interning, because these are short-lived
         // - Also, adding an interned string is quite expensive
         placeholder_name = RcString(FMT("ph_" << &impl_params_def << "_" << s_ph_counter));
@@ -144,33 +144,38 @@ bool StaticTraitResolve::find_impl(
             }
             else {
             }
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
-            if(assoc_unit.empty()) {
-                assoc_unit.insert(std::make_pair( RcString::new_interned("Discriminant"), HIR::TraitPath::AtyEqual {
+            // NOTE: Initialised by a lambda so it's safe if bodies are being checked in parallel
+            static const ::HIR::TraitPath::assoc_list_t   assoc_unit = [&]{
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( RcString::new_interned("Discriminant"), HIR::TraitPath::AtyEqual {
                     m_lang_DiscriminantKind,
                     {},
                     HIR::TypeRef::new_unit()
                     } ));
-            }
+                return rv;
+                }();
             return found_cb( ImplRef(HIR::PathParams(), &type, trait_params, &assoc_unit), false );
         }
         else if( TARGETVER_LEAST_1_54 && trait_path == m_lang_Pointee ) {
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
-            static ::HIR::TraitPath::assoc_list_t   assoc_slice;
-            static RcString name_Metadata;
-            if(assoc_unit.empty()) {
-                name_Metadata = RcString::new_interned("Metadata");
-                assoc_unit.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
+            static const RcString name_Metadata = RcString::new_interned("Metadata");
+            static const ::HIR::TraitPath::assoc_list_t   assoc_unit = [&]{
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
                     m_lang_Pointee,
                     {},
                     HIR::TypeRef::new_unit()
                     } ));
-                assoc_slice.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
+                return rv;
+                }();
+            static const ::HIR::TraitPath::assoc_list_t   assoc_slice = [&]{
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
                     m_lang_Pointee,
                     {},
                     HIR::CoreType::Usize
                     } ));
-            }
+                return rv;
+                }();
 
             // Generics (or opaque ATYs)
             if( type.data().is_Generic() || (type.data().is_Path() && type.data().as_Path().binding.is_Opaque()) ) {
@@ -767,7 +772,7 @@ bool StaticTraitResolve::find_impl(
             return rv;
 
         // Detect recursion and return true if detected
-        static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
+        thread_local static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
         for(const auto& ent : stack ) {
             if( *::std::get<0>(ent) != trait_path )
                 continue ;
@@ -1828,12 +1833,12 @@ bool StaticTraitResolve::expand_associated_types__UfcsKnown(const Span& sp, ::HI
     auto& e = input.data_mut().as_Path();
     auto& e2 = e.path.m_data.as_UfcsKnown();
 
-    static unsigned s_recursion_level;
+    thread_local static unsigned s_recursion_level;
     struct RecurseEntry {
         HIR::TypeRef    ty;
         unsigned level;
     };
-    static std::vector<RecurseEntry>    s_recursion_stack;
+    thread_local static std::vector<RecurseEntry>    s_recursion_stack;
     {
         bool hit_same_level_loop = false;
         for(const auto& ent : s_recursion_stack) {
@@ -2859,7 +2864,8 @@ HIR::Compare StaticTraitResolve::type_is_interior_mutable(const Span& sp, const
 
         TU_ARMA(Struct, pbe) {
             const HIR::GenericPath& p = e.path.m_data.as_Generic();
-            if( p.m_path == m_crate.get_lang_item_path(sp, "unsafe_cell") ) {
+            // NOTE: `#![no_core]` crates might not define `UnsafeCell`, in which case nothing is interior mutable
+            if( p.m_path == m_crate.get_lang_item_path_opt("unsafe_cell") ) {
                 return HIR::Compare::Equal;
             }
             // TODO: Cache this result?
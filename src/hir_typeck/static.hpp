@@ -129,6 +129,24 @@ public:
         m_item_generics = nullptr;
         prep_indexes();
     }
+
+    /// Generics state, saved so an item can be processed later (e.g. on a worker thread) with its own resolver
+    struct SavedGenerics {
+        MetadataType    self_metadata;
+        const ::HIR::GenericParams* impl_generics;
+        const ::HIR::GenericParams* item_generics;
+    };
+    SavedGenerics save_generics() const {
+        return SavedGenerics { m_self_metadata, m_impl_generics, m_item_generics };
+    }
+    void set_saved_generics(const SavedGenerics& saved) {
+        assert( !m_impl_generics );
+        assert( !m_item_generics );
+        m_self_metadata = saved.self_metadata;
+        m_impl_generics = saved.impl_generics;
+        m_item_generics = saved.item_generics;
+        prep_indexes();
+    }
     // Used by ResolveUFCS to regenerate
     void prep_indexes(const Span& sp) {
         TraitResolveCommon::prep_indexes(sp);
@@ -9,34 +9,132 @@
 #include <ident.hpp>
 #include <debug.hpp>
 #include <common.hpp>   // vector print
+#include <algorithm>
+#include <map>
 
 unsigned int Ident::Hygiene::g_next_scope = 0;
 
+namespace {
+    /// Interning tables backing `Ident::Hygiene`
+    struct HygieneTables
+    {
+        /// Parent scope for each scope (indexed by scope number)
+        ::std::vector<unsigned int> scope_parents;
+        /// Full context chain for each scope, lazily populated
+        ::std::vector< ::std::vector<unsigned int> >  scope_chains;
+
+        /// Interned module paths (index 0 is unused, meaning "no path")
+        ::std::vector< ::std::unique_ptr<Ident::ModPath> >    mod_paths;
+        ::std::map< ::std::pair<RcString, ::std::vector<RcString>>, unsigned int>    mod_path_lookup;
+
+        HygieneTables()
+        {
+            scope_parents.push_back(0);
+            scope_chains.push_back({});
+            mod_paths.push_back(nullptr);
+        }
+    };
+    HygieneTables& hygiene_tables() {
+        static HygieneTables   rv;
+        return rv;
+    }
+}
+
+unsigned int Ident::Hygiene::alloc_scope(unsigned int parent)
+{
+    auto& tables = hygiene_tables();
+    auto rv = ++g_next_scope;
+    assert(rv == tables.scope_parents.size());
+    tables.scope_parents.push_back(parent);
+    return rv;
+}
+const ::std::vector<unsigned int>& Ident::Hygiene::contexts() const
+{
+    auto& tables = hygiene_tables();
+    if( tables.scope_chains.size() <= m_scope ) {
+        tables.scope_chains.resize(tables.scope_parents.size());
+    }
+    if( m_scope != 0 && tables.scope_chains[m_scope].empty() )
+    {
+        ::std::vector<unsigned int> chain;
+        for(auto s = m_scope; s != 0; s = tables.scope_parents[s])
+            chain.push_back(s);
+        ::std::reverse(chain.begin(), chain.end());
+        tables.scope_chains[m_scope] = ::std::move(chain);
+    }
+    return tables.scope_chains[m_scope];
+}
+
+Ident::Hygiene Ident::Hygiene::get_parent() const
+{
+    //assert(m_scope != 0);
+    if( m_scope == 0 )
+        return Hygiene();
+    return Hygiene(hygiene_tables().scope_parents[m_scope], 0);
+}
+
+const Ident::ModPath& Ident::Hygiene::mod_path() const
+{
+    assert(m_mod_path != 0);
+    return *hygiene_tables().mod_paths[m_mod_path];
+}
+void Ident::Hygiene::set_mod_path(ModPath p)
+{
+    auto& tables = hygiene_tables();
+    auto key = ::std::make_pair(p.crate, p.ents);
+    auto it = tables.mod_path_lookup.find(key);
+    if( it == tables.mod_path_lookup.end() )
+    {
+        auto idx = static_cast<unsigned int>(tables.mod_paths.size());
+        tables.mod_paths.push_back( ::std::unique_ptr<ModPath>(new ModPath(::std::move(p))) );
+        it = tables.mod_path_lookup.insert( ::std::make_pair(::std::move(key), idx) ).first;
+    }
+    m_mod_path = it->second;
+}
+
 bool Ident::Hygiene::is_visible(const Hygiene& src) const
 {
     // HACK: Disable hygiene for now
     //return true;
 
-    if( m_inner->contexts.size() == 0 ) {
-        return src->contexts.size() == 0;
+    if( m_scope == 0 ) {
+        return src.m_scope == 0;
     }
 
-    auto des = m_inner->contexts.back();
-    for(const auto& c : src->contexts)
-        if( des == c )
+    // Visible if this scope is anywhere in the source's context chain
+    const auto& parents = hygiene_tables().scope_parents;
+    for(auto s = src.m_scope; s != 0; s = parents[s])
+        if( s == m_scope )
             return true;
     return false;
 }
 
+Ordering Ident::Hygiene::ord(const Hygiene& x) const
+{
+    // Scopes are unique, so the same scope means the same context chain
+    if( m_scope == x.m_scope )
+        return OrdEqual;
+    // Otherwise, keep the original lexical ordering of context chains
+    // - Size the chain cache to cover every allocated scope first, so neither `contexts` call can reallocate it
+    //   (which would invalidate `a`)
+    auto& tables = hygiene_tables();
+    if( tables.scope_chains.size() < tables.scope_parents.size() ) {
+        tables.scope_chains.resize(tables.scope_parents.size());
+    }
+    const auto& a = this->contexts();
+    const auto& b = x.contexts();
+    return ::ord(a, b);
+}
+
 ::std::ostream& operator<<(::std::ostream& os, const Ident& x) {
     os << x.name << x.hygiene;
     return os;
 }
 
 ::std::ostream& operator<<(::std::ostream& os, const Ident::Hygiene& x) {
-    os << "/*" << x->contexts;
-    if( x->search_module )
-        os << " " << *x->search_module;
+    os << "/*" << x.contexts();
+    if( x.has_mod_path() )
+        os << " " << x.mod_path();
     os << "*/";
     return os;
 }
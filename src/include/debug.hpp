@@ -12,7 +12,16 @@
 #include <cassert>
 #include <functional>
 
-extern int g_debug_indent_level;
+extern thread_local int g_debug_indent_level;
+/// Cached "debug enabled for the current phase" flag (updated on phase change)
+extern bool g_debug_enabled;
+/// Set when `MRUSTC_TRACE_JSON` is set, enables `TRACE_SPAN`
+extern bool g_trace_json_enabled;
+
+// `make NODEBUG=1` builds with all debug logging compiled out (unless a file defines `ENABLE_DEBUG`)
+#if defined(MRUSTC_NODEBUG) && !defined(ENABLE_DEBUG) && !defined(DISABLE_DEBUG)
+# define DISABLE_DEBUG
+#endif
 
 #ifndef DEBUG_EXTRA_ENABLE
 # define DEBUG_EXTRA_ENABLE  // Files can override this with their own flag if needed (e.g. `&& g_my_debug_on`)
@@ -23,11 +32,12 @@ extern int g_debug_indent_level;
 # define MAX_INDENT_LEVEL   450
 # define INDENT()    do { g_debug_indent_level += 1; assert(g_debug_indent_level<MAX_INDENT_LEVEL); } while(0)
 # define UNINDENT()    do { g_debug_indent_level -= 1; } while(0)
-# define DEBUG_ENABLED  (debug_enabled() DEBUG_EXTRA_ENABLE)
+# define DEBUG_ENABLED  (g_debug_enabled && debug_file_enabled() DEBUG_EXTRA_ENABLE)
 # define DEBUG(ss)   do{ if(DEBUG_ENABLED) { debug_output(g_debug_indent_level, __FUNCTION__) << ss << std::dec << ::std::endl; } } while(0)
 # define TRACE_FUNCTION  TraceLog _tf_( DEBUG_ENABLED ? __func__ : nullptr)
 # define TRACE_FUNCTION_F(ss)    TraceLog _tf_(DEBUG_ENABLED ? __func__ : nullptr, [&](::std::ostream&__os){ __os << ss; })
-# define TRACE_FUNCTION_FR(ss,ss2)    TraceLog _tf_(DEBUG_ENABLED ? __func__ : nullptr, [&](::std::ostream&__os){ __os << ss; }, [&](::std::ostream&__os){ __os << ss2;})
+// NOTE: The return formatter is named so it outlives the constructor call (`TraceLog` only keeps a reference)
+# define TRACE_FUNCTION_FR(ss,ss2)    auto _tf_ret_ = [&](::std::ostream&__os){ __os << ss2;}; TraceLog _tf_(DEBUG_ENABLED ? __func__ : nullptr, [&](::std::ostream&__os){ __os << ss; }, _tf_ret_)
 #else
 # define INDENT()    do { } while(0)
 # define UNINDENT()    do {} while(0)
@@ -37,9 +47,28 @@ extern int g_debug_indent_level;
 # define TRACE_FUNCTION_FR(ss,ss2)  do{ if(false) (void)(::NullSink() << ss); if(false) (void)(::NullSink() << ss2); } while(0)
 #endif
 
-extern bool debug_enabled();
+static inline bool debug_enabled() { return g_debug_enabled; }
 extern ::std::ostream& debug_output(int indent, const char* function);
 
+/// Check `MRUSTC_DEBUG_FILES` against a source file name (uncached, see `debug_file_enabled`)
+extern bool debug_file_filter(const char* file);
+#ifdef __GNUC__
+// Per-translation-unit cached file filter, only consulted once debug is already enabled for the phase
+static inline bool debug_file_enabled() {
+    static int cached = -1;
+    if( cached < 0 )
+        cached = debug_file_filter(__BASE_FILE__) ? 1 : 0;
+    return cached != 0;
+}
+#else
+static inline bool debug_file_enabled() { return true; }
+#endif
+
+// Chrome trace (`chrome://tracing`/Perfetto) spans, written to the file named by `MRUSTC_TRACE_JSON`
+// - Independent of `DISABLE_DEBUG`, costs a single flag check when not enabled.
+#define TRACE_SPAN(name)   TraceSpan _ts_(name)
+#define TRACE_SPAN_F(name, ss)   TraceSpan _ts_(name, [&](::std::ostream&__os){ __os << ss; })
+
 struct RepeatLitStr
 {
     const char *s;
@@ -65,12 +94,101 @@ public:
 class TraceLog
 {
     const char* m_tag;
-    ::std::function<void(::std::ostream&)>  m_ret;
+    // Type-erased reference to the return formatter (avoids constructing a `std::function` when tracing is off)
+    void (*m_ret_fcn)(const void*, ::std::ostream&);
+    const void* m_ret_ptr;
+
+    template<typename T>
+    static void call_fmt(const void* p, ::std::ostream& os) { (*static_cast<const T*>(p))(os); }
+
+    ::std::ostream& enter_output();
+    void enter_finish(::std::ostream& os);
+    void exit_output();
+public:
+    template<typename I, typename R>
+    TraceLog(const char* tag, const I& info_cb, const R& ret):
+        m_tag(tag),
+        m_ret_fcn(&call_fmt<R>),
+        m_ret_ptr(&ret)
+    {
+        if(m_tag) {
+            auto& os = enter_output();
+            info_cb(os);
+            enter_finish(os);
+        }
+        INDENT();
+    }
+    template<typename I>
+    TraceLog(const char* tag, const I& info_cb):
+        m_tag(tag),
+        m_ret_fcn(nullptr),
+        m_ret_ptr(nullptr)
+    {
+        if(m_tag) {
+            auto& os = enter_output();
+            info_cb(os);
+            enter_finish(os);
+        }
+        INDENT();
+    }
+    TraceLog(const char* tag):
+        m_tag(tag),
+        m_ret_fcn(nullptr),
+        m_ret_ptr(nullptr)
+    {
+        if(m_tag) {
+            enter_finish(enter_output());
+        }
+        INDENT();
+    }
+    TraceLog(const TraceLog&) = delete;
+    TraceLog& operator=(const TraceLog&) = delete;
+    ~TraceLog() {
+        UNINDENT();
+        if(m_tag) {
+            exit_output();
+        }
+    }
+};
+
+class TraceSpan
+{
+    const char* m_name;
+    unsigned long long  m_start;
+    ::std::string   m_detail;
 public:
-    TraceLog(const char* tag, ::std::function<void(::std::ostream&)> info_cb, ::std::function<void(::std::ostream&)> ret);
-    TraceLog(const char* tag, ::std::function<void(::std::ostream&)> info_cb);
-    TraceLog(const char* tag);
-    ~TraceLog();
+    /// Microseconds since the trace was opened
+    static unsigned long long now_us();
+    static void emit(const char* name, const ::std::string& detail, unsigned long long start, unsigned long long end);
+
+    TraceSpan(const char* name):
+        m_name(g_trace_json_enabled ? name : nullptr)
+    {
+        if(m_name) {
+            m_start = now_us();
+        }
+    }
+    template<typename I>
+    TraceSpan(const char* name, const I& detail_cb):
+        m_name(g_trace_json_enabled ? name : nullptr)
+    {
+        if(m_name) {
+            ::std::ostringstream    ss;
+            detail_cb(ss);
+            m_detail = ss.str();
+            m_start = now_us();
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    ~TraceSpan() {
+        if(m_name) {
+            emit(m_name, m_detail, m_start, now_us());
+        }
+    }
+
+    /// Open the trace output file (called by `debug_init_phases` when `MRUSTC_TRACE_JSON` is set)
+    static void open(const char* filename);
 };
 
 struct FmtLambda
@@ -10,6 +10,7 @@ class DebugTimedPhase
 {
     const char* m_name;
     clock_t m_start;
+    unsigned long long  m_span_start;
 public:
     DebugTimedPhase(const char* name);
     ~DebugTimedPhase();
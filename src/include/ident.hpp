@@ -21,88 +21,58 @@ struct Ident
         friend std::ostream& operator<<(std::ostream& os, const ModPath& x);
     };
 
-    // TODO: make this a reference-counted pointer instead (so it's cheaper to copy)
-    // - Presents challenges with setting the module path, and how this is used in macros.
+    /// Hygiene context for an identifier
+    ///
+    /// Stored as a pair of handles into global (append-only) tables, so copying is trivial and
+    /// comparing is an integer comparison in the common case.
+    /// - `m_scope` is the innermost scope, each scope is only ever created once so it uniquely identifies the
+    ///   full context chain.
+    /// - `m_mod_path` is an index into the interned module path table (0 for no path)
     class Hygiene
     {
         static unsigned g_next_scope;
 
-        struct Inner {
-            ::std::vector<unsigned int> contexts;
-            ::std::shared_ptr<ModPath> search_module;
-        };
-        // NOTE: Use a unique pointer to reduce the size to 1 pointer (instead of 5)
-        // - Used quite a bit, and parse sometimes runs out of stack.
-        ::std::unique_ptr<Inner>    m_inner;
+        unsigned int    m_scope;
+        unsigned int    m_mod_path;
 
-        Hygiene(unsigned int index):
-            m_inner(new Inner())
+        Hygiene(unsigned int scope, unsigned int mod_path):
+            m_scope(scope),
+            m_mod_path(mod_path)
         {
-            m_inner->contexts.push_back(index);
         }
-              Inner* operator->()       { return &*m_inner; }
-        const Inner* operator->() const { return &*m_inner; }
+
+        /// Allocate a new scope with the given parent scope (0 for none)
+        static unsigned int alloc_scope(unsigned int parent);
+        /// Obtain the full context chain for this hygiene (outermost first)
+        const ::std::vector<unsigned int>& contexts() const;
     public:
         Hygiene():
-            m_inner(new Inner())
+            m_scope(0),
+            m_mod_path(0)
         {}
-        Hygiene(const Hygiene& x):
-            m_inner(new Inner(*x.m_inner))
-        {
-        }
-        Hygiene& operator=(const Hygiene& x) {
-            *this = Hygiene(x);
-            assert(this->m_inner);
-            return *this;
-        }
-
-        //Hygiene(Hygiene&& x) = default;
-        Hygiene(Hygiene&& x): m_inner(std::move(x.m_inner)) {
-            //assert(m_inner);
-        }
-        Hygiene& operator=(Hygiene&& x) {
-            m_inner.reset(x.m_inner.release());
-            //assert(m_inner);
-            return *this;
-        }
 
         static Hygiene new_scope()
         {
-            return Hygiene(++g_next_scope);
+            return Hygiene(alloc_scope(0), 0);
         }
         static Hygiene new_scope_chained(const Hygiene& parent)
         {
-            Hygiene rv;
-            rv->search_module = parent->search_module;
-            rv->contexts.reserve( parent->contexts.size() + 1 );
-            rv->contexts.insert( rv->contexts.begin(),  parent->contexts.begin(), parent->contexts.end() );
-            rv->contexts.push_back( ++g_next_scope );
-            return rv;
-        }
-        Hygiene get_parent() const
-        {
-            //assert(this->contexts.size() > 1);
-            Hygiene rv;
-            rv->contexts.insert(rv->contexts.begin(),  m_inner->contexts.begin(), m_inner->contexts.end()-1);
-            return rv;
+            return Hygiene(alloc_scope(parent.m_scope), parent.m_mod_path);
         }
+        Hygiene get_parent() const;
 
         bool has_mod_path() const {
-            return m_inner->search_module != 0;
-        }
-        const ModPath& mod_path() const {
-            assert(m_inner->search_module);
-            return *m_inner->search_module;
-        }
-        void set_mod_path(ModPath p) {
-            m_inner->search_module.reset( new ModPath(::std::move(p)) );
+            return m_mod_path != 0;
         }
+        const ModPath& mod_path() const;
+        void set_mod_path(ModPath p);
 
         // Returns true if an ident with hygine `source` can see an ident with this hygine
         bool is_visible(const Hygiene& source) const;
-        Ordering ord(const Hygiene& x) const { ORD(m_inner->contexts, x->contexts); /*ORD(*m_inner->search_module, *x->search_module);*/ return OrdEqual; }
-        bool operator==(const Hygiene& x) const { return ord(x) == OrdEqual; }
-        bool operator!=(const Hygiene& x) const { return ord(x) != OrdEqual; }
+        Ordering ord(const Hygiene& x) const;
+        // NOTE: Equality only considers the scope (same as `ord`), not the module path
+        bool operator==(const Hygiene& x) const { return m_scope == x.m_scope; }
+        bool operator!=(const Hygiene& x) const { return m_scope != x.m_scope; }
         bool operator<(const Hygiene& x) const { return ord(x) == OrdLess; }
 
         friend ::std::ostream& operator<<(::std::ostream& os, const Hygiene& v);
@@ -0,0 +1,78 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/parallel.hpp
+ * - Running independent per-item work (e.g. function bodies) on multiple threads
+ */
+#pragma once
+#include <functional>
+#include <cstddef>
+#include <vector>
+
+namespace parallel {
+
+/// Set the number of threads used by `for_each` (from `-Z threads=N`), defaults to 1
+extern void set_thread_count(unsigned n);
+extern unsigned thread_count();
+
+/// Call `fcn(i)` for every `i` in `0 .. count`, using up to `thread_count()` threads (the calling thread is one of them)
+///
+/// - Items are started in index order, but may complete in any order. Anything that must be applied to shared state in
+///   a fixed order should be recorded per-item and applied by the caller afterwards.
+/// - A nested call (from within an item) runs on the current thread.
+/// - If any item throws, no new items are started and the exception from the lowest index is re-thrown on the calling
+///   thread once all workers have stopped.
+extern void for_each(size_t count, ::std::function<void(size_t)> fcn);
+
+/// Returns true if the current thread is running an item for `for_each` with more than one thread
+extern bool in_worker();
+
+/// Stops all other workers for the lifetime of this object, for operations that mutate crate-wide state (e.g. lazily
+/// evaluating a constant in the middle of typecheck).
+///
+/// Other workers are allowed to finish their current item (or reach their own `Exclusive`) first, so this must not be
+/// created while holding a lock that another item could be waiting on. Re-entrant, and a no-op outside of a worker.
+class Exclusive
+{
+    bool    m_locked;
+public:
+    Exclusive();
+    Exclusive(const Exclusive&) = delete;
+    Exclusive& operator=(const Exclusive&) = delete;
+    ~Exclusive();
+};
+
+/// Queue of per-item jobs (e.g. one per function body) run with `for_each`, where changes to shared state (e.g. new
+/// types and impls added to the crate) are deferred and applied in the order the jobs were pushed.
+///
+/// Commits are always applied after every job has finished (even when single-threaded), so jobs never observe each
+/// other's commits and the result doesn't depend on the thread count or on scheduling.
+class OrderedQueue
+{
+public:
+    /// Deferred changes made by a single job
+    class Commits
+    {
+        friend class OrderedQueue;
+        ::std::vector< ::std::function<void()> >  m_ents;
+    public:
+        void push(::std::function<void()> fcn) {
+            m_ents.push_back(::std::move(fcn));
+        }
+    };
+    typedef ::std::function<void(Commits& commits)>  job_t;
+private:
+    ::std::vector<job_t>    m_jobs;
+public:
+    void push(job_t job) {
+        m_jobs.push_back(::std::move(job));
+    }
+    size_t size() const {
+        return m_jobs.size();
+    }
+    /// Run all queued jobs, then apply their commits (on the calling thread). Leaves the queue empty.
+    void run();
+};
+
+}   // namespace parallel
@@ -10,11 +10,12 @@
 #include <cstring>
 #include <ostream>
 #include "../common.hpp"
+#include "refcount.hpp"
 
 class RcString
 {
     struct Inner {
-        unsigned int    refcount;
+        RefCount    refcount;
         unsigned int    size;
         unsigned int    ordering;   // Populated only for interned strings, 0 otherwise
         unsigned int    data[1];    // Actually arbitary
@@ -44,7 +45,7 @@ public:
     RcString(const RcString& x):
         m_ptr(x.m_ptr)
     {
-        if( m_ptr ) m_ptr->refcount += 1;
+        if( m_ptr ) m_ptr->refcount.inc();
     }
     RcString(RcString&& x):
         m_ptr(x.m_ptr)
@@ -60,7 +61,7 @@ public:
         {
             this->~RcString();
             m_ptr = x.m_ptr;
-            if( m_ptr ) m_ptr->refcount += 1;
+            if( m_ptr ) m_ptr->refcount.inc();
         }
         return *this;
     }
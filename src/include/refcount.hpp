@@ -0,0 +1,48 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/refcount.hpp
+ * - Intrusive reference count that is only atomic while worker threads are running
+ */
+#pragma once
+#include <atomic>
+
+/// Reference count for objects that may be shared between the worker threads of `parallel::for_each`
+///
+/// Almost all of the compiler is single-threaded, so the (comparatively expensive) atomic read-modify-write
+/// operations are only used while `RefCount::threaded()` is set.
+class RefCount
+{
+    ::std::atomic<unsigned> m_value;
+public:
+    RefCount(unsigned value=1):
+        m_value(value)
+    {}
+    RefCount(const RefCount&) = delete;
+    RefCount& operator=(const RefCount&) = delete;
+
+    /// Set by the main thread before starting workers, and cleared after they have all been joined
+    static bool& threaded() {
+        static bool s_threaded;
+        return s_threaded;
+    }
+
+    unsigned get() const {
+        return m_value.load(::std::memory_order_relaxed);
+    }
+    void inc() {
+        if( threaded() )
+            m_value.fetch_add(1, ::std::memory_order_relaxed);
+        else
+            m_value.store(get() + 1, ::std::memory_order_relaxed);
+    }
+    /// Decrement, returning true if this was the last reference
+    bool dec() {
+        if( threaded() )
+            return m_value.fetch_sub(1, ::std::memory_order_acq_rel) == 1;
+        auto v = get() - 1;
+        m_value.store(v, ::std::memory_order_relaxed);
+        return v == 0;
+    }
+};
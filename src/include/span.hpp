@@ -91,7 +91,7 @@ struct SpanInner
 {
     friend struct Span;
 protected:
-    size_t  reference_count;
+    RefCount    reference_count;
 public:
     Span    parent_span;
 
@@ -118,7 +118,6 @@ public:
 private:
     static SpanInner* alloc(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs) {
         auto* rv = new SpanInner_Source();
-        rv->reference_count = 1;
         rv->parent_span = parent;
         rv->filename = ::std::move(filename);
         rv->start_line = start_line;
@@ -30,6 +30,7 @@
 #include "expand/cfg.hpp"
 #include <target_detect.h>	// tools/common/target_detect.h
 #include <debug_inner.hpp>
+#include <parallel.hpp>
 
 #ifdef _WIN32
 # define NOGDI
@@ -99,8 +100,17 @@ struct ProgramParams
     struct {
         ::std::string   codegen_type;
         ::std::string   emit_build_command;
+        ::std::string   emit_symbol_map;
         ::std::string   panic_type;
+        ::std::string   incremental_dir;
+        bool    emit_hints = false;
+        bool    lto = false;
+        ::std::string   profile_generate_dir;
+        ::std::string   profile_use_dir;
+        bool    landing_pads = false;
     } codegen;
+    /// Command line (and relevant environment), used to key the incremental cache
+    ::std::string   invocation;
 
     ProgramParams(int argc, char *argv[]);
 
@@ -516,27 +526,40 @@ int main(int argc, char *argv[])
             }
             });
 
-        /// Emit the dependency files
-        if( params.emit_depfile != "" )
+        // Code using landing pads can't be linked with code using setjmp/longjmp (a panic would abort)
+        const auto unwind_mode = params.codegen.landing_pads ? ::HIR::Crate::UnwindMode::LandingPads : ::HIR::Crate::UnwindMode::SetJmp;
+        for(const auto& ec : crate.m_extern_crates)
         {
-            // - Iterate all loaded files for modules
-            struct PathEnumerator {
-                ::std::vector<::std::string> out;
-                void visit_module(::AST::Module& mod) {
-                    if( mod.m_file_info.path != "!" && mod.m_file_info.path.back() != '/' ) {
-                        out.push_back( mod.m_file_info.path );
-                    }
-                    // TODO: Should we check anon modules?
-                    //for(auto& amod : mod.anon_mods()) {
-                    //    this->visit_module(*amod);
-                    //}
-                    for(auto& i : mod.m_items) {
-                        if(i->data.is_Module()) {
-                            this->visit_module(i->data.as_Module());
-                        }
+            auto ec_mode = ec.second.m_hir->m_unwind_mode;
+            if( ec_mode != ::HIR::Crate::UnwindMode::NoCode && ec_mode != unwind_mode )
+            {
+                ERROR(Span(), E0000, "Crate `" << ec.first << "` (" << ec.second.m_filename << ") was built "
+                    << (ec_mode == ::HIR::Crate::UnwindMode::LandingPads ? "with" : "without") << " `-C landing-pads`, "
+                    << "all crates must use the same setting");
+            }
+        }
+
+        // - Iterate all loaded files for modules
+        struct PathEnumerator {
+            ::std::vector<::std::string> out;
+            void visit_module(::AST::Module& mod) {
+                if( mod.m_file_info.path != "!" && mod.m_file_info.path.back() != '/' ) {
+                    out.push_back( mod.m_file_info.path );
+                }
+                // TODO: Should we check anon modules?
+                //for(auto& amod : mod.anon_mods()) {
+                //    this->visit_module(*amod);
+                //}
+                for(auto& i : mod.m_items) {
+                    if(i->data.is_Module()) {
+                        this->visit_module(i->data.as_Module());
                     }
                 }
-            };
+            }
+        };
+        /// Emit the dependency files
+        if( params.emit_depfile != "" )
+        {
             PathEnumerator pe;
             pe.visit_module(crate.m_root_module);
 
@@ -558,6 +581,35 @@ int main(int argc, char *argv[])
             // - Iterate all extra files (include! and friends)
         }
 
+        // The constant evaluation cache is keyed on the content of everything read to build this crate
+        if( params.codegen.incremental_dir != "" )
+        {
+            PathEnumerator pe;
+            pe.visit_module(crate.m_root_module);
+            ::std::vector<::std::string>    source_files;
+            source_files.push_back(params.infile);
+            source_files.insert(source_files.end(), pe.out.begin(), pe.out.end());
+            source_files.insert(source_files.end(), crate.m_extra_files.begin(), crate.m_extra_files.end());
+            // - Entries for items only involving extern crates are shared between all crates with the same target
+            //   and cfg set, but the feature set and the rest of the invocation are specific to this crate.
+            ::std::stringstream cfg_ss;
+            Cfg_Dump(cfg_ss);
+            ::std::stringstream config;
+            ::std::string   local_config = params.invocation;
+            config << "target=" << params.target << " version=" << static_cast<int>(gTargetVersion) << "\n";
+            for(::std::string line; ::std::getline(cfg_ss, line); )
+            {
+                if( line.compare(0, 9, ">feature=") == 0 )
+                    local_config += "\n" + line;
+                else
+                    config << line << "\n";
+            }
+            // - env! and option_env! results are only known after expansion, so also go in the local key
+            for(const auto& e : crate.m_env_reads)
+                local_config += "\nenv:" + e;
+            ConvertHIR_ConstEvalCache_Init(params.codegen.incremental_dir, config.str(), local_config, source_files);
+        }
+
         // Resolve names to be absolute names (include references to the relevant struct/global/function)
         // - This does name checking on types and free functions.
         // - Resolves all identifiers/paths to references
@@ -591,6 +643,7 @@ int main(int argc, char *argv[])
         ::HIR::CratePtr hir_crate = CompilePhase< ::HIR::CratePtr>("HIR Lower", [&]() {
             return LowerHIR_FromAST(mv$( crate ));
             });
+        hir_crate->m_unwind_mode = unwind_mode;
         memory_dump("HIR Gen");
         if( params.debug.dump_hir )
         {
@@ -732,6 +785,10 @@ int main(int argc, char *argv[])
 
         // Lower expressions into MIR
         CompilePhaseV("Lower MIR", [&]() {
+            if( params.codegen.landing_pads )
+            {
+                HIR_GenerateMIR_SetUnwindCleanup();
+            }
             HIR_GenerateMIR(*hir_crate);
             });
 
@@ -769,6 +826,10 @@ int main(int argc, char *argv[])
                 });
         }
 
+        if( params.codegen.incremental_dir != "" )
+        {
+            MIR_Incremental_Init(params.codegen.incremental_dir, params.invocation);
+        }
         // Optimise the MIR
         CompilePhaseV("MIR Optimise", [&]() {
             MIR_OptimiseCrate(*hir_crate, params.debug.disable_mir_optimisations);
@@ -804,7 +865,13 @@ int main(int argc, char *argv[])
         TransOptions    trans_opt;
         trans_opt.mode = params.codegen.codegen_type == "" ? "c" : params.codegen.codegen_type;
         trans_opt.build_command_file = params.codegen.emit_build_command;
+        trans_opt.symbol_map_file = params.codegen.emit_symbol_map;
         trans_opt.opt_level = params.opt_level;
+        trans_opt.emit_hints = params.codegen.emit_hints;
+        trans_opt.lto = params.codegen.lto;
+        trans_opt.profile_generate_dir = params.codegen.profile_generate_dir;
+        trans_opt.profile_use_dir = params.codegen.profile_use_dir;
+        trans_opt.landing_pads = params.codegen.landing_pads;
         trans_opt.panic_crate = params.codegen.panic_type == "" ? "panic_abort" : "panic_"+params.codegen.panic_type;
         for(const char* libdir : params.lib_search_dirs ) {
             // Store these paths for use in final linking.
@@ -1002,6 +1069,16 @@ ProgramParams::ProgramParams(int argc, char *argv[])
 
     // Hacky command-line parsing
     for( int i = 1; i < argc; i ++ )
+    {
+        this->invocation += argv[i];
+        this->invocation += '\n';
+    }
+    if( const auto* a = getenv("MRUSTC_TARGET_VER") )
+    {
+        this->invocation += "MRUSTC_TARGET_VER=";
+        this->invocation += a;
+    }
+    for( int i = 1; i < argc; i ++ )
     {
         const char* arg = argv[i];
 
@@ -1087,17 +1164,25 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                         exit(1);
                     }
                     };
-                //auto no_optval = [&]() {
-                //    if(eq_pos != ::std::string::npos) {
-                //        ::std::cerr << "Flag -C " << optname << " doesn't take an argument" << ::std::endl;
-                //        exit(1);
-                //    }
-                //    };
+                auto no_optval = [&]() {
+                    if(eq_pos != ::std::string::npos) {
+                        ::std::cerr << "Flag -C " << optname << " doesn't take an argument" << ::std::endl;
+                        exit(1);
+                    }
+                    };
 
                 if( optname == "emit-build-command" ) {
                     get_optval();
                     this->codegen.emit_build_command = optval;
                 }
+                else if( optname == "emit-symbol-map" ) {
+                    get_optval();
+                    this->codegen.emit_symbol_map = optval;
+                }
+                else if( optname == "incremental" ) {
+                    get_optval();
+                    this->codegen.incremental_dir = optval;
+                }
                 else if( optname == "codegen-type" ) {
                     get_optval();
                     this->codegen.codegen_type = optval;
@@ -1110,6 +1195,45 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     get_optval();
                     this->codegen.panic_type = optval;
                 }
+                else if( optname == "c-hints" ) {
+                    no_optval();
+                    this->codegen.emit_hints = true;
+                }
+                else if( optname == "lto" ) {
+                    // Accept rustc's spellings, `thin` is treated as a full LTO
+                    if( eq_pos == ::std::string::npos || optval == "fat" || optval == "thin" || optval == "yes" || optval == "on" ) {
+                        this->codegen.lto = true;
+                    }
+                    else if( optval == "off" || optval == "no" ) {
+                        this->codegen.lto = false;
+                    }
+                    else {
+                        ::std::cerr << "Unknown value for -C lto: '" << optval << "'" << ::std::endl;
+                        exit(1);
+                    }
+                }
+                else if( optname == "opt-level" ) {
+                    get_optval();
+                    if( optval == "0" || optval == "1" || optval == "2" || optval == "3" ) {
+                        this->opt_level = optval[0] - '0';
+                    }
+                    else {
+                        ::std::cerr << "Unknown value for -C opt-level: '" << optval << "'" << ::std::endl;
+                        exit(1);
+                    }
+                }
+                else if( optname == "profile-generate" ) {
+                    get_optval();
+                    this->codegen.profile_generate_dir = optval;
+                }
+                else if( optname == "profile-use" ) {
+                    get_optval();
+                    this->codegen.profile_use_dir = optval;
+                }
+                else if( optname == "landing-pads" ) {
+                    no_optval();
+                    this->codegen.landing_pads = true;
+                }
                 else {
                     ::std::cerr << "Unknown codegen option: '" << optname << "'" << ::std::endl;
                     exit(1);
@@ -1198,6 +1322,19 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     no_optval();
                     this->run_borrowcheck = true;
                 }
+                else if( optname == "hir-expr-arena" ) {
+                    no_optval();
+                    HIR_EnableExprArena();
+                }
+                else if( optname == "threads" ) {
+                    get_optval();
+                    int n = atoi(optval.c_str());
+                    if( n <= 0 ) {
+                        ::std::cerr << "Invalid thread count for -Z threads - '" << optval << "'" << ::std::endl;
+                        exit(1);
+                    }
+                    parallel::set_thread_count(static_cast<unsigned>(n));
+                }
                 else {
                     ::std::cerr << "Unknown -Z flag: '" << optname << "'" << ::std::endl;
                     exit(1);
@@ -1389,6 +1526,11 @@ ProgramParams::ProgramParams(int argc, char *argv[])
         }
     }
 
+    if( this->codegen.profile_generate_dir != "" && this->codegen.profile_use_dir != "" ) {
+        ::std::cerr << "-C profile-generate and -C profile-use are mutually exclusive" << ::std::endl;
+        exit(1);
+    }
+
 
     if( const auto* a = getenv("MRUSTC_DUMP") )
     {
@@ -1447,6 +1589,14 @@ void ProgramParams::show_help() const
         "--target <name>    : Compile code for the given target\n"
         "--test             : Generate a unit test executable\n"
         "-C <option>        : Code-generation options\n"
+        "    opt-level=<n>      : Set the C compiler's optimisation level (0-3, `-O` is 2)\n"
+        "    incremental=<dir>  : Reuse optimised MIR and constant values of unchanged items from previous builds (cached in <dir>)\n"
+        "    c-hints            : Emit inlining, cold-path, aliasing and non-null hints as C compiler attributes\n"
+        "    lto                : Link-time optimisation across crates (objects keep LTO bytecode, executables are optimised whole)\n"
+        "    profile-generate=<dir> : Instrument the output to record execution profiles in <dir>\n"
+        "    profile-use=<dir>  : Optimise using the profiles in <dir> (from a `profile-generate` build of the same source)\n"
+        "    landing-pads       : Unwind panics through real landing pads, running drops (GCC, must be used for every crate)\n"
         "-Z <option>        : Debugging/experimental options\n"
+        "    threads=<n>        : Check, expand and lower function bodies on <n> threads\n"
         ;
 }
@@ -23,6 +23,9 @@
 #include "helpers.hpp"
 
 namespace {
+    /// Emit drops on panic paths (`-C landing-pads`, otherwise they're never run)
+    bool g_unwind_cleanup = false;
+
     class ExprVisitor_Conv:
         public MirConverter
     {
@@ -438,7 +441,10 @@ namespace {
 
         void emit_unwind(const Span& sp)
         {
-            // TODO: Emit the drop calls
+            if( g_unwind_cleanup )
+            {
+                m_builder.drop_all_for_unwind(sp);
+            }
             m_builder.end_block(::MIR::Terminator::make_Diverge({}));
         }
 
@@ -3084,6 +3090,7 @@ namespace {
 ::MIR::FunctionPointer LowerMIR(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, const ::HIR::ExprPtr& ptr, const ::HIR::TypeRef& ret_ty, const ::HIR::Function::args_t& args)
 {
     TRACE_FUNCTION_F(path);
+    TRACE_SPAN_F("LowerMIR", path);
 
     ::MIR::Function fcn;
     fcn.locals.reserve(ptr.m_bindings.size());
@@ -3157,6 +3164,9 @@ namespace {
 
             // ------------
 
+            // The state types are filled in below (in the crate), so stop any other workers (`-Z threads`) from reading them
+            parallel::Exclusive _excl;
+
             // 1. Generate the state machine switch (and enumerate saved variables)
             std::set<unsigned>  saved = ev.generator_finalise(gen_node->span(), const_cast<HIR::Enum&>(resolve.m_crate.get_enum_by_path(sp, gen_node->m_state_idx_enum)));
             // 2. Populate state structure
@@ -3408,15 +3418,20 @@ void HIR_GenerateMIR_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& path
     }
 }
 
+void HIR_GenerateMIR_SetUnwindCleanup()
+{
+    g_unwind_cleanup = true;
+}
+
 void HIR_GenerateMIR(::HIR::Crate& crate)
 {
-    ::MIR::OuterVisitor    ov { crate, [&](const auto& res, const auto& p, ::HIR::ExprPtr& expr_ptr, const auto& args, const auto& ty){
+    // Bodies are lowered independently, so can be spread over threads (`-Z threads`)
+    ::MIR::visit_crate_parallel(crate, [&](const auto& res, const auto& p, ::HIR::ExprPtr& expr_ptr, const auto& args, const auto& ty, auto& commits){
             if( !expr_ptr.get_mir_opt() )
             {
                 expr_ptr.set_mir( LowerMIR(res, p, expr_ptr, ty, args) );
             }
-        } };
-    ov.visit_crate(crate);
+        });
 
     // Once MIR is generated, free the HIR expression tree (replace each node with an empty tuple node)
     ::MIR::OuterVisitor ov_free(crate, [&](const auto& res, const auto& p, ::HIR::ExprPtr& expr_ptr, const auto& args, const auto& ty){
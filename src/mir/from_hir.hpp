@@ -414,6 +414,8 @@ public:
     void terminate_scope(const Span& sp, ScopeHandle , bool cleanup=true);
     /// Terminates a scope early (e.g. via return/break/...)
     void terminate_scope_early(const Span& sp, const ScopeHandle& , bool loop_exit=false);
+    /// Emit drops for every live value (for a panic unwinding out of the function), leaving their states unchanged
+    void drop_all_for_unwind(const Span& sp);
     /// Marks the end of a split arm (end match arm, if body, ...)
     void end_split_arm(const Span& sp, const ScopeHandle& , bool reachable, bool early=false);
     /// Terminates the current split early (TODO: What does this mean?)
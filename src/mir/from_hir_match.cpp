@@ -12,6 +12,7 @@
 #include <limits>   // std::numeric_limits
 #include <trans/target.hpp>
 #include <hir_conv/main_bindings.hpp>   // For consteval
+#include <parallel.hpp>
 
 void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNode_Match& node, ::MIR::LValue match_val );
 
@@ -333,9 +334,6 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
     // }
     // ```
 
-    // Indicates that an arm has a guard (which prevents most of the match optimisations from working)
-    bool fall_back_on_simple = false;
-
     const auto& match_ty = node.m_value->m_res_type;
     auto result_val = builder.new_temporary( node.m_res_type );
     auto next_block = builder.new_bb_unlinked();
@@ -716,19 +714,8 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
         }
 
         // If there is a guard, then flag
-        if( !arm.m_guards.empty() )
-        {
-            ac.has_condition = true;
-
-            // TODO: What to do with conditionals in the fast model?
-            // > Could split the match on each conditional - separating such that if a conditional fails it can fall into the other compatible branches.
-            // For now: Disable the complex logic, and fall back to a sequence of checks.
-            fall_back_on_simple = true;
-        }
-        else
-        {
-            ac.has_condition = false;
-        }
+        // - The decision tree resumes with the following rules if the guard fails
+        ac.has_condition = !arm.m_guards.empty();
 
         arm_code.push_back( std::move(ac) );
     }
@@ -782,14 +769,13 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
     //  > equal rules cannot be reordered
     //  > Values cannot cross ranges that contain the value
     //  > This will have to be a bubble sort to ensure that it's correctly stable.
-    if( !fall_back_on_simple ) {
-        sort_rulesets(arm_rules);
-        DEBUG("Post-sort");
-        for(const auto& arm_rule : arm_rules)
-        {
-            DEBUG("> (" << arm_rule.arm_idx << ", " << arm_rule.arm_rule_idx << ") - " << arm_rule.m_rules
-                    << (arm_code[arm_rule.arm_idx].has_condition ? " (cond)" : ""));
-        }
+    // NOTE: Guarded rules can be moved too, as only rules that can never both match are swapped.
+    sort_rulesets(arm_rules);
+    DEBUG("Post-sort");
+    for(const auto& arm_rule : arm_rules)
+    {
+        DEBUG("> (" << arm_rule.arm_idx << ", " << arm_rule.arm_rule_idx << ") - " << arm_rule.m_rules
+                << (arm_code[arm_rule.arm_idx].has_condition ? " (cond)" : ""));
     }
     // De-duplicate arms (emitting a warning when it happens)
     // - This allows later code to assume that duplicate arms are a codegen bug.
@@ -815,17 +801,15 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
         }
     }
 
-    // TODO: Combine identical-pattern arms, allowing potential use of condtionals
-    // - 
-    // If there's a conditional that isn't grouped with an unconditional pattern - then force fallback
-
     // TODO: SplitSlice is buggy, make it fall back to simple?
 
     // TODO: Don't generate inner code until decisions are generated (keeps MIR flow nice)
     // - Challenging, as the decision code needs somewhere to jump to.
     // - Allocating a BB and then rewriting references to it is a possibility.
 
-    if( fall_back_on_simple ) {
+    // `MRUSTC_MATCH_SIMPLE` forces the linear (arm-by-arm) lowering, for debugging the decision tree generator
+    static bool force_simple = getenv("MRUSTC_MATCH_SIMPLE") != nullptr;
+    if( force_simple ) {
         MIR_LowerHIR_Match_Simple( builder, conv, node/*.span(), match_ty*/, mv$(match_val), mv$(arm_rules), mv$(arm_code), first_cmp_block );
     }
     else {
@@ -1556,10 +1540,15 @@ void PatternRulesetBuilder::append_from(const Span& sp, const ::HIR::Pattern& pa
             {
                 // Request consteval
                 if( pve->binding->m_value_state == HIR::Constant::ValueState::Unknown ) {
-                    MonomorphState  unused_ms;
-                    const HIR::GenericParams* impl_def = nullptr;
-                    auto v = m_resolve.get_value(sp, pve->path, unused_ms, false, &impl_def);
-                    ConvertHIR_ConstantEvaluate_Constant(m_resolve.m_crate, impl_def, pve->path, const_cast<HIR::Constant&>(*pve->binding));
+                    // Evaluation can lower other bodies, so stop any other workers (`-Z threads`) - and then check
+                    // that one of them didn't evaluate it while this was waiting.
+                    parallel::Exclusive _excl;
+                    if( pve->binding->m_value_state == HIR::Constant::ValueState::Unknown ) {
+                        MonomorphState  unused_ms;
+                        const HIR::GenericParams* impl_def = nullptr;
+                        auto v = m_resolve.get_value(sp, pve->path, unused_ms, false, &impl_def);
+                        ConvertHIR_ConstantEvaluate_Constant(m_resolve.m_crate, impl_def, pve->path, const_cast<HIR::Constant&>(*pve->binding));
+                    }
                 }
                 ASSERT_BUG(sp, pve->binding->m_value_state == HIR::Constant::ValueState::Known, "Match with an unresolved constant - " << pve->path);
                 this->append_from_lit(sp, pve->binding->m_value_res, ty);
@@ -2267,39 +2256,8 @@ namespace {
                     return false;
                 if( be->last < ae->first )
                     return false;
-                // If the starts are the same (always inclusive) then overlap
-                if( ae->first == be->first )
-                    return true;
-
-                //auto check_ends = []( const PatternRule::Data_ValueRange& lo, const PatternRule::Data_ValueRange& hi)->bool {
-                //    return lo.is_inclusive == hi.is_inclusive ? lo.last <= hi.last
-                //        : (lo.is_inclusive
-                //            ? lo.last < hi.last // Lower side is inclusive, higher side exlusive - must be less than higher side
-                //            : throw "TODO" // Lower side is excl, higher side incl - lower+1 < higher = lower < higher-1 = lower
-                //            );
-                //    };
-                ASSERT_BUG(Span(), ae->is_inclusive && be->is_inclusive, "TODO: Handle overlap with exclusive ranges: "
-                    << ae->first << ".." << (ae->is_inclusive ? "=" : "") << ae->last
-                    << " and "
-                    << be->first << ".." << (be->is_inclusive ? "=" : "") << be->last
-                    );
-                assert(ae->is_inclusive && "TODO: Exclusive ranges");
-                assert(be->is_inclusive && "TODO: Exclusive ranges");
-                // Start of B within A
-                if( ae->first <= be->first && is_within_right(be->first, *ae) )
-                    return true;
-                // End of B within A
-                if( is_within_right(ae->first, *be) && be->last <= ae->last ) // TODO: Right-exclusive (if equal type then original check, otherwise complex)
-                    return true;
-                // Start of A within B
-                if( be->first <= ae->first && is_within_right(ae->first, *be) )
-                    return true;
-                // End of A within B
-                if( is_within_right(be->first, *ae) && ae->last <= be->last ) // TODO: Right-exclusive
-                    return true;
-
-                // Disjoint
-                return false;
+                // Both starts are inclusive, so the ranges overlap if each starts before the other ends
+                return is_within_right(be->first, *ae) && is_within_right(ae->first, *be);
             }
             else
             {
@@ -3218,6 +3176,16 @@ public:
     void gen_dispatch_range(const field_path_t& field_path, const ::MIR::Constant& first, const ::MIR::Constant& last, bool is_inclusive, ::MIR::BasicBlockId def_blk);
     void gen_dispatch_splitslice(const field_path_t& field_path, const PatternRule::Data_SplitSlice& e, ::MIR::BasicBlockId def_blk);
 
+    /// A distinct value or range in a bisected dispatch (values are stored as single-element inclusive ranges)
+    struct BisectEntry {
+        const ::MIR::Constant*  first;
+        const ::MIR::Constant*  last;
+        bool    is_inclusive;
+        ::MIR::BasicBlockId target;
+    };
+    bool try_gen_for_ranges(t_rules_subset& arm_rules, size_t& idx, size_t ofs, ::MIR::BasicBlockId default_arm);
+    void gen_dispatch_bisect(const ::MIR::LValue& val, const ::std::vector<BisectEntry>& entries, size_t lo, size_t hi, bool lower_known, ::MIR::BasicBlockId def_blk);
+
     ::MIR::LValue push_compare(::MIR::LValue left, ::MIR::eBinOp op, ::MIR::Param right)
     {
         return m_builder.lvalue_or_temp(sp, ::HIR::CoreType::Bool,
@@ -3364,31 +3332,16 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
 
                 if( ac.has_condition )
                 {
-                    TODO(sp, "Handle conditionals in Grouped");
-                    // TODO: If the condition fails, this should re-try the match on other rules that could have worked.
-                    // - For now, conditionals are disabled.
-
-                    // TODO: What if there's multiple patterns on this condition?
-                    // - For now, only the first pattern gets edited.
-                    // - Maybe clone the blocks used for the condition?
-
-#if 0
-                    // Check for marking in `ac` that the block has already been terminated, assert that target is `next`
-                    if( ap.cond_fail_tgt != 0 )
+                    // If the guard fails, resume with the remaining rules of this group (which were not excluded by
+                    // the checks leading here), and then with the rules after the group (via `default_arm`).
+                    // - Each rule is only reachable from one leaf, so its failure block is only terminated once.
+                    const auto& rc = ac.rules.at(ai.arm_rule);
+                    ASSERT_BUG(sp, rc.cond_false != ~0u, "Arm " << ai.arm << " has a condition, but no failure block");
+                    m_builder.set_cur_block( rc.cond_false );
+                    if( idx+1 == arm_rules.size() )
                     {
-                        ASSERT_BUG(sp, ap.cond_fail_tgt == next, "Condition fail target already set with mismatching arm, set to bb" << ap.cond_fail_tgt << " cur is bb" << next);
+                        m_builder.end_block( ::MIR::Terminator::make_Goto(default_arm) );
                     }
-                    else
-                    {
-                        ap.cond_fail_tgt = next;
-
-                        m_builder.set_cur_block( ap.cond_false );
-                        m_builder.end_block( ::MIR::Terminator::make_Goto(next) );
-                    }
-
-                    if( next != default_arm )
-                        m_builder.set_cur_block(next);
-#endif
                 }
                 else
                 {
@@ -3406,6 +3359,12 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
             idx ++;
         }
 
+        // - Disjoint value/range arms (bisected instead of testing each range in turn)
+        if( this->try_gen_for_ranges(arm_rules, idx, ofs, default_arm) )
+        {
+            continue ;
+        }
+
         // - Value arms
         auto start = idx;
         for(; idx < arm_rules.size() ; idx ++)
@@ -4118,3 +4077,125 @@ void MatchGenGrouped::gen_dispatch_splitslice(const field_path_t& field_path, co
     }
 }
 
+/// Handle a run of integer value/range rules (containing at least one range) that are all either equal or disjoint,
+/// using a binary search on the range starts instead of a linear sequence of range checks.
+///
+/// Returns `false` (without emitting anything) if the rules at `idx` aren't suitable
+bool MatchGenGrouped::try_gen_for_ranges(t_rules_subset& arm_rules, size_t& idx, size_t ofs, ::MIR::BasicBlockId default_arm)
+{
+    // Below this many distinct values/ranges, the existing linear checks are just as good
+    static const size_t MIN_BISECT_ENTRIES = 3;
+
+    auto is_candidate = [&](const PatternRule& r)->bool {
+        if( const auto* e = r.opt_Value() )
+            return e->is_Int() || e->is_Uint();
+        if( const auto* e = r.opt_ValueRange() )
+            return e->first.is_Int() || e->first.is_Uint();
+        return false;
+        };
+    auto start = idx;
+    auto end = idx;
+    bool has_range = false;
+    while( end < arm_rules.size() && arm_rules[end].size() > ofs && is_candidate(arm_rules[end][ofs]) )
+    {
+        // Each new rule must be either equal to or disjoint from all of the preceding ones (so they can be re-ordered)
+        const auto& r = arm_rules[end][ofs];
+        bool ok = true;
+        for(auto i = start; i < end && ok; i ++)
+        {
+            ok = rule_compatible(arm_rules[i][ofs], r) || !rules_overlap(arm_rules[i][ofs], r);
+        }
+        if( !ok )
+            break;
+        has_range |= r.is_ValueRange();
+        end ++;
+    }
+    if( !has_range )
+        return false;
+
+    // Sort into groups of equal rules (all are disjoint, so ordering between groups doesn't matter)
+    arm_rules.sub_sort(ofs, start, end - start);
+    ::std::vector<t_rules_subset>   slices;
+    for(auto i = start; i < end; )
+    {
+        auto j = i+1;
+        while( j < end && rule_compatible(arm_rules[i][ofs], arm_rules[j][ofs]) )
+            j ++;
+        slices.push_back( arm_rules.sub_slice(i, j - i) );
+        i = j;
+    }
+    if( slices.size() < MIN_BISECT_ENTRIES )
+        return false;
+    DEBUG(start << "+" << (end-start) << ": Bisected values/ranges (" << slices.size() << " distinct)");
+
+    bool has_default = (end < arm_rules.size());
+    auto next = (has_default ? m_builder.new_bb_unlinked() : default_arm);
+    auto cur_blk = m_builder.pause_cur_block();
+
+    ::std::vector<BisectEntry>  entries;
+    for(auto& slice : slices)
+    {
+        auto blk = m_builder.new_bb_unlinked();
+        const auto& r = slice[0][ofs];
+        if( const auto* e = r.opt_ValueRange() )
+            entries.push_back(BisectEntry { &e->first, &e->last, e->is_inclusive, blk });
+        else
+            entries.push_back(BisectEntry { &r.as_Value(), &r.as_Value(), true, blk });
+
+        m_builder.set_cur_block(blk);
+        this->gen_for_slice(slice, ofs+1, next);
+    }
+    ::std::sort(entries.begin(), entries.end(), [](const BisectEntry& a, const BisectEntry& b){ return *a.first < *b.first; });
+
+    m_builder.set_cur_block(cur_blk);
+    ::MIR::LValue   val;
+    ::HIR::TypeRef  ty;
+    get_ty_and_val(sp, m_builder, m_top_ty, m_top_val,  arm_rules[start][ofs].field_path, m_field_path_ofs,  ty, val);
+    DEBUG("ty = " << ty << ", val = " << val);
+    this->gen_dispatch_bisect(val, entries, 0, entries.size(), false, next);
+
+    if( has_default )
+    {
+        m_builder.set_cur_block(next);
+    }
+    idx = end;
+    return true;
+}
+/// Emit a binary search over sorted disjoint `entries[lo..hi]`, jumping to the entry's target or `def_blk`
+/// - `lower_known` indicates that `val` is known to be at least the start of `entries[lo]`
+void MatchGenGrouped::gen_dispatch_bisect(const ::MIR::LValue& val, const ::std::vector<BisectEntry>& entries, size_t lo, size_t hi, bool lower_known, ::MIR::BasicBlockId def_blk)
+{
+    assert(lo < hi);
+    if( hi - lo == 1 )
+    {
+        const auto& e = entries[lo];
+        if( e.first == e.last )
+        {
+            push_if_equal(sp, m_builder, val.clone(), ::MIR::Param(e.first->clone()), e.target, def_blk);
+            return ;
+        }
+        if( !lower_known )
+        {
+            auto test_bb_2 = m_builder.new_bb_unlinked();
+            auto cmp_lt_lval = m_builder.get_rval_in_if_cond(sp, ::MIR::RValue::make_BinOp({ ::MIR::Param(val.clone()), ::MIR::eBinOp::LT, ::MIR::Param(e.first->clone()) }));
+            m_builder.end_block( ::MIR::Terminator::make_If({ mv$(cmp_lt_lval), def_blk, test_bb_2 }) );
+            m_builder.set_cur_block(test_bb_2);
+        }
+        auto op = e.is_inclusive ? ::MIR::eBinOp::GT : ::MIR::eBinOp::GE;
+        auto cmp_gt_lval = m_builder.get_rval_in_if_cond(sp, ::MIR::RValue::make_BinOp({ ::MIR::Param(val.clone()), op, ::MIR::Param(e.last->clone()) }));
+        m_builder.end_block( ::MIR::Terminator::make_If({ mv$(cmp_gt_lval), def_blk, e.target }) );
+        return ;
+    }
+
+    // IF `val` < start of the middle entry : search the lower half, otherwise the upper half
+    auto mid = lo + (hi - lo) / 2;
+    auto bb_lower = m_builder.new_bb_unlinked();
+    auto bb_upper = m_builder.new_bb_unlinked();
+    auto cmp_lt_lval = m_builder.get_rval_in_if_cond(sp, ::MIR::RValue::make_BinOp({ ::MIR::Param(val.clone()), ::MIR::eBinOp::LT, ::MIR::Param(entries[mid].first->clone()) }));
+    m_builder.end_block( ::MIR::Terminator::make_If({ mv$(cmp_lt_lval), bb_lower, bb_upper }) );
+
+    m_builder.set_cur_block(bb_lower);
+    this->gen_dispatch_bisect(val, entries, lo, mid, lower_known, def_blk);
+    m_builder.set_cur_block(bb_upper);
+    this->gen_dispatch_bisect(val, entries, mid, hi, true, def_blk);
+}
@@ -0,0 +1,248 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/incremental.cpp
+ * - Incremental compilation cache for optimised MIR (`-C incremental=<dir>`)
+ *
+ * Each item's unoptimised MIR is fingerprinted, and combined with a hash of the crate's interface (everything
+ * except function bodies, but including the `#[inline]`/`#[cold]` markings that control inlining into callers), the
+ * loaded extern crates, and the compiler invocation.
+ * The optimised result is saved along with the fingerprints of every other local item whose MIR was inlined
+ * into it (transitively), and replayed in place of `MIR Optimise` when all of those still match.
+ */
+#include "incremental.hpp"
+#include "main_bindings.hpp"
+#include "mir.hpp"
+#include "operations.hpp"   // MIR_Dump_Fcn
+#include <mir/visit_crate_mir.hpp>
+#include <hir/hir.hpp>
+#include <hir/item_path.hpp>
+#include <hir/main_bindings.hpp>    // HIR_Dump_Interface, HIR_Serialise_Mir
+#include <hir_conv/main_bindings.hpp>   // ConvertHIR_Bind_Mir
+#include <version.hpp>
+#include <sys/stat.h>
+#ifdef _WIN32
+# include <direct.h>   // _mkdir
+#endif
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>   // std::rename
+
+namespace {
+    typedef ::std::vector< ::std::pair< ::std::string, uint64_t> >  deps_t;
+
+    const uint64_t FNV_BASIS = 0xcbf29ce484222325ull;
+    uint64_t fnv1a(uint64_t h, const ::std::string& s)
+    {
+        for(char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    struct State
+    {
+        bool    enabled = false;
+        ::std::string   dir;
+        uint64_t    config_hash = 0;
+        uint64_t    crate_hash = 0;
+
+        /// Unoptimised MIR fingerprint for each item (zero if the item path isn't unique)
+        ::std::map< ::std::string, uint64_t>  fingerprints;
+        /// MIR body to item path, used to identify inlined callees
+        ::std::map<const ::MIR::Function*, ::std::string>    names;
+        /// Dependencies of each item processed so far
+        ::std::map< ::std::string, deps_t>  item_deps;
+
+        ::std::string   cur_item;
+        ::std::map< ::std::string, uint64_t>    cur_deps;
+
+        unsigned    n_reused = 0;
+        unsigned    n_stored = 0;
+    } s_state;
+
+    ::std::string entry_filename(const ::std::string& name, uint64_t fp)
+    {
+        ::std::stringstream ss;
+        ss << ::std::hex << s_state.config_hash << s_state.crate_hash << fp;
+        auto h = fnv1a(fnv1a(FNV_BASIS, ss.str()), name);
+        ::std::stringstream rv;
+        rv << s_state.dir << "/" << ::std::hex << ::std::setw(16) << ::std::setfill('0') << h << ".mir";
+        return rv.str();
+    }
+    bool file_exists(const ::std::string& path)
+    {
+        struct stat s;
+        return stat(path.c_str(), &s) == 0;
+    }
+}
+
+void MIR_Incremental_Init(const ::std::string& dir, const ::std::string& config)
+{
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    if( !file_exists(dir) ) {
+        ::std::cerr << "WARN: Unable to create incremental cache directory '" << dir << "'" << ::std::endl;
+        return ;
+    }
+    s_state.enabled = true;
+    s_state.dir = dir;
+
+    ::std::stringstream ss;
+    ss << Version_GetString() << " " << gsVersion_GitHash << (gbVersion_GitDirty ? "-dirty " : " ") << gsVersion_BuildTime << "\n";
+    ss << config;
+    s_state.config_hash = fnv1a(FNV_BASIS, ss.str());
+}
+bool MIR_Incremental_Enabled()
+{
+    return s_state.enabled;
+}
+
+void MIR_Incremental_BeginCrate(const ::HIR::Crate& crate)
+{
+    TRACE_FUNCTION;
+    // Crate interface, and the identity of all loaded crates (changing a dependency invalidates everything)
+    ::std::stringstream ss;
+    HIR_Dump_Interface(ss, crate);
+    for(const auto& ec : crate.m_ext_crates)
+    {
+        ss << "\nextern " << ec.first << " " << ec.second.m_path;
+        struct stat s;
+        if( stat(ec.second.m_path.c_str(), &s) == 0 ) {
+            ss << " " << s.st_size << " " << s.st_mtime;
+        }
+    }
+    s_state.crate_hash = fnv1a(FNV_BASIS, ss.str());
+    DEBUG("crate_hash = " << ::std::hex << s_state.crate_hash << ::std::dec);
+
+    // Fingerprint all unoptimised bodies (before anything is inlined)
+    ::MIR::OuterVisitor ov { crate, [&](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+        {
+            const auto* mir = expr.get_mir_opt();
+            if( !mir )
+                return ;
+            auto name = FMT(p);
+            ::std::stringstream ss;
+            MIR_Dump_Fcn(ss, *mir);
+            auto fp = fnv1a(FNV_BASIS, ss.str());
+            if( fp == 0 )
+                fp = 1;
+            auto ins = s_state.fingerprints.insert(::std::make_pair(name, fp));
+            if( !ins.second ) {
+                DEBUG("Non-unique item path " << name << ", not caching");
+                ins.first->second = 0;
+            }
+            s_state.names[mir] = mv$(name);
+        }
+        };
+    ov.visit_crate(const_cast< ::HIR::Crate&>(crate));
+}
+
+bool MIR_Incremental_Load(const ::HIR::Crate& crate, const ::HIR::ItemPath& path, ::MIR::Function& fcn)
+{
+    auto name = FMT(path);
+    auto it = s_state.fingerprints.find(name);
+    if( it == s_state.fingerprints.end() || it->second == 0 )
+        return false;
+    auto filename = entry_filename(name, it->second);
+    if( !file_exists(filename) )
+        return false;
+
+    deps_t  deps;
+    ::MIR::FunctionPointer  cached;
+    try
+    {
+        cached = HIR_Deserialise_Mir(filename, deps);
+    }
+    catch(const ::std::runtime_error& e)
+    {
+        DEBUG("Unable to load " << filename << ": " << e.what());
+        return false;
+    }
+    for(const auto& d : deps)
+    {
+        auto dit = s_state.fingerprints.find(d.first);
+        if( dit == s_state.fingerprints.end() || dit->second == 0 || dit->second != d.second ) {
+            DEBUG(name << ": Dependency " << d.first << " changed");
+            return false;
+        }
+    }
+
+    DEBUG("Reusing " << name << " from " << filename);
+    ConvertHIR_Bind_Mir(crate, *cached);
+    fcn = mv$(*cached);
+    s_state.item_deps[name] = mv$(deps);
+    s_state.n_reused += 1;
+    return true;
+}
+
+void MIR_Incremental_BeginItem(const ::HIR::ItemPath& path)
+{
+    s_state.cur_item = FMT(path);
+    s_state.cur_deps.clear();
+}
+void MIR_Incremental_NoteRead(const ::MIR::Function* fcn)
+{
+    if( s_state.cur_item.empty() )
+        return ;
+    auto it = s_state.names.find(fcn);
+    // Not from this crate (covered by the crate hash)
+    if( it == s_state.names.end() )
+        return ;
+    const auto& name = it->second;
+    if( name == s_state.cur_item )
+        return ;
+    s_state.cur_deps[name] = s_state.fingerprints.at(name);
+    // If the callee has already been optimised, then its body includes everything inlined into it
+    auto dit = s_state.item_deps.find(name);
+    if( dit != s_state.item_deps.end() )
+    {
+        for(const auto& d : dit->second)
+            s_state.cur_deps.insert(d);
+    }
+}
+void MIR_Incremental_Store(const ::HIR::ItemPath& path, const ::MIR::Function& fcn)
+{
+    auto name = FMT(path);
+    assert(name == s_state.cur_item);
+    s_state.cur_item.clear();
+
+    deps_t  deps(s_state.cur_deps.begin(), s_state.cur_deps.end());
+    s_state.cur_deps.clear();
+
+    auto fp = s_state.fingerprints.at(name);
+    for(const auto& d : deps)
+    {
+        if( d.second == 0 )
+            fp = 0;
+    }
+    if( fp != 0 )
+    {
+        auto filename = entry_filename(name, fp);
+        // Write to a temporary and rename, so an interrupted build can't leave a truncated entry
+        auto tmp_filename = filename + ".tmp";
+        HIR_Serialise_Mir(tmp_filename, fcn, deps);
+        ::std::remove(filename.c_str());
+        if( ::std::rename(tmp_filename.c_str(), filename.c_str()) != 0 ) {
+            ::std::remove(tmp_filename.c_str());
+        }
+        else {
+            s_state.n_stored += 1;
+        }
+    }
+    s_state.item_deps[name] = mv$(deps);
+}
+
+void MIR_Incremental_EndCrate()
+{
+    ::std::cout << "Incremental: " << s_state.n_reused << " items reused, " << s_state.n_stored << " updated" << ::std::endl;
+    s_state.fingerprints.clear();
+    s_state.names.clear();
+    s_state.item_deps.clear();
+}
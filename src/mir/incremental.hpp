@@ -0,0 +1,32 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/incremental.hpp
+ * - Incremental compilation cache for optimised MIR (`-C incremental=<dir>`)
+ */
+#pragma once
+#include <string>
+
+namespace HIR {
+    class Crate;
+    class ItemPath;
+}
+namespace MIR {
+    class Function;
+}
+
+// NOTE: `MIR_Incremental_Init` is in main_bindings.hpp
+extern bool MIR_Incremental_Enabled();
+
+/// Fingerprint the crate's interface and all (unoptimised) MIR bodies
+extern void MIR_Incremental_BeginCrate(const ::HIR::Crate& crate);
+/// Replace `fcn` with the cached optimised version (if present and still valid)
+extern bool MIR_Incremental_Load(const ::HIR::Crate& crate, const ::HIR::ItemPath& path, ::MIR::Function& fcn);
+/// Start recording the MIR read (i.e. inlined) while optimising `path`
+extern void MIR_Incremental_BeginItem(const ::HIR::ItemPath& path);
+/// Note that the MIR of `fcn` has been used by the item being optimised
+extern void MIR_Incremental_NoteRead(const ::MIR::Function* fcn);
+/// Save the optimised MIR for `path`
+extern void MIR_Incremental_Store(const ::HIR::ItemPath& path, const ::MIR::Function& fcn);
+extern void MIR_Incremental_EndCrate();
@@ -12,6 +12,8 @@
 class TransList;
 
 extern void HIR_GenerateMIR(::HIR::Crate& crate);
+/// Lower panic paths with drops of the live values (for unwinding through landing pads)
+extern void HIR_GenerateMIR_SetUnwindCleanup();
 extern void MIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate);
 extern void MIR_CheckCrate(/*const*/ ::HIR::Crate& crate);
 extern void MIR_CheckCrate_Full(/*const*/ ::HIR::Crate& crate);
@@ -20,6 +22,8 @@ extern void MIR_BorrowCheck_Crate(::HIR::Crate& crate);
 extern void MIR_CleanupCrate(::HIR::Crate& crate);
 extern void MIR_Cleanup_SetPostMonomorph();
 extern void MIR_OptimiseCrate(::HIR::Crate& crate, bool minimal_optimisations);
+/// Enable the incremental cache of optimised MIR (`-C incremental`), `config` identifies the compiler invocation
+extern void MIR_Incremental_Init(const ::std::string& dir, const ::std::string& config);
 extern void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list, bool post_save);
 
 
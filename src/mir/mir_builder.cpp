@@ -704,7 +704,8 @@ MirBuilder::SaveCodeProto MirBuilder::code_save_start()
     TRACE_FUNCTION;
     // Push to the stack
     // Create a new block and link in
-    static size_t s_next_index;
+    // NOTE: Only needs to be unique within a body, and bodies can be lowered in parallel
+    thread_local static size_t s_next_index;
     SaveCodeProto   rv;
     rv.index = s_next_index ++;
     m_code_save_stack.push_back(CodeSaveStackEnt { rv.index, {} });
@@ -2336,6 +2337,21 @@ void MirBuilder::drop_value_from_state(const Span& sp, const VarState& vs, ::MIR
     )
 }
 
+void MirBuilder::drop_all_for_unwind(const Span& sp)
+{
+    TRACE_FUNCTION;
+    // Innermost scope first, same order as `terminate_scope_early`
+    for(auto idx : ::reverse(m_scope_stack))
+    {
+        drop_scope_values(m_scopes.at(idx));
+    }
+    for(size_t i = 0; i < m_arg_states.size(); i ++)
+    {
+        const auto& state = get_slot_state(sp, i, SlotType::Argument);
+        drop_value_from_state(sp, state, ::MIR::LValue::new_Argument(static_cast<unsigned>(i)));
+    }
+}
+
 void MirBuilder::drop_scope_values(const ScopeDef& sd)
 {
     TU_MATCHA( (sd.data), (e),
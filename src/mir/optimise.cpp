@@ -13,6 +13,7 @@
 #include <mir/helpers.hpp>
 #include <mir/operations.hpp>
 #include <mir/visit_crate_mir.hpp>
+#include <mir/incremental.hpp>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
@@ -34,7 +35,19 @@
 // List of optimisations avaliable
 // ----
 bool MIR_Optimise_BlockSimplify(::MIR::TypeResolve& state, ::MIR::Function& fcn);
-bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool minimal, const TransList* list=nullptr);
+/// Limit on how much a single function can grow through inlining (in units of `MIR_Optimise_InlineCost`)
+struct InlineBudget
+{
+    /// Remaining cost that can be inlined into this function
+    int remaining;
+    /// Strongly-connected component of the call graph containing this function (`~0u` if not known)
+    /// - Callees from the same component are never inlined (they're mutually recursive)
+    unsigned scc_index;
+
+    InlineBudget(const ::MIR::Function& fcn, unsigned scc_index=~0u);
+};
+unsigned MIR_Optimise_InlineCost(const ::MIR::Function& fcn);
+bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool minimal, const TransList* list=nullptr, InlineBudget* budget=nullptr);
 bool MIR_Optimise_SplitAggregates(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateKnownValues(::MIR::TypeResolve& state, ::MIR::Function& fcn);
@@ -50,6 +63,12 @@ bool MIR_Optimise_GotoAssign(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_UselessReborrows(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_GarbageCollect_Partial(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_GarbageCollect(::MIR::TypeResolve& state, ::MIR::Function& fcn);
+bool MIR_Optimise_Devirtualise(::MIR::TypeResolve& state, ::MIR::Function& fcn, const TransList& list);
+bool MIR_Optimise_PromoteBoxes(::MIR::TypeResolve& state, ::MIR::Function& fcn);
+::std::vector<bool> MIR_Optimise_PromoteBoxes_Candidates(::MIR::TypeResolve& state, const ::MIR::Function& fcn);
+bool MIR_Optimise_ValueNumbering(::MIR::TypeResolve& state, ::MIR::Function& fcn);
+::HIR::FunctionSummary MIR_Optimise_Summarise(const ::MIR::TypeResolve& state, const ::MIR::Function& fcn);
+bool MIR_Optimise_CallSummariesApply(const ::MIR::TypeResolve& state, const ::MIR::Function& fcn);
 
 enum {
     CHECKMODE_UNKNOWN,
@@ -104,7 +123,8 @@ void MIR_OptimiseMin(const StaticTraitResolve& resolve, const ::HIR::ItemPath& p
     TRACE_FUNCTION_F(path);
     ::MIR::TypeResolve   state { sp, resolve, FMT_CB(ss, ss << path;), ret_type, args, fcn };
 
-    while( MIR_Optimise_Inlining(state, fcn, true) )
+    InlineBudget    inline_budget { fcn };
+    while( MIR_Optimise_Inlining(state, fcn, true, nullptr, &inline_budget) )
     {
         MIR_Cleanup(resolve, path, fcn, args, ret_type);
         //MIR_Dump_Fcn(::std::cout, fcn);
@@ -134,17 +154,25 @@ void MIR_OptimiseMin(const StaticTraitResolve& resolve, const ::HIR::ItemPath& p
     return ;
 }
 /// Perfom inlining only, using a list of monomorphised functions, then cleans up the flow graph
+/// - `scc_index` is the function's call graph component (see `MIR_OptimiseCrate_Inlining`)
 ///
 /// Returns true if any optimisation was performed
-bool MIR_OptimiseInline(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, ::MIR::Function& fcn, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type, const TransList& list)
+bool MIR_OptimiseInline(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, ::MIR::Function& fcn, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type, const TransList& list, unsigned scc_index)
 {
     static Span sp;
     bool rv = false;
     TRACE_FUNCTION_FR(path, rv);
     ::MIR::TypeResolve   state { sp, resolve, FMT_CB(ss, ss << path;), ret_type, args, fcn };
 
-    while( MIR_Optimise_Inlining(state, fcn, false, &list) )
+    InlineBudget    inline_budget { fcn, scc_index };
+    // Devirtualised calls are candidates for inlining, and inlining can expose where trait objects were created
+    for(;;)
     {
+        bool changed = MIR_Optimise_Devirtualise(state, fcn, list);
+        changed |= MIR_Optimise_PromoteBoxes(state, fcn);
+        changed |= MIR_Optimise_Inlining(state, fcn, false, &list, &inline_budget);
+        if( !changed )
+            break;
         MIR_Cleanup(resolve, path, fcn, args, ret_type);
         if( check_after_all() ) {
             MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -152,7 +180,8 @@ bool MIR_OptimiseInline(const StaticTraitResolve& resolve, const ::HIR::ItemPath
         rv = true;
     }
 
-    if( rv )
+    // Also re-optimise if summaries of the callees allow calls to be simplified
+    if( rv || MIR_Optimise_CallSummariesApply(state, fcn) )
     {
         MIR_Optimise(resolve, path, fcn, args, ret_type, /*do_inline=*/false);
     }
@@ -163,8 +192,10 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
 {
     static Span sp;
     TRACE_FUNCTION_F(path);
+    TRACE_SPAN_F("MIR_Optimise", path);
     ::MIR::TypeResolve   state { sp, resolve, FMT_CB(ss, ss << path;), ret_type, args, fcn };
 
+    InlineBudget    inline_budget { fcn };
     bool change_happened;
     unsigned int pass_num = 0;
     do
@@ -265,6 +296,18 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         }
         //else { MIR_Validate(resolve, path, fcn, args, ret_type); }
 
+        // >> Eliminate redundant expressions/loads across blocks, and hoist loop invariants
+        if( MIR_Optimise_ValueNumbering(state, fcn) )
+        {
+#if DUMP_AFTER_ALL
+            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+#endif
+            if( check_after_all() ) {
+                MIR_Validate(resolve, path, fcn, args, ret_type);
+            }
+            change_happened = true;
+        }
+
         // >> Move common statements (assignments) across gotos.
         //if( MIR_Optimise_CommonStatements(state, fcn) )
         //{
@@ -346,7 +389,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         // >> Inline short functions
         if( do_inline && !change_happened )
         {
-            if( MIR_Optimise_Inlining(state, fcn, /*minimal=*/false) )
+            if( MIR_Optimise_Inlining(state, fcn, /*minimal=*/false, nullptr, &inline_budget) )
             {
                 // Apply cleanup again (as monomorpisation in inlining may have exposed a vtable call)
                 MIR_Cleanup(resolve, path, fcn, args, ret_type);
@@ -694,6 +737,10 @@ namespace
         const ::HIR::TypeRef*   self_ty;
         const ::HIR::GenericParams* impl_params_def;
         const ::HIR::GenericParams* fcn_params_def;
+        /// Definition of the called function (for `#[inline]` markings)
+        const ::HIR::Function*  fcn_def;
+        /// Call graph component of the called function (only known when a `TransList` is used)
+        unsigned    scc_index;
 
 
         ::HIR::PathParams   fcn_params_tmp;
@@ -702,6 +749,8 @@ namespace
             , self_ty(nullptr)
             , impl_params_def(nullptr)
             , fcn_params_def(nullptr)
+            , fcn_def(nullptr)
+            , scc_index(~0u)
         {}
 
         const ::HIR::TypeRef* get_self_type() const override {
@@ -746,6 +795,8 @@ namespace
             DEBUG("fcn_params = " << *params.fcn_params);
 
             const auto& hir_fcn = *it->second->ptr;
+            params.fcn_def = &hir_fcn;
+            params.scc_index = it->second->scc_index;
             if( it->second->monomorphised.code ) {
                 //DEBUG("Found monomorphised - PP=" << params.impl_params << "," << *params.fcn_params);
                 return &*it->second->monomorphised.code;
@@ -790,7 +841,12 @@ namespace
             }
         TU_ARMA(Function, f) {
             params.fcn_params_def = &f->m_params;
-            return f->m_code.get_mir_opt();
+            params.fcn_def = f;
+            const auto* rv = f->m_code.get_mir_opt();
+            if( rv ) {
+                MIR_Incremental_NoteRead(rv);
+            }
+            return rv;
             }
         }
         return nullptr;
@@ -875,6 +931,55 @@ namespace
         }
         throw std::runtime_error("Corrupted MIR::Param");
     }
+
+    /// Intrinsics with no side-effects that always return (so can be removed if their result isn't used)
+    bool intrinsic_is_pure(const RcString& name)
+    {
+        static const char* const PURE_INTRINSICS[] = {
+            "size_of", "size_of_val", "min_align_of", "min_align_of_val", "pref_align_of", "align_of",
+            "needs_drop", "type_id", "type_name", "discriminant_value",
+            "transmute", "forget", "likely", "unlikely", "mrustc_slice_len",
+            "offset", "arith_offset",
+            "add_with_overflow", "sub_with_overflow", "mul_with_overflow",
+            "overflowing_add", "overflowing_sub", "overflowing_mul",
+            "wrapping_add", "wrapping_sub", "wrapping_mul",
+            "saturating_add", "saturating_sub",
+            "unchecked_add", "unchecked_sub", "unchecked_mul", "unchecked_div", "unchecked_rem", "unchecked_shl", "unchecked_shr",
+            "exact_div", "rotate_left", "rotate_right",
+            "ctpop", "ctlz", "ctlz_nonzero", "cttz", "cttz_nonzero", "bswap", "bitreverse",
+            "sqrtf32", "sqrtf64", "fabsf32", "fabsf64", "floorf32", "floorf64", "ceilf32", "ceilf64",
+            "truncf32", "truncf64", "copysignf32", "copysignf64",
+            };
+        for(const char* n : PURE_INTRINSICS)
+            if( name == n )
+                return true;
+        return false;
+    }
+    /// Intrinsics that can't unwind (i.e. ones that don't call back into rust code, or that catch panics)
+    bool intrinsic_is_no_unwind(const RcString& name)
+    {
+        static const char* const NO_UNWIND_INTRINSICS[] = {
+            "abort", "unreachable", "assume", "breakpoint", "try", "catch_unwind",
+            "copy", "copy_nonoverlapping", "write_bytes", "move_val_init", "init", "uninit",
+            "volatile_load", "volatile_store", "unaligned_volatile_load", "unaligned_volatile_store",
+            "volatile_copy_memory", "volatile_copy_nonoverlapping_memory", "volatile_set_memory",
+            };
+        if( intrinsic_is_pure(name) )
+            return true;
+        if( strncmp(name.c_str(), "atomic_", 7) == 0 )
+            return true;
+        for(const char* n : NO_UNWIND_INTRINSICS)
+            if( name == n )
+                return true;
+        return false;
+    }
+    /// Summary of the function called by a `Call` terminator (see `MIR_OptimiseCrate_Inlining`), null if not known
+    const ::HIR::FunctionSummary* get_call_summary(const ::MIR::TypeResolve& state, const ::MIR::Terminator::Data_Call& te)
+    {
+        if( !te.fcn.is_Path() )
+            return nullptr;
+        return state.m_crate.get_function_summary(te.fcn.as_Path());
+    }
 } // namespace ""
 
 
@@ -1055,9 +1160,113 @@ bool MIR_Optimise_BlockSimplify(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 
 
 // --------------------------------------------------------------------
-// If two temporaries don't overlap in lifetime (blocks in which they're valid), unify the two
+// Replace calls with a copy of the called function's body, if the cost model allows
 // --------------------------------------------------------------------
-bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool minimal, const TransList* list/*=nullptr*/)
+namespace {
+    unsigned inline_cost(const ::MIR::Param& p) {
+        return p.is_Constant() ? 0 : 1;
+    }
+    unsigned inline_cost(const ::std::vector<::MIR::Param>& vals) {
+        unsigned rv = 0;
+        for(const auto& p : vals)
+            rv += inline_cost(p);
+        return rv;
+    }
+    unsigned inline_cost(const ::MIR::Statement& stmt)
+    {
+        TU_MATCH_HDRA( (stmt), {)
+        TU_ARMA(Assign, se) {
+            TU_MATCH_HDRA( (se.src), {)
+            default:
+                return 1;
+            TU_ARMA(Tuple, re)       { return 1 + inline_cost(re.vals) / 2; }
+            TU_ARMA(Array, re)       { return 1 + inline_cost(re.vals) / 2; }
+            TU_ARMA(EnumVariant, re) { return 1 + inline_cost(re.vals) / 2; }
+            TU_ARMA(Struct, re)      { return 1 + inline_cost(re.vals) / 2; }
+            }
+            }
+        TU_ARMA(Asm, se) {
+            return 10;
+            }
+        TU_ARMA(Asm2, se) {
+            return 10;
+            }
+        TU_ARMA(SetDropFlag, se) {
+            return 0;
+            }
+        TU_ARMA(SaveDropFlag, se) {
+            return 1;
+            }
+        TU_ARMA(LoadDropFlag, se) {
+            return 1;
+            }
+        TU_ARMA(Drop, se) {
+            return 3;
+            }
+        TU_ARMA(ScopeEnd, se) {
+            return 0;
+            }
+        }
+        throw "";
+    }
+    unsigned inline_cost(const ::MIR::Terminator& term)
+    {
+        TU_MATCH_HDRA( (term), {)
+        TU_ARMA(Incomplete, te) {
+            return 0;
+            }
+        TU_ARMA(Return, te) {
+            return 0;
+            }
+        TU_ARMA(Diverge, te) {
+            return 0;
+            }
+        TU_ARMA(Goto, te) {
+            return 0;
+            }
+        TU_ARMA(Panic, te) {
+            return 0;
+            }
+        TU_ARMA(If, te) {
+            return 1;
+            }
+        TU_ARMA(Switch, te) {
+            return 1 + te.targets.size() / 2;
+            }
+        TU_ARMA(SwitchValue, te) {
+            return 1 + te.targets.size() / 2;
+            }
+        TU_ARMA(Call, te) {
+            // Intrinsics are (mostly) single operations, anything else is a full call with argument setup
+            if( te.fcn.is_Intrinsic() )
+                return 1 + inline_cost(te.args) / 2;
+            return 5 + inline_cost(te.args);
+            }
+        }
+        throw "";
+    }
+}
+/// Approximate size of a function's body once emitted, used by the inliner.
+/// - Roughly one unit per simple operation, with calls/drops/asm weighted higher and drop flag updates free.
+unsigned MIR_Optimise_InlineCost(const ::MIR::Function& fcn)
+{
+    unsigned rv = 0;
+    for(const auto& bb : fcn.blocks)
+    {
+        for(const auto& stmt : bb.statements)
+            rv += inline_cost(stmt);
+        rv += inline_cost(bb.terminator);
+    }
+    return rv;
+}
+InlineBudget::InlineBudget(const ::MIR::Function& fcn, unsigned scc_index)
+    // A function can double in size, or grow by a fixed amount if it is small
+    : remaining( static_cast<int>(::std::max(MIR_Optimise_InlineCost(fcn), 100u)) )
+    , scc_index(scc_index)
+{
+}
+
+bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool minimal, const TransList* list/*=nullptr*/, InlineBudget* budget/*=nullptr*/)
 {
     bool inline_happened = false;
     TRACE_FUNCTION_FR("", inline_happened);
@@ -1152,64 +1361,96 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                 return val.is_Constant() && !val.as_Constant().is_Const();
             }
         }
-        static bool can_inline(const ::HIR::Path& path, const ::MIR::Function& fcn, const std::vector<::MIR::Param>& params, bool minimal)
+        /// Returns true if the function directly calls itself
+        /// - NOTE: Without a `TransList` this is comparing the pre-monomorph paths in `fcn` with the post-monomorph `path`
+        static bool calls_self(const ::HIR::Path& path, const ::MIR::Function& fcn)
         {
-            // TODO: If the function is marked as `inline(always)`, then inline it regardless of the contents
-            // TODO: If the function is marked as `inline(never)`, then don't inline
-            // TODO: Take a monomorph helper so recursion can be detected
-
-            if( minimal ) {
+            for(const auto& bb : fcn.blocks)
+            {
+                if( const auto* te = bb.terminator.opt_Call() )
+                {
+                    if( te->fcn.is_Path() && te->fcn.as_Path() == path )
+                        return true;
+                }
+            }
+            return false;
+        }
+        /// Determine if `fcn` should be inlined into the caller, and the cost (in units of `MIR_Optimise_InlineCost`)
+        /// that will be charged against the caller's budget.
+        static bool can_inline(const ::HIR::Path& path, const ::HIR::Function* fcn_def, const ::MIR::Function& fcn, const std::vector<::MIR::Param>& params, bool minimal, const InlineBudget* budget, unsigned& out_cost)
+        {
+            // Base cost of a function without an `#[inline]` hint that will be inlined
+            const unsigned THRESHOLD_AUTO = 20;
+            // Base cost of a function with `#[inline]` that will be inlined
+            const unsigned THRESHOLD_HINT = 60;
+
+            auto inline_type = fcn_def ? fcn_def->m_markings.inline_type : ::HIR::Function::Markings::Inline::Auto;
+            if( inline_type == ::HIR::Function::Markings::Inline::Never ) {
+                DEBUG("#[inline(never)]");
+                return false;
+            }
+            // Detect and avoid simple recursion.
+            // - Mutual recursion is detected using the call graph (with a `TransList`), or by the inline stack in the caller
+            if( calls_self(path, fcn) ) {
+                DEBUG("Recursive");
                 return false;
             }
 
-
-            // TODO: Allow functions that are just a switch on an input.
-            if( fcn.blocks.size() == 1 )
+            unsigned cost = MIR_Optimise_InlineCost(fcn);
+            if( inline_type == ::HIR::Function::Markings::Inline::Always )
             {
-                return fcn.blocks[0].statements.size() < 10 && ! fcn.blocks[0].terminator.is_Goto();
+                // `#[inline(always)]` ignores the size, but is still limited by the budget (which guarantees termination
+                // if there is recursion that wasn't otherwise detected)
+                out_cost = cost;
+                return !budget || budget->remaining > 0;
             }
-            else if( fcn.blocks.size() == 2 && fcn.blocks[0].terminator.is_Call() )
-            {
-                const auto& blk0_te = fcn.blocks[0].terminator.as_Call();
-                if( !fcn.blocks[1].terminator.is_Diverge() )
-                    return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() > 10 )
-                    return false;
-                // Detect and avoid simple recursion.
-                // - This won't detect mutual recursion - that also needs prevention.
-                // TODO: This is the pre-monomorph path, but we're comparing with the post-monomorph path
-                if( blk0_te.fcn.is_Path() && blk0_te.fcn.as_Path() == path )
-                    return false;
-                return true;
+            if( minimal ) {
+                return false;
             }
-            else if( fcn.blocks.size() == 3 && fcn.blocks[0].terminator.is_Call() )
+
+            // Wrappers around a switch on a constant - only one arm will remain after const propagation
+            if( can_inline_Switch_wrapper(path, fcn, params) || can_inline_SwitchValue_wrapper(path, fcn, params) )
             {
-                const auto& blk0_te = fcn.blocks[0].terminator.as_Call();
-                if( !(fcn.blocks[1].terminator.is_Diverge() || fcn.blocks[1].terminator.is_Return()) )
-                    return false;
-                if( !(fcn.blocks[2].terminator.is_Diverge() || fcn.blocks[2].terminator.is_Return()) )
-                    return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > 10 )
-                    return false;
-                // Detect and avoid simple recursion.
-                // - This won't detect mutual recursion - that also needs prevention.
-                // TODO: This is the pre-monomorph path, but we're comparing with the post-monomorph path
-                if( blk0_te.fcn.is_Path() && blk0_te.fcn.as_Path() == path )
-                    return false;
-                return true;
+                cost = ::std::min(cost, THRESHOLD_AUTO);
             }
             else
             {
-            }
+                // If the entry block branches on a constant value, then most of the function will be removed.
+                const auto& entry = fcn.blocks[0];
+                const ::MIR::LValue* branch_val = nullptr;
+                TU_MATCH_HDRA( (entry.terminator), {)
+                default:
+                    break;
+                TU_ARMA(If, te)          { branch_val = &te.cond; }
+                TU_ARMA(Switch, te)      { branch_val = &te.val; }
+                TU_ARMA(SwitchValue, te) { branch_val = &te.val; }
+                }
+                if( branch_val && value_is_const(fcn, 0, entry.statements.size(), *branch_val, params) )
+                {
+                    DEBUG("Entry branch is on a constant");
+                    cost /= 2;
+                }
+                // Each constant argument is likely to allow some folding
+                for(const auto& p : params)
+                {
+                    if( p.is_Constant() && !p.as_Constant().is_Const() )
+                        cost -= ::std::min(cost, 2u);
+                }
+                cost = ::std::max(cost, 1u);
 
-            // TODO: If all inputs are known, then allow larger/complex functions (e.g. allow one call and any number of blocks?)
-            // - Seen `min_by(const, const, fcn)` - that would be a trivial optimisation
+                unsigned threshold = (inline_type == ::HIR::Function::Markings::Inline::Normal ? THRESHOLD_HINT : THRESHOLD_AUTO);
+                if( cost > threshold ) {
+                    DEBUG("Too expensive: " << cost << " > " << threshold);
+                    return false;
+                }
+            }
 
-            if( can_inline_Switch_wrapper(path, fcn, params) )
-                return true;
-            if( can_inline_SwitchValue_wrapper(path, fcn, params) )
-                return true;
-            return false;
+            if( budget && static_cast<int>(cost) > budget->remaining ) {
+                DEBUG("Over budget: " << cost << " > " << budget->remaining);
+                return false;
+            }
+            out_cost = cost;
+            return true;
         }
 
         /// Case: A Switch that has all distinct arms that just call a function AND the value is over (effectively) a literal
@@ -1402,6 +1643,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
         }
     };
 
+    const auto box_candidates = MIR_Optimise_PromoteBoxes_Candidates(state, fcn);
     for(unsigned int i = 0; i < fcn.blocks.size(); i ++)
     {
         state.set_cur_stmt_term(i);
@@ -1412,12 +1654,19 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             const auto& path = te->fcn.as_Path();
             DEBUG(state << fcn.blocks[i].terminator);
 
-            for(const auto& e : inlined_functions)
+            // Check if this call came from an inlined copy of the same function (mutual recursion)
+            if( ::std::any_of(inlined_functions.begin(), inlined_functions.end(), [&](const InlineEvent& e){ return path == e.path && e.has_bb(i); }) )
             {
-                if( path == e.path && e.has_bb(i) )
-                {
-                    MIR_BUG(state, "Recursive inline of " << path);
-                }
+                DEBUG("Can't inline - recursion via inlined code");
+                continue ;
+            }
+
+            // Keep promotable allocations out of line, so `MIR_Optimise_PromoteBoxes` can find them once the box's users have been inlined
+            // - Blocks added by this pass haven't been checked yet, so are left for the next pass
+            if( (i >= box_candidates.size() || box_candidates[i]) && path.m_data.is_Generic() && path.m_data.as_Generic().m_path == state.m_crate.get_lang_item_path_opt("exchange_malloc") )
+            {
+                DEBUG("Can't inline - allocation that may be promoted");
+                continue ;
             }
 
             Cloner  cloner { state.sp, state.m_resolve, *te };
@@ -1429,17 +1678,23 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                 DEBUG("Can't inline - recursion");
                 continue ;
             }
+            if( budget && cloner.params.scc_index != ~0u && cloner.params.scc_index == budget->scc_index )
+            {
+                DEBUG("Can't inline - recursion (same call graph component)");
+                continue ;
+            }
 
-            // Check the size of the target function.
-            // Inline IF:
-            // - First BB ends with a call and total count is 3
-            // - Statement count smaller than 10
-            if( ! H::can_inline(path, *called_mir, te->args, minimal) )
+            // Check the cost of the target function against the caller's budget
+            unsigned cost = 0;
+            if( ! H::can_inline(path, cloner.params.fcn_def, *called_mir, te->args, minimal, budget, cost) )
             {
                 DEBUG("Can't inline " << path);
                 continue ;
             }
-            TRACE_FUNCTION_F("Inline " << path);
+            TRACE_FUNCTION_F("Inline " << path << " (cost " << cost << ")");
+            if( budget ) {
+                budget->remaining -= static_cast<int>(cost);
+            }
 
             // Allocate a temporary for the return value
             {
@@ -1516,10 +1771,6 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             }
             fcn.blocks[i].terminator = ::MIR::Terminator::make_Goto( cloner.bb_base );
             inline_happened = true;
-
-            // TODO: Store the inlined path along with the start and end BBs, and then use that to detect recursive
-            // inlining
-            // - Recursive inlining should be an immediate panic.
         }
     }
     return inline_happened;
@@ -1602,10 +1853,19 @@ namespace {
                 {
                     // Check the panic arm (should just be a list of destructor calls follwed by a Diverge terminator)
                     const auto& panic_bb = fcn.blocks[te->panic_block];
-                    ASSERT_BUG(Span(), panic_bb.terminator.is_Diverge(), "Panic arm of call does not end with Diverge");
-                    if( !panic_bb.statements.empty() )
+                    if( !panic_bb.terminator.is_Diverge() )
+                    {
+                        // Cleanup spread over several blocks (`-C landing-pads`, after block merging)
+                        DEBUG("> Panic arm abort");
+                        return IterPathRes::Abort;
+                    }
+                    for(unsigned i = 0; i < panic_bb.statements.size(); i ++)
                     {
-                        TODO(Span(), "Visit call panic block");
+                        if( cb_stmt(StmtRef(te->panic_block, i), panic_bb.statements[i]) )
+                        {
+                            DEBUG("> Early true (panic arm)");
+                            return IterPathRes::EarlyTrue;
+                        }
                     }
                     // Possibly loop into the next block
                     if( !visted_bbs.insert(te->ret_block).second ) {
@@ -3169,7 +3429,41 @@ bool MIR_Optimise_ConstPropagate(::MIR::TypeResolve& state, ::MIR::Function& fcn
     bool changed = false;
     TRACE_FUNCTION_FR("", changed);
 
+    // - Calls to functions that can't unwind don't need a cleanup path (the old path is removed by garbage collection)
+    {
+        auto is_diverge_only = [](const ::MIR::BasicBlock& bb) {
+            return bb.statements.empty() && bb.terminator.is_Diverge();
+            };
+        ::MIR::BasicBlockId diverge_bb = ~0u;
+        for(size_t i = 0; i < fcn.blocks.size(); i ++)
+        {
+            const auto* te = fcn.blocks[i].terminator.opt_Call();
+            if( !te || is_diverge_only(fcn.blocks[te->panic_block]) )
+                continue ;
+            const auto* summary = get_call_summary(state, *te);
+            bool no_unwind = te->fcn.is_Intrinsic() ? intrinsic_is_no_unwind(te->fcn.as_Intrinsic().name) : (summary && summary->no_unwind);
+            if( !no_unwind )
+                continue ;
+            if( diverge_bb == ~0u )
+            {
+                auto it = ::std::find_if(fcn.blocks.begin(), fcn.blocks.end(), is_diverge_only);
+                if( it != fcn.blocks.end() ) {
+                    diverge_bb = it - fcn.blocks.begin();
+                }
+                else {
+                    diverge_bb = fcn.blocks.size();
+                    fcn.blocks.push_back(::MIR::BasicBlock { {}, ::MIR::Terminator::make_Diverge({}) });
+                }
+            }
+            state.set_cur_stmt_term(i);
+            DEBUG(state << "Callee can't unwind, removing cleanup path bb" << fcn.blocks[i].terminator.as_Call().panic_block);
+            fcn.blocks[i].terminator.as_Call().panic_block = diverge_bb;
+            changed = true;
+        }
+    }
+
     // - Remove calls to `size_of` and `align_of` (replace with value if known)
+    // - Replace calls to pure functions with a known return value (see `MIR_OptimiseCrate_Inlining`)
     for(auto& bb : fcn.blocks)
     {
         state.set_cur_stmt_term(bb);
@@ -3177,6 +3471,45 @@ bool MIR_Optimise_ConstPropagate(::MIR::TypeResolve& state, ::MIR::Function& fcn
         if( !bb.terminator.is_Call() )
             continue ;
         auto& te = bb.terminator.as_Call();
+        if( const auto* summary = get_call_summary(state, te) )
+        {
+            if( !summary->is_pure )
+                continue ;
+            if( summary->has_const_return )
+            {
+                ::MIR::Constant val;
+                switch(summary->const_return_ty)
+                {
+                case ::HIR::CoreType::Bool:
+                    val = ::MIR::Constant::make_Bool({ summary->const_return_val != U128(0) });
+                    break;
+                case ::HIR::CoreType::I8:
+                case ::HIR::CoreType::I16:
+                case ::HIR::CoreType::I32:
+                case ::HIR::CoreType::I64:
+                case ::HIR::CoreType::I128:
+                case ::HIR::CoreType::Isize:
+                    val = ::MIR::Constant::make_Int({ S128(summary->const_return_val), summary->const_return_ty });
+                    break;
+                default:
+                    val = ::MIR::Constant::make_Uint({ summary->const_return_val, summary->const_return_ty });
+                    break;
+                }
+                DEBUG(state << "Pure call always returns " << val);
+                bb.statements.push_back(::MIR::Statement::make_Assign({ mv$(te.ret_val), mv$(val) }));
+                bb.terminator = ::MIR::Terminator::make_Goto(te.ret_block);
+                changed = true;
+            }
+            else if( summary->returns_arg < te.args.size() )
+            {
+                DEBUG(state << "Pure call always returns argument " << summary->returns_arg);
+                auto val = param_to_rvalue(mv$(te.args[summary->returns_arg]));
+                bb.statements.push_back(::MIR::Statement::make_Assign({ mv$(te.ret_val), mv$(val) }));
+                bb.terminator = ::MIR::Terminator::make_Goto(te.ret_block);
+                changed = true;
+            }
+            continue ;
+        }
         if( !te.fcn.is_Intrinsic() )
             continue ;
         const auto& tef = te.fcn.as_Intrinsic();
@@ -5149,1090 +5482,2916 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
 }
 
 // ----------------------------------------
-// Clear all drop flags that are never read
+// Dominator-scoped value numbering
+// - Re-computations of pure expressions (and loads from unborrowed locals, or through `&T` where `T: Freeze`) are
+//   replaced with a copy of an earlier result that dominates them.
+// - Comparisons already decided by a dominating `If` (e.g. repeated bounds checks) become constants.
+// - Pure non-trapping expressions that are invariant in a loop are hoisted into a preheader.
+//
+// Locals aren't in SSA form, so values are named by `local@version` instead, with the version bumped on every
+// write (and at join points for locals that might have been written on another path).
 // ----------------------------------------
-bool MIR_Optimise_DeadDropFlags(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+bool MIR_Optimise_ValueNumbering(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 {
-    bool removed_statement = false;
-    TRACE_FUNCTION_FR("", removed_statement);
-    ::std::vector<bool> used_drop_flags( fcn.drop_flags.size() );
+    TRACE_FUNCTION;
+    bool changed = false;
+    bool cfg_changed = false;
+    const size_t n_bbs = fcn.blocks.size();
+    const size_t n_locals = fcn.locals.size();
+
+    // --- Control flow graph and dominator tree ---
+    ::std::vector< ::std::vector<unsigned> >  preds(n_bbs);
+    ::std::vector< ::std::vector<unsigned> >  succs(n_bbs);
+    for(unsigned bb = 0; bb < n_bbs; bb ++)
     {
-        ::std::vector<bool> read_drop_flags( fcn.drop_flags.size() );
-        visit_blocks(state, fcn, [&read_drop_flags,&used_drop_flags](auto , const ::MIR::BasicBlock& block) {
-                for(const auto& stmt : block.statements)
-                {
-                    if( const auto* e = stmt.opt_SetDropFlag() )
-                    {
-                        if(e->other != ~0u) {
-                            read_drop_flags[e->other] = true;
-                            used_drop_flags[e->other] = true;
-                        }
-                        used_drop_flags[e->idx] = true;
-                    }
-                    else if( const auto* e = stmt.opt_Drop() )
-                    {
-                        if(e->flag_idx != ~0u) {
-                            read_drop_flags[e->flag_idx] = true;
-                            used_drop_flags[e->flag_idx] = true;
-                        }
-                    }
-                    else if( const auto* e = stmt.opt_SaveDropFlag() )
-                    {
-                        read_drop_flags[e->idx] = true;
-                        used_drop_flags[e->idx] = true;
-                    }
-                    else if( const auto* e = stmt.opt_LoadDropFlag() )
-                    {
-                        used_drop_flags[e->idx] = true;
-                    }
+        visit_terminator_target(fcn.blocks[bb].terminator, [&](const ::MIR::BasicBlockId& dst) {
+            if( ::std::find(succs[bb].begin(), succs[bb].end(), dst) == succs[bb].end() ) {
+                succs[bb].push_back(dst);
+                preds[dst].push_back(bb);
+            }
+            });
+    }
+    // Reverse post-order (unreachable blocks are excluded)
+    ::std::vector<unsigned> rpo;
+    ::std::vector<unsigned> rpo_idx(n_bbs, ~0u);
+    {
+        ::std::vector<bool> visited(n_bbs);
+        ::std::vector< ::std::pair<unsigned,size_t> >   stack;
+        visited[0] = true;
+        stack.push_back(::std::make_pair(0u, size_t(0)));
+        while( !stack.empty() )
+        {
+            auto& top = stack.back();
+            if( top.second < succs[top.first].size() )
+            {
+                auto next = succs[top.first][top.second++];
+                if( !visited[next] ) {
+                    visited[next] = true;
+                    stack.push_back(::std::make_pair(next, size_t(0)));
                 }
-                });
-        DEBUG("Un-read drop flags:" << FMT_CB(ss,
-            for(size_t i = 0; i < read_drop_flags.size(); i ++)
-                if( ! read_drop_flags[i] && used_drop_flags[i] )
-                    ss << " " << i;
-            ));
-        visit_blocks_mut(state, fcn, [&read_drop_flags,&removed_statement](auto _id, auto& block) {
-                for(auto it = block.statements.begin(); it != block.statements.end(); )
+            }
+            else
+            {
+                rpo.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+        ::std::reverse(rpo.begin(), rpo.end());
+        for(size_t i = 0; i < rpo.size(); i ++)
+            rpo_idx[rpo[i]] = i;
+    }
+    // Immediate dominators (Cooper, Harvey & Kennedy)
+    ::std::vector<unsigned> idom(n_bbs, ~0u);
+    idom[0] = 0;
+    for(bool updated = true; updated; )
+    {
+        updated = false;
+        for(size_t i = 1; i < rpo.size(); i ++)
+        {
+            unsigned bb = rpo[i];
+            unsigned new_idom = ~0u;
+            for(auto p : preds[bb])
+            {
+                if( idom[p] == ~0u )
+                    continue;
+                if( new_idom == ~0u ) {
+                    new_idom = p;
+                    continue;
+                }
+                unsigned a = p, b = new_idom;
+                while( a != b )
                 {
-                    if(it->is_SetDropFlag() && ! read_drop_flags[it->as_SetDropFlag().idx] ) {
-                        removed_statement = true;
-                        it = block.statements.erase(it);
-                    }
-                    else if( it->is_LoadDropFlag() && ! read_drop_flags[it->as_LoadDropFlag().idx] ) {
-                        removed_statement = true;
-                        it = block.statements.erase(it);
-                    }
-                    else {
-                        ++ it;
-                    }
+                    while( rpo_idx[a] > rpo_idx[b] )    a = idom[a];
+                    while( rpo_idx[b] > rpo_idx[a] )    b = idom[b];
                 }
-                });
+                new_idom = a;
+            }
+            if( new_idom != idom[bb] ) {
+                idom[bb] = new_idom;
+                updated = true;
+            }
+        }
     }
-
-    // Find any drop flags that are never assigned with a value other than their default, then remove those dead assignments.
+    ::std::vector< ::std::vector<unsigned> >  dom_children(n_bbs);
+    for(size_t i = 1; i < rpo.size(); i ++)
+        dom_children[idom[rpo[i]]].push_back(rpo[i]);
+    // Pre/post numbering of the dominator tree, for constant-time dominance checks
+    ::std::vector<unsigned> dom_pre(n_bbs, ~0u);
+    ::std::vector<unsigned> dom_post(n_bbs, 0);
     {
-        ::std::vector<bool> edited_drop_flags( fcn.drop_flags.size() );
-        visit_blocks(state, fcn, [&edited_drop_flags,&fcn](auto , const ::MIR::BasicBlock& block) {
-                for(const auto& stmt : block.statements)
-                {
-                    if( const auto* e = stmt.opt_SetDropFlag() )
-                    {
-                        if(e->other != ~0u) {
-                            // If the drop flag is set based on another, assume it's changed
-                            edited_drop_flags[e->idx] = true;
+        unsigned counter = 0;
+        ::std::vector< ::std::pair<unsigned,size_t> >   stack;
+        dom_pre[0] = counter++;
+        stack.push_back(::std::make_pair(0u, size_t(0)));
+        while( !stack.empty() )
+        {
+            auto& top = stack.back();
+            if( top.second < dom_children[top.first].size() )
+            {
+                auto c = dom_children[top.first][top.second++];
+                dom_pre[c] = counter++;
+                stack.push_back(::std::make_pair(c, size_t(0)));
+            }
+            else
+            {
+                dom_post[top.first] = counter++;
+                stack.pop_back();
+            }
+        }
+    }
+    auto dominates = [&](unsigned a, unsigned b)->bool {
+        return a < n_bbs && dom_pre[a] != ~0u && dom_pre[b] != ~0u
+            && dom_pre[a] <= dom_pre[b] && dom_post[b] <= dom_post[a];
+        };
+
+    // --- Classify locals ---
+    // A local is tracked if it can only be modified by statements that name it (i.e. it's never borrowed mutably,
+    // or shared with interior mutability)
+    ::std::vector<bool> local_tracked(n_locals, true);
+    ::std::vector<bool> arg_tracked(state.m_args.size(), true);
+    ::std::vector<unsigned> def_count(n_locals);
+    // Locals written by each block (including by a call returning to it, and `ScopeEnd`)
+    ::std::vector< ::std::vector<unsigned> >  block_writes(n_bbs);
+    auto has_deref = [](const ::MIR::LValue& lv)->bool {
+        return ::std::any_of(lv.m_wrappers.begin(), lv.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Deref(); });
+        };
+    auto note_write = [&](const ::MIR::LValue& lv, unsigned bb) {
+        // Writing through a pointer doesn't change the pointer
+        if( has_deref(lv) )
+            return ;
+        if( lv.m_root.is_Local() ) {
+            def_count[lv.m_root.as_Local()] += 1;
+            block_writes[bb].push_back(lv.m_root.as_Local());
+        }
+        else if( lv.m_root.is_Argument() ) {
+            arg_tracked[lv.m_root.as_Argument()] = false;
+        }
+        };
+    auto note_borrow = [&](::HIR::BorrowType bt, bool is_raw, const ::MIR::LValue& lv) {
+        if( has_deref(lv) )
+            return ;
+        if( bt == ::HIR::BorrowType::Shared && !is_raw ) {
+            ::HIR::TypeRef  tmp;
+            if( state.m_resolve.type_is_interior_mutable(state.sp, state.get_lvalue_type(tmp, lv)) == ::HIR::Compare::Unequal )
+                return ;
+        }
+        if( lv.m_root.is_Local() ) {
+            local_tracked[lv.m_root.as_Local()] = false;
+        }
+        else if( lv.m_root.is_Argument() ) {
+            arg_tracked[lv.m_root.as_Argument()] = false;
+        }
+        };
+    auto note_param = [&](const ::MIR::Param& p) {
+        if( const auto* e = p.opt_Borrow() )
+            note_borrow(e->type, false, e->val);
+        };
+    for(unsigned bb = 0; bb < n_bbs; bb ++)
+    {
+        const auto& blk = fcn.blocks[bb];
+        for(size_t stmt_idx = 0; stmt_idx < blk.statements.size(); stmt_idx ++)
+        {
+            const auto& stmt = blk.statements[stmt_idx];
+            state.set_cur_stmt(bb, stmt_idx);
+            visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                if( vu == ValUsage::Write )
+                    note_write(lv, bb);
+                return false;
+                });
+            if( const auto* se = stmt.opt_Assign() )
+            {
+                const auto& rv = se->src;
+                if( const auto* e = rv.opt_Borrow() ) {
+                    note_borrow(e->type, e->is_raw, e->val);
+                }
+                else if( const auto* e = rv.opt_SizedArray() ) {
+                    note_param(e->val);
+                }
+                else if( const auto* e = rv.opt_BinOp() ) {
+                    note_param(e->val_l);
+                    note_param(e->val_r);
+                }
+                else if( const auto* e = rv.opt_MakeDst() ) {
+                    note_param(e->ptr_val);
+                    note_param(e->meta_val);
+                }
+                else if( const auto* e = rv.opt_Tuple() ) {
+                    for(const auto& v : e->vals)    note_param(v);
+                }
+                else if( const auto* e = rv.opt_Array() ) {
+                    for(const auto& v : e->vals)    note_param(v);
+                }
+                else if( const auto* e = rv.opt_UnionVariant() ) {
+                    note_param(e->val);
+                }
+                else if( const auto* e = rv.opt_EnumVariant() ) {
+                    for(const auto& v : e->vals)    note_param(v);
+                }
+                else if( const auto* e = rv.opt_Struct() ) {
+                    for(const auto& v : e->vals)    note_param(v);
+                }
+            }
+            else if( const auto* se = stmt.opt_Asm2() )
+            {
+                for(const auto& p : se->params)
+                    if( const auto* pe = p.opt_Reg() )
+                        if( pe->input )
+                            note_param(*pe->input);
+            }
+            else if( const auto* se = stmt.opt_ScopeEnd() )
+            {
+                for(auto idx : se->slots)
+                    block_writes[bb].push_back(idx);
+            }
+        }
+        state.set_cur_stmt_term(bb);
+        if( const auto* te = blk.terminator.opt_Call() )
+        {
+            // The return value is written on the edge to the return block
+            note_write(te->ret_val, te->ret_block);
+            for(const auto& a : te->args)
+                note_param(a);
+        }
+    }
+    for(auto& w : block_writes)
+    {
+        ::std::sort(w.begin(), w.end());
+        w.erase(::std::unique(w.begin(), w.end()), w.end());
+    }
+    ::std::vector<bool> local_copy(n_locals);
+    for(size_t idx = 0; idx < n_locals; idx ++)
+        local_copy[idx] = local_tracked[idx] && state.m_resolve.type_is_copy(state.sp, fcn.locals[idx]);
+
+    auto is_float_ty = [](const ::HIR::TypeRef& ty)->bool {
+        if( const auto* te = ty.data().opt_Primitive() )
+        {
+            switch(*te)
+            {
+            case ::HIR::CoreType::F16:
+            case ::HIR::CoreType::F32:
+            case ::HIR::CoreType::F64:
+            case ::HIR::CoreType::F128:
+                return true;
+            default:
+                break;
+            }
+        }
+        return false;
+        };
+    // Deref of a `&T` where `T: Freeze` - the pointed-to value can't change while the borrow is live
+    auto is_frozen_deref = [&](const ::MIR::LValue& lv, size_t wrapper_idx)->bool {
+        ::HIR::TypeRef  tmp;
+        const auto& ty = state.get_lvalue_type(tmp, lv, lv.m_wrappers.size() - wrapper_idx);
+        const auto* te = ty.data().opt_Borrow();
+        return te && te->type == ::HIR::BorrowType::Shared
+            && state.m_resolve.type_is_interior_mutable(state.sp, te->inner) == ::HIR::Compare::Unequal;
+        };
+    // Comparisons are normalised so `a > b` and `b < a` share a key
+    auto binop_key = [](::MIR::eBinOp op, ::std::string l, ::std::string r)->::std::string {
+        switch(op)
+        {
+        case ::MIR::eBinOp::GT: op = ::MIR::eBinOp::LT; ::std::swap(l, r);  break;
+        case ::MIR::eBinOp::GE: op = ::MIR::eBinOp::LE; ::std::swap(l, r);  break;
+        case ::MIR::eBinOp::ADD:
+        case ::MIR::eBinOp::MUL:
+        case ::MIR::eBinOp::BIT_OR:
+        case ::MIR::eBinOp::BIT_AND:
+        case ::MIR::eBinOp::BIT_XOR:
+        case ::MIR::eBinOp::EQ:
+        case ::MIR::eBinOp::NE:
+            if( r < l )
+                ::std::swap(l, r);
+            break;
+        default:
+            break;
+        }
+        return FMT("B" << static_cast<int>(op) << "(" << l << "," << r << ")");
+        };
+    auto negate_cmp = [](::MIR::eBinOp op)->::MIR::eBinOp {
+        switch(op)
+        {
+        case ::MIR::eBinOp::EQ: return ::MIR::eBinOp::NE;
+        case ::MIR::eBinOp::NE: return ::MIR::eBinOp::EQ;
+        case ::MIR::eBinOp::LT: return ::MIR::eBinOp::GE;
+        case ::MIR::eBinOp::LE: return ::MIR::eBinOp::GT;
+        case ::MIR::eBinOp::GT: return ::MIR::eBinOp::LE;
+        case ::MIR::eBinOp::GE: return ::MIR::eBinOp::LT;
+        default:
+            BUG(Span(), "negate_cmp on non-comparison " << static_cast<int>(op));
+        }
+        };
+    auto is_cmp = [](::MIR::eBinOp op)->bool {
+        switch(op)
+        {
+        case ::MIR::eBinOp::EQ: case ::MIR::eBinOp::NE:
+        case ::MIR::eBinOp::LT: case ::MIR::eBinOp::LE:
+        case ::MIR::eBinOp::GT: case ::MIR::eBinOp::GE:
+            return true;
+        default:
+            return false;
+        }
+        };
+
+    // --- Value numbering over the dominator tree ---
+    ::std::vector<unsigned> version(n_locals);
+    ::std::vector< ::std::string>   alias(n_locals);    // If non-empty, the local is a copy of this value
+    unsigned next_version = 1;
+    struct VersionUndo {
+        unsigned    idx;
+        unsigned    version;
+        ::std::string   alias;
+    };
+    ::std::vector<VersionUndo>  version_undo;
+    struct Comparison {
+        ::MIR::eBinOp   op;
+        ::std::string   l, r;
+        bool    is_float;
+    };
+    // Expression -> (local, version) holding its result
+    ::std::map< ::std::string, ::std::pair<unsigned,unsigned> >    avail;
+    // Value or comparison -> known boolean result
+    ::std::map< ::std::string, bool>    facts;
+    // Boolean value -> comparison that produced it
+    ::std::map< ::std::string, Comparison>  def_cmp;
+    ::std::vector< ::std::function<void()> >    map_undo;
+    auto scoped_set = [&](auto& map, const ::std::string& key, auto val) {
+        auto it = map.find(key);
+        if( it == map.end() ) {
+            map.insert(::std::make_pair(key, ::std::move(val)));
+            map_undo.push_back([&map,key](){ map.erase(key); });
+        }
+        else {
+            auto old = ::std::move(it->second);
+            it->second = ::std::move(val);
+            map_undo.push_back([&map,key,old](){ map[key] = old; });
+        }
+        };
+    auto bump = [&](unsigned idx) {
+        version_undo.push_back(VersionUndo { idx, version[idx], ::std::move(alias[idx]) });
+        version[idx] = next_version ++;
+        alias[idx].clear();
+        };
+    auto bump_lvalue = [&](const ::MIR::LValue& lv) {
+        if( !has_deref(lv) && lv.m_root.is_Local() )
+            bump(lv.m_root.as_Local());
+        };
+    auto local_name = [&](unsigned idx)->::std::string {
+        if( !alias[idx].empty() )
+            return alias[idx];
+        return "_" + ::std::to_string(idx) + "@" + ::std::to_string(version[idx]);
+        };
+    // Join points: Give new versions to the locals written by any block on a path from the immediate dominator (whose
+    // writes are already visible) to the join, i.e. the blocks found walking back from it without passing through
+    // the dominator. The entry block has no dominator, so a loop back to it includes the block itself.
+    ::std::vector<unsigned> walk_mark(n_bbs);
+    ::std::vector<unsigned> bump_mark(n_locals);
+    unsigned walk_gen = 0;
+    ::std::vector<unsigned> walk_stack;
+    auto bump_join = [&](unsigned bb) {
+        walk_gen ++;
+        unsigned stop = (bb == 0 ? ~0u : idom[bb]);
+        walk_stack = preds[bb];
+        while( !walk_stack.empty() )
+        {
+            unsigned b = walk_stack.back();
+            walk_stack.pop_back();
+            if( b == stop || walk_mark[b] == walk_gen )
+                continue ;
+            walk_mark[b] = walk_gen;
+            for(auto idx : block_writes[b])
+            {
+                if( !local_tracked[idx] || bump_mark[idx] == walk_gen )
+                    continue ;
+                bump_mark[idx] = walk_gen;
+                bump(idx);
+            }
+            walk_stack.insert(walk_stack.end(), preds[b].begin(), preds[b].end());
+        }
+        };
+    auto lvalue_key = [&](const ::MIR::LValue& lv, ::std::string& out)->bool {
+        if( lv.m_root.is_Local() ) {
+            if( !local_tracked[lv.m_root.as_Local()] )
+                return false;
+            out = local_name(lv.m_root.as_Local());
+        }
+        else if( lv.m_root.is_Argument() ) {
+            if( !arg_tracked[lv.m_root.as_Argument()] )
+                return false;
+            out = "a" + ::std::to_string(lv.m_root.as_Argument());
+        }
+        else {
+            return false;
+        }
+        for(size_t i = 0; i < lv.m_wrappers.size(); i ++)
+        {
+            const auto& w = lv.m_wrappers[i];
+            if( w.is_Field() ) {
+                out += "." + ::std::to_string(w.as_Field());
+            }
+            else if( w.is_Downcast() ) {
+                out += "#" + ::std::to_string(w.as_Downcast());
+            }
+            else if( w.is_Index() ) {
+                if( w.as_Index() >= n_locals || !local_tracked[w.as_Index()] )
+                    return false;
+                out += "[" + local_name(w.as_Index()) + "]";
+            }
+            else {
+                if( !is_frozen_deref(lv, i) )
+                    return false;
+                out += "*";
+            }
+        }
+        return true;
+        };
+    auto param_key = [&](const ::MIR::Param& p, ::std::string& out)->bool {
+        if( const auto* e = p.opt_Constant() ) {
+            // Length-prefixed, as the formatted constant could contain anything
+            auto s = FMT(*e);
+            out = FMT("#" << s.size() << ":" << s);
+            return true;
+        }
+        if( const auto* e = p.opt_LValue() )
+            return lvalue_key(*e, out);
+        return false;
+        };
+    auto rvalue_key = [&](const ::MIR::RValue& rv, ::std::string& out)->bool {
+        ::std::string   k1, k2;
+        if( const auto* e = rv.opt_Use() ) {
+            // Whole values are handled as copies
+            if( e->m_wrappers.empty() || !lvalue_key(*e, k1) )
+                return false;
+            out = "L" + k1;
+            return true;
+        }
+        if( const auto* e = rv.opt_BinOp() ) {
+            switch(e->op)
+            {
+            case ::MIR::eBinOp::ADD_OV:
+            case ::MIR::eBinOp::SUB_OV:
+            case ::MIR::eBinOp::MUL_OV:
+            case ::MIR::eBinOp::DIV_OV:
+                return false;
+            default:
+                break;
+            }
+            if( !param_key(e->val_l, k1) || !param_key(e->val_r, k2) )
+                return false;
+            out = binop_key(e->op, k1, k2);
+            return true;
+        }
+        if( const auto* e = rv.opt_UniOp() ) {
+            if( !lvalue_key(e->val, k1) )
+                return false;
+            out = FMT("U" << static_cast<int>(e->op) << "(" << k1 << ")");
+            return true;
+        }
+        if( const auto* e = rv.opt_Cast() ) {
+            if( !lvalue_key(e->val, k1) )
+                return false;
+            out = FMT("C(" << k1 << " as " << e->type << ")");
+            return true;
+        }
+        if( const auto* e = rv.opt_DstMeta() ) {
+            if( !lvalue_key(e->val, k1) )
+                return false;
+            out = "M(" + k1 + ")";
+            return true;
+        }
+        if( const auto* e = rv.opt_DstPtr() ) {
+            if( !lvalue_key(e->val, k1) )
+                return false;
+            out = "P(" + k1 + ")";
+            return true;
+        }
+        return false;
+        };
+
+    auto process_block = [&](unsigned bb) {
+        // - Values that may have been written on another path into this block get new versions
+        if( preds[bb].size() > 1 || (bb == 0 && !preds[bb].empty()) )
+        {
+            bump_join(bb);
+        }
+        for(auto p : preds[bb])
+        {
+            if( const auto* te = fcn.blocks[p].terminator.opt_Call() )
+            {
+                if( te->ret_block == bb )
+                    bump_lvalue(te->ret_val);
+            }
+        }
+        // - Entered through one arm of an `If`: the condition (and the comparison that produced it) is known
+        if( preds[bb].size() == 1 )
+        {
+            if( const auto* te = fcn.blocks[preds[bb][0]].terminator.opt_If() )
+            {
+                ::std::string   cond_name;
+                if( te->bb_true != te->bb_false && lvalue_key(te->cond, cond_name) )
+                {
+                    bool val = (bb == te->bb_true);
+                    scoped_set(facts, cond_name, val);
+                    auto it = def_cmp.find(cond_name);
+                    if( it != def_cmp.end() )
+                    {
+                        auto c = it->second;
+                        scoped_set(facts, binop_key(c.op, c.l, c.r), val);
+                        // NOTE: Float comparisons can't be inverted (NaN)
+                        if( !c.is_float )
+                            scoped_set(facts, binop_key(negate_cmp(c.op), c.l, c.r), !val);
+                    }
+                }
+            }
+        }
+
+        auto& blk = fcn.blocks[bb];
+        for(size_t stmt_idx = 0; stmt_idx < blk.statements.size(); stmt_idx ++)
+        {
+            auto& stmt = blk.statements[stmt_idx];
+            state.set_cur_stmt(bb, stmt_idx);
+            if( auto* se = stmt.opt_Assign() )
+            {
+                ::std::string   key;
+                bool has_key = rvalue_key(se->src, key);
+                if( has_key )
+                {
+                    auto fit = facts.find(key);
+                    auto ait = avail.find(key);
+                    if( fit != facts.end() )
+                    {
+                        DEBUG(state << "Known result: " << se->src << " = " << fit->second);
+                        se->src = ::MIR::RValue::make_Constant(::MIR::Constant::make_Bool({ fit->second }));
+                        has_key = false;
+                        changed = true;
+                    }
+                    else if( ait != avail.end() && version[ait->second.first] == ait->second.second
+                        && !(se->dst.m_root.is_Local() && se->dst.m_root.as_Local() == ait->second.first) )
+                    {
+                        DEBUG(state << "Redundant: " << se->src << " = _" << ait->second.first);
+                        se->src = ::MIR::RValue::make_Use(::MIR::LValue::new_Local(ait->second.first));
+                        has_key = false;
+                        changed = true;
+                    }
+                }
+                // Gather information on the source before the destination is updated
+                ::std::string   copy_name;
+                bool is_copy = false;
+                if( const auto* e = se->src.opt_Use() )
+                    is_copy = e->m_wrappers.empty() && lvalue_key(*e, copy_name);
+                bool has_cmp = false;
+                Comparison  cmp;
+                if( has_key && se->src.is_BinOp() && is_cmp(se->src.as_BinOp().op) )
+                {
+                    const auto& e = se->src.as_BinOp();
+                    ::HIR::TypeRef  tmp;
+                    has_cmp = param_key(e.val_l, cmp.l) && param_key(e.val_r, cmp.r);
+                    cmp.op = e.op;
+                    cmp.is_float = is_float_ty(state.get_param_type(tmp, e.val_l));
+                }
+                bump_lvalue(se->dst);
+                if( se->dst.m_wrappers.empty() && se->dst.m_root.is_Local() && local_copy[se->dst.m_root.as_Local()] )
+                {
+                    unsigned idx = se->dst.m_root.as_Local();
+                    if( is_copy ) {
+                        version_undo.push_back(VersionUndo { idx, version[idx], ::std::move(alias[idx]) });
+                        alias[idx] = copy_name;
+                    }
+                    else if( const auto* e = se->src.opt_Constant() ) {
+                        if( e->is_Bool() )
+                            scoped_set(facts, local_name(idx), e->as_Bool().v);
+                    }
+                    else if( has_key ) {
+                        scoped_set(avail, key, ::std::make_pair(idx, version[idx]));
+                        if( has_cmp )
+                            scoped_set(def_cmp, local_name(idx), cmp);
+                    }
+                }
+            }
+            else if( const auto* se = stmt.opt_ScopeEnd() )
+            {
+                for(auto idx : se->slots)
+                    bump(idx);
+            }
+            else
+            {
+                visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                    if( vu == ValUsage::Write )
+                        bump_lvalue(lv);
+                    return false;
+                    });
+            }
+        }
+
+        state.set_cur_stmt_term(bb);
+        if( auto* te = blk.terminator.opt_If() )
+        {
+            ::std::string   cond_name;
+            if( lvalue_key(te->cond, cond_name) )
+            {
+                auto it = facts.find(cond_name);
+                if( it != facts.end() )
+                {
+                    DEBUG(state << "Condition known to be " << it->second);
+                    auto dst = it->second ? te->bb_true : te->bb_false;
+                    blk.terminator = ::MIR::Terminator::make_Goto(dst);
+                    changed = true;
+                    cfg_changed = true;
+                }
+            }
+        }
+        };
+
+    struct Frame {
+        unsigned    bb;
+        size_t  next_child;
+        size_t  version_mark;
+        size_t  map_mark;
+    };
+    ::std::vector<Frame>    stack;
+    auto enter = [&](unsigned bb) {
+        stack.push_back(Frame { bb, 0, version_undo.size(), map_undo.size() });
+        process_block(bb);
+        };
+    enter(0);
+    while( !stack.empty() )
+    {
+        auto& top = stack.back();
+        if( top.next_child < dom_children[top.bb].size() )
+        {
+            enter(dom_children[top.bb][top.next_child++]);
+        }
+        else
+        {
+            while( version_undo.size() > top.version_mark )
+            {
+                auto& u = version_undo.back();
+                version[u.idx] = u.version;
+                alias[u.idx] = ::std::move(u.alias);
+                version_undo.pop_back();
+            }
+            while( map_undo.size() > top.map_mark )
+            {
+                map_undo.back()();
+                map_undo.pop_back();
+            }
+            stack.pop_back();
+        }
+    }
+
+    // --- Loop-invariant code motion ---
+    // NOTE: Skipped if the CFG changed above, as the loop structure is then out of date
+    if( cfg_changed )
+        return changed;
+
+    // Natural loops, with loops sharing a header merged
+    ::std::map<unsigned, ::std::vector<bool> >  loop_bodies;
+    for(auto bb : rpo)
+    {
+        for(auto s : succs[bb])
+        {
+            if( !dominates(s, bb) )
+                continue ;
+            auto& body = loop_bodies[s];
+            body.resize(n_bbs);
+            body[s] = true;
+            ::std::vector<unsigned> todo;
+            if( !body[bb] ) {
+                body[bb] = true;
+                todo.push_back(bb);
+            }
+            while( !todo.empty() )
+            {
+                auto b = todo.back();
+                todo.pop_back();
+                for(auto p : preds[b])
+                {
+                    if( !body[p] && rpo_idx[p] != ~0u ) {
+                        body[p] = true;
+                        todo.push_back(p);
+                    }
+                }
+            }
+        }
+    }
+    // Innermost (smallest) loops first, so code hoisted out of an inner loop can then leave the outer loop too
+    ::std::vector< ::std::pair<size_t, unsigned> >  loop_order;
+    for(const auto& l : loop_bodies)
+        loop_order.push_back(::std::make_pair( ::std::count(l.second.begin(), l.second.end(), true), l.first ));
+    ::std::sort(loop_order.begin(), loop_order.end());
+
+    // Only expressions that can't trap (or otherwise misbehave) when evaluated speculatively are hoisted
+    ::std::vector<bool> written(n_locals);
+    auto is_invariant_lv = [&](const ::MIR::LValue& lv)->bool {
+        if( lv.m_root.is_Local() ) {
+            if( !local_tracked[lv.m_root.as_Local()] || written[lv.m_root.as_Local()] )
+                return false;
+        }
+        else if( lv.m_root.is_Argument() ) {
+            if( !arg_tracked[lv.m_root.as_Argument()] )
+                return false;
+        }
+        else {
+            return false;
+        }
+        for(size_t i = 0; i < lv.m_wrappers.size(); i ++)
+        {
+            const auto& w = lv.m_wrappers[i];
+            if( w.is_Field() )
+                continue ;
+            // NOTE: Indexing isn't bounds checked at this level, and a downcast may be of the wrong variant
+            if( !w.is_Deref() || !is_frozen_deref(lv, i) )
+                return false;
+        }
+        return true;
+        };
+    auto is_invariant_param = [&](const ::MIR::Param& p)->bool {
+        if( p.is_Constant() )
+            return true;
+        if( const auto* e = p.opt_LValue() )
+            return is_invariant_lv(*e);
+        return false;
+        };
+    auto is_hoistable = [&](const ::MIR::RValue& rv)->bool {
+        if( const auto* e = rv.opt_Use() ) {
+            return !e->m_wrappers.empty() && is_invariant_lv(*e);
+        }
+        if( const auto* e = rv.opt_BinOp() ) {
+            switch(e->op)
+            {
+            case ::MIR::eBinOp::ADD:
+            case ::MIR::eBinOp::SUB:
+            case ::MIR::eBinOp::MUL:
+            case ::MIR::eBinOp::BIT_OR:
+            case ::MIR::eBinOp::BIT_AND:
+            case ::MIR::eBinOp::BIT_XOR:
+            case ::MIR::eBinOp::EQ:
+            case ::MIR::eBinOp::NE:
+            case ::MIR::eBinOp::LT:
+            case ::MIR::eBinOp::LE:
+            case ::MIR::eBinOp::GT:
+            case ::MIR::eBinOp::GE:
+                break;
+            // Division/remainder can trap, and over-long shifts are undefined in C
+            default:
+                return false;
+            }
+            return is_invariant_param(e->val_l) && is_invariant_param(e->val_r);
+        }
+        if( const auto* e = rv.opt_UniOp() ) {
+            return is_invariant_lv(e->val);
+        }
+        if( const auto* e = rv.opt_Cast() ) {
+            // Out-of-range float to integer casts are undefined in C
+            ::HIR::TypeRef  tmp;
+            return is_invariant_lv(e->val) && !is_float_ty(state.get_lvalue_type(tmp, e->val));
+        }
+        if( const auto* e = rv.opt_DstMeta() ) {
+            return is_invariant_lv(e->val);
+        }
+        if( const auto* e = rv.opt_DstPtr() ) {
+            return is_invariant_lv(e->val);
+        }
+        return false;
+        };
+
+    for(const auto& l : loop_order)
+    {
+        unsigned header = l.second;
+        // The entry block can't have a preheader
+        if( header == 0 )
+            continue ;
+        const auto& body = loop_bodies.at(header);
+
+        ::std::fill(written.begin(), written.end(), false);
+        for(unsigned bb = 0; bb < body.size(); bb ++)
+        {
+            if( !body[bb] )
+                continue ;
+            for(const auto& stmt : fcn.blocks[bb].statements)
+            {
+                visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                    if( vu == ValUsage::Write && !has_deref(lv) && lv.m_root.is_Local() )
+                        written[lv.m_root.as_Local()] = true;
+                    return false;
+                    });
+            }
+            if( const auto* te = fcn.blocks[bb].terminator.opt_Call() )
+            {
+                if( !has_deref(te->ret_val) && te->ret_val.m_root.is_Local() )
+                    written[te->ret_val.m_root.as_Local()] = true;
+            }
+        }
+
+        // Pull out statements until nothing more can move (a hoisted value can make its users invariant)
+        ::std::vector< ::MIR::Statement>    hoisted;
+        for(bool progress = true; progress; )
+        {
+            progress = false;
+            for(unsigned bb = 0; bb < body.size(); bb ++)
+            {
+                if( !body[bb] )
+                    continue ;
+                auto& stmts = fcn.blocks[bb].statements;
+                for(auto it = stmts.begin(); it != stmts.end(); )
+                {
+                    const auto* se = it->opt_Assign();
+                    if( se && se->dst.is_Local() && local_copy[se->dst.as_Local()] && def_count[se->dst.as_Local()] == 1 )
+                    {
+                        unsigned idx = se->dst.as_Local();
+                        state.set_cur_stmt(bb, it - stmts.begin());
+                        if( is_hoistable(se->src) )
+                        {
+                            DEBUG(state << "Hoist out of loop bb" << header << ": " << *it);
+                            hoisted.push_back(::std::move(*it));
+                            it = stmts.erase(it);
+                            written[idx] = false;
+                            progress = true;
+                            continue ;
+                        }
+                    }
+                    ++ it;
+                }
+            }
+        }
+        if( hoisted.empty() )
+            continue ;
+        changed = true;
+
+        // Find or create a preheader
+        ::std::vector<unsigned> outside_preds;
+        for(auto p : preds[header])
+            if( !(p < body.size() && body[p]) )
+                outside_preds.push_back(p);
+        unsigned preheader;
+        if( outside_preds.size() == 1 && fcn.blocks[outside_preds[0]].terminator.is_Goto() )
+        {
+            preheader = outside_preds[0];
+        }
+        else
+        {
+            preheader = fcn.blocks.size();
+            fcn.blocks.push_back(::MIR::BasicBlock { {}, ::MIR::Terminator::make_Goto(header) });
+            for(auto p : outside_preds)
+            {
+                visit_terminator_target_mut(fcn.blocks[p].terminator, [&](::MIR::BasicBlockId& dst) {
+                    if( dst == header )
+                        dst = preheader;
+                    });
+            }
+            preds.push_back(outside_preds);
+            preds[header].erase(::std::remove_if(preds[header].begin(), preds[header].end(), [&](unsigned p){
+                return ::std::find(outside_preds.begin(), outside_preds.end(), p) != outside_preds.end();
+                }), preds[header].end());
+            preds[header].push_back(preheader);
+            // Enclosing loops now contain the new block
+            for(auto& ol : loop_bodies)
+            {
+                ol.second.resize(fcn.blocks.size());
+                if( ol.first != header && ol.second[header] )
+                    ol.second[preheader] = true;
+            }
+            DEBUG("Created preheader bb" << preheader << " for loop bb" << header);
+        }
+        auto& dst_stmts = fcn.blocks[preheader].statements;
+        for(auto& s : hoisted)
+            dst_stmts.push_back(::std::move(s));
+    }
+
+    return changed;
+}
+
+// ----------------------------------------
+// Clear all drop flags that are never read
+// ----------------------------------------
+bool MIR_Optimise_DeadDropFlags(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool removed_statement = false;
+    TRACE_FUNCTION_FR("", removed_statement);
+    ::std::vector<bool> used_drop_flags( fcn.drop_flags.size() );
+    {
+        ::std::vector<bool> read_drop_flags( fcn.drop_flags.size() );
+        visit_blocks(state, fcn, [&read_drop_flags,&used_drop_flags](auto , const ::MIR::BasicBlock& block) {
+                for(const auto& stmt : block.statements)
+                {
+                    if( const auto* e = stmt.opt_SetDropFlag() )
+                    {
+                        if(e->other != ~0u) {
+                            read_drop_flags[e->other] = true;
+                            used_drop_flags[e->other] = true;
+                        }
+                        used_drop_flags[e->idx] = true;
+                    }
+                    else if( const auto* e = stmt.opt_Drop() )
+                    {
+                        if(e->flag_idx != ~0u) {
+                            read_drop_flags[e->flag_idx] = true;
+                            used_drop_flags[e->flag_idx] = true;
+                        }
+                    }
+                    else if( const auto* e = stmt.opt_SaveDropFlag() )
+                    {
+                        read_drop_flags[e->idx] = true;
+                        used_drop_flags[e->idx] = true;
+                    }
+                    else if( const auto* e = stmt.opt_LoadDropFlag() )
+                    {
+                        used_drop_flags[e->idx] = true;
+                    }
+                }
+                });
+        DEBUG("Un-read drop flags:" << FMT_CB(ss,
+            for(size_t i = 0; i < read_drop_flags.size(); i ++)
+                if( ! read_drop_flags[i] && used_drop_flags[i] )
+                    ss << " " << i;
+            ));
+        visit_blocks_mut(state, fcn, [&read_drop_flags,&removed_statement](auto _id, auto& block) {
+                for(auto it = block.statements.begin(); it != block.statements.end(); )
+                {
+                    if(it->is_SetDropFlag() && ! read_drop_flags[it->as_SetDropFlag().idx] ) {
+                        removed_statement = true;
+                        it = block.statements.erase(it);
+                    }
+                    else if( it->is_LoadDropFlag() && ! read_drop_flags[it->as_LoadDropFlag().idx] ) {
+                        removed_statement = true;
+                        it = block.statements.erase(it);
+                    }
+                    else {
+                        ++ it;
+                    }
+                }
+                });
+    }
+
+    // Find any drop flags that are never assigned with a value other than their default, then remove those dead assignments.
+    {
+        ::std::vector<bool> edited_drop_flags( fcn.drop_flags.size() );
+        visit_blocks(state, fcn, [&edited_drop_flags,&fcn](auto , const ::MIR::BasicBlock& block) {
+                for(const auto& stmt : block.statements)
+                {
+                    if( const auto* e = stmt.opt_SetDropFlag() )
+                    {
+                        if(e->other != ~0u) {
+                            // If the drop flag is set based on another, assume it's changed
+                            edited_drop_flags[e->idx] = true;
+                        }
+                        else if( e->new_val != fcn.drop_flags[e->idx] ) {
+                            // If the new value is not the default, it's changed
+                            edited_drop_flags[e->idx] = true;
+                        }
+                        else {
+                            // Set to the default, doesn't change the 'edited' state
+                        }
+                    }
+                }
+                });
+        DEBUG("Un-edited drop flags:" << FMT_CB(ss,
+            for(size_t i = 0; i < edited_drop_flags.size(); i ++)
+                if( ! edited_drop_flags[i] && used_drop_flags[i] )
+                    ss << " " << i;
+            ));
+        visit_blocks_mut(state, fcn, [&edited_drop_flags,&removed_statement,&fcn](auto _id, auto& block) {
+                for(auto it = block.statements.begin(); it != block.statements.end(); )
+                {
+                    // If this is a SetDropFlag and the target flag isn't edited, remove
+                    if(const auto* e = it->opt_SetDropFlag())
+                    {
+                        if( ! edited_drop_flags[e->idx] ) {
+                            assert( e->new_val == fcn.drop_flags[e->idx] );
+                            removed_statement = true;
+                            it = block.statements.erase(it);
                         }
-                        else if( e->new_val != fcn.drop_flags[e->idx] ) {
-                            // If the new value is not the default, it's changed
-                            edited_drop_flags[e->idx] = true;
+                        else {
+                            ++ it;
+                        }
+                    }
+                    else {
+                        ++ it;
+                    }
+                }
+                });
+    }
+
+    return removed_statement;
+}
+
+// --------------------------------------------------------------------
+// Remove unread assignments of locals (and replaced assignments of anything?)
+// --------------------------------------------------------------------
+bool MIR_Optimise_DeadAssignments(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    // Find any locals that are never read, and delete their assignments.
+
+    // Per-local flag indicating that the particular local is read.
+    ::std::vector<bool> read_locals( fcn.locals.size() );
+    ::std::vector<bool> dropped_locals( fcn.locals.size() );
+    for(const auto& bb : fcn.blocks)
+    {
+        auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+            if( lv.m_root.is_Local() ) {
+                read_locals[lv.m_root.as_Local()] = true;
+            }
+            for(const auto& w : lv.m_wrappers)
+                if(w.is_Index())
+                    read_locals[w.as_Index()] = true;
+            return false;
+            };
+        for(const auto& stmt : bb.statements)
+        {
+            // If the assignment is to a local, then just consider the source (the target is writing to a local)
+            if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() )  {
+                visit_mir_lvalues(stmt.as_Assign().src, cb);
+            }
+            // Record drops differently, allowing us to remove unused non-Copy items
+            else if( stmt.is_Drop() && stmt.as_Drop().slot.is_Local() ) {
+                dropped_locals[ stmt.as_Drop().slot.as_Local() ] = true;
+            }
+            // For other statment types (e.g. asm) - record anything
+            else {
+                visit_mir_lvalues(stmt, cb);
+            }
+        }
+        // Calls to pure functions can be removed if the result is unused, so don't count the result as a read
+        const ::MIR::LValue* pure_ret_val = nullptr;
+        if( const auto* te = bb.terminator.opt_Call() ) {
+            const auto* summary = get_call_summary(state, *te);
+            if( summary && summary->is_pure && te->ret_val.is_Local() )
+                pure_ret_val = &te->ret_val;
+        }
+        visit_mir_lvalues(bb.terminator, [&](const ::MIR::LValue& lv, ValUsage vu) {
+            return &lv == pure_ret_val ? false : cb(lv, vu);
+            });
+    }
+
+    for(auto& bb : fcn.blocks)
+    {
+        for(auto it = bb.statements.begin(), next = it+1; it != bb.statements.end(); it = next, next = it+1 )
+        {
+            state.set_cur_stmt(&bb - &fcn.blocks.front(), it - bb.statements.begin());
+
+            // Remove drops of assigned values that will be removed
+            if( it->is_Drop() && it->as_Drop().slot.is_Local() ) {
+                auto idx = it->as_Drop().slot.as_Local();
+                if( !read_locals[idx] && fcn.locals[idx].data().is_Borrow() ) {
+                    DEBUG(state << "Drop of unread value, remove - " << *it);
+                    next = it = bb.statements.erase(it);
+                    continue;
+                }
+            }
+
+            // Not an assignment, ignore
+            if( !(it->is_Assign() && it->as_Assign().dst.is_Local()) )
+                continue ;
+            auto idx = it->as_Assign().dst.as_Local();
+            // Local was read, ignore it
+            if( read_locals[idx] )
+                continue;
+            // If the local was dropped, then ignore IF it's not a borrow (TODO: Only if there's drop glue?)
+            if( dropped_locals[idx] && !fcn.locals[idx].data().is_Borrow() )
+                continue;
+            // Remove the assignment, as it's unused
+            DEBUG(state << "Unread assignment, remove - " << *it);
+            next = it = bb.statements.erase(it);
+            changed = true;
+        }
+
+        // Remove calls to pure functions with unused results
+        if( const auto* te = bb.terminator.opt_Call() )
+        {
+            if( te->ret_val.is_Local() && !read_locals[te->ret_val.as_Local()] && !dropped_locals[te->ret_val.as_Local()] )
+            {
+                const auto* summary = get_call_summary(state, *te);
+                if( summary && summary->is_pure )
+                {
+                    state.set_cur_stmt_term(&bb - &fcn.blocks.front());
+                    DEBUG(state << "Unused result of pure call, remove - " << bb.terminator);
+                    bb.terminator = ::MIR::Terminator::make_Goto(te->ret_block);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Locate assignments of locals then find the next assignment or read.
+    return changed;
+}
+
+// --------------------------------------------------------------------
+// Eliminate no-operation assignments that may have appeared
+// --------------------------------------------------------------------
+bool MIR_Optimise_NoopRemoval(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    HIR::TypeRef    tmp_ty;
+    // Remove useless operations
+    for(auto& bb : fcn.blocks)
+    {
+        // Multi-statement no-ops (round-trip casts, reboorrow+cast)
+        for(auto it = bb.statements.begin(); it != bb.statements.end(); ++it)
+        {
+            state.set_cur_stmt(&bb - fcn.blocks.data(), it - bb.statements.begin());
+            // `_0 = &mut *foo`, then `_1 = _0 as *mut T` where `foo: *mut T`
+            // - Note: Accepts `_0 = &*foo; _1 = _0 as T` where `foo: T`
+            if( it->is_Assign()
+                && it->as_Assign().dst.is_Local()
+                && it->as_Assign().src.is_Borrow()
+                && it->as_Assign().src.as_Borrow().val.is_Deref()
+                )
+            {
+                const auto& dst_lv = it->as_Assign().dst;
+                auto src_lv = it->as_Assign().src.as_Borrow().val.clone_unwrapped();
+                // Find the next use of this target lvalue
+                for(auto it2 = it+1; it2 != bb.statements.end(); ++it2)
+                {
+                    // If it's a cast back to the original type, then replace with a direct assignment of the original value
+                    if(it2->is_Assign()
+                        && it2->as_Assign().src.is_Cast()
+                        && it2->as_Assign().src.as_Cast().val == dst_lv
+                        )
+                    {
+                        const auto& dst_ty = it2->as_Assign().src.as_Cast().type;
+                        HIR::TypeRef    tmp;
+                        const auto& orig_ty = state.get_lvalue_type(tmp, src_lv);
+                        if( orig_ty == dst_ty )
+                        {
+                            DEBUG(state << "Reborrow and cast back - " << *it << " and " << *it2);
+                            it2->as_Assign().src = std::move(src_lv);
+                            break;
+                        }
+                    }
+                    if( check_invalidates_lvalue(*it2, src_lv, false) )
+                    {
+                        break;
+                    }
+                }
+            }
+
+            // `_0 = foo as *const T; _1 = _0 as *mut T` where `foo: *mut T`
+            // - Note: Accepts `_0 = foo as *const T; _1 = _0 as U` where `foo: U`
+            if( it->is_Assign()
+                && it->as_Assign().dst.is_Local()
+                && it->as_Assign().src.is_Cast()
+                && it->as_Assign().src.as_Cast().type.data().is_Pointer()
+                )
+            {
+                const auto& dst_lv = it->as_Assign().dst;
+                const auto& src_lv = it->as_Assign().src.as_Cast().val;
+                // Find the next use of this target lvalue
+                for(auto it2 = it+1; it2 != bb.statements.end(); ++it2)
+                {
+                    // If it's a cast back to the original type, then replace with a direct assignment of the original value
+                    if(it2->is_Assign()
+                        && it2->as_Assign().src.is_Cast()
+                        && it2->as_Assign().src.as_Cast().val == dst_lv
+                        )
+                    {
+                        const auto& dst_ty = it2->as_Assign().src.as_Cast().type;
+                        HIR::TypeRef    tmp;
+                        const auto& orig_ty = state.get_lvalue_type(tmp, src_lv);
+                        if( orig_ty == dst_ty )
+                        {
+                            DEBUG(state << "Round-trip pointer cast - " << *it << " and " << *it2);
+                            it2->as_Assign().src = src_lv.clone();
+                            break;
+                        }
+                    }
+                    if( check_invalidates_lvalue(*it2, src_lv, false) )
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        for(auto it = bb.statements.begin(); it != bb.statements.end(); )
+        {
+            state.set_cur_stmt(&bb - fcn.blocks.data(), it - bb.statements.begin());
+
+            // Placeholder: Asm block with empty template and no inputs/outputs/flags
+            if( *it == MIR::Statement::make_Asm({}) )
+            {
+                DEBUG(state << "Empty ASM placeholder, remove - " << *it);
+                it = bb.statements.erase(it);
+                changed = true;
+
+                continue;
+            }
+
+            // `Value = Use(Value)`
+            if( it->is_Assign()
+                && it->as_Assign().src.is_Use()
+                && it->as_Assign().src.as_Use() == it->as_Assign().dst
+                )
+            {
+                DEBUG(state << "Useless assignment, remove - " << *it);
+                it = bb.statements.erase(it);
+                changed = true;
+
+                continue ;
+            }
+
+            // `Value = Borrow(Deref(Value))`
+            if( it->is_Assign()
+                && it->as_Assign().src.is_Borrow()
+                && it->as_Assign().src.as_Borrow().val.is_Deref()
+                && it->as_Assign().src.as_Borrow().val.clone_unwrapped() == it->as_Assign().dst
+                )
+            {
+                DEBUG(state << "Useless assignment (v = &*v), remove - " << *it);
+                it = bb.statements.erase(it);
+                changed = true;
+            
+                continue ;
+            }
+
+            // Cast to the same type
+            if( it->is_Assign()
+                && it->as_Assign().src.is_Cast()
+                && it->as_Assign().src.as_Cast().type == state.get_lvalue_type(tmp_ty, it->as_Assign().src.as_Cast().val)
+                )
+            {
+                DEBUG(state << "No-op cast, replace with assignment - " << *it);
+                auto v = mv$(it->as_Assign().src.as_Cast().val);
+                it->as_Assign().src = MIR::RValue::make_Use({ mv$(v) });
+                changed = true;
+
+                ++ it;
+                continue ;
+            }
+
+            // Drop of Copy type
+            if( it->is_Drop()
+                && state.lvalue_is_copy(it->as_Drop().slot)
+                )
+            {
+                DEBUG(state << "Drop of Copy type, remove - " << *it);
+                it = bb.statements.erase(it);
+                changed = true;
+
+                continue;
+            }
+
+            ++ it;
+        }
+    }
+
+    return changed;
+}
+
+// --------------------------------------------------------------------
+// If the first statement of a block is an assignment from a local, and all sources of that block assign to that local
+// - Move the assigment backwards
+// --------------------------------------------------------------------
+bool MIR_Optimise_GotoAssign(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    // 1. Locate blocks that start with an elligable assignemnt 
+    // - Target must be "simple" (not a static, no wrappers)
+    // - Source can be any lvalue? Restrict to locals for now (static/deref assignment is a side-effect)
+    //   > Restrict to single-read locals? Or replace the trigger statement with a reversed copy?
+    // 2. Check all source blocks, and see if they assign to that block
+    // > Terminator must be: GOTO, or CALL <lv> = ... (with the non-panic arm)
+    // 3. If more than half the source blocks assign the source, then move up
+    // - Any IF/SWITCH/... terminator blocks the optimisation
+    for(auto& dst_bb : fcn.blocks)
+    {
+        if( dst_bb.statements.empty() )
+            continue;
+        auto bb_idx = &dst_bb - fcn.blocks.data();
+        state.set_cur_stmt(bb_idx, 0);
+        auto& stmt = dst_bb.statements[0];
+        if( !stmt.is_Assign() )
+            continue ;
+        if( !stmt.as_Assign().src.is_Use() )
+            continue ;
+        auto& dst = stmt.as_Assign().dst;
+        auto& src = stmt.as_Assign().src.as_Use();
+
+        if( !dst.m_wrappers.empty() || dst.m_root.is_Static() )
+            continue;
+        if( !src.is_Local() )
+            continue ;
+        // Source must be a single-read local (so this assignment can be deleted)
+        unsigned n_read = 0;
+        unsigned n_borrow = 0;
+        visit_mir_lvalues(state, fcn, [&](const auto& lv, auto vu) {
+            if(lv.m_root == src.m_root) {
+                switch(vu)
+                {
+                case ValUsage::Read:
+                case ValUsage::Move:
+                    n_read ++;
+                    break;
+                case ValUsage::Borrow:
+                    n_borrow ++;
+                    break;
+                case ValUsage::Write:
+                    // Don't care
+                    break;
+                }
+            }
+            for(const auto& w : lv.m_wrappers)
+            {
+                if(w.is_Index())
+                {
+                    if( ::MIR::LValue::new_Local(w.as_Index()) == src ) {
+                        n_read ++;
+                    }
+                }
+            }
+            return true;
+            });
+        state.set_cur_stmt(bb_idx, 0);
+        if( n_read > 1 || n_borrow > 0 ) {
+            DEBUG(state << "Source " << src << " is read " << n_read << " times and borrowed " << n_borrow);
+            continue ;
+        }
+        DEBUG(state << "Eligible assignment (" << stmt << ")");
+
+        // Find source blocks, check terminators/last
+        std::vector<unsigned> sources;
+        unsigned num_used = 0;
+        for(const auto& src_bb : fcn.blocks)
+        {
+            unsigned bb_idx = &src_bb - fcn.blocks.data();
+            bool used = false;
+            visit_terminator_target(src_bb.terminator, [&](const auto& tgt) { 
+                if( tgt == state.get_cur_block() ) {
+                    used = true;
+                    sources.push_back(bb_idx);
+                }
+                });
+            if( used )
+            {
+                TU_MATCH_HDRA( (src_bb.terminator), { )
+                TU_ARMA(Goto, e) {
+                    if( src_bb.statements.empty() ) {
+                        DEBUG(state << "BB" << bb_idx << " empty");
+                    }
+                    else if( TU_TEST1(src_bb.statements.back(), Assign, .dst == src) ) {
+                        DEBUG("BB" << bb_idx << "/" << src_bb.statements.size() << " " << src_bb.statements.back());
+                        num_used += 1;
+                    }
+                    else {
+                        DEBUG("BB" << bb_idx << "/" << src_bb.statements.size() << " " << src_bb.statements.back() << " - Doesn't write");
+                    }
+                    }
+                TU_ARMA(Call, e) {
+                    if( e.ret_block != state.get_cur_block() ) {
+                        DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Not return block");
+                    }
+                    else if( e.ret_val != src ) {
+                        DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Doesn't write to source");
+                    }
+                    else {
+                        num_used += 1;
+                    }
+                    }
+                break; default:
+                    DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Wrong terminator type");
+                    break;
+                }
+            }
+        }
+
+        // TODO: Allow if one arm doesn't update?
+        // - What if a call invalidates the target?
+        if( num_used < sources.size() ) {
+            DEBUG(state << "- Not all sources set the value");
+            continue ;
+        }
+
+        changed = true;
+
+        // Time to edit.
+        // 1. Update all sources
+        for(auto bb_idx : sources)
+        {
+            auto& src_bb = fcn.blocks[bb_idx];
+
+            if( TU_TEST1(src_bb.terminator, Call, .ret_val == src) )
+            {
+                DEBUG("- Source block: BB" << bb_idx << " - term " << src_bb.terminator);
+                src_bb.terminator.as_Call().ret_val = dst.clone();
+            }
+            else if( !src_bb.statements.empty() && TU_TEST1(src_bb.statements.back(), Assign, .dst == src) )
+            {
+                DEBUG("- Source block: BB" << bb_idx << " - tail " << src_bb.statements.back());
+                src_bb.statements.back().as_Assign().dst = dst.clone();
+            }
+            else
+            {
+                MIR_TODO(state, "Handle copying assignment to source");
+            }
+            if( !src_bb.statements.empty() )
+            {
+                DEBUG("+- BB" << bb_idx << "/" << (src_bb.statements.size()-1) << " " << src_bb.statements.back());
+            }
+            DEBUG("+- BB" << bb_idx << "/TERM " << src_bb.terminator);
+        }
+        // IF the value is `Copy` (i.e. the initial assignment could be expected to survive), then reverse the destination
+        // - Can't do this, it's going to cause infinite recursion!
+        if( false && state.lvalue_is_copy(dst) )
+        {
+            auto d = dst.clone();
+            dst = mv$(src);
+            src = mv$(d);
+            DEBUG(state << "- Updated (" << stmt << ")");
+        }
+        else
+        {
+            stmt = MIR::Statement();
+            DEBUG(state << "- Deleted");
+        }
+    }
+
+    return changed;
+}
+
+// --------------------------------------------------------------------
+// Find re-borrows of values that aren't otherwise used.
+//
+// - Look for `<local> = &[mut] *<local/arg>`
+// - Check if the source is only ever used here (and in a drop)
+// - If that's the case, replace usage with a move and delete the drop
+//
+// TODO: Could allow multiple uses if it's a shared borrow
+// --------------------------------------------------------------------
+bool MIR_Optimise_UselessReborrows(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    // TODO: This doesn't work if the assignment happens in a loop (can lead to multiple moves)
+    // - Need to have a way of knowing if a block is a loop member
+#if 0
+    for(auto& blk : fcn.blocks)
+    {
+        for(auto& stmt : blk.statements)
+        {
+            state.set_cur_stmt(&blk - fcn.blocks.data(), &stmt - blk.statements.data());
+            // Must be `<local> = &[mut] *<local/arg>`
+            if( !stmt.is_Assign() )
+                continue ;
+            const auto& dst = stmt.as_Assign().dst;
+            auto& src_rv = stmt.as_Assign().src;    // Will be updated at the end of the block
+            if( !dst.is_Local() )
+                continue;
+            if( !src_rv.is_Borrow() )
+                continue ;
+            const auto& src_lv = src_rv.as_Borrow().val;
+            if( src_lv.m_wrappers.size() != 1 )
+                continue ;
+            if( src_lv.m_wrappers[0].is_Deref() == false )
+                continue ;
+            if( !(src_lv.m_root.is_Local() || src_lv.m_root.is_Argument()) )
+                continue ;
+            auto src_slot = MIR::LValue(src_lv.m_root.clone(), {});
+            // Ensure that the type is a borrow of the same class
+            HIR::TypeRef tmp_ty;
+            const auto& src_ty = state.get_lvalue_type(tmp_ty, src_slot);
+            if(!TU_TEST1(src_ty.m_data, Borrow, .type == src_rv.as_Borrow().type))
+                continue;
+            DEBUG(state << "Suitable re-borrow operation");
+
+            // With this value, count places it's used
+            unsigned n_wrapped = 0;
+            unsigned n_drop = 0;
+            bool invalidate = false;
+            StmtRef drop_pos;
+            visit_mir_lvalues(state, fcn, [&](const auto& lv, ValUsage vu)->bool {
+                if(lv == src_slot)
+                {
+                    auto pos = StmtRef(state.get_cur_block(), state.get_cur_stmt_ofs());
+                    // Direct usage (only one), should be a drop (look that up)
+                    const auto& blk = fcn.blocks.at(pos.bb_idx);
+                    if( pos.stmt_idx < blk.statements.size() && blk.statements.at(pos.stmt_idx).is_Drop() )
+                    {
+                        DEBUG(state << " Dropped");
+                        // Valid!
+                        n_drop ++;
+                        if( n_drop > 1 )
+                        {
+                            invalidate = true;
                         }
-                        else {
-                            // Set to the default, doesn't change the 'edited' state
+                        else
+                        {
+                            drop_pos = pos;
                         }
                     }
+                    else
+                    {
+                        invalidate = true;
+                    }
                 }
-                });
-        DEBUG("Un-edited drop flags:" << FMT_CB(ss,
-            for(size_t i = 0; i < edited_drop_flags.size(); i ++)
-                if( ! edited_drop_flags[i] && used_drop_flags[i] )
-                    ss << " " << i;
-            ));
-        visit_blocks_mut(state, fcn, [&edited_drop_flags,&removed_statement,&fcn](auto _id, auto& block) {
-                for(auto it = block.statements.begin(); it != block.statements.end(); )
+                else if(lv.m_root == src_slot.m_root)
                 {
-                    // If this is a SetDropFlag and the target flag isn't edited, remove
-                    if(const auto* e = it->opt_SetDropFlag())
+                    DEBUG(state << " Wrapped usage");
+                    // Wrapped usage (expect only one)
+                    n_wrapped ++;
+                    if(n_wrapped > 1)
                     {
-                        if( ! edited_drop_flags[e->idx] ) {
-                            assert( e->new_val == fcn.drop_flags[e->idx] );
-                            removed_statement = true;
-                            it = block.statements.erase(it);
-                        }
-                        else {
-                            ++ it;
-                        }
-                    }
-                    else {
-                        ++ it;
+                        invalidate = true;
                     }
                 }
+                else
+                {
+                    // Ignore
+                }
+                return false;
                 });
+            state.set_cur_stmt(&blk - fcn.blocks.data(), &stmt - blk.statements.data());
+            if( invalidate )
+            {
+                DEBUG(state << "Source isn't suitable");
+                continue ;
+            }
+
+            // Can now delete!
+            if(n_drop > 0)
+            {
+                DEBUG(state << "Wiping drop at " << drop_pos);
+                // Clear drop statement
+                auto& drop_blk = fcn.blocks.at(drop_pos.bb_idx);
+                auto& drop_stmt = drop_blk.statements.at(drop_pos.stmt_idx);
+                drop_stmt = MIR::Statement();
+            }
+            // Update the initial assignment
+            DEBUG(state << "Updating assignment");
+            src_rv = ::MIR::RValue::make_Use(mv$(src_slot));
+
+            changed = true;
+        }
     }
+#endif
 
-    return removed_statement;
+    return changed;
 }
 
 // --------------------------------------------------------------------
-// Remove unread assignments of locals (and replaced assignments of anything?)
+// Clear all unused blocks
 // --------------------------------------------------------------------
-bool MIR_Optimise_DeadAssignments(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+bool MIR_Optimise_GarbageCollect_Partial(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 {
-    bool changed = false;
-    TRACE_FUNCTION_FR("", changed);
+    bool rv = false;
+    TRACE_FUNCTION_FR("", rv);
+    ::std::vector<bool> visited( fcn.blocks.size() );
+    visit_blocks(state, fcn, [&visited](auto bb, const auto& /*block*/) {
+            assert( !visited[bb] );
+            visited[bb] = true;
+            });
+    for(unsigned int i = 0; i < visited.size(); i ++)
+    {
+        auto& blk = fcn.blocks[i];
+        if( blk.terminator.is_Incomplete() && blk.statements.empty() )
+        {
+        }
+        else if( visited[i] )
+        {
+        }
+        else
+        {
+            DEBUG("CLEAR bb" << i);
+            blk.statements.clear();
+            blk.terminator = ::MIR::Terminator::make_Incomplete({});
+            rv = true;
+        }
+    }
+    return rv;
+}
+// --------------------------------------------------------------------
+// Remove all unused temporaries and blocks
+// --------------------------------------------------------------------
+bool MIR_Optimise_GarbageCollect(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    ::std::vector<bool> used_locals( fcn.locals.size() );
+    ::std::vector<bool> used_dfs( fcn.drop_flags.size() );
+    ::std::vector<bool> visited( fcn.blocks.size() );
 
-    // Find any locals that are never read, and delete their assignments.
+    visit_blocks(state, fcn, [&](auto bb, const auto& block) {
+        visited[bb] = true;
 
-    // Per-local flag indicating that the particular local is read.
-    ::std::vector<bool> read_locals( fcn.locals.size() );
-    ::std::vector<bool> dropped_locals( fcn.locals.size() );
-    for(const auto& bb : fcn.blocks)
-    {
-        auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
-            if( lv.m_root.is_Local() ) {
-                read_locals[lv.m_root.as_Local()] = true;
-            }
+        auto assigned_lval = [&](const ::MIR::LValue& lv) {
+            // TODO: Consume through indexing/field accesses
             for(const auto& w : lv.m_wrappers)
-                if(w.is_Index())
-                    read_locals[w.as_Index()] = true;
-            return false;
+            {
+                if( w.is_Field() ) {
+                }
+                else {
+                    return ;
+                }
+            }
+            if( lv.m_root.is_Local() )
+            {
+                used_locals[lv.m_root.as_Local()] = true;
+            }
             };
-        for(const auto& stmt : bb.statements)
+
+        for(const auto& stmt : block.statements)
         {
-            // If the assignment is to a local, then just consider the source (the target is writing to a local)
-            if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() )  {
-                visit_mir_lvalues(stmt.as_Assign().src, cb);
+            TU_IFLET( ::MIR::Statement, stmt, Assign, e,
+                assigned_lval(e.dst);
+            )
+            //else if( const auto* e = stmt.opt_Drop() )
+            //{
+            //    //if( e->flag_idx != ~0u )
+            //    //    used_dfs.at(e->flag_idx) = true;
+            //}
+            else if( const auto* e = stmt.opt_Asm() )
+            {
+                for(const auto& val : e->outputs)
+                    assigned_lval(val.second);
             }
-            // Record drops differently, allowing us to remove unused non-Copy items
-            else if( stmt.is_Drop() && stmt.as_Drop().slot.is_Local() ) {
-                dropped_locals[ stmt.as_Drop().slot.as_Local() ] = true;
+            else if( const auto* e = stmt.opt_Asm2() )
+            {
+                for(const auto& p : e->params)
+                {
+                    if(p.is_Reg() && p.as_Reg().output)
+                        assigned_lval(*p.as_Reg().output);
+                }
             }
-            // For other statment types (e.g. asm) - record anything
-            else {
-                visit_mir_lvalues(stmt, cb);
+            else if( const auto* e = stmt.opt_SetDropFlag() )
+            {
+                if( e->other != ~0u )
+                    used_dfs.at(e->other) = true;
+                used_dfs.at(e->idx) = true;
+            }
+            else if( const auto* e = stmt.opt_LoadDropFlag() )
+            {
+                used_dfs.at(e->idx) = true;
             }
         }
-        visit_mir_lvalues(bb.terminator, cb);
-    }
 
-    for(auto& bb : fcn.blocks)
-    {
-        for(auto it = bb.statements.begin(), next = it+1; it != bb.statements.end(); it = next, next = it+1 )
+        if( const auto* te = block.terminator.opt_Call() )
         {
-            state.set_cur_stmt(&bb - &fcn.blocks.front(), it - bb.statements.begin());
-
-            // Remove drops of assigned values that will be removed
-            if( it->is_Drop() && it->as_Drop().slot.is_Local() ) {
-                auto idx = it->as_Drop().slot.as_Local();
-                if( !read_locals[idx] && fcn.locals[idx].data().is_Borrow() ) {
-                    DEBUG(state << "Drop of unread value, remove - " << *it);
-                    next = it = bb.statements.erase(it);
-                    continue;
-                }
-            }
+            assigned_lval(te->ret_val);
+        }
+        });
 
-            // Not an assignment, ignore
-            if( !(it->is_Assign() && it->as_Assign().dst.is_Local()) )
-                continue ;
-            auto idx = it->as_Assign().dst.as_Local();
-            // Local was read, ignore it
-            if( read_locals[idx] )
-                continue;
-            // If the local was dropped, then ignore IF it's not a borrow (TODO: Only if there's drop glue?)
-            if( dropped_locals[idx] && !fcn.locals[idx].data().is_Borrow() )
-                continue;
-            // Remove the assignment, as it's unused
-            DEBUG(state << "Unread assignment, remove - " << *it);
-            next = it = bb.statements.erase(it);
-            changed = true;
+    ::std::vector<unsigned int> block_rewrite_table;
+    for(unsigned int i = 0, j = 0; i < fcn.blocks.size(); i ++)
+    {
+        block_rewrite_table.push_back( visited[i] ? j ++ : ~0u );
+    }
+    ::std::vector<unsigned int> local_rewrite_table;
+    unsigned int n_locals = fcn.locals.size();
+    for(unsigned int i = 0, j = 0; i < n_locals; i ++)
+    {
+        if( !used_locals[i] )
+        {
+            fcn.locals.erase(fcn.locals.begin() + j);
+        }
+        else {
+            DEBUG("_" << i << " => _" << j);
         }
+        local_rewrite_table.push_back( used_locals[i] ? j ++ : ~0u );
+    }
+    DEBUG("Deleted Locals:" << FMT_CB(ss,
+                for(auto run : runs(used_locals))
+                    if( !used_locals[run.first] )
+                    {
+                        ss << " " << run.first;
+                        if(run.second != run.first)
+                            ss << "-" << run.second;
+                    }
+                ));
+    ::std::vector<unsigned int> df_rewrite_table;
+    unsigned int n_df = fcn.drop_flags.size();
+    for(unsigned int i = 0, j = 0; i < n_df; i ++)
+    {
+        if( !used_dfs[i] )
+        {
+            DEBUG("GC df" << i);
+            // NOTE: Not erased until after rewriting
+        }
+        df_rewrite_table.push_back( used_dfs[i] ? j ++ : ~0u );
     }
 
-    // Locate assignments of locals then find the next assignment or read.
-    return changed;
-}
-
-// --------------------------------------------------------------------
-// Eliminate no-operation assignments that may have appeared
-// --------------------------------------------------------------------
-bool MIR_Optimise_NoopRemoval(::MIR::TypeResolve& state, ::MIR::Function& fcn)
-{
-    bool changed = false;
-    TRACE_FUNCTION_FR("", changed);
-
-    HIR::TypeRef    tmp_ty;
-    // Remove useless operations
-    for(auto& bb : fcn.blocks)
+    auto it = fcn.blocks.begin();
+    for(unsigned int i = 0; i < visited.size(); i ++)
     {
-        // Multi-statement no-ops (round-trip casts, reboorrow+cast)
-        for(auto it = bb.statements.begin(); it != bb.statements.end(); ++it)
+        if( visited[i] )
         {
-            state.set_cur_stmt(&bb - fcn.blocks.data(), it - bb.statements.begin());
-            // `_0 = &mut *foo`, then `_1 = _0 as *mut T` where `foo: *mut T`
-            // - Note: Accepts `_0 = &*foo; _1 = _0 as T` where `foo: T`
-            if( it->is_Assign()
-                && it->as_Assign().dst.is_Local()
-                && it->as_Assign().src.is_Borrow()
-                && it->as_Assign().src.as_Borrow().val.is_Deref()
-                )
+            auto lvalue_cb = [&](::MIR::LValue& lv, auto ) {
+                if( lv.m_root.is_Local() )
+                {
+                    auto e = lv.m_root.as_Local();
+                    MIR_ASSERT(state, e < local_rewrite_table.size(), "Variable out of range - " << lv);
+                    // If the table entry for this variable is !0, it wasn't marked as used
+                    MIR_ASSERT(state, local_rewrite_table.at(e) != ~0u, "LValue " << lv << " incorrectly marked as unused");
+                    lv.m_root = ::MIR::LValue::Storage::new_Local(local_rewrite_table.at(e) );
+                }
+                for(auto& w : lv.m_wrappers)
+                {
+                    if( w.is_Index())
+                    {
+                        w = ::MIR::LValue::Wrapper::new_Index(local_rewrite_table.at( w.as_Index() ));
+                    }
+                }
+                return false;
+                };
+            ::std::vector<bool> to_remove_statements(it->statements.size());
+            for(auto& stmt : it->statements)
             {
-                const auto& dst_lv = it->as_Assign().dst;
-                auto src_lv = it->as_Assign().src.as_Borrow().val.clone_unwrapped();
-                // Find the next use of this target lvalue
-                for(auto it2 = it+1; it2 != bb.statements.end(); ++it2)
+                auto stmt_idx = &stmt - &it->statements.front();
+                state.set_cur_stmt(i, stmt_idx);
+
+                if( stmt == ::MIR::Statement() )
                 {
-                    // If it's a cast back to the original type, then replace with a direct assignment of the original value
-                    if(it2->is_Assign()
-                        && it2->as_Assign().src.is_Cast()
-                        && it2->as_Assign().src.as_Cast().val == dst_lv
-                        )
+                    DEBUG(state << "Remove " << stmt << " - Pure default");
+                    to_remove_statements[stmt_idx] = true;
+                    continue ;
+                }
+
+                if( auto* se = stmt.opt_Drop() )
+                {
+                    // If the drop flag was unset, either remove the drop or remove the drop flag reference
+                    if( se->flag_idx != ~0u && df_rewrite_table[se->flag_idx] == ~0u)
                     {
-                        const auto& dst_ty = it2->as_Assign().src.as_Cast().type;
-                        HIR::TypeRef    tmp;
-                        const auto& orig_ty = state.get_lvalue_type(tmp, src_lv);
-                        if( orig_ty == dst_ty )
-                        {
-                            DEBUG(state << "Reborrow and cast back - " << *it << " and " << *it2);
-                            it2->as_Assign().src = std::move(src_lv);
-                            break;
+                        if( fcn.drop_flags.at(se->flag_idx) ) {
+                            DEBUG(state << "Remove flag from " << stmt << " - Flag never set and default true");
+                            se->flag_idx = ~0u;
+                        }
+                        else {
+                            DEBUG(state << "Remove " << stmt << " - Flag never set and default false");
+                            to_remove_statements[stmt_idx] = true;
+                            continue ;
                         }
                     }
-                    if( check_invalidates_lvalue(*it2, src_lv, false) )
+
+                    // HACK: Remove drop if it's of an unused value (TODO: only if it's conditional?)
+                    if( se->slot.is_Local() && local_rewrite_table[se->slot.as_Local()] == ~0u )
                     {
-                        break;
+                        DEBUG(state << "Remove " << stmt << " - Dropping non-set value");
+                        to_remove_statements[stmt_idx] = true;
+                        continue ;
                     }
                 }
-            }
 
-            // `_0 = foo as *const T; _1 = _0 as *mut T` where `foo: *mut T`
-            // - Note: Accepts `_0 = foo as *const T; _1 = _0 as U` where `foo: U`
-            if( it->is_Assign()
-                && it->as_Assign().dst.is_Local()
-                && it->as_Assign().src.is_Cast()
-                && it->as_Assign().src.as_Cast().type.data().is_Pointer()
-                )
-            {
-                const auto& dst_lv = it->as_Assign().dst;
-                const auto& src_lv = it->as_Assign().src.as_Cast().val;
-                // Find the next use of this target lvalue
-                for(auto it2 = it+1; it2 != bb.statements.end(); ++it2)
+                visit_mir_lvalues_mut(stmt, lvalue_cb);
+                if( auto* se = stmt.opt_Drop() )
                 {
-                    // If it's a cast back to the original type, then replace with a direct assignment of the original value
-                    if(it2->is_Assign()
-                        && it2->as_Assign().src.is_Cast()
-                        && it2->as_Assign().src.as_Cast().val == dst_lv
-                        )
+                    // Rewrite drop flag indexes
+                    if( se->flag_idx != ~0u )
+                        se->flag_idx = df_rewrite_table[se->flag_idx];
+                }
+                else if( auto* se = stmt.opt_SetDropFlag() )
+                {
+                    // Rewrite drop flag indexes OR delete
+                    if( df_rewrite_table[se->idx] == ~0u ) {
+                        to_remove_statements[stmt_idx] = true;
+                        continue ;
+                    }
+                    se->idx = df_rewrite_table[se->idx];
+                    if( se->other != ~0u )
+                        se->other = df_rewrite_table[se->other];
+                }
+                else if( auto* se = stmt.opt_LoadDropFlag() )
+                {
+                    se->idx = df_rewrite_table[se->idx];
+                }
+                else if( auto* se = stmt.opt_SaveDropFlag() )
+                {
+                    se->idx = df_rewrite_table[se->idx];
+                }
+                else if( auto* se = stmt.opt_ScopeEnd() )
+                {
+                    for(auto it = se->slots.begin(); it != se->slots.end(); )
                     {
-                        const auto& dst_ty = it2->as_Assign().src.as_Cast().type;
-                        HIR::TypeRef    tmp;
-                        const auto& orig_ty = state.get_lvalue_type(tmp, src_lv);
-                        if( orig_ty == dst_ty )
-                        {
-                            DEBUG(state << "Round-trip pointer cast - " << *it << " and " << *it2);
-                            it2->as_Assign().src = src_lv.clone();
-                            break;
+                        if( local_rewrite_table.at(*it) == ~0u ) {
+                            it = se->slots.erase(it);
+                        }
+                        else {
+                            *it = local_rewrite_table.at(*it);
+                            ++ it;
                         }
                     }
-                    if( check_invalidates_lvalue(*it2, src_lv, false) )
-                    {
-                        break;
+
+                    if( se->slots.empty() ) {
+                        DEBUG(state << "Delete ScopeEnd (now empty)");
+                        to_remove_statements[stmt_idx] = true;
+                        continue ;
                     }
                 }
             }
-        }
-
-        for(auto it = bb.statements.begin(); it != bb.statements.end(); )
-        {
-            state.set_cur_stmt(&bb - fcn.blocks.data(), it - bb.statements.begin());
-
-            // Placeholder: Asm block with empty template and no inputs/outputs/flags
-            if( *it == MIR::Statement::make_Asm({}) )
-            {
-                DEBUG(state << "Empty ASM placeholder, remove - " << *it);
-                it = bb.statements.erase(it);
-                changed = true;
-
-                continue;
-            }
-
-            // `Value = Use(Value)`
-            if( it->is_Assign()
-                && it->as_Assign().src.is_Use()
-                && it->as_Assign().src.as_Use() == it->as_Assign().dst
-                )
-            {
-                DEBUG(state << "Useless assignment, remove - " << *it);
-                it = bb.statements.erase(it);
-                changed = true;
-
-                continue ;
-            }
-
-            // `Value = Borrow(Deref(Value))`
-            if( it->is_Assign()
-                && it->as_Assign().src.is_Borrow()
-                && it->as_Assign().src.as_Borrow().val.is_Deref()
-                && it->as_Assign().src.as_Borrow().val.clone_unwrapped() == it->as_Assign().dst
-                )
-            {
-                DEBUG(state << "Useless assignment (v = &*v), remove - " << *it);
-                it = bb.statements.erase(it);
-                changed = true;
-            
-                continue ;
-            }
-
-            // Cast to the same type
-            if( it->is_Assign()
-                && it->as_Assign().src.is_Cast()
-                && it->as_Assign().src.as_Cast().type == state.get_lvalue_type(tmp_ty, it->as_Assign().src.as_Cast().val)
+            state.set_cur_stmt_term(i);
+            // Rewrite and advance
+            visit_mir_lvalues_mut(it->terminator, lvalue_cb);
+            TU_MATCHA( (it->terminator), (e),
+            (Incomplete,
+                ),
+            (Return,
+                ),
+            (Diverge,
+                ),
+            (Goto,
+                e = block_rewrite_table[e];
+                ),
+            (Panic,
+                ),
+            (If,
+                e.bb_true  = block_rewrite_table[e.bb_true ];
+                e.bb_false = block_rewrite_table[e.bb_false];
+                ),
+            (Switch,
+                for(auto& target : e.targets)
+                    target = block_rewrite_table[target];
+                ),
+            (SwitchValue,
+                for(auto& target : e.targets)
+                    target = block_rewrite_table[target];
+                e.def_target = block_rewrite_table[e.def_target];
+                ),
+            (Call,
+                e.ret_block   = block_rewrite_table[e.ret_block];
+                e.panic_block = block_rewrite_table[e.panic_block];
                 )
-            {
-                DEBUG(state << "No-op cast, replace with assignment - " << *it);
-                auto v = mv$(it->as_Assign().src.as_Cast().val);
-                it->as_Assign().src = MIR::RValue::make_Use({ mv$(v) });
-                changed = true;
-
-                ++ it;
-                continue ;
-            }
+            )
 
-            // Drop of Copy type
-            if( it->is_Drop()
-                && state.lvalue_is_copy(it->as_Drop().slot)
-                )
-            {
-                DEBUG(state << "Drop of Copy type, remove - " << *it);
-                it = bb.statements.erase(it);
-                changed = true;
+            // Delete all statements flagged in a bitmap for deletion
+            assert(it->statements.size() == to_remove_statements.size());
+            auto new_end = ::std::remove_if(it->statements.begin(), it->statements.end(), [&](const auto& s){
+                    size_t stmt_idx = (&s - &it->statements.front());
+                    return to_remove_statements[stmt_idx];
+                    });
+            it->statements.erase(new_end, it->statements.end());
+        }
+        ++it;
+    }
 
-                continue;
-            }
+    auto new_blocks_end = ::std::remove_if(fcn.blocks.begin(), fcn.blocks.end(), [&](const auto& bb) {
+        size_t i = &bb - &fcn.blocks.front();
+        if( !visited[i] ) {
+            DEBUG("GC bb" << i);
+        }
+        return !visited[i];
+        });
+    fcn.blocks.erase(new_blocks_end, fcn.blocks.end());
 
-            ++ it;
+    // NOTE: Drop flags are bool, so can't use the above hack
+    for(unsigned int i = 0, j = 0; i < n_df; i ++)
+    {
+        if( !used_dfs[i] )
+        {
+            fcn.drop_flags.erase(fcn.drop_flags.begin() + j);
+        }
+        else
+        {
+            j ++;
         }
     }
 
-    return changed;
+    // TODO: Detect if any optimisations happened, and return true in that case
+    return false;
 }
 
+
+#if 0
 // --------------------------------------------------------------------
-// If the first statement of a block is an assignment from a local, and all sources of that block assign to that local
-// - Move the assigment backwards
+// Detect patterns
 // --------------------------------------------------------------------
-bool MIR_Optimise_GotoAssign(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+bool MIR_Optimise_PatternRec(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 {
-    bool changed = false;
-    TRACE_FUNCTION_FR("", changed);
+    // ASSIGN _1 = VARIANT ? #? (_0: &[T]/&str);
+    // ASSIGN _2 = _0@?.1 (where the variant is (usize, usize)
+    // ->
+    // ASSIGN _2 = DSTMETA _0
+}
+#endif
 
-    // 1. Locate blocks that start with an elligable assignemnt 
-    // - Target must be "simple" (not a static, no wrappers)
-    // - Source can be any lvalue? Restrict to locals for now (static/deref assignment is a side-effect)
-    //   > Restrict to single-read locals? Or replace the trigger statement with a reversed copy?
-    // 2. Check all source blocks, and see if they assign to that block
-    // > Terminator must be: GOTO, or CALL <lv> = ... (with the non-panic arm)
-    // 3. If more than half the source blocks assign the source, then move up
-    // - Any IF/SWITCH/... terminator blocks the optimisation
-    for(auto& dst_bb : fcn.blocks)
+
+/// Sort basic blocks to approximate program flow (helps when reading MIR)
+void MIR_SortBlocks(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, ::MIR::Function& fcn)
+{
+    ::std::vector<bool> visited( fcn.blocks.size() );
+    ::std::vector<::std::pair<unsigned,unsigned>> depths( fcn.blocks.size() );
+
+    struct Todo {
+        size_t  bb_idx;
+        unsigned    branch_count;
+        unsigned    level;
+    };
+    unsigned int branches = 0;
+    ::std::vector<Todo> todo;
+    todo.push_back( Todo { 0, 0, 0 } );
+
+    while(!todo.empty())
     {
-        if( dst_bb.statements.empty() )
-            continue;
-        auto bb_idx = &dst_bb - fcn.blocks.data();
-        state.set_cur_stmt(bb_idx, 0);
-        auto& stmt = dst_bb.statements[0];
-        if( !stmt.is_Assign() )
-            continue ;
-        if( !stmt.as_Assign().src.is_Use() )
+        auto info = todo.back();
+        todo.pop_back();
+        if( visited[info.bb_idx] )
             continue ;
-        auto& dst = stmt.as_Assign().dst;
-        auto& src = stmt.as_Assign().src.as_Use();
 
-        if( !dst.m_wrappers.empty() || dst.m_root.is_Static() )
-            continue;
-        if( !src.is_Local() )
-            continue ;
-        // Source must be a single-read local (so this assignment can be deleted)
-        unsigned n_read = 0;
-        unsigned n_borrow = 0;
-        visit_mir_lvalues(state, fcn, [&](const auto& lv, auto vu) {
-            if(lv.m_root == src.m_root) {
-                switch(vu)
-                {
-                case ValUsage::Read:
-                case ValUsage::Move:
-                    n_read ++;
-                    break;
-                case ValUsage::Borrow:
-                    n_borrow ++;
-                    break;
-                case ValUsage::Write:
-                    // Don't care
-                    break;
-                }
-            }
-            for(const auto& w : lv.m_wrappers)
-            {
-                if(w.is_Index())
-                {
-                    if( ::MIR::LValue::new_Local(w.as_Index()) == src ) {
-                        n_read ++;
-                    }
-                }
-            }
-            return true;
+        visited[info.bb_idx] = true;
+        depths[info.bb_idx] = ::std::make_pair( info.branch_count, info.level );
+        const auto& bb = fcn.blocks[info.bb_idx];
+
+        TU_MATCHA( (bb.terminator), (te),
+        (Incomplete,
+            ),
+        (Return,
+            ),
+        (Diverge,
+            ),
+        (Goto,
+            todo.push_back(Todo { te, info.branch_count, info.level + 1 });
+            ),
+        (Panic,
+            todo.push_back(Todo { te.dst, info.branch_count, info.level + 1 });
+            ),
+        (If,
+            todo.push_back(Todo { te.bb_true , ++branches, info.level + 1 });
+            todo.push_back(Todo { te.bb_false, ++branches, info.level + 1 });
+            ),
+        (Switch,
+            for(auto dst : te.targets)
+                todo.push_back(Todo { dst, ++branches, info.level + 1 });
+            ),
+        (SwitchValue,
+            for(auto dst : te.targets)
+                todo.push_back(Todo { dst, ++branches, info.level + 1 });
+            todo.push_back(Todo { te.def_target, info.branch_count, info.level + 1 });
+            ),
+        (Call,
+            todo.push_back(Todo { te.ret_block, info.branch_count, info.level + 1 });
+            todo.push_back(Todo { te.panic_block, ++branches, info.level + 1 });
+            )
+        )
+    }
+
+    // Sort a list of block indexes by `depths`
+    ::std::vector<size_t>   idxes;
+    idxes.reserve(fcn.blocks.size());
+    for(size_t i = 0; i < fcn.blocks.size(); i++)
+        idxes.push_back(i);
+    ::std::sort( idxes.begin(), idxes.end(), [&](auto a, auto b){
+            return depths.at(a) < depths.at(b);
             });
-        state.set_cur_stmt(bb_idx, 0);
-        if( n_read > 1 || n_borrow > 0 ) {
-            DEBUG(state << "Source " << src << " is read " << n_read << " times and borrowed " << n_borrow);
-            continue ;
-        }
-        DEBUG(state << "Eligible assignment (" << stmt << ")");
 
-        // Find source blocks, check terminators/last
-        std::vector<unsigned> sources;
-        unsigned num_used = 0;
-        for(const auto& src_bb : fcn.blocks)
-        {
-            unsigned bb_idx = &src_bb - fcn.blocks.data();
-            bool used = false;
-            visit_terminator_target(src_bb.terminator, [&](const auto& tgt) { 
-                if( tgt == state.get_cur_block() ) {
-                    used = true;
-                    sources.push_back(bb_idx);
-                }
-                });
-            if( used )
-            {
-                TU_MATCH_HDRA( (src_bb.terminator), { )
-                TU_ARMA(Goto, e) {
-                    if( src_bb.statements.empty() ) {
-                        DEBUG(state << "BB" << bb_idx << " empty");
-                    }
-                    else if( TU_TEST1(src_bb.statements.back(), Assign, .dst == src) ) {
-                        DEBUG("BB" << bb_idx << "/" << src_bb.statements.size() << " " << src_bb.statements.back());
-                        num_used += 1;
-                    }
-                    else {
-                        DEBUG("BB" << bb_idx << "/" << src_bb.statements.size() << " " << src_bb.statements.back() << " - Doesn't write");
-                    }
-                    }
-                TU_ARMA(Call, e) {
-                    if( e.ret_block != state.get_cur_block() ) {
-                        DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Not return block");
-                    }
-                    else if( e.ret_val != src ) {
-                        DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Doesn't write to source");
-                    }
-                    else {
-                        num_used += 1;
-                    }
-                    }
-                break; default:
-                    DEBUG(state << "BB" << bb_idx << "/TERM " << src_bb.terminator << " - Wrong terminator type");
-                    break;
-                }
-            }
-        }
+    DEBUG(idxes);
 
-        // TODO: Allow if one arm doesn't update?
-        // - What if a call invalidates the target?
-        if( num_used < sources.size() ) {
-            DEBUG(state << "- Not all sources set the value");
-            continue ;
-        }
+    decltype(fcn.blocks)    new_block_list;
+    new_block_list.reserve( fcn.blocks.size() );
+    for(auto idx : idxes)
+    {
+        auto fix_bb_idx = [&](auto idx){ return ::std::find(idxes.begin(), idxes.end(), idx) - idxes.begin(); };
+        new_block_list.push_back( mv$(fcn.blocks[idx]) );
+        new_block_list.back().statements.shrink_to_fit();   // Save some memory
+        visit_terminator_target_mut(new_block_list.back().terminator, [&](auto& te){
+            te = fix_bb_idx(te);
+            });
+    }
+    fcn.blocks = mv$(new_block_list);
+}
 
-        changed = true;
 
-        // Time to edit.
-        // 1. Update all sources
-        for(auto bb_idx : sources)
+void MIR_OptimiseCrate(::HIR::Crate& crate, bool do_minimal_optimisation)
+{
+    bool incremental = MIR_Incremental_Enabled();
+    if( incremental ) {
+        MIR_Incremental_BeginCrate(crate);
+    }
+    ::MIR::OuterVisitor ov { crate, [&](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
         {
-            auto& src_bb = fcn.blocks[bb_idx];
-
-            if( TU_TEST1(src_bb.terminator, Call, .ret_val == src) )
-            {
-                DEBUG("- Source block: BB" << bb_idx << " - term " << src_bb.terminator);
-                src_bb.terminator.as_Call().ret_val = dst.clone();
+            //if( ! dynamic_cast<::HIR::ExprNode_Block*>(expr.get()) ) {
+            //    return ;
+            //}
+            auto& mir = expr.get_mir_or_error_mut(Span());
+            if( incremental ) {
+                if( MIR_Incremental_Load(crate, p, mir) )
+                    return ;
+                MIR_Incremental_BeginItem(p);
             }
-            else if( !src_bb.statements.empty() && TU_TEST1(src_bb.statements.back(), Assign, .dst == src) )
-            {
-                DEBUG("- Source block: BB" << bb_idx << " - tail " << src_bb.statements.back());
-                src_bb.statements.back().as_Assign().dst = dst.clone();
+            if( do_minimal_optimisation ) {
+                MIR_OptimiseMin(res, p, mir, args, ty);
             }
-            else
-            {
-                MIR_TODO(state, "Handle copying assignment to source");
+            else {
+                MIR_Optimise(res, p, mir, args, ty);
             }
-            if( !src_bb.statements.empty() )
-            {
-                DEBUG("+- BB" << bb_idx << "/" << (src_bb.statements.size()-1) << " " << src_bb.statements.back());
+            // Run cleanup to handle now-monomoprhised inlined constants
+            MIR_Cleanup(res, p, mir, args, ty);
+            if( incremental ) {
+                MIR_Incremental_Store(p, mir);
             }
-            DEBUG("+- BB" << bb_idx << "/TERM " << src_bb.terminator);
-        }
-        // IF the value is `Copy` (i.e. the initial assignment could be expected to survive), then reverse the destination
-        // - Can't do this, it's going to cause infinite recursion!
-        if( false && state.lvalue_is_copy(dst) )
-        {
-            auto d = dst.clone();
-            dst = mv$(src);
-            src = mv$(d);
-            DEBUG(state << "- Updated (" << stmt << ")");
-        }
-        else
-        {
-            stmt = MIR::Statement();
-            DEBUG(state << "- Deleted");
         }
+        };
+    ov.visit_crate(crate);
+    if( incremental ) {
+        MIR_Incremental_EndCrate();
     }
-
-    return changed;
 }
 
 // --------------------------------------------------------------------
-// Find re-borrows of values that aren't otherwise used.
-//
-// - Look for `<local> = &[mut] *<local/arg>`
-// - Check if the source is only ever used here (and in a drop)
-// - If that's the case, replace usage with a move and delete the drop
-//
-// TODO: Could allow multiple uses if it's a shared borrow
+// Summarise a function's behaviour for its callers (see `::HIR::FunctionSummary`)
+// - Callees without a summary (unknown, or in the same call graph component) are assumed to unwind and have side-effects
 // --------------------------------------------------------------------
-bool MIR_Optimise_UselessReborrows(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+::HIR::FunctionSummary MIR_Optimise_Summarise(const ::MIR::TypeResolve& state, const ::MIR::Function& fcn)
 {
-    bool changed = false;
-    TRACE_FUNCTION_FR("", changed);
+    TRACE_FUNCTION;
+    ::HIR::FunctionSummary  rv;
 
-    // TODO: This doesn't work if the assignment happens in a loop (can lead to multiple moves)
-    // - Need to have a way of knowing if a block is a loop member
-#if 0
-    for(auto& blk : fcn.blocks)
+    bool can_unwind = false;
+    bool has_effects = false;
+
+    auto has_deref = [](const ::MIR::LValue& lv) {
+        return ::std::any_of(lv.m_wrappers.begin(), lv.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Deref(); });
+        };
+
+    // Return value facts - every write to the return slot has to be an assignment of the same constant or argument
+    const ::MIR::Constant*  ret_const = nullptr;
+    bool    ret_const_valid = true;
+    unsigned    ret_arg = ~0u;
+    bool    ret_arg_valid = true;
+    // Arguments that could have changed before a return (written to, or borrowed)
+    ::std::vector<bool> arg_changed( state.m_args.size() );
+    auto note_write = [&](const ::MIR::LValue& lv, const ::MIR::RValue* src) {
+        if( lv.m_root.is_Static() || has_deref(lv) ) {
+            has_effects = true;
+        }
+        else if( lv.m_root.is_Argument() ) {
+            arg_changed[lv.m_root.as_Argument()] = true;
+        }
+        else if( lv.m_root.is_Return() ) {
+            if( !src || !lv.m_wrappers.empty() ) {
+                ret_const_valid = false;
+                ret_arg_valid = false;
+            }
+            else if( src->is_Constant() && (src->as_Constant().is_Int() || src->as_Constant().is_Uint() || src->as_Constant().is_Bool()) ) {
+                ret_arg_valid = false;
+                if( ret_const && *ret_const != src->as_Constant() )
+                    ret_const_valid = false;
+                ret_const = &src->as_Constant();
+            }
+            else if( src->is_Use() && src->as_Use().m_wrappers.empty() && src->as_Use().m_root.is_Argument() ) {
+                ret_const_valid = false;
+                if( ret_arg != ~0u && ret_arg != src->as_Use().m_root.as_Argument() )
+                    ret_arg_valid = false;
+                ret_arg = src->as_Use().m_root.as_Argument();
+            }
+            else {
+                ret_const_valid = false;
+                ret_arg_valid = false;
+            }
+        }
+        };
+    auto note_borrow = [&](const ::MIR::LValue& lv) {
+        if( has_deref(lv) )
+            return ;
+        if( lv.m_root.is_Argument() ) {
+            arg_changed[lv.m_root.as_Argument()] = true;
+        }
+        else if( lv.m_root.is_Return() ) {
+            ret_const_valid = false;
+            ret_arg_valid = false;
+        }
+        };
+
+    for(const auto& bb : fcn.blocks)
     {
-        for(auto& stmt : blk.statements)
+        for(const auto& stmt : bb.statements)
         {
-            state.set_cur_stmt(&blk - fcn.blocks.data(), &stmt - blk.statements.data());
-            // Must be `<local> = &[mut] *<local/arg>`
-            if( !stmt.is_Assign() )
-                continue ;
-            const auto& dst = stmt.as_Assign().dst;
-            auto& src_rv = stmt.as_Assign().src;    // Will be updated at the end of the block
-            if( !dst.is_Local() )
-                continue;
-            if( !src_rv.is_Borrow() )
-                continue ;
-            const auto& src_lv = src_rv.as_Borrow().val;
-            if( src_lv.m_wrappers.size() != 1 )
-                continue ;
-            if( src_lv.m_wrappers[0].is_Deref() == false )
-                continue ;
-            if( !(src_lv.m_root.is_Local() || src_lv.m_root.is_Argument()) )
-                continue ;
-            auto src_slot = MIR::LValue(src_lv.m_root.clone(), {});
-            // Ensure that the type is a borrow of the same class
-            HIR::TypeRef tmp_ty;
-            const auto& src_ty = state.get_lvalue_type(tmp_ty, src_slot);
-            if(!TU_TEST1(src_ty.m_data, Borrow, .type == src_rv.as_Borrow().type))
-                continue;
-            DEBUG(state << "Suitable re-borrow operation");
+            if( const auto* se = stmt.opt_Assign() )
+            {
+                note_write(se->dst, &se->src);
+            }
+            else if( const auto* se = stmt.opt_Drop() )
+            {
+                // Drop glue can do anything (including panicking)
+                has_effects = true;
+                can_unwind = true;
+                note_write(se->slot, nullptr);
+            }
+            else if( stmt.is_Asm() || stmt.is_Asm2() )
+            {
+                has_effects = true;
+                visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                    if( vu == ValUsage::Write )
+                        note_write(lv, nullptr);
+                    return false;
+                    });
+            }
+            else
+            {
+                // Drop flag manipulation, no effect outside of this function
+            }
+            visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                if( vu == ValUsage::Borrow )
+                    note_borrow(lv);
+                return false;
+                });
+        }
 
-            // With this value, count places it's used
-            unsigned n_wrapped = 0;
-            unsigned n_drop = 0;
-            bool invalidate = false;
-            StmtRef drop_pos;
-            visit_mir_lvalues(state, fcn, [&](const auto& lv, ValUsage vu)->bool {
-                if(lv == src_slot)
-                {
-                    auto pos = StmtRef(state.get_cur_block(), state.get_cur_stmt_ofs());
-                    // Direct usage (only one), should be a drop (look that up)
-                    const auto& blk = fcn.blocks.at(pos.bb_idx);
-                    if( pos.stmt_idx < blk.statements.size() && blk.statements.at(pos.stmt_idx).is_Drop() )
-                    {
-                        DEBUG(state << " Dropped");
-                        // Valid!
-                        n_drop ++;
-                        if( n_drop > 1 )
-                        {
-                            invalidate = true;
-                        }
-                        else
-                        {
-                            drop_pos = pos;
-                        }
-                    }
-                    else
-                    {
-                        invalidate = true;
-                    }
+        TU_MATCH_HDRA( (bb.terminator), {)
+        default:
+            break;
+        TU_ARMA(Incomplete, te) {
+            has_effects = true;
+            }
+        TU_ARMA(Panic, te) {
+            can_unwind = true;
+            }
+        TU_ARMA(Call, te) {
+            TU_MATCH_HDRA( (te.fcn), {)
+            TU_ARMA(Intrinsic, f) {
+                has_effects |= !intrinsic_is_pure(f.name);
+                can_unwind |= !intrinsic_is_no_unwind(f.name);
                 }
-                else if(lv.m_root == src_slot.m_root)
-                {
-                    DEBUG(state << " Wrapped usage");
-                    // Wrapped usage (expect only one)
-                    n_wrapped ++;
-                    if(n_wrapped > 1)
-                    {
-                        invalidate = true;
-                    }
+            TU_ARMA(Path, p) {
+                if( const auto* summary = get_call_summary(state, te) ) {
+                    has_effects |= !summary->is_pure;
+                    can_unwind |= !summary->no_unwind;
                 }
-                else
-                {
-                    // Ignore
+                else {
+                    has_effects = true;
+                    can_unwind = true;
+                }
+                }
+            TU_ARMA(Value, v) {
+                has_effects = true;
+                can_unwind = true;
                 }
-                return false;
-                });
-            state.set_cur_stmt(&blk - fcn.blocks.data(), &stmt - blk.statements.data());
-            if( invalidate )
-            {
-                DEBUG(state << "Source isn't suitable");
-                continue ;
             }
-
-            // Can now delete!
-            if(n_drop > 0)
+            for(const auto& a : te.args)
             {
-                DEBUG(state << "Wiping drop at " << drop_pos);
-                // Clear drop statement
-                auto& drop_blk = fcn.blocks.at(drop_pos.bb_idx);
-                auto& drop_stmt = drop_blk.statements.at(drop_pos.stmt_idx);
-                drop_stmt = MIR::Statement();
+                if( const auto* ae = a.opt_Borrow() )
+                    note_borrow(ae->val);
+            }
+            note_write(te.ret_val, nullptr);
             }
-            // Update the initial assignment
-            DEBUG(state << "Updating assignment");
-            src_rv = ::MIR::RValue::make_Use(mv$(src_slot));
-
-            changed = true;
         }
     }
-#endif
 
-    return changed;
-}
-
-// --------------------------------------------------------------------
-// Clear all unused blocks
-// --------------------------------------------------------------------
-bool MIR_Optimise_GarbageCollect_Partial(::MIR::TypeResolve& state, ::MIR::Function& fcn)
-{
-    bool rv = false;
-    TRACE_FUNCTION_FR("", rv);
-    ::std::vector<bool> visited( fcn.blocks.size() );
-    visit_blocks(state, fcn, [&visited](auto bb, const auto& /*block*/) {
-            assert( !visited[bb] );
-            visited[bb] = true;
-            });
-    for(unsigned int i = 0; i < visited.size(); i ++)
+    // A function with a loop might not return, so can't be removed even if it has no other effects
+    if( !has_effects )
     {
-        auto& blk = fcn.blocks[i];
-        if( blk.terminator.is_Incomplete() && blk.statements.empty() )
-        {
-        }
-        else if( visited[i] )
+        // Iterative DFS, looking for an edge back to a block on the current path
+        struct Ent {
+            ::MIR::BasicBlockId bb;
+            ::std::vector<::MIR::BasicBlockId>  targets;
+            size_t  next;
+        };
+        auto get_targets = [&](::MIR::BasicBlockId bb) {
+            ::std::vector<::MIR::BasicBlockId>  rv;
+            visit_terminator_target(fcn.blocks[bb].terminator, [&](const ::MIR::BasicBlockId& t){ rv.push_back(t); });
+            return rv;
+            };
+        ::std::vector<uint8_t> visit_state( fcn.blocks.size() );  // 0 = unvisited, 1 = on the current path, 2 = done
+        ::std::vector<Ent>  stack;
+        visit_state[0] = 1;
+        stack.push_back(Ent { 0, get_targets(0), 0 });
+        while( !stack.empty() && !has_effects )
         {
+            auto& e = stack.back();
+            if( e.next == e.targets.size() ) {
+                visit_state[e.bb] = 2;
+                stack.pop_back();
+                continue ;
+            }
+            auto t = e.targets[e.next++];
+            if( visit_state[t] == 1 ) {
+                DEBUG("Loop at bb" << t);
+                has_effects = true;
+            }
+            else if( visit_state[t] == 0 ) {
+                visit_state[t] = 1;
+                stack.push_back(Ent { t, get_targets(t), 0 });
+            }
         }
-        else
-        {
-            DEBUG("CLEAR bb" << i);
-            blk.statements.clear();
-            blk.terminator = ::MIR::Terminator::make_Incomplete({});
-            rv = true;
+    }
+
+    rv.no_unwind = !can_unwind;
+    // NOTE: Unwinding is only possible through a call to a function with side-effects, but check anyway
+    rv.is_pure = !has_effects && !can_unwind;
+    if( ret_arg_valid && ret_arg != ~0u && !arg_changed[ret_arg] )
+    {
+        rv.returns_arg = ret_arg;
+    }
+    if( ret_const_valid && ret_const )
+    {
+        rv.has_const_return = true;
+        TU_MATCH_HDRA( (*ret_const), {)
+        default:
+            MIR_BUG(state, "Unexpected constant type - " << *ret_const);
+        TU_ARMA(Int, c) {
+            rv.const_return_ty = c.t;
+            rv.const_return_val = c.v.get_inner();
+            }
+        TU_ARMA(Uint, c) {
+            rv.const_return_ty = c.t;
+            rv.const_return_val = c.v;
+            }
+        TU_ARMA(Bool, c) {
+            rv.const_return_ty = ::HIR::CoreType::Bool;
+            rv.const_return_val = U128(c.v ? 1 : 0);
+            }
         }
     }
+    DEBUG("no_unwind=" << rv.no_unwind << " is_pure=" << rv.is_pure << " returns_arg=" << rv.returns_arg
+        << " const_return=" << rv.has_const_return << ":" << rv.const_return_val);
     return rv;
 }
+
 // --------------------------------------------------------------------
-// Remove all unused temporaries and blocks
+// Replace calls through a vtable with direct calls (making them candidates for inlining)
+// - If the trait object was created in this function with a known vtable, the call is replaced
+// - Otherwise, if there is only one vtable for the trait in the program, a direct call is guarded by a vtable comparison
 // --------------------------------------------------------------------
-bool MIR_Optimise_GarbageCollect(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+bool MIR_Optimise_Devirtualise(::MIR::TypeResolve& state, ::MIR::Function& fcn, const TransList& list)
 {
-    ::std::vector<bool> used_locals( fcn.locals.size() );
-    ::std::vector<bool> used_dfs( fcn.drop_flags.size() );
-    ::std::vector<bool> visited( fcn.blocks.size() );
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
 
-    visit_blocks(state, fcn, [&](auto bb, const auto& block) {
-        visited[bb] = true;
+    auto has_deref = [](const ::MIR::LValue& lv) {
+        return ::std::any_of(lv.m_wrappers.begin(), lv.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Deref(); });
+        };
 
-        auto assigned_lval = [&](const ::MIR::LValue& lv) {
-            // TODO: Consume through indexing/field accesses
-            for(const auto& w : lv.m_wrappers)
-            {
-                if( w.is_Field() ) {
-                }
-                else {
-                    return ;
-                }
-            }
-            if( lv.m_root.is_Local() )
-            {
-                used_locals[lv.m_root.as_Local()] = true;
-            }
+    // Locals with a single whole-value assignment, that are otherwise never modified or borrowed
+    ::std::vector<const ::MIR::RValue*> local_defs( fcn.locals.size() );
+    {
+        ::std::vector<bool> local_invalid( fcn.locals.size() );
+        auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+            if( (vu == ValUsage::Write || vu == ValUsage::Borrow) && lv.m_root.is_Local() && !has_deref(lv) )
+                local_invalid[lv.m_root.as_Local()] = true;
+            return false;
             };
-
-        for(const auto& stmt : block.statements)
+        for(const auto& bb : fcn.blocks)
         {
-            TU_IFLET( ::MIR::Statement, stmt, Assign, e,
-                assigned_lval(e.dst);
-            )
-            //else if( const auto* e = stmt.opt_Drop() )
-            //{
-            //    //if( e->flag_idx != ~0u )
-            //    //    used_dfs.at(e->flag_idx) = true;
-            //}
-            else if( const auto* e = stmt.opt_Asm() )
-            {
-                for(const auto& val : e->outputs)
-                    assigned_lval(val.second);
-            }
-            else if( const auto* e = stmt.opt_Asm2() )
+            for(const auto& stmt : bb.statements)
             {
-                for(const auto& p : e->params)
+                if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() )
                 {
-                    if(p.is_Reg() && p.as_Reg().output)
-                        assigned_lval(*p.as_Reg().output);
+                    auto idx = stmt.as_Assign().dst.as_Local();
+                    if( local_defs[idx] )
+                        local_invalid[idx] = true;
+                    local_defs[idx] = &stmt.as_Assign().src;
+                    visit_mir_lvalues(stmt.as_Assign().src, cb);
+                }
+                else
+                {
+                    visit_mir_lvalues(stmt, cb);
                 }
             }
-            else if( const auto* e = stmt.opt_SetDropFlag() )
+            visit_mir_lvalues(bb.terminator, cb);
+            if( const auto* te = bb.terminator.opt_Call() )
             {
-                if( e->other != ~0u )
-                    used_dfs.at(e->other) = true;
-                used_dfs.at(e->idx) = true;
+                for(const auto& a : te->args)
+                    if( const auto* ae = a.opt_Borrow() )
+                        cb(ae->val, ValUsage::Borrow);
             }
-            else if( const auto* e = stmt.opt_LoadDropFlag() )
-            {
-                used_dfs.at(e->idx) = true;
+        }
+        for(size_t i = 0; i < local_defs.size(); i ++)
+        {
+            if( local_invalid[i] )
+                local_defs[i] = nullptr;
+        }
+    }
+
+    // Find the vtable static for a vtable pointer (or a trait object pointer, if `is_dst` is set)
+    ::std::function<const ::HIR::Path*(const ::MIR::LValue&, bool, unsigned)>   get_vtable;
+    get_vtable = [&](const ::MIR::LValue& lv, bool is_dst, unsigned depth)->const ::HIR::Path* {
+        if( depth > 16 )
+            return nullptr;
+        // Field of a local struct/tuple
+        if( !lv.m_wrappers.empty() )
+        {
+            if( !lv.m_wrappers.back().is_Field() )
+                return nullptr;
+            auto inner_lv = lv.clone_unwrapped();
+            if( !inner_lv.is_Local() || !local_defs[inner_lv.as_Local()] )
+                return nullptr;
+            const auto& def = *local_defs[inner_lv.as_Local()];
+            unsigned fld_idx = lv.m_wrappers.back().as_Field();
+            const ::std::vector<::MIR::Param>* vals = def.is_Struct() ? &def.as_Struct().vals : def.is_Tuple() ? &def.as_Tuple().vals : nullptr;
+            if( !vals || fld_idx >= vals->size() || !(*vals)[fld_idx].is_LValue() )
+                return nullptr;
+            return get_vtable((*vals)[fld_idx].as_LValue(), is_dst, depth+1);
+        }
+        if( !lv.is_Local() || !local_defs[lv.as_Local()] )
+            return nullptr;
+        const auto& def = *local_defs[lv.as_Local()];
+        if( const auto* e = def.opt_Use() ) {
+            return get_vtable(*e, is_dst, depth+1);
+        }
+        if( !is_dst )
+        {
+            if( const auto* e = def.opt_DstMeta() ) {
+                return get_vtable(e->val, true, depth+1);
+            }
+            if( const auto* e = def.opt_Constant() ) {
+                return e->is_ItemAddr() ? &*e->as_ItemAddr() : nullptr;
+            }
+        }
+        else
+        {
+            if( const auto* e = def.opt_MakeDst() ) {
+                if( e->meta_val.is_Constant() && e->meta_val.as_Constant().is_ItemAddr() )
+                    return &*e->meta_val.as_Constant().as_ItemAddr();
+                if( e->meta_val.is_LValue() )
+                    return get_vtable(e->meta_val.as_LValue(), false, depth+1);
+                return nullptr;
+            }
+            // Re-borrows and pointer casts keep the metadata
+            if( const auto* e = def.opt_Borrow() ) {
+                if( e->val.m_wrappers.empty() || !e->val.m_wrappers.back().is_Deref() )
+                    return nullptr;
+                return get_vtable(e->val.clone_unwrapped(), true, depth+1);
+            }
+            if( const auto* e = def.opt_Cast() ) {
+                return get_vtable(e->val, true, depth+1);
+            }
+            // A smart pointer (e.g. `Box`) constructed from a trait object pointer
+            if( const auto* e = def.opt_Struct() ) {
+                const auto& str = state.m_crate.get_struct_by_path(state.sp, e->path.m_path);
+                if( str.m_struct_markings.coerce_unsized == ::HIR::StructMarkings::Coerce::None )
+                    return nullptr;
+                unsigned fld_idx = str.m_struct_markings.coerce_unsized_index;
+                if( fld_idx >= e->vals.size() || !e->vals[fld_idx].is_LValue() )
+                    return nullptr;
+                return get_vtable(e->vals[fld_idx].as_LValue(), true, depth+1);
             }
         }
+        return nullptr;
+        };
 
-        if( const auto* te = block.terminator.opt_Call() )
+    // Get the function at index `idx` of a vtable static (checking that it's of the expected type)
+    auto get_vtable_entry = [&](const ::HIR::Path& vtable_path, const ::HIR::TypeRef& vtable_ty, unsigned idx)->const ::HIR::Path* {
+        auto it = list.m_statics.find(vtable_path);
+        if( it == list.m_statics.end() || !it->second->ptr )
+            return nullptr;
+        const auto& stat = *it->second->ptr;
+        if( !stat.m_value_generated || stat.m_type != vtable_ty )
+            return nullptr;
+        const auto* repr = Target_GetTypeRepr(state.sp, state.m_resolve, stat.m_type);
+        if( !repr || idx >= repr->fields.size() )
+            return nullptr;
+        for(const auto& r : stat.m_value_res.relocations)
         {
-            assigned_lval(te->ret_val);
+            if( r.ofs == repr->fields[idx].offset && r.p )
+                return &*r.p;
         }
-        });
+        return nullptr;
+        };
+    // Get the only vtable for a given vtable type (if there's only one)
+    // - The map from vtable type to vtable (`nullptr` if there's more than one) is built on first use
+    ::std::map<::HIR::TypeRef, const ::HIR::Path*>  single_vtables;
+    bool single_vtables_built = false;
+    auto get_single_vtable = [&](const ::HIR::TypeRef& vtable_ty)->const ::HIR::Path* {
+        if( !single_vtables_built )
+        {
+            for(const auto& ent : list.m_statics)
+            {
+                if( !ent.first.m_data.is_UfcsKnown() || ent.first.m_data.as_UfcsKnown().item != "vtable#" )
+                    continue ;
+                if( !ent.second->ptr )
+                    continue ;
+                auto ins = single_vtables.insert(::std::make_pair(ent.second->ptr->m_type.clone(), &ent.first));
+                if( !ins.second )
+                    ins.first->second = nullptr;
+            }
+            single_vtables_built = true;
+        }
+        auto it = single_vtables.find(vtable_ty);
+        return it != single_vtables.end() ? it->second : nullptr;
+        };
+    // Check that the vtable's function can be called directly with this call's arguments, and get the receiver type
+    // - The vtable call passes the receiver as `*const ()`, the method takes a borrow of the concrete type
+    auto get_receiver_type = [&](const ::HIR::Path& path, const ::MIR::Terminator::Data_Call& te)->::HIR::TypeRef {
+        auto it = list.m_functions.find(path);
+        if( it == list.m_functions.end() || !it->second->ptr || te.args.empty() || !te.args[0].is_LValue() )
+            return ::HIR::TypeRef();
+        const auto& ent = *it->second;
+        if( ent.ptr->m_variadic || ent.ptr->m_args.size() != te.args.size() )
+            return ::HIR::TypeRef();
+        auto get_arg_ty = [&](size_t i) {
+            return ent.monomorphised.code ? ent.monomorphised.arg_tys[i].second.clone() : ent.pp.monomorph(state.m_resolve, ent.ptr->m_args[i].second);
+            };
+        ::HIR::TypeRef  tmp;
+        const auto& in_recv_ty = state.get_param_type(tmp, te.args[0]);
+        if( !(in_recv_ty.data().is_Pointer() && in_recv_ty.data().as_Pointer().inner == ::HIR::TypeRef::new_unit()) )
+            return ::HIR::TypeRef();
+        for(size_t i = 1; i < te.args.size(); i ++)
+        {
+            if( state.get_param_type(tmp, te.args[i]) != get_arg_ty(i) )
+                return ::HIR::TypeRef();
+        }
+        auto ret_ty = ent.monomorphised.code ? ent.monomorphised.ret_ty.clone() : ent.pp.monomorph(state.m_resolve, ent.ptr->m_return);
+        if( !ret_ty.data().is_Diverge() && state.get_lvalue_type(tmp, te.ret_val) != ret_ty )
+            return ::HIR::TypeRef();
+        auto rv = get_arg_ty(0);
+        if( !rv.data().is_Borrow() )
+            return ::HIR::TypeRef();
+        return rv;
+        };
 
-    ::std::vector<unsigned int> block_rewrite_table;
-    for(unsigned int i = 0, j = 0; i < fcn.blocks.size(); i ++)
-    {
-        block_rewrite_table.push_back( visited[i] ? j ++ : ~0u );
-    }
-    ::std::vector<unsigned int> local_rewrite_table;
-    unsigned int n_locals = fcn.locals.size();
-    for(unsigned int i = 0, j = 0; i < n_locals; i ++)
+    // Blocks containing the fallback (indirect) call of an existing speculative devirtualisation
+    ::std::set<::MIR::BasicBlockId> speculated_blocks;
+    for(const auto& bb : fcn.blocks)
     {
-        if( !used_locals[i] )
+        if( const auto* te = bb.terminator.opt_If() )
         {
-            fcn.locals.erase(fcn.locals.begin() + j);
-        }
-        else {
-            DEBUG("_" << i << " => _" << j);
+            if( te->cond.is_Local() && local_defs[te->cond.as_Local()] && local_defs[te->cond.as_Local()]->is_BinOp() ) {
+                const auto& e = local_defs[te->cond.as_Local()]->as_BinOp();
+                if( e.op == ::MIR::eBinOp::EQ && e.val_r.is_Constant() && e.val_r.as_Constant().is_ItemAddr() )
+                    speculated_blocks.insert(te->bb_false);
+            }
         }
-        local_rewrite_table.push_back( used_locals[i] ? j ++ : ~0u );
     }
-    DEBUG("Deleted Locals:" << FMT_CB(ss,
-                for(auto run : runs(used_locals))
-                    if( !used_locals[run.first] )
-                    {
-                        ss << " " << run.first;
-                        if(run.second != run.first)
-                            ss << "-" << run.second;
-                    }
-                ));
-    ::std::vector<unsigned int> df_rewrite_table;
-    unsigned int n_df = fcn.drop_flags.size();
-    for(unsigned int i = 0, j = 0; i < n_df; i ++)
+
+    struct Rewrite {
+        ::MIR::BasicBlockId bb;
+        ::HIR::Path fcn_path;
+        ::HIR::TypeRef  recv_ty;
+        ::MIR::LValue   vtable_lv;
+        // If set, the call is guarded by a comparison with this vtable
+        const ::HIR::Path*  guard_vtable;
+    };
+    ::std::vector<Rewrite>  rewrites;
+    for(const auto& bb : fcn.blocks)
     {
-        if( !used_dfs[i] )
+        auto bb_idx = static_cast<::MIR::BasicBlockId>(&bb - &fcn.blocks.front());
+        const auto* te = bb.terminator.opt_Call();
+        if( !te || !te->fcn.is_Value() )
+            continue ;
+        // A vtable call is `(*vtable).N(...)`
+        const auto& fcn_lv = te->fcn.as_Value();
+        if( !(fcn_lv.m_wrappers.size() == 2 && fcn_lv.m_wrappers[0].is_Deref() && fcn_lv.m_wrappers[1].is_Field() && fcn_lv.m_root.is_Local()) )
+            continue ;
+        auto vtable_lv = fcn_lv.clone_unwrapped(2);
+        const auto& vtable_ptr_ty = fcn.locals[vtable_lv.as_Local()];
+        if( !vtable_ptr_ty.data().is_Pointer() )
+            continue ;
+        const auto& vtable_ty = vtable_ptr_ty.data().as_Pointer().inner;
+        state.set_cur_stmt_term(bb_idx);
+
+        const ::HIR::Path*  guard_vtable = nullptr;
+        const auto* vtable_path = get_vtable(vtable_lv, false, 0);
+        if( !vtable_path )
         {
-            DEBUG("GC df" << i);
-            // NOTE: Not erased until after rewriting
+            if( speculated_blocks.count(bb_idx) )
+                continue ;
+            vtable_path = guard_vtable = get_single_vtable(vtable_ty);
+            if( !vtable_path )
+                continue ;
         }
-        df_rewrite_table.push_back( used_dfs[i] ? j ++ : ~0u );
+        const auto* fcn_path = get_vtable_entry(*vtable_path, vtable_ty, fcn_lv.m_wrappers[1].as_Field());
+        if( !fcn_path )
+            continue ;
+        auto recv_ty = get_receiver_type(*fcn_path, *te);
+        if( recv_ty == ::HIR::TypeRef() )
+            continue ;
+        DEBUG(state << "Devirtualise " << fcn_lv << " to " << *fcn_path << (guard_vtable ? " (speculative)" : ""));
+        rewrites.push_back(Rewrite { bb_idx, fcn_path->clone(), mv$(recv_ty), mv$(vtable_lv), guard_vtable });
     }
 
-    auto it = fcn.blocks.begin();
-    for(unsigned int i = 0; i < visited.size(); i ++)
+    for(auto& rw : rewrites)
     {
-        if( visited[i] )
+        auto new_local = [&](::HIR::TypeRef ty) {
+            fcn.locals.push_back(mv$(ty));
+            return ::MIR::LValue::new_Local(static_cast<unsigned>(fcn.locals.size() - 1));
+            };
+        ::std::vector<::MIR::Statement>  recv_stmts;
+        // Convert the `*const ()` receiver into a borrow of the concrete type
+        const auto& recv_b = rw.recv_ty.data().as_Borrow();
+        auto ptr_ty = ::HIR::TypeRef::new_pointer(recv_b.type == ::HIR::BorrowType::Shared ? ::HIR::BorrowType::Shared : ::HIR::BorrowType::Unique, recv_b.inner.clone());
+        auto ptr_lv = new_local(ptr_ty.clone());
+        auto recv_lv = new_local(rw.recv_ty.clone());
+        auto& te = fcn.blocks[rw.bb].terminator.as_Call();
+        recv_stmts.push_back(::MIR::Statement::make_Assign({ ptr_lv.clone(), ::MIR::RValue::make_Cast({ te.args[0].as_LValue().clone(), mv$(ptr_ty) }) }));
+        recv_stmts.push_back(::MIR::Statement::make_Assign({ recv_lv.clone(), ::MIR::RValue::make_Borrow({ recv_b.type, false, ::MIR::LValue::new_Deref(mv$(ptr_lv)) }) }));
+
+        if( !rw.guard_vtable )
         {
-            auto lvalue_cb = [&](::MIR::LValue& lv, auto ) {
-                if( lv.m_root.is_Local() )
-                {
-                    auto e = lv.m_root.as_Local();
-                    MIR_ASSERT(state, e < local_rewrite_table.size(), "Variable out of range - " << lv);
-                    // If the table entry for this variable is !0, it wasn't marked as used
-                    MIR_ASSERT(state, local_rewrite_table.at(e) != ~0u, "LValue " << lv << " incorrectly marked as unused");
-                    lv.m_root = ::MIR::LValue::Storage::new_Local(local_rewrite_table.at(e) );
-                }
-                for(auto& w : lv.m_wrappers)
-                {
-                    if( w.is_Index())
-                    {
-                        w = ::MIR::LValue::Wrapper::new_Index(local_rewrite_table.at( w.as_Index() ));
-                    }
-                }
-                return false;
-                };
-            ::std::vector<bool> to_remove_statements(it->statements.size());
-            for(auto& stmt : it->statements)
-            {
-                auto stmt_idx = &stmt - &it->statements.front();
-                state.set_cur_stmt(i, stmt_idx);
+            for(auto& stmt : recv_stmts)
+                fcn.blocks[rw.bb].statements.push_back(mv$(stmt));
+            te.fcn = mv$(rw.fcn_path);
+            te.args[0] = mv$(recv_lv);
+        }
+        else
+        {
+            // `if vtable == &<T as Trait>::vtable# { direct call } else { original call }`
+            ::std::vector<::MIR::Param> args;
+            args.push_back( mv$(recv_lv) );
+            for(size_t i = 1; i < te.args.size(); i ++)
+                args.push_back( te.args[i].clone() );
+            ::MIR::BasicBlock   direct_bb { mv$(recv_stmts), ::MIR::Terminator::make_Call({ te.ret_block, te.panic_block, te.ret_val.clone(), mv$(rw.fcn_path), mv$(args) }) };
+            ::MIR::BasicBlock   indirect_bb { {}, mv$(fcn.blocks[rw.bb].terminator) };
+
+            auto cond_lv = new_local(::HIR::CoreType::Bool);
+            auto& bb = fcn.blocks[rw.bb];
+            bb.statements.push_back(::MIR::Statement::make_Assign({ cond_lv.clone(), ::MIR::RValue::make_BinOp({
+                mv$(rw.vtable_lv), ::MIR::eBinOp::EQ, ::MIR::Constant::make_ItemAddr(box$(rw.guard_vtable->clone()))
+                }) }));
+            auto direct_idx = static_cast<::MIR::BasicBlockId>(fcn.blocks.size());
+            bb.terminator = ::MIR::Terminator::make_If({ mv$(cond_lv), direct_idx, direct_idx + 1 });
+            fcn.blocks.push_back(mv$(direct_bb));
+            fcn.blocks.push_back(mv$(indirect_bb));
+        }
+        changed = true;
+    }
 
-                if( stmt == ::MIR::Statement() )
-                {
-                    DEBUG(state << "Remove " << stmt << " - Pure default");
-                    to_remove_statements[stmt_idx] = true;
-                    continue ;
-                }
+    return changed;
+}
 
-                if( auto* se = stmt.opt_Drop() )
-                {
-                    // If the drop flag was unset, either remove the drop or remove the drop flag reference
-                    if( se->flag_idx != ~0u && df_rewrite_table[se->flag_idx] == ~0u)
-                    {
-                        if( fcn.drop_flags.at(se->flag_idx) ) {
-                            DEBUG(state << "Remove flag from " << stmt << " - Flag never set and default true");
-                            se->flag_idx = ~0u;
-                        }
-                        else {
-                            DEBUG(state << "Remove " << stmt << " - Flag never set and default false");
-                            to_remove_statements[stmt_idx] = true;
-                            continue ;
-                        }
-                    }
+// --------------------------------------------------------------------
+// Replace `box` allocations that never leave the function with stack locals
+// - The box must only be accessed through its pointer and dropped (never moved out whole, borrowed, or copied)
+// - Drops of the box then only drop the contents (and shallow drops are removed)
+// --------------------------------------------------------------------
+namespace {
+    class BoxPromotion
+    {
+        // Larger allocations stay on the heap, to avoid excessive stack usage
+        static const size_t MAX_PROMOTED_SIZE = 4096;
+
+        ::MIR::TypeResolve& state;
+        const ::MIR::Function&  fcn;
+        const ::HIR::SimplePath&    lang_exchange_malloc;
+
+        struct Use {
+            size_t  bb_idx;
+            size_t  stmt_idx;   // `statements.size()` for the terminator
+            const ::MIR::LValue*    lv;
+            ValUsage    vu;
+        };
+    public:
+        enum class Result {
+            /// Not a `box` allocation, or the box escapes
+            Never,
+            /// Only blocked by things inlining could remove (the box being passed to/returned from a call, or the
+            /// size of a generic type), so the allocation must stay out of line until then
+            Later,
+            /// Can be promoted now
+            Promote,
+        };
+        /// A promotable allocation (see `check`)
+        struct Alloc {
+            const ::HIR::TypeRef*   data_ty;
+            unsigned    ptr_idx;
+            unsigned    box_idx;
+            /// `_ptr = Cast(_raw as *mut T)`
+            size_t  cast_bb;
+            size_t  cast_stmt;
+            /// `_ptr* = value`, in the same block as the cast
+            size_t  init_stmt;
+            /// Drops of the box (or any of the locals it's moved into)
+            ::std::vector<::std::pair<size_t,size_t>>   drops;
+        };
 
-                    // HACK: Remove drop if it's of an unused value (TODO: only if it's conditional?)
-                    if( se->slot.is_Local() && local_rewrite_table[se->slot.as_Local()] == ~0u )
-                    {
-                        DEBUG(state << "Remove " << stmt << " - Dropping non-set value");
-                        to_remove_statements[stmt_idx] = true;
-                        continue ;
-                    }
-                }
+        BoxPromotion(::MIR::TypeResolve& state, const ::MIR::Function& fcn):
+            state(state),
+            fcn(fcn),
+            lang_exchange_malloc(state.m_crate.get_lang_item_path_opt("exchange_malloc"))
+        {
+        }
 
-                visit_mir_lvalues_mut(stmt, lvalue_cb);
-                if( auto* se = stmt.opt_Drop() )
-                {
-                    // Rewrite drop flag indexes
-                    if( se->flag_idx != ~0u )
-                        se->flag_idx = df_rewrite_table[se->flag_idx];
-                }
-                else if( auto* se = stmt.opt_SetDropFlag() )
-                {
-                    // Rewrite drop flag indexes OR delete
-                    if( df_rewrite_table[se->idx] == ~0u ) {
-                        to_remove_statements[stmt_idx] = true;
-                        continue ;
-                    }
-                    se->idx = df_rewrite_table[se->idx];
-                    if( se->other != ~0u )
-                        se->other = df_rewrite_table[se->other];
-                }
-                else if( auto* se = stmt.opt_LoadDropFlag() )
-                {
-                    se->idx = df_rewrite_table[se->idx];
+        bool is_alloc(size_t bb_idx) const
+        {
+            const auto* te = fcn.blocks[bb_idx].terminator.opt_Call();
+            return te && te->fcn.is_Path() && te->fcn.as_Path().m_data.is_Generic()
+                && te->fcn.as_Path().m_data.as_Generic().m_path == lang_exchange_malloc && te->ret_val.is_Local();
+        }
+
+        /// Check the `_raw = exchange_malloc(size, align)` call terminating `alloc_bb`
+        Result check(size_t alloc_bb, Alloc& out) const
+        {
+            if( !is_alloc(alloc_bb) )
+                return Result::Never;
+            const auto& alloc_te = fcn.blocks[alloc_bb].terminator.as_Call();
+            state.set_cur_stmt_term(alloc_bb);
+            auto raw_idx = alloc_te.ret_val.as_Local();
+
+            // `_ptr = Cast(_raw as *mut T)` must be the only use of the raw allocation
+            auto raw_uses = get_uses(raw_idx);
+            if( raw_uses.size() != 2 )
+                return Result::Never;
+            const auto& cast_use = (raw_uses[0].vu == ValUsage::Write ? raw_uses[1] : raw_uses[0]);
+            const auto* cast_stmt = get_stmt(cast_use);
+            if( !cast_stmt || !cast_stmt->is_Assign() || !cast_stmt->as_Assign().src.is_Cast() || !cast_stmt->as_Assign().dst.is_Local() )
+                return Result::Never;
+            out.cast_bb = cast_use.bb_idx;
+            out.cast_stmt = cast_use.stmt_idx;
+            out.ptr_idx = cast_stmt->as_Assign().dst.as_Local();
+            const auto& ptr_ty = fcn.locals[out.ptr_idx];
+            if( !(ptr_ty.data().is_Pointer() && ptr_ty.data().as_Pointer().type == ::HIR::BorrowType::Unique) )
+                return Result::Never;
+            out.data_ty = &ptr_ty.data().as_Pointer().inner;
+            size_t  data_size, data_align;
+            bool    size_known = Target_GetSizeAndAlignOf(state.sp, state.m_resolve, *out.data_ty, data_size, data_align);
+            if( size_known && (data_size == 0 || data_size > MAX_PROMOTED_SIZE) )
+                return Result::Never;
+
+            // The pointer must be initialised (`_ptr* = ...`) before anything else in the same block, then only converted into the box
+            out.init_stmt = SIZE_MAX;
+            out.box_idx = ~0u;
+            for(const auto& u : get_uses(out.ptr_idx))
+            {
+                const auto* stmt = get_stmt(u);
+                if( stmt == cast_stmt ) {
+                    continue ;
                 }
-                else if( auto* se = stmt.opt_SaveDropFlag() )
+                if( u.vu == ValUsage::Write && u.lv->m_wrappers.size() == 1 && u.lv->m_wrappers[0].is_Deref()
+                    && u.bb_idx == out.cast_bb && u.stmt_idx > out.cast_stmt && out.init_stmt == SIZE_MAX )
                 {
-                    se->idx = df_rewrite_table[se->idx];
+                    out.init_stmt = u.stmt_idx;
+                    continue ;
                 }
-                else if( auto* se = stmt.opt_ScopeEnd() )
+                if( !stmt && u.lv->is_Local() && out.box_idx == ~0u )
                 {
-                    for(auto it = se->slots.begin(); it != se->slots.end(); )
+                    const auto& te = fcn.blocks[u.bb_idx].terminator.as_Call();
+                    if( te.fcn.is_Intrinsic() && te.fcn.as_Intrinsic().name == "transmute" && te.ret_val.is_Local()
+                        && state.m_resolve.is_type_owned_box(fcn.locals[te.ret_val.as_Local()]) )
                     {
-                        if( local_rewrite_table.at(*it) == ~0u ) {
-                            it = se->slots.erase(it);
-                        }
-                        else {
-                            *it = local_rewrite_table.at(*it);
-                            ++ it;
-                        }
-                    }
-
-                    if( se->slots.empty() ) {
-                        DEBUG(state << "Delete ScopeEnd (now empty)");
-                        to_remove_statements[stmt_idx] = true;
+                        out.box_idx = te.ret_val.as_Local();
                         continue ;
                     }
                 }
-            }
-            state.set_cur_stmt_term(i);
-            // Rewrite and advance
-            visit_mir_lvalues_mut(it->terminator, lvalue_cb);
-            TU_MATCHA( (it->terminator), (e),
-            (Incomplete,
-                ),
-            (Return,
-                ),
-            (Diverge,
-                ),
-            (Goto,
-                e = block_rewrite_table[e];
-                ),
-            (Panic,
-                ),
-            (If,
-                e.bb_true  = block_rewrite_table[e.bb_true ];
-                e.bb_false = block_rewrite_table[e.bb_false];
-                ),
-            (Switch,
-                for(auto& target : e.targets)
-                    target = block_rewrite_table[target];
-                ),
-            (SwitchValue,
-                for(auto& target : e.targets)
-                    target = block_rewrite_table[target];
-                e.def_target = block_rewrite_table[e.def_target];
-                ),
-            (Call,
-                e.ret_block   = block_rewrite_table[e.ret_block];
-                e.panic_block = block_rewrite_table[e.panic_block];
-                )
-            )
-
-            // Delete all statements flagged in a bitmap for deletion
-            assert(it->statements.size() == to_remove_statements.size());
-            auto new_end = ::std::remove_if(it->statements.begin(), it->statements.end(), [&](const auto& s){
-                    size_t stmt_idx = (&s - &it->statements.front());
-                    return to_remove_statements[stmt_idx];
+                if( is_deref_access(*u.lv) ) {
+                    continue ;
+                }
+                return Result::Never;
+            }
+            if( out.init_stmt == SIZE_MAX || out.box_idx == ~0u )
+                return Result::Never;
+            // - Ensure that the initialisation is the first use after the cast
+            for(size_t i = out.cast_stmt + 1; i < out.init_stmt; i ++)
+            {
+                bool    used = false;
+                visit_mir_lvalues(fcn.blocks[out.cast_bb].statements[i], [&](const ::MIR::LValue& lv, ValUsage ) {
+                    if( lv.m_root.is_Local() && lv.m_root.as_Local() == out.ptr_idx )
+                        used = true;
+                    return false;
                     });
-            it->statements.erase(new_end, it->statements.end());
-        }
-        ++it;
-    }
+                if( used )
+                    return Result::Never;
+            }
 
-    auto new_blocks_end = ::std::remove_if(fcn.blocks.begin(), fcn.blocks.end(), [&](const auto& bb) {
-        size_t i = &bb - &fcn.blocks.front();
-        if( !visited[i] ) {
-            DEBUG("GC bb" << i);
+            // Collect the box and any locals it's moved into
+            ::std::vector<unsigned> box_locals;
+            box_locals.push_back(out.box_idx);
+            for(bool added = true; added; )
+            {
+                added = false;
+                for(const auto& bb : fcn.blocks)
+                {
+                    for(const auto& stmt : bb.statements)
+                    {
+                        if( !stmt.is_Assign() || !stmt.as_Assign().dst.is_Local() )
+                            continue ;
+                        const auto& se = stmt.as_Assign();
+                        const auto* src = se.src.is_Use() ? &se.src.as_Use() : se.src.is_Cast() ? &se.src.as_Cast().val : nullptr;
+                        if( !src || !src->is_Local() || ::std::find(box_locals.begin(), box_locals.end(), src->as_Local()) == box_locals.end() )
+                            continue ;
+                        if( ::std::find(box_locals.begin(), box_locals.end(), se.dst.as_Local()) != box_locals.end() )
+                            continue ;
+                        if( !state.m_resolve.is_type_owned_box(fcn.locals[se.dst.as_Local()]) )
+                            continue ;
+                        box_locals.push_back(se.dst.as_Local());
+                        added = true;
+                    }
+                }
+            }
+            // - Each is assigned once, and otherwise only used to access the data, dropped, or moved into another of the set
+            bool    inline_needed = !size_known;
+            out.drops.clear();
+            for(auto idx : box_locals)
+            {
+                unsigned n_writes = 0;
+                for(const auto& u : get_uses(idx))
+                {
+                    const auto* stmt = get_stmt(u);
+                    if( u.lv->is_Local() && u.vu == ValUsage::Write ) {
+                        if( stmt && stmt->is_Drop() ) {
+                            out.drops.push_back(::std::make_pair(u.bb_idx, u.stmt_idx));
+                        }
+                        else {
+                            n_writes += 1;
+                        }
+                        continue ;
+                    }
+                    if( is_deref_access(*u.lv) ) {
+                        continue ;
+                    }
+                    if( u.lv->is_Local() && u.vu != ValUsage::Borrow && stmt && stmt->is_Assign() && stmt->as_Assign().dst.is_Local() ) {
+                        auto dst_idx = stmt->as_Assign().dst.as_Local();
+                        if( ::std::find(box_locals.begin(), box_locals.end(), dst_idx) != box_locals.end() && (stmt->as_Assign().src.is_Use() || stmt->as_Assign().src.is_Cast()) )
+                            continue ;
+                    }
+                    // Passing the box (or a borrow of it) to a call, or returning it, may be removed by inlining
+                    if( u.lv->is_Local() && !stmt && fcn.blocks[u.bb_idx].terminator.is_Call() ) {
+                        inline_needed = true;
+                        continue ;
+                    }
+                    if( u.lv->is_Local() && u.vu != ValUsage::Borrow && stmt && stmt->is_Assign() && stmt->as_Assign().dst.is_Return() && stmt->as_Assign().src.is_Use() ) {
+                        inline_needed = true;
+                        continue ;
+                    }
+                    DEBUG(state << "Box " << ::MIR::LValue::new_Local(out.box_idx) << " escapes via " << *u.lv << " in BB" << u.bb_idx << "/" << u.stmt_idx);
+                    return Result::Never;
+                }
+                if( n_writes != 1 )
+                    return Result::Never;
+            }
+            if( inline_needed )
+                return Result::Later;
+            // - The previous box mustn't still be alive if the allocation is reached again (e.g. in a loop), as the stack slot is reused
+            {
+                ::std::vector<bool> mask( fcn.locals.size() );
+                for(auto idx : box_locals)
+                    mask[idx] = true;
+                auto lifetimes = MIR_Helper_GetLifetimes(state, fcn, /*dump_debug=*/false, &mask);
+                auto alloc_stmt = static_cast<unsigned>(fcn.blocks[alloc_bb].statements.size());
+                if( ::std::any_of(box_locals.begin(), box_locals.end(), [&](unsigned idx){ return lifetimes.slot_valid(idx, alloc_bb, alloc_stmt); }) )
+                {
+                    DEBUG(state << "Box " << ::MIR::LValue::new_Local(out.box_idx) << " is still alive at the allocation");
+                    return Result::Never;
+                }
+            }
+            return Result::Promote;
         }
-        return !visited[i];
-        });
-    fcn.blocks.erase(new_blocks_end, fcn.blocks.end());
 
-    // NOTE: Drop flags are bool, so can't use the above hack
-    for(unsigned int i = 0, j = 0; i < n_df; i ++)
-    {
-        if( !used_dfs[i] )
+    private:
+        ::std::vector<Use> get_uses(unsigned local_idx) const
         {
-            fcn.drop_flags.erase(fcn.drop_flags.begin() + j);
+            ::std::vector<Use>  rv;
+            for(size_t bb_idx = 0; bb_idx < fcn.blocks.size(); bb_idx ++)
+            {
+                const auto& bb = fcn.blocks[bb_idx];
+                size_t stmt_idx = 0;
+                auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+                    if( lv.m_root.is_Local() && lv.m_root.as_Local() == local_idx )
+                        rv.push_back(Use { bb_idx, stmt_idx, &lv, vu });
+                    return false;
+                    };
+                for(; stmt_idx < bb.statements.size(); stmt_idx ++)
+                    visit_mir_lvalues(bb.statements[stmt_idx], cb);
+                visit_mir_lvalues(bb.terminator, cb);
+                if( const auto* te = bb.terminator.opt_Call() )
+                {
+                    for(const auto& a : te->args)
+                        if( const auto* ae = a.opt_Borrow() )
+                            cb(ae->val, ValUsage::Borrow);
+                }
+            }
+            return rv;
         }
-        else
+        const ::MIR::Statement* get_stmt(const Use& u) const
         {
-            j ++;
+            const auto& bb = fcn.blocks[u.bb_idx];
+            return u.stmt_idx < bb.statements.size() ? &bb.statements[u.stmt_idx] : nullptr;
         }
-    }
-
-    // TODO: Detect if any optimisations happened, and return true in that case
-    return false;
+        // Access to the boxed value (i.e. through the pointer within the box)
+        static bool is_deref_access(const ::MIR::LValue& lv)
+        {
+            for(const auto& w : lv.m_wrappers)
+            {
+                if( w.is_Deref() )
+                    return true;
+                if( !w.is_Field() )
+                    return false;
+            }
+            return false;
+        }
+    };
 }
 
-
-#if 0
-// --------------------------------------------------------------------
-// Detect patterns
-// --------------------------------------------------------------------
-bool MIR_Optimise_PatternRec(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+/// Allocations that `MIR_Optimise_PromoteBoxes` might be able to promote once their users are inlined (indexed by the
+/// block the `exchange_malloc` call terminates). These must not be inlined themselves.
+::std::vector<bool> MIR_Optimise_PromoteBoxes_Candidates(::MIR::TypeResolve& state, const ::MIR::Function& fcn)
 {
-    // ASSIGN _1 = VARIANT ? #? (_0: &[T]/&str);
-    // ASSIGN _2 = _0@?.1 (where the variant is (usize, usize)
-    // ->
-    // ASSIGN _2 = DSTMETA _0
+    ::std::vector<bool> rv( fcn.blocks.size() );
+    BoxPromotion    bp { state, fcn };
+    for(size_t bb_idx = 0; bb_idx < fcn.blocks.size(); bb_idx ++)
+    {
+        BoxPromotion::Alloc a;
+        rv[bb_idx] = bp.check(bb_idx, a) != BoxPromotion::Result::Never;
+    }
+    return rv;
 }
-#endif
 
-
-/// Sort basic blocks to approximate program flow (helps when reading MIR)
-void MIR_SortBlocks(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, ::MIR::Function& fcn)
+bool MIR_Optimise_PromoteBoxes(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 {
-    ::std::vector<bool> visited( fcn.blocks.size() );
-    ::std::vector<::std::pair<unsigned,unsigned>> depths( fcn.blocks.size() );
-
-    struct Todo {
-        size_t  bb_idx;
-        unsigned    branch_count;
-        unsigned    level;
-    };
-    unsigned int branches = 0;
-    ::std::vector<Todo> todo;
-    todo.push_back( Todo { 0, 0, 0 } );
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
 
-    while(!todo.empty())
+    BoxPromotion    bp { state, fcn };
+    for(size_t alloc_bb = 0; alloc_bb < fcn.blocks.size(); alloc_bb ++)
     {
-        auto info = todo.back();
-        todo.pop_back();
-        if( visited[info.bb_idx] )
+        BoxPromotion::Alloc a;
+        if( bp.check(alloc_bb, a) != BoxPromotion::Result::Promote )
             continue ;
 
-        visited[info.bb_idx] = true;
-        depths[info.bb_idx] = ::std::make_pair( info.branch_count, info.level );
-        const auto& bb = fcn.blocks[info.bb_idx];
+        DEBUG(state << "Promote box " << ::MIR::LValue::new_Local(a.box_idx) << " (" << *a.data_ty << ") to the stack");
+        auto stack_lv = ::MIR::LValue::new_Local(static_cast<unsigned>(fcn.locals.size()));
+        fcn.locals.push_back(a.data_ty->clone());
 
-        TU_MATCHA( (bb.terminator), (te),
-        (Incomplete,
-            ),
-        (Return,
-            ),
-        (Diverge,
-            ),
-        (Goto,
-            todo.push_back(Todo { te, info.branch_count, info.level + 1 });
-            ),
-        (Panic,
-            todo.push_back(Todo { te.dst, info.branch_count, info.level + 1 });
-            ),
-        (If,
-            todo.push_back(Todo { te.bb_true , ++branches, info.level + 1 });
-            todo.push_back(Todo { te.bb_false, ++branches, info.level + 1 });
-            ),
-        (Switch,
-            for(auto dst : te.targets)
-                todo.push_back(Todo { dst, ++branches, info.level + 1 });
-            ),
-        (SwitchValue,
-            for(auto dst : te.targets)
-                todo.push_back(Todo { dst, ++branches, info.level + 1 });
-            todo.push_back(Todo { te.def_target, info.branch_count, info.level + 1 });
-            ),
-        (Call,
-            todo.push_back(Todo { te.ret_block, info.branch_count, info.level + 1 });
-            todo.push_back(Todo { te.panic_block, ++branches, info.level + 1 });
-            )
-        )
+        // Drop only the contents of the box (and remove shallow drops, which would just free it)
+        ::std::map<size_t, ::std::vector<size_t>>   removed_stmts;
+        for(const auto& d : a.drops)
+        {
+            auto& se = fcn.blocks[d.first].statements[d.second].as_Drop();
+            if( se.kind == ::MIR::eDropKind::SHALLOW ) {
+                removed_stmts[d.first].push_back(d.second);
+            }
+            else {
+                se.slot = ::MIR::LValue::new_Deref(mv$(se.slot));
+            }
+        }
+        // `_ptr* = value` becomes `_stack = value; _ptr = &raw mut _stack`
+        {
+            auto& stmts = fcn.blocks[a.cast_bb].statements;
+            auto& init = stmts[a.init_stmt].as_Assign();
+            init.dst = stack_lv.clone();
+            stmts.insert(stmts.begin() + a.init_stmt + 1, ::MIR::Statement::make_Assign({
+                ::MIR::LValue::new_Local(a.ptr_idx), ::MIR::RValue::make_Borrow({ ::HIR::BorrowType::Unique, true, mv$(stack_lv) })
+                }));
+            for(auto& idx : removed_stmts[a.cast_bb])
+                if( idx > a.init_stmt )
+                    idx += 1;
+            removed_stmts[a.cast_bb].push_back(a.cast_stmt);
+        }
+        for(auto& e : removed_stmts)
+        {
+            auto& stmts = fcn.blocks[e.first].statements;
+            ::std::sort(e.second.begin(), e.second.end());
+            for(auto it = e.second.rbegin(); it != e.second.rend(); ++it)
+                stmts.erase(stmts.begin() + *it);
+        }
+        // And the allocation call is no longer needed
+        auto ret_block = fcn.blocks[alloc_bb].terminator.as_Call().ret_block;
+        fcn.blocks[alloc_bb].terminator = ::MIR::Terminator::make_Goto(ret_block);
+        changed = true;
     }
 
-    // Sort a list of block indexes by `depths`
-    ::std::vector<size_t>   idxes;
-    idxes.reserve(fcn.blocks.size());
-    for(size_t i = 0; i < fcn.blocks.size(); i++)
-        idxes.push_back(i);
-    ::std::sort( idxes.begin(), idxes.end(), [&](auto a, auto b){
-            return depths.at(a) < depths.at(b);
-            });
-
-    DEBUG(idxes);
+    return changed;
+}
 
-    decltype(fcn.blocks)    new_block_list;
-    new_block_list.reserve( fcn.blocks.size() );
-    for(auto idx : idxes)
+/// Check if any call in the function will be simplified using the callee's summary (see `MIR_Optimise_ConstPropagate`
+/// and `MIR_Optimise_DeadAssignments`)
+bool MIR_Optimise_CallSummariesApply(const ::MIR::TypeResolve& state, const ::MIR::Function& fcn)
+{
+    // Pure calls that are only removable if their result is unused
+    ::std::vector<const ::MIR::Terminator::Data_Call*>  pure_calls;
+    for(const auto& bb : fcn.blocks)
     {
-        auto fix_bb_idx = [&](auto idx){ return ::std::find(idxes.begin(), idxes.end(), idx) - idxes.begin(); };
-        new_block_list.push_back( mv$(fcn.blocks[idx]) );
-        new_block_list.back().statements.shrink_to_fit();   // Save some memory
-        visit_terminator_target_mut(new_block_list.back().terminator, [&](auto& te){
-            te = fix_bb_idx(te);
-            });
+        const auto* te = bb.terminator.opt_Call();
+        if( !te )
+            continue ;
+        const auto* summary = get_call_summary(state, *te);
+        if( !summary )
+            continue ;
+        const auto& panic_bb = fcn.blocks[te->panic_block];
+        if( summary->no_unwind && !(panic_bb.statements.empty() && panic_bb.terminator.is_Diverge()) )
+            return true;
+        if( !summary->is_pure )
+            continue ;
+        if( summary->has_const_return || summary->returns_arg < te->args.size() )
+            return true;
+        if( te->ret_val.is_Local() )
+            pure_calls.push_back(te);
     }
-    fcn.blocks = mv$(new_block_list);
-}
-
+    if( pure_calls.empty() )
+        return false;
 
-void MIR_OptimiseCrate(::HIR::Crate& crate, bool do_minimal_optimisation)
-{
-    ::MIR::OuterVisitor ov { crate, [do_minimal_optimisation](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+    // Same definition of "used" as `MIR_Optimise_DeadAssignments`
+    ::std::vector<bool> used_locals( fcn.locals.size() );
+    auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+        if( lv.m_root.is_Local() ) {
+            used_locals[lv.m_root.as_Local()] = true;
+        }
+        for(const auto& w : lv.m_wrappers)
+            if(w.is_Index())
+                used_locals[w.as_Index()] = true;
+        return false;
+        };
+    for(const auto& bb : fcn.blocks)
+    {
+        for(const auto& stmt : bb.statements)
         {
-            //if( ! dynamic_cast<::HIR::ExprNode_Block*>(expr.get()) ) {
-            //    return ;
-            //}
-            auto& mir = expr.get_mir_or_error_mut(Span());
-            if( do_minimal_optimisation ) {
-                MIR_OptimiseMin(res, p, mir, args, ty);
+            if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() )  {
+                visit_mir_lvalues(stmt.as_Assign().src, cb);
             }
             else {
-                MIR_Optimise(res, p, mir, args, ty);
+                visit_mir_lvalues(stmt, cb);
             }
-            // Run cleanup to handle now-monomoprhised inlined constants
-            MIR_Cleanup(res, p, mir, args, ty);
         }
-        };
-    ov.visit_crate(crate);
+        const auto* te = bb.terminator.opt_Call();
+        const ::MIR::LValue* pure_ret_val = (te && ::std::find(pure_calls.begin(), pure_calls.end(), te) != pure_calls.end()) ? &te->ret_val : nullptr;
+        visit_mir_lvalues(bb.terminator, [&](const ::MIR::LValue& lv, ValUsage vu) {
+            return &lv == pure_ret_val ? false : cb(lv, vu);
+            });
+    }
+    for(const auto* te : pure_calls)
+    {
+        if( !used_locals[te->ret_val.as_Local()] )
+            return true;
+    }
+    return false;
 }
 
 void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list, bool post_save)
@@ -6293,47 +8452,139 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list, bool
         }
     }
 
-    const size_t  MAX_ITERATIONS = 5; // TODO: Tune this.
-    size_t  num_iterations = 0;
-    bool did_inline_on_pass;
-    do
+    // Build the call graph (direct calls between functions in the list)
+    struct Node {
+        TransList_Function* ent;
+        ::MIR::Function*    mir;
+        ::std::vector<unsigned> callees;
+        // Tarjan state
+        unsigned    index = ~0u;
+        unsigned    lowlink = 0;
+        bool    on_stack = false;
+    };
+    ::std::vector<Node>  nodes;
+    ::std::map<const ::HIR::Path*, unsigned>    node_idx;
+    nodes.reserve(list.m_functions.size());
+    for(auto& fcn_ent : list.m_functions)
     {
-        did_inline_on_pass = false;
-
-        for(auto& fcn_ent : list.m_functions)
+        auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.second->ptr);
+        Node    n;
+        n.ent = &*fcn_ent.second;
+        n.mir = fcn_ent.second->monomorphised.code ? &*fcn_ent.second->monomorphised.code
+            : hir_fcn.m_code ? &hir_fcn.m_code.get_mir_or_error_mut(Span())
+            : nullptr;
+        node_idx.insert(::std::make_pair(&fcn_ent.first, static_cast<unsigned>(nodes.size())));
+        nodes.push_back(::std::move(n));
+    }
+    for(auto& n : nodes)
+    {
+        if( !n.mir )
+            continue ;
+        for(const auto& bb : n.mir->blocks)
         {
-            const auto& path = fcn_ent.first;
-            //const auto& pp = fcn_ent.second->pp;
-            auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.second->ptr);
-            auto& mono_fcn = fcn_ent.second->monomorphised;
-
-            ::std::string s = FMT(path);
-            ::HIR::ItemPath ip(s);
-
-            if( mono_fcn.code )
+            if( const auto* te = bb.terminator.opt_Call() )
             {
-                did_inline_on_pass |= MIR_OptimiseInline(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty, list);
-
-                MIR_Cleanup(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty);
+                if( !te->fcn.is_Path() )
+                    continue ;
+                auto it = list.m_functions.find(te->fcn.as_Path());
+                if( it != list.m_functions.end() )
+                    n.callees.push_back( node_idx.at(&it->first) );
             }
-            else if( hir_fcn.m_code )
-            {
-                auto& mir = hir_fcn.m_code.get_mir_or_error_mut(Span());
-                bool did_opt = MIR_OptimiseInline(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return, list);
-                mir.trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
-                did_inline_on_pass |= did_opt;
+        }
+    }
 
-                MIR_Cleanup(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return);
-            }
-            else
+    // Find strongly-connected components (iterative Tarjan)
+    // - Components are completed in reverse topological order, i.e. callees before their callers
+    ::std::vector<unsigned> scc_order;  // Node indexes, grouped by component, in completion order
+    {
+        unsigned next_index = 0;
+        unsigned next_scc = 0;
+        ::std::vector<unsigned> stack;
+        ::std::vector<::std::pair<unsigned,size_t>>  call_stack; // (node, next callee)
+        for(unsigned root = 0; root < nodes.size(); root ++)
+        {
+            if( nodes[root].index != ~0u )
+                continue ;
+            call_stack.push_back(::std::make_pair(root, 0));
+            while( !call_stack.empty() )
             {
-                // Extern, no optimisations
+                unsigned v = call_stack.back().first;
+                size_t& ci = call_stack.back().second;
+                auto& n = nodes[v];
+                if( ci == 0 && n.index == ~0u )
+                {
+                    n.index = n.lowlink = next_index++;
+                    stack.push_back(v);
+                    n.on_stack = true;
+                }
+                if( ci < n.callees.size() )
+                {
+                    unsigned w = n.callees[ci++];
+                    if( nodes[w].index == ~0u ) {
+                        call_stack.push_back(::std::make_pair(w, 0));
+                    }
+                    else if( nodes[w].on_stack ) {
+                        n.lowlink = ::std::min(n.lowlink, nodes[w].index);
+                    }
+                    continue ;
+                }
+                // All callees visited
+                if( n.lowlink == n.index )
+                {
+                    unsigned w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        nodes[w].on_stack = false;
+                        nodes[w].ent->scc_index = next_scc;
+                        scc_order.push_back(w);
+                    } while( w != v );
+                    next_scc += 1;
+                }
+                call_stack.pop_back();
+                if( !call_stack.empty() ) {
+                    auto& p = nodes[call_stack.back().first];
+                    p.lowlink = ::std::min(p.lowlink, n.lowlink);
+                }
             }
         }
-    } while( did_inline_on_pass && num_iterations < MAX_ITERATIONS );
+        DEBUG(nodes.size() << " functions in " << next_scc << " call graph components");
+    }
 
-    if( did_inline_on_pass )
+    // Inline bottom-up: by the time a function is processed, all of its callees (outside its own component) have
+    // already had their own callees inlined.
+    for(unsigned idx : scc_order)
     {
-        DEBUG("Ran inlining optimise pass to exhaustion (maximum of " << MAX_ITERATIONS << " hit");
+        auto& n = nodes[idx];
+        if( !n.mir )
+        {
+            // Extern, no optimisations
+            continue ;
+        }
+        const auto& path = *n.ent->path;
+        auto& hir_fcn = *const_cast<::HIR::Function*>(n.ent->ptr);
+        auto& mono_fcn = n.ent->monomorphised;
+
+        ::std::string s = FMT(path);
+        ::HIR::ItemPath ip(s);
+
+        const auto& args = mono_fcn.code ? mono_fcn.arg_tys : hir_fcn.m_args;
+        const auto& ret_ty = mono_fcn.code ? mono_fcn.ret_ty : hir_fcn.m_return;
+        MIR_OptimiseInline(resolve, ip, *n.mir, args, ret_ty, list, n.ent->scc_index);
+        if( !mono_fcn.code )
+        {
+            n.mir->trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
+        }
+        MIR_Cleanup(resolve, ip, *n.mir, args, ret_ty);
+
+        // Summarise the now-optimised function for its callers (which are all processed later)
+        // - Only non-generic functions are exported, as downstream crates do their own monomorphisation
+        {
+            static Span sp;
+            ::MIR::TypeResolve   state { sp, resolve, FMT_CB(ss, ss << path;), ret_ty, args, *n.mir };
+            auto summary = MIR_Optimise_Summarise(state, *n.mir);
+            summary.is_exported = !mono_fcn.code;
+            crate.m_function_summaries[path.clone()] = ::std::move(summary);
+        }
     }
 }
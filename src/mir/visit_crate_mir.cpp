@@ -7,6 +7,8 @@
  */
 #include "visit_crate_mir.hpp"
 #include <hir/expr.hpp>
+#include <memory>   // shared_ptr
+#include <set>
 
 // NOTE: This is left here to ensure that any expressions that aren't handled by higher code cause a failure
 void MIR::OuterVisitor::visit_expr(::HIR::ExprPtr& exp)
@@ -92,3 +94,34 @@ void MIR::OuterVisitor::visit_trait_impl(const ::HIR::SimplePath& trait_path, ::
     auto _ = this->m_resolve.set_impl_generics(impl.m_type, impl.m_params);
     ::HIR::Visitor::visit_trait_impl(trait_path, impl);
 }
+
+void MIR::visit_crate_parallel(::HIR::Crate& crate, parallel_cb_t cb)
+{
+    // Everything passed to the `OuterVisitor` callback can be a temporary, so is copied for the job
+    struct Body {
+        ::HIR::ItemPathOwned    path;
+        StaticTraitResolve::SavedGenerics   generics;
+        ::HIR::ExprPtr* expr;
+        const ::HIR::Function::args_t*  args;
+        ::HIR::TypeRef  ret_type;
+    };
+    static const ::HIR::Function::args_t   empty_args;
+
+    ::parallel::OrderedQueue    queue;
+    ::std::set<const ::HIR::ExprPtr*>   seen;
+    OuterVisitor    ov { crate, [&](const StaticTraitResolve& res, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& expr, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type) {
+        // Array size expressions are shared between copies of the type, and must not be run twice at once
+        if( !seen.insert(&expr).second )
+            return ;
+        // NOTE: Non-empty argument lists are only passed for functions, and those are owned by the crate
+        auto body = ::std::make_shared<Body>(Body { ip, res.save_generics(), &expr, args.empty() ? &empty_args : &args, ret_type.clone() });
+        queue.push([&crate,&cb,body](::parallel::OrderedQueue::Commits& commits) {
+            StaticTraitResolve  resolve { crate };
+            resolve.set_saved_generics(body->generics);
+            cb(resolve, body->path.get(), *body->expr, *body->args, body->ret_type, commits);
+            });
+        } };
+    ov.visit_crate(crate);
+    DEBUG(queue.size() << " bodies");
+    queue.run();
+}
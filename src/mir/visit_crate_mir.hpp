@@ -8,6 +8,7 @@
 #pragma once
 #include <hir/visitor.hpp>
 #include <hir_typeck/static.hpp>
+#include <parallel.hpp>
 
 namespace MIR {
 
@@ -43,5 +44,13 @@ public:
     void visit_trait_impl(const ::HIR::SimplePath& trait_path, ::HIR::TraitImpl& impl) override;
 };
 
+/// Callback for `visit_crate_parallel`, as for `OuterVisitor` but with somewhere to record changes to the crate
+typedef ::std::function<void(const StaticTraitResolve& resolve, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& expr, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type, ::parallel::OrderedQueue::Commits& commits)>  parallel_cb_t;
+
+/// Visit the same bodies as `OuterVisitor` (but each only once), and run the callback on up to `parallel::thread_count()` threads
+///
+/// Each body gets its own resolver. The callback may only modify its own body, anything else (e.g. adding items to the
+/// crate) must be pushed to `commits` - which are applied in visit order once all bodies are done.
+extern void visit_crate_parallel(::HIR::Crate& crate, parallel_cb_t cb);
 
 }   // namespace MIR
@@ -0,0 +1,173 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * parallel.cpp
+ * - Running independent per-item work on multiple threads
+ */
+#include <parallel.hpp>
+#include <refcount.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    unsigned    s_thread_count = 1;
+
+    /// Worker scheduling state
+    /// - Workers count themselves as running while processing an item
+    /// - An `Exclusive` section waits until no other worker is running, and blocks new items from starting
+    struct State
+    {
+        ::std::mutex    lock;
+        ::std::condition_variable   cv;
+        /// Set while `for_each` has threads running
+        bool    active = false;
+        /// Number of workers currently inside an item (and not waiting for/holding an exclusive section)
+        unsigned    n_running = 0;
+        /// Number of workers waiting to enter an exclusive section
+        unsigned    n_exclusive_waiting = 0;
+        bool    exclusive_held = false;
+    } s_state;
+
+    thread_local bool   s_in_worker = false;
+    thread_local unsigned   s_exclusive_depth = 0;
+
+    void begin_item()
+    {
+        ::std::unique_lock<::std::mutex>    lh(s_state.lock);
+        // Exclusive sections take priority over starting new items
+        s_state.cv.wait(lh, []{ return !s_state.exclusive_held && s_state.n_exclusive_waiting == 0; });
+        s_state.n_running += 1;
+    }
+    void end_item()
+    {
+        ::std::lock_guard<::std::mutex>    lh(s_state.lock);
+        s_state.n_running -= 1;
+        s_state.cv.notify_all();
+    }
+}
+
+namespace parallel {
+
+void set_thread_count(unsigned n)
+{
+    s_thread_count = ::std::max(n, 1u);
+}
+unsigned thread_count()
+{
+    return s_thread_count;
+}
+
+bool in_worker()
+{
+    return s_in_worker;
+}
+
+void for_each(size_t count, ::std::function<void(size_t)> fcn)
+{
+    if( s_thread_count <= 1 || count <= 1 || s_state.active )
+    {
+        for(size_t i = 0; i < count; i ++)
+            fcn(i);
+        return ;
+    }
+
+    size_t n_threads = ::std::min<size_t>(s_thread_count, count);
+    ::std::atomic<size_t>   next_item { 0 };
+    ::std::atomic<bool> failed { false };
+    ::std::vector<::std::exception_ptr> errors(count);
+
+    auto worker = [&]() {
+        s_in_worker = true;
+        for(;;)
+        {
+            begin_item();
+            size_t i = next_item.fetch_add(1);
+            if( i >= count || failed ) {
+                end_item();
+                break;
+            }
+            try
+            {
+                fcn(i);
+            }
+            catch(...)
+            {
+                errors[i] = ::std::current_exception();
+                failed = true;
+            }
+            end_item();
+        }
+        s_in_worker = false;
+    };
+
+    s_state.active = true;
+    RefCount::threaded() = true;
+    ::std::vector<::std::thread>    threads;
+    threads.reserve(n_threads - 1);
+    for(size_t i = 1; i < n_threads; i ++)
+        threads.push_back(::std::thread(worker));
+    worker();
+    for(auto& t : threads)
+        t.join();
+    RefCount::threaded() = false;
+    s_state.active = false;
+
+    for(const auto& e : errors)
+    {
+        if(e)
+            ::std::rethrow_exception(e);
+    }
+}
+
+void OrderedQueue::run()
+{
+    auto jobs = ::std::move(m_jobs);
+    m_jobs.clear();
+    ::std::vector<Commits>  commits(jobs.size());
+    for_each(jobs.size(), [&](size_t i) {
+        jobs[i](commits[i]);
+        // Release anything captured by the job while still (potentially) on a worker
+        jobs[i] = job_t();
+        });
+    for(auto& c : commits)
+    {
+        for(auto& e : c.m_ents)
+            e();
+    }
+}
+
+Exclusive::Exclusive():
+    m_locked(s_in_worker && s_exclusive_depth == 0)
+{
+    s_exclusive_depth += 1;
+    if( !m_locked )
+        return ;
+
+    ::std::unique_lock<::std::mutex>    lh(s_state.lock);
+    // Stop counting as running (so other waiters can proceed), then wait until nothing else is
+    s_state.n_running -= 1;
+    s_state.n_exclusive_waiting += 1;
+    s_state.cv.notify_all();
+    s_state.cv.wait(lh, []{ return !s_state.exclusive_held && s_state.n_running == 0; });
+    s_state.n_exclusive_waiting -= 1;
+    s_state.exclusive_held = true;
+}
+Exclusive::~Exclusive()
+{
+    s_exclusive_depth -= 1;
+    if( !m_locked )
+        return ;
+
+    ::std::lock_guard<::std::mutex>    lh(s_state.lock);
+    s_state.exclusive_held = false;
+    s_state.n_running += 1;
+    s_state.cv.notify_all();
+}
+
+}   // namespace parallel
@@ -10,6 +10,7 @@
 #include <string>
 #include <iostream>
 #include <algorithm>    // std::max
+#include <mutex>
 
 RcString::RcString(const char* s, size_t len):
     m_ptr(nullptr)
@@ -18,7 +19,7 @@ RcString::RcString(const char* s, size_t len):
     {
         size_t nwords = (len+1 + sizeof(unsigned int)-1) / sizeof(unsigned int);
         m_ptr = reinterpret_cast<Inner*>(malloc(sizeof(Inner) + (nwords - 1) * sizeof(unsigned int)));
-        m_ptr->refcount = 1;
+        new(&m_ptr->refcount) RefCount(1);
         m_ptr->size = static_cast<unsigned>(len);
         m_ptr->ordering = 0;
         char* data_mut = reinterpret_cast<char*>(m_ptr->data);
@@ -31,9 +32,8 @@ RcString::~RcString()
 {
     if(m_ptr)
     {
-        m_ptr->refcount -= 1;
         //::std::cout << "RcString(" << m_ptr << " \"" << *this << "\") - " << *m_ptr << " refs left (drop)" << ::std::endl;
-        if( m_ptr->refcount == 0 )
+        if( m_ptr->refcount.dec() )
         {
             free(m_ptr);
         }
@@ -251,12 +251,17 @@ namespace {
     };
 }
 TieredSet*   RcString_interned_strings;
-bool    RcString_interned_ordering_valid;
+::std::atomic<bool> RcString_interned_ordering_valid;
+// Only locked while worker threads are running (see `RefCount::threaded`)
+::std::mutex    RcString_interned_lock;
 
 RcString RcString::new_interned(const char* s, size_t len)
 {
     if(len == 0)
         return RcString();
+    ::std::unique_lock<::std::mutex>    lh(RcString_interned_lock, ::std::defer_lock);
+    if(RefCount::threaded())
+        lh.lock();
     if(!RcString_interned_strings) {
         RcString_interned_strings = new TieredSet;
     }
@@ -275,6 +280,10 @@ Ordering RcString::ord_interned(const RcString& s) const
     assert(s.is_interned() && this->is_interned());
     if(!RcString_interned_ordering_valid)
     {
+        // The ordering indexes can't be updated while other threads may be reading them, but they're the same as the
+        // string ordering anyway.
+        if(RefCount::threaded())
+            return ord(s.c_str(), s.size());
         // Populate cache
         unsigned i = 1;
         assert(RcString_interned_strings);
@@ -26,15 +26,14 @@ Span::Span(const Span& x):
     m_ptr(x.m_ptr)
 {
     if( m_ptr ) {
-        m_ptr->reference_count += 1;
+        m_ptr->reference_count.inc();
     }
 }
 Span::~Span()
 {
     if(m_ptr)
     {
-        m_ptr->reference_count --;
-        if( m_ptr->reference_count == 0 )
+        if( m_ptr->reference_count.dec() )
         {
             delete m_ptr;
         }
@@ -130,7 +129,6 @@ void SpanInner_Macro::fmt(::std::ostream& os) const
 /*static*/ SpanInner* SpanInner_Macro::alloc(Span parent, RcString crate, RcString macro)
 {
     auto rv = new SpanInner_Macro;
-    rv->reference_count = 1;
     rv->parent_span = std::move(parent);
     rv->crate = std::move(crate);
     rv->macro = std::move(macro);
@@ -15,6 +15,7 @@
 
 #include "codegen.hpp"
 #include "monomorphise.hpp"
+#include "mangling.hpp"
 
 void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, ::HIR::CratePtr crate_ptr, TransList list, const ::std::string& hir_file)
 {
@@ -27,7 +28,7 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
     }
     else if( opt.mode == "c" )
     {
-        codegen = Trans_Codegen_GetGeneratorC(*crate_ptr, outfile);
+        codegen = Trans_Codegen_GetGeneratorC(*crate_ptr, outfile, opt);
     }
     else
     {
@@ -180,6 +181,7 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
             const auto& fcn = *ent.second->ptr;
             const auto& pp = ent.second->pp;
             TRACE_FUNCTION_F(path);
+            TRACE_SPAN_F("Codegen", path);
             DEBUG("FUNCTION CODE " << path);
             // `is_extern` is set if there's no HIR (i.e. this function is from an external crate)
             bool is_extern = ! static_cast<bool>(fcn.m_code);
@@ -210,5 +212,10 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
     list = TransList();
     // Would drop the entire crate, but finalise tends to need it
     codegen->finalise(opt, out_ty, hir_file);
+
+    if( opt.symbol_map_file != "" )
+    {
+        Trans_Mangle_WriteSymbolMap(opt.symbol_map_file);
+    }
 }
 
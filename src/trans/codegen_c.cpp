@@ -21,8 +21,32 @@
 #include <iomanip>
 #include "target_version.hpp"
 #include <string_view.hpp>
+#ifdef _WIN32
+# include <direct.h>    // _mkdir, _getcwd
+#else
+# include <sys/stat.h>  // mkdir
+# include <unistd.h>    // getcwd
+#endif
 
 namespace {
+    /// Absolute path of the directory containing `path`
+    ::std::string get_absolute_dir(const ::std::string& path)
+    {
+        auto dir_end = path.find_last_of("/\\");
+        auto dir = (dir_end == ::std::string::npos ? ::std::string() : path.substr(0, dir_end));
+        bool is_absolute = (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+        if( is_absolute )
+            return dir;
+        char cwd[4096];
+#ifdef _WIN32
+        if( !_getcwd(cwd, sizeof(cwd)) )
+#else
+        if( !getcwd(cwd, sizeof(cwd)) )
+#endif
+            BUG(Span(), "Unable to get the current directory");
+        return dir == "" ? ::std::string(cwd) : FMT(cwd << "/" << dir);
+    }
+
     struct FmtShell
     {
         const ::std::string& s;
@@ -201,6 +225,73 @@ namespace {
         return rv;
     }
 
+    struct GccDetection
+    {
+        /// Compiler command (see `detect_gcc` for how it's picked)
+        ::std::string   command;
+        /// The compiler is clang (which also defines `__GNUC__`, but lacks some GNU C extensions)
+        bool    is_clang = false;
+        /// Value of `__GNUC__` (0 if the compiler couldn't be queried)
+        unsigned    major_version = 0;
+    };
+
+    const GccDetection& detect_gcc()
+    {
+        static GccDetection rv;
+        static bool done = false;
+        if( done )
+            return rv;
+        done = true;
+        // Pick the compiler
+        // - from `CC_${TRIPLE}` environment variable, with all '-' in TRIPLE replaced by '_'
+        // - from the `CC` environment variable
+        // - `${TRIPLE}-gcc` (if available)
+        // - `gcc` as fallback
+        std::string varname = "CC_" +  Target_GetCurSpec().m_backend_c.m_c_compiler;
+        std::replace(varname.begin(), varname.end(), '-', '_');
+
+        if( getenv(varname.c_str()) ) {
+            rv.command = getenv(varname.c_str());
+        }
+        else if( getenv("CC") ) {
+            rv.command = getenv("CC");
+        }
+        else if (system(("command -v " + Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" + " >/dev/null 2>&1").c_str()) == 0) {
+            rv.command = Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc";
+        }
+        else {
+            rv.command = "gcc";
+        }
+
+        // Ask the compiler for its predefined macros, to tell GCC from clang (and get the version)
+#ifdef _WIN32
+        FILE* fp = _popen((rv.command + " -dM -E -x c NUL 2>NUL").c_str(), "r");
+#else
+        FILE* fp = popen((rv.command + " -dM -E -x c /dev/null 2>/dev/null").c_str(), "r");
+#endif
+        if( fp )
+        {
+            char line[256];
+            while( fgets(line, sizeof(line), fp) )
+            {
+                unsigned v;
+                if( strncmp(line, "#define __clang__ ", 18) == 0 ) {
+                    rv.is_clang = true;
+                }
+                else if( sscanf(line, "#define __GNUC__ %u", &v) == 1 ) {
+                    rv.major_version = v;
+                }
+            }
+#ifdef _WIN32
+            _pclose(fp);
+#else
+            pclose(fp);
+#endif
+        }
+        DEBUG("C compiler `" << rv.command << "`: clang=" << rv.is_clang << " __GNUC__=" << rv.major_version);
+        return rv;
+    }
+
     enum class AtomicOp
     {
         Add,
@@ -231,6 +322,8 @@ namespace {
 
         ::std::string   m_outfile_path;
         ::std::string   m_outfile_path_c;
+        /// Path to the shared prelude header (empty if the prelude is emitted inline)
+        ::std::string   m_prelude_path;
 
         ::std::ofstream m_of;
         const ::MIR::TypeResolve* m_mir_res = nullptr;
@@ -239,13 +332,20 @@ namespace {
         struct {
             bool emulated_i128 = false;
             bool disallow_empty_structs = false;
+            /// Emit attributes/builtins for facts known from the source (`-C c-hints`)
+            bool emit_hints = false;
+            /// Panics unwind through landing pads (`-C landing-pads`), see `get_landing_pads`
+            bool landing_pads = false;
         } m_options;
 
+        /// Landing pad state for each block of the function being emitted (empty if it has no landing pads)
+        ::std::vector<unsigned> m_landing_pads;
+
 
         ::std::set< ::HIR::TypeRef> m_emitted_fn_types;
         ::std::set< const TypeRepr*>    m_embedded_tags;
     public:
-        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile):
+        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
             m_crate(crate),
             m_resolve(crate),
             m_outfile_path(outfile),
@@ -273,11 +373,56 @@ namespace {
                 m_options.disallow_empty_structs = true;
                 break;
             }
+            // NOTE: Only GCC/Clang attributes are emitted
+            m_options.emit_hints = opt.emit_hints && m_compiler == Compiler::Gcc;
+            // Landing pads use GNU C nested functions and non-local `goto`, which MSVC and clang don't support
+            m_options.landing_pads = opt.landing_pads && m_compiler == Compiler::Gcc && !detect_gcc().is_clang;
+            if( opt.landing_pads && !m_options.landing_pads )
+            {
+                WARNING(Span(), W0000, "-C landing-pads is only supported with GCC, panics will use setjmp/longjmp");
+            }
 
+            // Profile-guided builds: GCC checksums each function's source file name, so refer to the source by name only.
+            // That way the instrumented and optimised builds can be done in different directories.
+            const bool is_pgo = opt.profile_generate_dir != "" || opt.profile_use_dir != "";
+            if( is_pgo && m_compiler == Compiler::Gcc )
+            {
+                auto name_start = m_outfile_path_c.find_last_of("/\\");
+                m_of << "#line 1 \"" << m_outfile_path_c.substr(name_start == ::std::string::npos ? 0 : name_start+1) << "\"\n";
+            }
             m_of
                 << "/*\n"
                 << " * AUTOGENERATED by mrustc\n"
                 << " */\n"
+                ;
+
+            // Helpers that are identical for every crate (for a given target/compiler) live in a shared prelude
+            // header, so the C compiler can use a pre-compiled copy instead of re-parsing them for every crate.
+            // - MSVC's PCH model doesn't fit (needs a matching source file), so the prelude is emitted inline there.
+            // - Set `MRUSTC_C_PRELUDE_INLINE` to get self-contained `.c` files (useful when debugging).
+            ::std::stringstream prelude;
+            emit_prelude(prelude);
+            // - Also inline for profile-guided builds, so the prelude's functions are covered by the `#line` above
+            if( m_compiler == Compiler::Gcc && !is_pgo && !getenv("MRUSTC_C_PRELUDE_INLINE") )
+            {
+                m_prelude_path = write_prelude_header(prelude.str());
+                auto name_start = m_prelude_path.find_last_of("/\\");
+                // NOTE: The prelude is in the same directory as the generated source, so include it by name
+                m_of << "#include \"" << m_prelude_path.substr(name_start == ::std::string::npos ? 0 : name_start+1) << "\"\n";
+            }
+            else
+            {
+                m_of << prelude.str();
+            }
+        }
+
+        ~CodeGenerator_C() {}
+
+    private:
+        /// Emit the crate-independent part of the generated source (includes, typedefs, and helper functions)
+        void emit_prelude(::std::ostream& os)
+        {
+            os
                 << "#include <stddef.h>\n"
                 << "#include <stdint.h>\n"
                 << "#include <stdbool.h>\n"
@@ -287,7 +432,7 @@ namespace {
             switch(m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                os
                     << "#include <stdatomic.h>\n"   // atomic_*
                     << "#include <stdlib.h>\n"  // abort
                     << "#include <string.h>\n"  // mem*
@@ -296,7 +441,7 @@ namespace {
                     ;
                 break;
             case Compiler::Msvc:
-                m_of
+                os
                     << "#include <windows.h>\n"
                     << "#include <math.h>\n"  // fabsf, ...
                     << "#include <intrin.h>\n"
@@ -305,7 +450,7 @@ namespace {
                     ;
                 break;
             }
-            m_of
+            os
                 << "typedef uint32_t RUST_CHAR;\n"
                 << "typedef uint8_t RUST_BOOL;\n"
                 << "typedef struct { void* PTR; size_t META; } SLICE_PTR;\n"
@@ -314,7 +459,7 @@ namespace {
                 ;
             if( m_options.disallow_empty_structs )
             {
-                m_of
+                os
                     << "typedef struct { char _d; } tUNIT;\n"
                     << "typedef char tBANG;\n"
                     << "typedef struct { char _d; } tTYPEID;\n"
@@ -322,26 +467,31 @@ namespace {
             }
             else
             {
-                m_of
+                os
                     << "typedef struct { } tUNIT;\n"
                     << "typedef struct { } tBANG;\n"
                     << "typedef struct { } tTYPEID;\n"
                     ;
             }
-            m_of
+            os
                 << "static inline size_t ALIGN_TO(size_t s, size_t a) { return (s + a-1) / a * a; }\n"
                 << "\n"
                 ;
             switch(m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                os
                     << "extern void _Unwind_Resume(void) __attribute__((noreturn));\n"
                     << "#define ALIGNOF(t) __alignof__(t)\n"
                     ;
+                if( m_options.landing_pads )
+                {
+                    // The real signature, to continue unwinding the current panic after running a cleanup block
+                    os << "extern void mrustc_unwind_resume(void* exc) __asm__(\"_Unwind_Resume\") __attribute__((noreturn));\n";
+                }
                 break;
             case Compiler::Msvc:
-                m_of
+                os
                     << "__declspec(noreturn) static void _Unwind_Resume(void) { abort(); }\n"
                     << "#define ALIGNOF(t) __alignof(t)\n"
                     ;
@@ -352,12 +502,12 @@ namespace {
             switch (m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                os
                     << "extern __thread jmp_buf*    mrustc_panic_target;\n"
                     << "extern __thread void* mrustc_panic_value;\n"
                     ;
                 // 64-bit bit ops (gcc intrinsics)
-                m_of
+                os
                     << "static inline uint64_t __builtin_clz64(uint64_t v) {\n"
                     << "\treturn ( (v >> 32) != 0 ? __builtin_clz(v>>32) : 32 + __builtin_clz(v));\n"
                     << "}\n"
@@ -368,7 +518,7 @@ namespace {
                 // Atomic hackery
                 for(int sz = 8; sz <= 64; sz *= 2)
                 {
-                    m_of
+                    os
                         << "static inline uint"<<sz<<"_t __mrustc_atomicloop"<<sz<<"(volatile uint"<<sz<<"_t* slot, uint"<<sz<<"_t param, int ordering, uint"<<sz<<"_t (*cb)(uint"<<sz<<"_t, uint"<<sz<<"_t)) {"
                         << " int ordering_load = (ordering == memory_order_release || ordering == memory_order_acq_rel ? memory_order_relaxed : ordering);" // If Release, Load with Relaxed
                         << " for(;;) {"
@@ -380,7 +530,7 @@ namespace {
                 }
                 break;
             case Compiler::Msvc:
-                m_of
+                os
                     << "static inline int32_t __builtin_popcountll(uint64_t v) {\n"
                     << "\treturn __popcnt(v & 0xFFFFFFFF) + __popcnt(v >> 32);\n"
                     << "}\n"
@@ -588,7 +738,7 @@ namespace {
                 // Atomic hackery
                 for(int sz = 8; sz <= 64; sz *= 2)
                 {
-                    m_of
+                    os
                         << "static inline uint"<<sz<<"_t __mrustc_atomicloop"<<sz<<"(volatile uint"<<sz<<"_t* slot, uint"<<sz<<"_t param, uint"<<sz<<"_t (*cb)(uint"<<sz<<"_t, uint"<<sz<<"_t)) {"
                         << " for(;;) {"
                         << " uint"<<sz<<"_t v = InterlockedCompareExchange" << sz << "(slot, 0,0);"
@@ -602,7 +752,7 @@ namespace {
 
             if( m_options.emulated_i128 )
             {
-                m_of
+                os
                     << "typedef struct { uint64_t lo, hi; } uint128_t;\n"
                     << "typedef struct { uint64_t lo, hi; } int128_t;\n"
                     << "static inline uint128_t intrinsic_ctlz_u128(uint128_t v);\n"
@@ -753,7 +903,7 @@ namespace {
             else
             {
                 // GCC-only
-                m_of
+                os
                     << "typedef unsigned __int128 uint128_t;\n"
                     << "typedef signed __int128 int128_t;\n"
                     << "static inline uint128_t __builtin_bswap128(uint128_t v) {\n"
@@ -771,7 +921,7 @@ namespace {
             }
 
             // Common helpers
-            m_of
+            os
                 << "\n"
                 << "static inline int slice_cmp(SLICE_PTR l, SLICE_PTR r) {\n"
                 << "\tint rv = memcmp(l.PTR, r.PTR, l.META < r.META ? l.META : r.META);\n"
@@ -805,11 +955,11 @@ namespace {
                 ;
             if( m_options.emulated_i128 )
             {
-                m_of << "static inline uint128_t __mrustc_bitrev128(uint128_t v) { uint128_t rv = { __mrustc_bitrev64(v.hi), __mrustc_bitrev64(v.lo) }; return rv; }\n";
+                os << "static inline uint128_t __mrustc_bitrev128(uint128_t v) { uint128_t rv = { __mrustc_bitrev64(v.hi), __mrustc_bitrev64(v.lo) }; return rv; }\n";
             }
             else
             {
-                m_of << "static inline uint128_t __mrustc_bitrev128(uint128_t v) {"
+                os << "static inline uint128_t __mrustc_bitrev128(uint128_t v) {"
                     << " if(v==0) return 0;"
                     << " uint128_t rv = ((uint128_t)__mrustc_bitrev64(v>>64))|((uint128_t)__mrustc_bitrev64(v)<<64);"
                     << " return rv;"
@@ -818,7 +968,7 @@ namespace {
             }
             for(int sz = 8; sz <= 64; sz *= 2)
             {
-                m_of
+                os
                     << "static inline uint"<<sz<<"_t __mrustc_op_umax"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return (a > b ? a : b); }\n"
                     << "static inline uint"<<sz<<"_t __mrustc_op_umin"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return (a < b ? a : b); }\n"
                     << "static inline uint"<<sz<<"_t __mrustc_op_imax"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return ((int"<<sz<<"_t)a > (int"<<sz<<"_t)b ? a : b); }\n"
@@ -828,7 +978,7 @@ namespace {
             }
 
             // Float16 and Float128
-            m_of
+            os
                 << "typedef struct f16 { uint16_t v; } f16;\n"
                 << "static f16 f16_disabled(){ abort(); }\n"
                 << "static int f16_cmp(f16 a, f16 b){ abort(); }\n"
@@ -837,8 +987,79 @@ namespace {
                 << "static int f128_cmp(f128 a, f128 b){ abort(); }\n"
                 ;
         }
-
-        ~CodeGenerator_C() {}
+        /// Write the prelude to a header next to the output (named by a hash of its contents, so it's shared by
+        /// every crate built with the same target and compiler), returning its path.
+        ::std::string write_prelude_header(const ::std::string& contents)
+        {
+            auto dir_end = m_outfile_path.find_last_of("/\\");
+            auto dir = (dir_end == ::std::string::npos ? ::std::string() : m_outfile_path.substr(0, dir_end+1));
+            auto hash = ::std::hash<::std::string>()(contents);
+            auto path = FMT(dir << "mrustc-prelude-" << ::std::hex << hash << ".h");
+
+            // Already generated (by this or another invocation)
+            if( ::std::ifstream(path).good() )
+                return path;
+            // Write to a temporary and rename, so parallel builds never see a partial header
+            auto tmp_path = FMT(path << "." << ::std::hex << ::std::hash<::std::string>()(m_outfile_path) << ".tmp");
+            {
+                ::std::ofstream of(tmp_path);
+                ASSERT_BUG(Span(), of.is_open(), "Failed to open `" << tmp_path << "` for writing");
+                of
+                    << "/*\n"
+                    << " * AUTOGENERATED by mrustc - C backend prelude\n"
+                    << " */\n"
+                    // NOTE: A guard instead of `#pragma once`, as GCC warns about the latter when pre-compiling
+                    << "#ifndef MRUSTC_PRELUDE_" << ::std::hex << hash << "\n"
+                    << "#define MRUSTC_PRELUDE_" << ::std::hex << hash << "\n"
+                    << contents
+                    << "#endif\n"
+                    ;
+                ASSERT_BUG(Span(), !of.bad(), "Error set on output stream for: " << tmp_path);
+            }
+            if( ::std::rename(tmp_path.c_str(), path.c_str()) != 0 )
+            {
+                // Windows can't rename over an existing file (i.e. someone else got there first)
+                ::std::remove(tmp_path.c_str());
+            }
+            return path;
+        }
+        /// Pre-compile the prelude header for the current compiler invocation (`compile_args` is the compiler
+        /// followed by the code-generation flags), failures are ignored as the compiler falls back to the header.
+        void build_prelude_pch(const ::std::vector<::std::string>& compile_args, bool is_windows)
+        {
+            // Only GCC searches for `<header>.gch` (clang needs an explicit `-include-pch`)
+            if( compile_args[0].find("clang") != ::std::string::npos )
+                return ;
+            // GCC checks each file in a `.gch` directory, so one variant per distinct set of flags can co-exist
+            auto pch_dir = m_prelude_path + ".gch";
+            ::std::stringstream flags_ss;
+            for(const auto& a : compile_args)
+                flags_ss << a << "\n";
+            auto pch_path = FMT(pch_dir << "/" << ::std::hex << ::std::hash<::std::string>()(flags_ss.str()) << ".gch");
+            if( ::std::ifstream(pch_path).good() )
+                return ;
+#ifdef _WIN32
+            _mkdir(pch_dir.c_str());
+#else
+            mkdir(pch_dir.c_str(), 0777);
+#endif
+            auto tmp_path = FMT(pch_path << "." << ::std::hex << ::std::hash<::std::string>()(m_outfile_path) << ".tmp");
+            ::std::stringstream cmd_ss;
+            if( getenv("MRUSTC_CCACHE") ) {
+                cmd_ss << "ccache ";
+            }
+            for(const auto& a : compile_args)
+                cmd_ss << "\"" << FmtShell(a, is_windows) << "\" ";
+            cmd_ss << "-x c-header -o \"" << FmtShell(tmp_path, is_windows) << "\" \"" << FmtShell(m_prelude_path, is_windows) << "\"";
+            DEBUG("- " << cmd_ss.str());
+            if( system(cmd_ss.str().c_str()) == 0 )
+            {
+                if( ::std::rename(tmp_path.c_str(), pch_path.c_str()) == 0 )
+                    return ;
+            }
+            ::std::remove(tmp_path.c_str());
+        }
+    public:
 
         void finalise(const TransOptions& opt, CodegenOutput out_ty, const ::std::string& hir_file) override
         {
@@ -1272,31 +1493,11 @@ namespace {
             bool is_windows = false;
 #endif
             size_t  arg_file_start = 0;
+            ::std::vector<::std::string>    pch_args;
             switch( m_compiler )
             {
             case Compiler::Gcc:
-                // Pick the compiler
-                // - from `CC_${TRIPLE}` environment variable, with all '-' in TRIPLE replaced by '_'
-                // - from the `CC` environment variable
-                // - `${TRIPLE}-gcc` (if available)
-                // - `gcc` as fallback
-                {
-                    std::string varname = "CC_" +  Target_GetCurSpec().m_backend_c.m_c_compiler;
-                    std::replace(varname.begin(), varname.end(), '-', '_');
-
-                    if( getenv(varname.c_str()) ) {
-                        args.push_back( getenv(varname.c_str()) );
-                    }
-                    else if( getenv("CC") ) {
-                            args.push_back( getenv("CC") );
-                    }
-                    else if (system(("command -v " + Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" + " >/dev/null 2>&1").c_str()) == 0) {
-                        args.push_back( Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" );
-                    }
-                    else {
-                        args.push_back("gcc");
-                    }
-                }
+                args.push_back( detect_gcc().command );
                 arg_file_start = args.get_vec().size();
                 for( const auto& a : Target_GetCurSpec().m_backend_c.m_compiler_opts )
                 {
@@ -1310,10 +1511,16 @@ namespace {
                     args.push_back("-O1");
                     break;
                 case 2:
-                    //args.push_back("-O2");
-                    args.push_back("-O1");  // HACK: Work around mrustc #347 by reducing the optimisation level
+                    args.push_back("-O2");
+                    break;
+                default:
+                    args.push_back("-O3");
                     break;
                 }
+                // Rust has no type-based aliasing rules, and pointer casts between unrelated types are routine (and
+                // valid) in rust code. So the C compiler can't be allowed to assume that differently typed accesses
+                // don't alias.
+                args.push_back("-fno-strict-aliasing");
 #if defined(__GNUC__) && !defined(__clang__)
 #if __GNUC__ < 16 && !(__GNUC__ == 15 && __GNUC_MINOR__ > 1)
                 // HACK: Work around [https://gcc.gnu.org/bugzilla/show_bug.cgi?id=117423] by disabling an optimisation stage
@@ -1323,12 +1530,62 @@ namespace {
                 }
 #endif
 #endif
+                if( m_options.landing_pads )
+                {
+                    // Unwind tables with cleanup entries for the `cleanup` variables (see `emit_function_code`)
+                    args.push_back("-fexceptions");
+                }
+                if( opt.lto )
+                {
+                    // Keep GIMPLE in the objects so the final link can inline across crates.
+                    // - Library objects are also fat (carry machine code), so they can still be linked by a non-LTO build
+                    args.push_back("-flto");
+                    switch(out_ty)
+                    {
+                    case CodegenOutput::Object:
+                    case CodegenOutput::StaticLibrary:
+                        args.push_back("-ffat-lto-objects");
+                        break;
+                    case CodegenOutput::Executable:
+                    case CodegenOutput::DynamicLibrary:
+                        break;
+                    }
+                }
+                if( opt.profile_generate_dir != "" || opt.profile_use_dir != "" )
+                {
+                    if( opt.profile_generate_dir != "" )
+                    {
+                        args.push_back("-fprofile-generate=" + opt.profile_generate_dir);
+                        args.push_back("-fprofile-update=atomic");  // Counters are shared between threads
+                    }
+                    else
+                    {
+                        args.push_back("-fprofile-use=" + opt.profile_use_dir);
+                        args.push_back("-Wno-missing-profile");     // Code not run during training has no profile
+                    }
+                    // Profiles are named after the absolute object path, strip the output directory so the instrumented
+                    // and optimised builds can be in different directories.
+                    // - Only GCC 11 and later support this, older versions need the directories to match
+                    if( !detect_gcc().is_clang && detect_gcc().major_version >= 11 )
+                    {
+                        args.push_back("-fprofile-prefix-path=" + get_absolute_dir(m_outfile_path));
+                    }
+                    // Keep compiler-generated names (e.g. profile constructors) the same between the two builds
+                    auto name_start = m_outfile_path.find_last_of("/\\");
+                    args.push_back("-frandom-seed=" + m_outfile_path.substr(name_start == ::std::string::npos ? 0 : name_start+1));
+                }
                 if( opt.emit_debug_info )
                 {
                     args.push_back("-g");
                 }
                 // TODO: Why?
                 args.push_back("-fPIC");
+                // The prelude header can only be pre-compiled with the same compiler and code-generation flags
+                if( m_prelude_path != "" )
+                {
+                    const auto& argv = args.get_vec();
+                    pch_args.assign(argv.begin(), argv.end());
+                }
                 args.push_back("-o");
                 switch(out_ty)
                 {
@@ -1417,6 +1674,14 @@ namespace {
                     //args.push_back("/O2");
                     break;
                 }
+                if( opt.lto )
+                {
+                    args.push_back("/GL");  // Whole-program optimisation, the linker switches to /LTCG when it sees these objects
+                }
+                if( opt.profile_generate_dir != "" || opt.profile_use_dir != "" )
+                {
+                    WARNING(Span(), W0000, "Profile-guided optimisation is not supported with MSVC, ignoring");
+                }
                 if( opt.emit_debug_info )
                 {
                     args.push_back("/DEBUG");
@@ -1531,6 +1796,10 @@ namespace {
             }
             else
             {
+                if( !pch_args.empty() )
+                {
+                    build_prelude_pch(pch_args, is_windows);
+                }
                 int ec = system(cmd_ss.str().c_str());
                 if( ec == -1 )
                 {
@@ -2848,6 +3117,29 @@ namespace {
             else if( item.m_linkage.name == "_Unwind_RaiseException" )
             {
                 MIR_ASSERT(*m_mir_res, m_compiler == Compiler::Gcc, item.m_linkage.name << " in non-GCC mode");
+                if( m_options.landing_pads )
+                {
+                    // A forced unwind runs the landing pads of every frame until one catches (see the `try` intrinsic).
+                    // - A `setjmp`-based `try` (from a crate built without landing pads) is jumped to once its frame is
+                    //   reached, i.e. when the frame's CFA is above the `jmp_buf` it registered.
+                    m_of << "// - Magic compiler impl (landing pads)\n";
+                    m_of << "extern int mrustc_unwind_forced(void*, int (*)(int, int, uint64_t, void*, void*, void*), void*) __asm__(\"_Unwind_ForcedUnwind\");\n";
+                    m_of << "extern uintptr_t mrustc_unwind_get_cfa(void*) __asm__(\"_Unwind_GetCFA\");\n";
+                    m_of << "static int mrustc_unwind_stop(int version, int actions, uint64_t exc_class, void* exc, void* ctx, void* arg) {\n";
+                    m_of << "\tif( mrustc_panic_target && ((actions & 16) || (uintptr_t)mrustc_panic_target < mrustc_unwind_get_cfa(ctx)) )\n";
+                    m_of << "\t\tlongjmp(*mrustc_panic_target, 1);\n";
+                    m_of << "\tif( actions & 16 ) abort();\n";  // _UA_END_OF_STACK: Nothing caught the panic
+                    m_of << "\treturn 0;\n"; // _URC_NO_REASON
+                    m_of << "}\n";
+                    m_of << "static ";
+                    emit_function_header(p, item, params);
+                    m_of << " {\n";
+                    m_of << "\tmrustc_panic_value = arg0;\n";
+                    m_of << "\tmrustc_unwind_forced(arg0, mrustc_unwind_stop, 0);\n";
+                    m_of << "\tabort();\n";  // Only returns if the unwind couldn't be started
+                    m_of << "}\n";
+                    return;
+                }
                 m_of << "// - Magic compiler impl\n";
                 m_of << "static ";
                 emit_function_header(p, item, params);
@@ -2949,7 +3241,7 @@ namespace {
             if( is_extern_def ) {
                 m_of << "static ";
             }
-            emit_function_header(p, item, params);
+            emit_function_header(p, item, params, &*code);
             m_of << "\n";
             m_of << "{\n";
 
@@ -3046,6 +3338,28 @@ namespace {
             }
 #endif
 
+            // Landing pads: Each call sets `uw_state` to select the cleanup block (or `try` handler) for a panic unwinding
+            // out of it, and the `cleanup` variable's handler (run by the unwinder) jumps there from the nested function.
+            // - Labels targeted by a non-local goto must be declared at the start of the block.
+            m_landing_pads = item.m_markings.is_naked ? ::std::vector<unsigned>() : get_landing_pads(*code);
+            ::std::map<unsigned, ::std::string> landing_pad_labels;
+            for(size_t i = 0; i < m_landing_pads.size(); i ++)
+            {
+                if( m_landing_pads[i] > code->blocks.size() ) {
+                    landing_pad_labels[m_landing_pads[i]] = FMT("bb" << i << "_catch");
+                }
+                else if( m_landing_pads[i] > 0 ) {
+                    landing_pad_labels[m_landing_pads[i]] = FMT("bb" << m_landing_pads[i]-1);
+                }
+            }
+            if( !landing_pad_labels.empty() )
+            {
+                m_of << "\t__label__ ";
+                for(const auto& e : landing_pad_labels)
+                    m_of << (&e == &*landing_pad_labels.begin() ? "" : ", ") << e.second;
+                m_of << ";\n";
+            }
+
             // Variables
             m_of << "\t"; emit_ctype(ret_type, FMT_CB(ss, ss << "rv";)); m_of << ";\n";
             for(unsigned int i = 0; i < code->locals.size(); i ++) {
@@ -3062,15 +3376,43 @@ namespace {
             for(unsigned int i = 0; i < code->drop_flags.size(); i ++) {
                 m_of << "\tbool df" << i << " = " << code->drop_flags[i] << ";\n";
             }
+            if( !landing_pad_labels.empty() )
+            {
+                // NOTE: The state is cleared first, as a cleanup block that ends in `diverge` re-visits this frame.
+                // - The exception is saved on entry, as a cleanup block can raise (and catch) other panics before
+                //   resuming, which overwrites `mrustc_panic_value`.
+                m_of << "\tvoid* uw_exc = 0;\n";
+                m_of << "\tvoid uw_landing(unsigned* s) { unsigned site = *s; *s = 0; switch(site) {";
+                for(const auto& e : landing_pad_labels)
+                    m_of << " case " << e.first << ": uw_exc = mrustc_panic_value; goto " << e.second << ";";
+                m_of << " } }\n";
+                m_of << "\tunsigned uw_state __attribute__((cleanup(uw_landing))) = 0;\n";
+            }
+            ::std::vector<bool> cold_blocks;
+            if( m_options.emit_hints && !item.m_markings.is_naked )
+            {
+                // The natural alignment of the C type is already assumed, but larger alignments (e.g. SIMD types or
+                // `#[repr(align)]`) aren't always visible to the vectoriser.
+                for(unsigned int i = 0; i < arg_types.size(); i ++)
+                {
+                    size_t  align;
+                    if( hint_is_thin_ref(arg_types[i].second, &align) && align >= 16 ) {
+                        m_of << "\targ" << i << " = __builtin_assume_aligned(arg" << i << ", " << align << ");\n";
+                    }
+                }
+                cold_blocks = get_cold_blocks(*code);
+            }
 
             ::std::vector<unsigned> bb_use_counts( code->blocks.size() );
             for(const auto& blk : code->blocks)
             {
                 MIR::visit::visit_terminator_target(blk.terminator, [&](const auto& tgt){ bb_use_counts[tgt] ++; });
                 // Ignore the panic arm. (TODO: is this correct?)
+                // - Unless it's a landing pad
                 if( const auto* te = blk.terminator.opt_Call() )
                 {
-                    bb_use_counts[te->panic_block] --;
+                    if( m_landing_pads.empty() || m_landing_pads[&blk - code->blocks.data()] != te->panic_block + 1 )
+                        bb_use_counts[te->panic_block] --;
                 }
             }
 
@@ -3191,7 +3533,7 @@ namespace {
                 // HACK: Ignore any blocks that only contain `diverge;`
                 if( code->blocks[i].statements.size() == 0 && code->blocks[i].terminator.is_Diverge() ) {
                     DEBUG("- Diverge only, omitting");
-                    m_of << "bb" << i << ": _Unwind_Resume(); // Diverge\n";
+                    m_of << "bb" << i << ": "; emit_diverge(); m_of << " // Diverge\n";
                     continue ;
                 }
 
@@ -3239,6 +3581,9 @@ namespace {
                     m_of << "\tfor(;;);\n";
                     }
                 TU_ARMA(Return, e) {
+                    // Leaving the function runs the cleanup variable's handler, so make sure it does nothing
+                    if( !m_landing_pads.empty() )
+                        m_of << "\tuw_state = 0;\n";
                     // If the return type is (), don't return a value.
                     if( ret_type == ::HIR::TypeRef::new_unit() )
                         m_of << "\treturn ;\n";
@@ -3246,7 +3591,7 @@ namespace {
                         m_of << "\treturn rv;\n";
                     }
                 TU_ARMA(Diverge, e) {
-                    m_of << "\t_Unwind_Resume();\n";
+                    m_of << "\t"; emit_diverge(); m_of << "\n";
                     }
                 TU_ARMA(Goto, e) {
                     if( e == i+1 )
@@ -3262,7 +3607,14 @@ namespace {
                     m_of << "\tgoto bb" << e << "; /* panic */\n";
                     }
                 TU_ARMA(If, e) {
-                    m_of << "\tif("; emit_lvalue(e.cond); m_of << ") goto bb" << e.bb_true << "; else goto bb" << e.bb_false << ";\n";
+                    m_of << "\tif(";
+                    if( !cold_blocks.empty() && cold_blocks[e.bb_true] != cold_blocks[e.bb_false] ) {
+                        m_of << "__builtin_expect("; emit_lvalue(e.cond); m_of << ", " << (cold_blocks[e.bb_true] ? 0 : 1) << ")";
+                    }
+                    else {
+                        emit_lvalue(e.cond);
+                    }
+                    m_of << ") goto bb" << e.bb_true << "; else goto bb" << e.bb_false << ";\n";
                     }
                 TU_ARMA(Switch, e) {
 
@@ -3329,6 +3681,7 @@ namespace {
             }
             m_of << "}\n";
             m_of.flush();
+            m_landing_pads.clear();
             m_mir_res = nullptr;
         }
 
@@ -3724,6 +4077,9 @@ namespace {
             } break;
             case ::MIR::Statement::TAG_Drop: {
                 const auto& e = stmt.as_Drop();
+                // A panic in the drop glue mustn't use the previous call's landing pad (that could drop this again)
+                if( !m_landing_pads.empty() )
+                    m_of << indent << "uw_state = 0;\n";
                 ::HIR::TypeRef  tmp;
                 const auto& ty = mir_res.get_lvalue_type(tmp, e.slot);
 
@@ -3983,6 +4339,31 @@ namespace {
                         }
                         break;
                     }
+                    else if( const char* uty = get_wrapping_arith_type(ty, ve.op) ) {
+                        // Rust integer arithmetic wraps (when not checked), but signed overflow is UB in C
+                        // - So do it as unsigned, and convert back (GCC defines that conversion as modulo)
+                        m_of << "("; emit_ctype(ty); m_of << ")(";
+                        m_of << "(" << uty << ")"; emit_param(ve.val_l);
+                        switch(ve.op)
+                        {
+                        case ::MIR::eBinOp::ADD:   m_of << " + ";    break;
+                        case ::MIR::eBinOp::SUB:   m_of << " - ";    break;
+                        case ::MIR::eBinOp::MUL:   m_of << " * ";    break;
+                        case ::MIR::eBinOp::BIT_SHL:   m_of << " << ";   break;
+                        default:
+                            MIR_BUG(mir_res, "Unexpected wrapping op in " << e.src);
+                        }
+                        if( ve.op != ::MIR::eBinOp::BIT_SHL ) {
+                            m_of << "(" << uty << ")";
+                        }
+                        emit_param(ve.val_r);
+                        if( type_is_emulated_i128(ty_r) )
+                        {
+                            m_of << ".lo";
+                        }
+                        m_of << ")";
+                        break;
+                    }
                     else {
                     }
 
@@ -4066,6 +4447,14 @@ namespace {
                     }
 
 
+                    if( ve.op == ::MIR::eUniOp::NEG ) {
+                        if( const char* uty = get_wrapping_arith_type(ty, ::MIR::eBinOp::SUB) ) {
+                            // `-MIN` wraps in rust, but is UB in C
+                            emit_lvalue(e.dst); m_of << " = ("; emit_ctype(ty); m_of << ")(0 - (" << uty << ")"; emit_lvalue(ve.val); m_of << ")";
+                            break;
+                        }
+                    }
+
                     emit_lvalue(e.dst);
                     m_of << " = ";
                     switch(ve.op)
@@ -4628,44 +5017,18 @@ namespace {
             ::HIR::TypeRef  tmp;
             const auto& ty = mir_res.get_lvalue_type(tmp, val);
             if( const auto* ve = values.opt_String() ) {
-                m_of << indent << "{ static SLICE_PTR switch_strings[] = {";
-                for(const auto& v : *ve)
-                {
-                    m_of << " {"; this->print_escaped_string(v); m_of << "," << v.size() << "},";
-                }
-                m_of << " {0,0} };\n";
-                m_of << indent << "switch( mrustc_string_search_linear("; emit_lvalue(val); m_of << ", " << ve->size() << ", switch_strings) ) {\n";
-                for(size_t i = 0; i < ve->size(); i++)
-                {
-                    m_of << indent << "case " << i << ": "; cb(i); m_of << " break;\n";
-                }
-                m_of << indent << "default: "; cb(SIZE_MAX); m_of << "\n";
-                m_of << indent << "} }\n";
+                emit_term_switchvalue_strings(indent, *ve, [&]{ emit_lvalue(val); }, cb);
             }
             else if( const auto* ve = values.opt_ByteString() ) {
-                m_of << indent << "{ static SLICE_PTR switch_strings[] = {";
-                for(const auto& v : *ve)
-                {
-                    m_of << " {"; this->print_escaped_string(v); m_of << "," << v.size() << "},";
-                }
-                m_of << " {0,0} };\n";
-                HIR::TypeRef    tmp;
-                const auto& ty = mir_res.get_lvalue_type(tmp, val);
-                m_of << indent << "switch( mrustc_string_search_linear(";
-                if( const auto* a = ty.data().as_Borrow().inner.data().opt_Array() ) {
-                    auto len = a->size.as_Known();
-                    m_of << "make_sliceptr("; emit_lvalue(val); m_of << "->DATA, " << len << ")";
-                }
-                else {
-                    emit_lvalue(val);
-                }
-                m_of << ", " << ve->size() << ", switch_strings) ) {\n";
-                for(size_t i = 0; i < ve->size(); i++)
-                {
-                    m_of << indent << "case " << i << ": "; cb(i); m_of << " break;\n";
-                }
-                m_of << indent << "default: "; cb(SIZE_MAX); m_of << "\n";
-                m_of << indent << "} }\n";
+                emit_term_switchvalue_strings(indent, *ve, [&]{
+                    if( const auto* a = ty.data().as_Borrow().inner.data().opt_Array() ) {
+                        auto len = a->size.as_Known();
+                        m_of << "make_sliceptr("; emit_lvalue(val); m_of << "->DATA, " << len << ")";
+                    }
+                    else {
+                        emit_lvalue(val);
+                    }
+                    }, cb);
             }
             else if( const auto* ve = values.opt_Unsigned() ) {
                 m_of << indent << "switch("; emit_lvalue(val);
@@ -4703,9 +5066,94 @@ namespace {
                 MIR_BUG(mir_res, "SwitchValue with unknown value type - " << values.tag_str());
             }
         }
+        /// Emit a switch over string/byte-string values (`emit_val` emits the `SLICE_PTR` being matched)
+        template<typename T>
+        void emit_term_switchvalue_strings(const RepeatLitStr& indent, const ::std::vector<T>& values, ::std::function<void()> emit_val, const ::std::function<void(size_t)>& cb)
+        {
+            // Below this many values a linear search (which stops early thanks to the values being sorted) is cheaper
+            static const size_t MIN_BUCKETED_VALUES = 5;
+
+            m_of << indent << "{ static SLICE_PTR switch_strings[] = {";
+            for(const auto& v : values)
+            {
+                m_of << " {"; this->print_escaped_string(v); m_of << "," << v.size() << "},";
+            }
+            m_of << " {0,0} };\n";
+            if( values.size() < MIN_BUCKETED_VALUES )
+            {
+                m_of << indent << "switch( mrustc_string_search_linear("; emit_val(); m_of << ", " << values.size() << ", switch_strings) ) {\n";
+            }
+            else
+            {
+                // Dispatch on the length, then (if there's more than one candidate of that length) on the byte position that
+                // best splits the candidates, and finally confirm with a single `memcmp`
+                ::std::map<size_t, ::std::vector<size_t>>   by_len;
+                for(size_t i = 0; i < values.size(); i++)
+                    by_len[values[i].size()].push_back(i);
+
+                m_of << indent << "size_t switch_idx = SIZE_MAX; SLICE_PTR switch_val = "; emit_val(); m_of << ";\n";
+                m_of << indent << "switch(switch_val.META) {\n";
+                for(const auto& len_ent : by_len)
+                {
+                    const auto len = len_ent.first;
+                    const auto& idxs = len_ent.second;
+                    m_of << indent << "case " << len << ":";
+                    if( len == 0 ) {
+                        m_of << " switch_idx = " << idxs[0] << "; break;\n";
+                        continue;
+                    }
+                    if( idxs.size() == 1 ) {
+                        m_of << " if( memcmp(switch_val.PTR, switch_strings[" << idxs[0] << "].PTR, " << len << ") == 0 ) switch_idx = " << idxs[0] << "; break;\n";
+                        continue;
+                    }
+                    m_of << "\n";
+                    // Pick the byte that has the most distinct values across the candidates
+                    size_t best_pos = 0;
+                    size_t best_count = 0;
+                    for(size_t pos = 0; pos < len && best_count < idxs.size(); pos ++)
+                    {
+                        ::std::set<uint8_t>  seen;
+                        for(auto i : idxs)
+                            seen.insert(static_cast<uint8_t>(values[i][pos]));
+                        if( seen.size() > best_count ) {
+                            best_pos = pos;
+                            best_count = seen.size();
+                        }
+                    }
+                    ::std::map<uint8_t, ::std::vector<size_t>>  by_byte;
+                    for(auto i : idxs)
+                        by_byte[static_cast<uint8_t>(values[i][best_pos])].push_back(i);
+                    m_of << indent << "\tswitch( ((const uint8_t*)switch_val.PTR)[" << best_pos << "] ) {\n";
+                    for(const auto& byte_ent : by_byte)
+                    {
+                        m_of << indent << "\tcase " << unsigned(byte_ent.first) << ":";
+                        for(auto i : byte_ent.second)
+                        {
+                            m_of << " if( memcmp(switch_val.PTR, switch_strings[" << i << "].PTR, " << len << ") == 0 ) { switch_idx = " << i << "; break; }";
+                        }
+                        m_of << " break;\n";
+                    }
+                    m_of << indent << "\t}\n";
+                    m_of << indent << "\tbreak;\n";
+                }
+                m_of << indent << "}\n";
+                m_of << indent << "switch( switch_idx ) {\n";
+            }
+            for(size_t i = 0; i < values.size(); i++)
+            {
+                m_of << indent << "case " << i << ": "; cb(i); m_of << " break;\n";
+            }
+            m_of << indent << "default: "; cb(SIZE_MAX); m_of << "\n";
+            m_of << indent << "} }\n";
+        }
         void emit_term_call(const ::MIR::TypeResolve& mir_res, const ::MIR::Terminator::Data_Call& e, unsigned indent_level)
         {
             auto indent = RepeatLitStr { "\t", static_cast<int>(indent_level) };
+            // NOTE: A call that can't unwind doesn't need to reset the state from a previous call
+            if( !m_landing_pads.empty() && (m_landing_pads[mir_res.get_cur_block()] != 0 || call_can_unwind(e)) )
+            {
+                m_of << indent << "uw_state = " << m_landing_pads[mir_res.get_cur_block()] << ";\n";
+            }
             m_of << indent;
 
             bool has_zst = false;
@@ -5802,7 +6250,257 @@ namespace {
             }
         }
 
-        void emit_function_header(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params)
+        /// Returns true if this argument type is a thin reference to a sized non-ZST (for non-null/alignment hints)
+        bool hint_is_thin_ref(const ::HIR::TypeRef& ty, size_t* out_align=nullptr) const
+        {
+            if( !ty.data().is_Borrow() )
+                return false;
+            const auto& inner = ty.data().as_Borrow().inner;
+            if( this->metadata_type(inner) != MetadataType::None )
+                return false;
+            size_t  size, align;
+            if( !Target_GetSizeAndAlignOf(sp, m_resolve, inner, size, align) || size == 0 )
+                return false;
+            if( out_align )
+                *out_align = align;
+            return true;
+        }
+        /// Returns true if an argument can be `restrict`: the pointed-to value is only accessed through this pointer for
+        /// the duration of the call (`&mut T`), or isn't modified at all (`&T` with no interior mutability)
+        bool hint_is_restrict(const ::HIR::TypeRef& ty) const
+        {
+            if( !hint_is_thin_ref(ty) )
+                return false;
+            const auto& te = ty.data().as_Borrow();
+            switch(te.type)
+            {
+            case ::HIR::BorrowType::Unique:
+                return true;
+            case ::HIR::BorrowType::Shared:
+                // No `UnsafeCell` lang item (e.g. `#![no_core]`), so nothing can be interior mutable
+                if( m_crate.get_lang_item_path_opt("unsafe_cell") == ::HIR::SimplePath() )
+                    return true;
+                return m_resolve.type_is_interior_mutable(sp, te.inner) == ::HIR::Compare::Unequal;
+            case ::HIR::BorrowType::Owned:
+                break;
+            }
+            return false;
+        }
+        /// Unsigned C type to evaluate a wrapping integer operation in, or `nullptr` if the plain C operator is fine
+        /// - Signed overflow (and left shift of negative values) is UB in C
+        /// - Types narrower than `int` are promoted to `int`, so `u16 * u16` and `u8 << 24` can overflow too
+        const char* get_wrapping_arith_type(const ::HIR::TypeRef& ty, ::MIR::eBinOp op) const
+        {
+            if( !ty.data().is_Primitive() || type_is_emulated_i128(ty) )
+                return nullptr;
+            bool is_small = false;
+            const char* rv = nullptr;
+            switch(ty.data().as_Primitive())
+            {
+            case ::HIR::CoreType::U8:
+            case ::HIR::CoreType::I8:
+            case ::HIR::CoreType::U16:
+            case ::HIR::CoreType::I16:
+                is_small = true;
+                rv = "unsigned int";
+                break;
+            case ::HIR::CoreType::I32:  rv = "uint32_t";   break;
+            case ::HIR::CoreType::I64:  rv = "uint64_t";   break;
+            case ::HIR::CoreType::I128: rv = "uint128_t";  break;
+            case ::HIR::CoreType::Isize:    rv = "uintptr_t";  break;
+            default:
+                return nullptr;
+            }
+            switch(op)
+            {
+            case ::MIR::eBinOp::ADD:
+            case ::MIR::eBinOp::SUB:
+                return is_small ? nullptr : rv;
+            case ::MIR::eBinOp::MUL:
+            case ::MIR::eBinOp::BIT_SHL:
+                return rv;
+            default:
+                return nullptr;
+            }
+        }
+
+        /// Landing pads for `-C landing-pads`: The value of `uw_state` for the call ending each block.
+        /// - `0` for calls that unwind straight out (the panic block just diverges), `bb+1` for a cleanup block, and
+        ///   `blocks.size()+1+bb` for a `try` intrinsic (caught in its `_catch` handler).
+        /// - Empty if no call in the function needs a landing pad (so the function is emitted as without them)
+        ::std::vector<unsigned> get_landing_pads(const ::MIR::Function& code) const
+        {
+            ::std::vector<unsigned> rv;
+            // NOTE: The structured emitter doesn't handle landing pads
+            if( !m_options.landing_pads || getenv("MRUSTC_STRUCTURED_C") )
+                return rv;
+            bool has_landing_pads = false;
+            rv.resize(code.blocks.size());
+            for(size_t i = 0; i < code.blocks.size(); i ++)
+            {
+                const auto* te = code.blocks[i].terminator.opt_Call();
+                if( !te )
+                    continue;
+                if( te->fcn.is_Intrinsic() && (te->fcn.as_Intrinsic().name == "try" || te->fcn.as_Intrinsic().name == "catch_unwind") )
+                {
+                    rv[i] = code.blocks.size() + 1 + i;
+                    has_landing_pads = true;
+                }
+                else if( !call_can_unwind(*te) )
+                {
+                    // No landing pad needed, and `uw_state` is left alone
+                }
+                else
+                {
+                    const auto& panic_bb = code.blocks[te->panic_block];
+                    if( !(panic_bb.statements.empty() && panic_bb.terminator.is_Diverge()) )
+                    {
+                        rv[i] = te->panic_block + 1;
+                        has_landing_pads = true;
+                    }
+                }
+            }
+            if( !has_landing_pads )
+                rv.clear();
+            return rv;
+        }
+        /// Check if a call can unwind (i.e. isn't to a function that MIR optimisation found never unwinds)
+        bool call_can_unwind(const ::MIR::Terminator::Data_Call& te) const
+        {
+            if( !te.fcn.is_Path() )
+                return true;
+            const auto* summary = m_crate.get_function_summary(te.fcn.as_Path());
+            return !(summary && summary->no_unwind);
+        }
+        /// Emit a statement to continue unwinding (for `diverge`)
+        void emit_diverge()
+        {
+            if( !m_options.landing_pads ) {
+                m_of << "_Unwind_Resume();";
+            }
+            else {
+                // NOTE: This frame is re-visited by the unwinder, so its cleanup handler must not jump again
+                // - The saved exception is restored as the current one, for the landing pads of the outer frames
+                if( !m_landing_pads.empty() )
+                    m_of << "uw_state = 0; mrustc_panic_value = uw_exc; mrustc_unwind_resume(uw_exc);";
+                else
+                    m_of << "mrustc_unwind_resume(mrustc_panic_value);";
+            }
+        }
+
+        /// Emit function attributes for `-C c-hints`
+        /// - `code` is only set for the definition
+        void emit_function_hints(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params, const ::HIR::TypeRef& ret_ty, const ::MIR::Function* code)
+        {
+            switch(item.m_markings.inline_type)
+            {
+            case ::HIR::Function::Markings::Inline::Auto:
+            case ::HIR::Function::Markings::Inline::Normal:
+                break;
+            case ::HIR::Function::Markings::Inline::Never:
+                m_of << "__attribute__((noinline)) ";
+                break;
+            case ::HIR::Function::Markings::Inline::Always:
+                // gcc errors if an `always_inline` call can't be inlined, so only emit it on the definition (the prototype
+                // is always emitted first without it) of functions that don't make any direct calls (so can't recurse).
+                // `inline` avoids a warning, and still emits an external definition as the prototype isn't `inline`.
+                // - Functions with landing pads can't be inlined (they're the target of a non-local goto)
+                if( code && !item.m_variadic && item.m_linkage.type != ::HIR::Linkage::Type::Weak
+                    && get_landing_pads(*code).empty()
+                    && ::std::none_of(code->blocks.begin(), code->blocks.end(), [](const ::MIR::BasicBlock& bb){ return bb.terminator.is_Call() && bb.terminator.as_Call().fcn.is_Path(); })
+                    )
+                {
+                    m_of << "inline __attribute__((always_inline)) ";
+                }
+                break;
+            }
+            if( item.m_markings.is_cold ) {
+                m_of << "__attribute__((cold)) ";
+            }
+            if( ret_ty.data().is_Diverge() ) {
+                m_of << "__attribute__((noreturn)) ";
+            }
+            // Facts found by MIR optimisation (see `MIR_OptimiseCrate_Inlining`)
+            if( const auto* summary = m_crate.get_function_summary(p) )
+            {
+                // NOTE: gcc ignores (and warns about) `pure` on a `void` function
+                if( summary->is_pure && ret_ty != ::HIR::TypeRef::new_unit() ) {
+                    m_of << "__attribute__((pure)) ";
+                }
+                if( summary->no_unwind ) {
+                    m_of << "__attribute__((nothrow)) ";
+                }
+            }
+            bool has_nonnull = false;
+            for(unsigned int i = 0; i < item.m_args.size(); i ++)
+            {
+                if( hint_is_thin_ref(params.monomorph(m_resolve, item.m_args[i].second)) )
+                {
+                    m_of << (has_nonnull ? "," : "__attribute__((nonnull(") << (i+1);
+                    has_nonnull = true;
+                }
+            }
+            if( has_nonnull ) {
+                m_of << "))) ";
+            }
+        }
+        /// Find blocks that only lead to a panic/unwind or a call to a `#[cold]`/diverging function (for `__builtin_expect`)
+        ::std::vector<bool> get_cold_blocks(const ::MIR::Function& code) const
+        {
+            auto call_is_cold = [&](const ::MIR::Terminator::Data_Call& te)->bool {
+                if( te.fcn.is_Intrinsic() ) {
+                    return te.fcn.as_Intrinsic().name == "abort";
+                }
+                if( !te.fcn.is_Path() ) {
+                    return false;
+                }
+                MonomorphState  ms_tmp;
+                auto v = m_resolve.get_value(sp, te.fcn.as_Path(), ms_tmp, /*signature_only=*/true);
+                if( !v.is_Function() ) {
+                    return false;
+                }
+                const auto& f = *v.as_Function();
+                return f.m_markings.is_cold || f.m_return.data().is_Diverge();
+                };
+            ::std::vector<bool> rv( code.blocks.size() );
+            // Iterate to a fixed point (loops are never cold)
+            bool changed;
+            do
+            {
+                changed = false;
+                for(size_t i = 0; i < code.blocks.size(); i ++)
+                {
+                    if( rv[i] )
+                        continue ;
+                    bool is_cold = false;
+                    TU_MATCH_HDRA( (code.blocks[i].terminator), {)
+                    TU_ARMA(Incomplete, te) { is_cold = true; }
+                    TU_ARMA(Return, te)     { is_cold = false; }
+                    TU_ARMA(Diverge, te)    { is_cold = true; }
+                    TU_ARMA(Goto, te)       { is_cold = rv[te]; }
+                    TU_ARMA(Panic, te)      { is_cold = true; }
+                    TU_ARMA(If, te)         { is_cold = rv[te.bb_true] && rv[te.bb_false]; }
+                    TU_ARMA(Switch, te) {
+                        is_cold = ::std::all_of(te.targets.begin(), te.targets.end(), [&](::MIR::BasicBlockId b){ return rv[b]; });
+                        }
+                    TU_ARMA(SwitchValue, te) {
+                        is_cold = rv[te.def_target] && ::std::all_of(te.targets.begin(), te.targets.end(), [&](::MIR::BasicBlockId b){ return rv[b]; });
+                        }
+                    TU_ARMA(Call, te) {
+                        is_cold = rv[te.ret_block] || call_is_cold(te);
+                        }
+                    }
+                    if( is_cold )
+                    {
+                        rv[i] = true;
+                        changed = true;
+                    }
+                }
+            } while(changed);
+            return rv;
+        }
+
+        void emit_function_header(const ::HIR::Path& p, const ::HIR::Function& item, const Trans_Params& params, const ::MIR::Function* code=nullptr)
         {
             ::HIR::TypeRef  tmp;
             const auto& ret_ty = monomorphise_fcn_return(tmp, item, params);
@@ -5816,6 +6514,9 @@ namespace {
                     TODO(Span(), "Naked functions in msvc");
                 }
             }
+            else if( m_options.emit_hints ) {
+                emit_function_hints(p, item, params, ret_ty, code);
+            }
             auto cb = FMT_CB(ss,
                 // TODO: Cleaner ABI handling
                 if( item.m_abi == "system" && m_compiler == Compiler::Msvc )
@@ -5834,7 +6535,8 @@ namespace {
                         ss << "\n\t\t";
                         // TODO: If the type has a high alignment, emit as a pointer? Might have FFI issues
                         auto ty = params.monomorph(m_resolve, item.m_args[i].second);
-                        this->emit_ctype( ty, FMT_CB(os, os << (this->type_is_high_align(ty) ? "*":"") << "arg" << i;) );
+                        bool is_restrict = m_options.emit_hints && !item.m_markings.is_naked && this->hint_is_restrict(ty);
+                        this->emit_ctype( ty, FMT_CB(os, os << (this->type_is_high_align(ty) ? "*":"") << (is_restrict ? "restrict ":"") << "arg" << i;) );
                         if( item.m_variadic || i+1 < item.m_args.size() )    m_of << ",";
                         m_of << " // " << ty;
                     }
@@ -6448,6 +7150,23 @@ namespace {
                 m_of << "abort()";
             }
             else if( name == "try" || name == "catch_unwind" ) {
+                if( !m_landing_pads.empty() )
+                {
+                    // Landing pad: `uw_state` was set by `emit_term_call`, so the cleanup handler jumps to `_catch` if
+                    // the call unwinds. No cost unless a panic happens.
+                    emit_param(e.args.at(0)); m_of << "("; emit_param(e.args.at(1)); m_of << "); ";
+                    emit_lvalue(e.ret_val); m_of << " = 0;";
+                    m_of << " if(0) { bb" << m_mir_res->get_cur_block() << "_catch:";
+                    if(TARGETVER_MOST_1_39) {
+                        m_of << " *(void**)("; emit_param(e.args.at(2)); m_of << ") = uw_exc;";
+                    }
+                    else {
+                        m_of << " ("; emit_param(e.args.at(2)); m_of << ")("; emit_param(e.args.at(1)); m_of << ", uw_exc);";
+                    }
+                    m_of << " "; emit_lvalue(e.ret_val); m_of << " = 1;";   // Return value non-zero when panic happens
+                    m_of << " }";
+                    return ;
+                }
                 // Register thread-local setjmp
                 switch(m_compiler)
                 {
@@ -6983,6 +7702,13 @@ namespace {
                     }
                     m_of << ")";
                 }
+                else if( const char* uty = get_wrapping_arith_type(params.m_types.at(0), ::MIR::eBinOp::BIT_SHL) )
+                {
+                    // Shifting a negative (or promoted) value left is UB in C, see the `BIT_SHL` binop
+                    m_of << "("; emit_ctype(params.m_types.at(0)); m_of << ")(";
+                    m_of << "(" << uty << ")"; emit_param(e.args.at(0)); m_of << " << "; emit_param(e.args.at(1));
+                    m_of << ")";
+                }
                 else
                 {
                     emit_param(e.args.at(0)); m_of << " << "; emit_param(e.args.at(1));
@@ -8458,7 +9184,7 @@ namespace {
     Span CodeGenerator_C::sp;
 }
 
-::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile)
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
 {
-    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile));
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile, opt));
 }
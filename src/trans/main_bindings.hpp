@@ -19,6 +19,18 @@ struct TransOptions
     unsigned int opt_level = 0;
     bool emit_debug_info = false;
     ::std::string   build_command_file;
+    /// If non-empty, write the mangled symbol names (and what they name) to this file
+    ::std::string   symbol_map_file;
+    /// Emit optimisation hints (inlining, cold paths, aliasing, non-null) as C compiler attributes
+    bool emit_hints = false;
+    /// Compile with link-time optimisation (objects carry LTO bytecode, executables are optimised as a whole)
+    bool lto = false;
+    /// Instrument the generated code to write execution profiles into this directory
+    ::std::string   profile_generate_dir;
+    /// Optimise using the profiles written to this directory by an instrumented build
+    ::std::string   profile_use_dir;
+    /// Unwind panics with the system unwinder, running cleanup blocks as landing pads (instead of `setjmp`/`longjmp`)
+    bool landing_pads = false;
 
     ::std::string   panic_crate;
 
@@ -16,8 +16,13 @@ namespace HIR {
     class TypeRef;
 }
 
-extern ::FmtLambda Trans_Mangle(const ::HIR::SimplePath& path);
-extern ::FmtLambda Trans_Mangle(const ::HIR::GenericPath& path);
-extern ::FmtLambda Trans_Mangle(const ::HIR::Path& path);
-extern ::FmtLambda Trans_Mangle(const ::HIR::TypeRef& ty);
+// Mangled names are memoised in a process-wide symbol table, the returned reference is stable for the rest of the
+// process.
+extern const ::std::string& Trans_Mangle(const ::HIR::SimplePath& path);
+extern const ::std::string& Trans_Mangle(const ::HIR::GenericPath& path);
+extern const ::std::string& Trans_Mangle(const ::HIR::Path& path);
+extern const ::std::string& Trans_Mangle(const ::HIR::TypeRef& ty);
+
+/// Write every symbol mangled so far (one `<symbol>\t<source>` line each, sorted by symbol)
+extern void Trans_Mangle_WriteSymbolMap(const ::std::string& filename);
 
@@ -12,14 +12,18 @@
 #include <string_view.hpp>
 #include <hir/hir.hpp>  // ABI_RUST
 #include <hir/type.hpp>
+#include "mangling.hpp"
 #include <cctype>
-#include <algorithm>	// std::find
 #include <cmath>	// ceil/log10
+#include <fstream>
+#include <map>
+#include <unordered_map>
 
 class Mangler
 {
     ::std::ostream& m_os;
-    std::vector<RcString>    m_name_cache;
+    // Name -> back-reference index (index is the order of first use)
+    std::unordered_map<RcString, unsigned>  m_name_cache;
 public:
     Mangler(::std::ostream& os):
         m_os(os)
@@ -46,10 +50,10 @@ public:
     void fmt_name(const RcString& s)
     {
         // Support back-references to names (if shorter than the literal name)
-        auto it = std::find(m_name_cache.begin(), m_name_cache.end(), s);
+        auto it = m_name_cache.find(s);
         if(it != m_name_cache.end())
         {
-            auto idx = it - m_name_cache.begin();
+            auto idx = it->second;
             // Only emit this way if shorter than the formatted name would be.
             auto len = 1 + static_cast<unsigned>(std::ceil(std::log10(idx+1) / std::log10(26)));
             if(len < s.size())
@@ -60,7 +64,7 @@ public:
         }
         else
         {
-            m_name_cache.push_back(s);
+            m_name_cache.insert(::std::make_pair(s, static_cast<unsigned>(m_name_cache.size())));
         }
 
         this->fmt_name(s.c_str());
@@ -374,7 +378,7 @@ public:
 }
 
 namespace {
-    ::FmtLambda max_len(::FmtLambda v) {
+    ::std::string max_len(::FmtLambda v) {
         std::stringstream   ss;
         ss << v;
         auto s = ss.str();
@@ -388,16 +392,59 @@ namespace {
         }
         else {
         }
-        return ::FmtLambda([=](::std::ostream& os){
-            os << s;
-            });
+        return s;
     }
+
+    /// Crate-wide table of mangled names
+    /// - Codegen asks for the same path many times (prototype, each call site, vtables, drop glue), so format each once
+    /// NOTE: Not thread-safe, only used from the (single-threaded) trans stage
+    struct SymbolTable
+    {
+        ::std::map< ::HIR::SimplePath, ::std::string>   simple_paths;
+        ::std::map< ::HIR::GenericPath, ::std::string>  generic_paths;
+        ::std::map< ::HIR::Path, ::std::string> paths;
+        ::std::map< ::HIR::TypeRef, ::std::string>  types;
+
+        template<typename T>
+        static const ::std::string& get(::std::map<T, ::std::string>& map, const T& v, ::FmtLambda (*mangle)(const T&))
+        {
+            auto it = map.find(v);
+            if( it == map.end() )
+            {
+                it = map.insert(::std::make_pair(v.clone(), max_len(mangle(v)))).first;
+            }
+            return it->second;
+        }
+    } g_symbol_table;
+}
+#define DO_MANGLE(ty, field) const ::std::string& Trans_Mangle(const ::HIR::ty& v) { \
+    return SymbolTable::get(g_symbol_table.field, v, &Trans_Mangle##ty); \
 }
-// TODO: If the mangled name exceeds a limit, stop emitting the real name and start hashing the rest.
-#define DO_MANGLE(ty) ::FmtLambda Trans_Mangle(const ::HIR::ty& v) { \
-    return max_len(Trans_Mangle##ty(v)); \
+DO_MANGLE(SimplePath, simple_paths)
+DO_MANGLE(GenericPath, generic_paths)
+DO_MANGLE(Path, paths)
+DO_MANGLE(TypeRef, types)
+
+void Trans_Mangle_WriteSymbolMap(const ::std::string& filename)
+{
+    ::std::map< ::std::string, ::std::string>    sorted;
+    auto add = [&](const auto& map) {
+        for(const auto& e : map)
+            sorted.insert(::std::make_pair( e.second, FMT(e.first) ));
+        };
+    add(g_symbol_table.simple_paths);
+    add(g_symbol_table.generic_paths);
+    add(g_symbol_table.paths);
+    add(g_symbol_table.types);
+
+    ::std::ofstream os(filename);
+    if( !os.good() )
+    {
+        ::std::cerr << "Unable to open symbol map file '" << filename << "' for writing" << ::std::endl;
+        exit(1);
+    }
+    for(const auto& e : sorted)
+    {
+        os << e.first << "\t" << e.second << "\n";
+    }
 }
-DO_MANGLE(SimplePath)
-DO_MANGLE(GenericPath)
-DO_MANGLE(Path)
-DO_MANGLE(TypeRef)
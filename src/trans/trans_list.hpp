@@ -87,11 +87,14 @@ struct TransList_Function
     CachedFunction  monomorphised;
     /// Forces the function to not be emited as code (just emit the signature)
     bool    force_prototype;
+    /// Index of the strongly-connected component of the call graph containing this function (set by inlining)
+    unsigned    scc_index;
 
     TransList_Function(const ::HIR::Path& path):
         path(&path),
         ptr(nullptr),
-        force_prototype(false)
+        force_prototype(false),
+        scc_index(~0u)
     {}
 };
 struct TransList_Static
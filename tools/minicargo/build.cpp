@@ -878,12 +878,29 @@ void Job_Build::push_args_common(StringList& args, const helpers::path& outfile,
         args.push_back("-Z");
         args.push_back("force-unstable-if-unmarked");
     }
-    if( true /*parent.m_opts.enable_optimise*/ ) {
+    if( parent.m_opts.opt_level ) {
+        args.push_back("-C"); args.push_back(format("opt-level=", parent.m_opts.opt_level));
+    }
+    else if( true /*parent.m_opts.enable_optimise*/ ) {
         args.push_back("-O");
     }
     if( parent.m_opts.emit_mmir ) {
         args.push_back("-C"); args.push_back("codegen-type=monomir");
     }
+    // NOTE: Passed to every crate (not just the final binary), so the libraries carry LTO bytecode
+    if( parent.m_opts.enable_lto && !parent.is_rustc() && !parent.m_opts.emit_mmir ) {
+        args.push_back("-C"); args.push_back("lto");
+    }
+    // NOTE: Also passed to every crate, as the panic runtime and the crates catching panics must agree on the mechanism
+    if( parent.m_opts.enable_landing_pads && !parent.is_rustc() && !parent.m_opts.emit_mmir ) {
+        args.push_back("-C"); args.push_back("landing-pads");
+    }
+    if( parent.m_opts.profile_generate_dir.is_valid() && !parent.m_opts.emit_mmir ) {
+        args.push_back("-C"); args.push_back(format("profile-generate=", parent.m_opts.profile_generate_dir));
+    }
+    if( parent.m_opts.profile_use_dir.is_valid() && !parent.m_opts.emit_mmir ) {
+        args.push_back("-C"); args.push_back(format("profile-use=", parent.m_opts.profile_use_dir));
+    }
 
     for(const auto& d : parent.m_opts.lib_search_dirs)
     {
@@ -21,6 +21,11 @@ struct BuildOptions
     ::std::vector<::helpers::path>  lib_search_dirs;
     bool emit_mmir = false;
     bool enable_debug = false;
+    const char* opt_level = nullptr;    // if null, `-O` is used
+    bool enable_lto = false;
+    bool enable_landing_pads = false;
+    ::helpers::path profile_generate_dir;   // If valid, instrument all crates to record profiles here
+    ::helpers::path profile_use_dir;    // If valid, optimise all crates using the profiles here
     const char* target_name = nullptr;  // if null, host is used
     enum class Mode {
         /// Build the binary/library
@@ -60,6 +60,19 @@ struct ProgramOptions
     /// Enable debug output (`-g` passed)
     bool enable_debug = false;
 
+    /// Optimisation level (`-C opt-level=<n>` passed, instead of `-O`)
+    const char* opt_level = nullptr;
+
+    /// Build every crate with link-time optimisation (`-C lto` passed)
+    bool enable_lto = false;
+
+    /// Build every crate with landing pads for unwinding panics (`-C landing-pads` passed)
+    bool enable_landing_pads = false;
+
+    /// Profile-guided optimisation: directory to write profiles into (`-C profile-generate`), or to read them from (`-C profile-use`)
+    const char* profile_generate_dir = nullptr;
+    const char* profile_use_dir = nullptr;
+
     bool no_default_features = false;
     ::std::vector<::std::string>    features;
 
@@ -279,6 +292,13 @@ int main(int argc, const char* argv[])
         build_opts.lib_search_dirs.reserve(opts.lib_search_dirs.size());
         build_opts.emit_mmir = opts.emit_mmir;
         build_opts.enable_debug = opts.enable_debug;
+        build_opts.opt_level = opts.opt_level;
+        build_opts.enable_lto = opts.enable_lto;
+        build_opts.enable_landing_pads = opts.enable_landing_pads;
+        if( opts.profile_generate_dir )
+            build_opts.profile_generate_dir = ::helpers::path(opts.profile_generate_dir);
+        if( opts.profile_use_dir )
+            build_opts.profile_use_dir = ::helpers::path(opts.profile_use_dir);
         build_opts.target_name = opts.target;
         for(const auto* d : opts.lib_search_dirs)
             build_opts.lib_search_dirs.push_back( ::helpers::path(d) );
@@ -459,6 +479,33 @@ int ProgramOptions::parse(int argc, const char* argv[])
             else if( ::std::strcmp(arg, "--test") == 0 ) {
                 this->test = true;
             }
+            else if( ::std::strcmp(arg, "--opt-level") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->opt_level = argv[++i];
+            }
+            else if( ::std::strcmp(arg, "--lto") == 0 ) {
+                this->enable_lto = true;
+            }
+            else if( ::std::strcmp(arg, "--landing-pads") == 0 ) {
+                this->enable_landing_pads = true;
+            }
+            else if( ::std::strcmp(arg, "--profile-generate") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->profile_generate_dir = argv[++i];
+            }
+            else if( ::std::strcmp(arg, "--profile-use") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->profile_use_dir = argv[++i];
+            }
             else {
                 ::std::cerr << "Unknown flag " << arg << ::std::endl;
                 return 1;
@@ -466,6 +513,12 @@ int ProgramOptions::parse(int argc, const char* argv[])
         }
     }
 
+    if( this->profile_generate_dir && this->profile_use_dir )
+    {
+        ::std::cerr << "--profile-generate and --profile-use are mutually exclusive" << ::std::endl;
+        return 1;
+    }
+
     if( !this->directory /*|| !this->outfile*/ )
     {
         usage(::std::cerr);
@@ -497,6 +550,11 @@ void ProgramOptions::help() const
         << "-j <count>               : Run at most <count> build tasks at once (default is to run only one)\n"
         << "-n                       : Don't build any packages, just list the packages that would be built\n"
         << "-g                       : Pass `-g` to compiler\n"
+        << "--opt-level <n>          : Build with `-C opt-level=<n>` instead of `-O`\n"
+        << "--lto                    : Build all crates with `-C lto`, optimising the final binary across crates\n"
+        << "--landing-pads           : Build all crates with `-C landing-pads`, so panics run destructors as they unwind\n"
+        << "--profile-generate <dir> : Instrument all crates to record execution profiles in <dir>\n"
+        << "--profile-use <dir>      : Optimise all crates using the profiles in <dir>\n"
         << "--no-default-features    : \n"
         << "--features <list>        : \n"
         ;
@@ -26,6 +26,8 @@ struct ProgramOptions
 
     // Output logfile
     ::std::string   logfile;
+    // Print execution statistics on exit
+    bool    show_stats = false;
     // Arguments for the program
     ::std::vector<const char*>  args;
 
@@ -107,18 +109,17 @@ int main(int argc, const char* argv[])
     try
     {
         GlobalState global(tree);
-        InterpreterThread   root_thread(global);
 
         ::std::vector<Value>    args;
         args.push_back(::std::move(val_argc));
         args.push_back(::std::move(val_argv));
-        Value   rv;
-        root_thread.start("main#", ::std::move(args));
-        while( !root_thread.step_one(rv) )
-        {
-        }
+        Value   rv = global.run_main("main#", ::std::move(args));
 
         LOG_NOTICE("Return code: " << rv);
+        if( opts.show_stats )
+        {
+            InterpreterThread::dump_extern_stats(::std::cerr);
+        }
     }
     catch(const DebugExceptionTodo& /*e*/)
     {
@@ -205,6 +206,9 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 const char* opt = argv[++argidx];
                 this->logfile = opt;
             }
+            else if( ::std::strcmp(arg, "--stats") == 0 ) {
+                this->show_stats = true;
+            }
             //else if( ::std::strcmp(arg, "--api") == 0 ) {
             //}
             else {
@@ -222,5 +226,5 @@ int ProgramOptions::parse(int argc, const char* argv[])
 
 void ProgramOptions::show_help(const char* prog) const
 {
-    ::std::cout << "USAGE: " << prog << " <infile> <... args>" << ::std::endl;
+    ::std::cout << "USAGE: " << prog << " [--logfile <file>] [--stats] <infile> <... args>" << ::std::endl;
 }
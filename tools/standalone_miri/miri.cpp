@@ -12,6 +12,8 @@
 #include "string_view.hpp"
 #include <algorithm>
 #include <iomanip>
+#include <thread>   // this_thread::sleep_for
+#include <chrono>
 #include "debug.hpp"
 #include "miri.hpp"
 #include <target_version.hpp>
@@ -433,6 +435,19 @@ struct MirHelpers
 GlobalState::GlobalState(const ModuleTree& modtree):
     m_modtree(modtree)
 {
+    // Resolve the targets of external functions
+    m_modtree.iterate_functions([this](RcString name, const Function& f) {
+        const auto& link_name = f.external.link_name;
+        if( link_name == "" )
+            return ;
+        // Force using the `call_extern` version for the allocator
+        if( link_name != "__rust_allocate" && link_name != "__rust_reallocate" )
+        {
+            f.external.impl_fcn = m_modtree.get_ext_function(link_name.c_str());
+        }
+        f.external.shim_idx = InterpreterThread::resolve_extern(link_name);
+        });
+
     // Generate statics
     m_modtree.iterate_statics([this](RcString name, const Static& s) {
         auto val = Value(s.ty);
@@ -544,6 +559,75 @@ GlobalState::GlobalState(const ModuleTree& modtree):
 // ====================================================================
 //
 // ====================================================================
+GlobalState::~GlobalState()
+{
+}
+uint64_t GlobalState::create_thread(const ::HIR::Path& entry, ::std::vector<Value> args)
+{
+    uint64_t id = m_threads.size() + 1;
+    ThreadInfo  ti;
+    ti.thread.reset(new InterpreterThread(*this, id));
+    ti.thread->start(entry, ::std::move(args));
+    m_threads.push_back(::std::move(ti));
+    return id;
+}
+Value GlobalState::run_main(const RcString& entry, ::std::vector<Value> args)
+{
+    // Number of instructions to run a thread for before switching to the next
+    const size_t TIME_SLICE = 1000;
+
+    assert(m_threads.empty());
+    create_thread(::HIR::Path { entry }, ::std::move(args));
+    for(;;)
+    {
+        bool made_progress = false;
+        // NOTE: Threads can be created during this loop, so check the size every iteration
+        for(size_t idx = 0; idx < m_threads.size(); idx ++)
+        {
+            if( m_threads[idx].is_complete )
+                continue ;
+            auto& thread = *m_threads[idx].thread;
+            for(size_t i = 0; i < TIME_SLICE; i ++)
+            {
+                thread.m_thread.is_blocked = false;
+                thread.m_thread.yield_requested = false;
+                Value   rv;
+                if( thread.step_one(rv) )
+                {
+                    LOG_DEBUG("Thread " << (idx+1) << " complete");
+                    m_threads[idx].is_complete = true;
+                    m_threads[idx].result = ::std::move(rv);
+                    made_progress = true;
+                    break;
+                }
+                if( thread.m_thread.is_blocked )
+                    break;
+                made_progress = true;
+                if( thread.m_thread.yield_requested )
+                    break;
+            }
+            // The process ends when the main thread returns
+            if( m_threads[0].is_complete )
+            {
+                // Other threads are abandoned (don't print their stacks)
+                for(auto& t : m_threads)
+                    t.thread->m_stack.clear();
+                return ::std::move(m_threads[0].result);
+            }
+        }
+        if( !made_progress )
+        {
+            // A timed condition variable wait will eventually time out, so give the clock a chance to advance
+            if( ::std::any_of(m_threads.begin(), m_threads.end(), [](const ThreadInfo& ti){ return !ti.is_complete && ti.thread->m_thread.cond_timed; }) )
+            {
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+                continue ;
+            }
+            LOG_ERROR("Deadlock - all " << m_threads.size() << " threads are blocked");
+        }
+    }
+}
+
 InterpreterThread::~InterpreterThread()
 {
     for(size_t i = 0; i < m_stack.size(); i++)
@@ -565,11 +649,11 @@ InterpreterThread::~InterpreterThread()
         ::std::cout << ::std::endl;
     }
 }
-void InterpreterThread::start(const RcString& p, ::std::vector<Value> args)
+void InterpreterThread::start(const ::HIR::Path& p, ::std::vector<Value> args)
 {
     assert( this->m_stack.empty() );
     Value   v;
-    if( this->call_path(v, HIR::Path { p }, ::std::move(args)) )
+    if( this->call_path(v, p, ::std::move(args)) )
     {
         LOG_TODO("Handle immediate return thread entry");
     }
@@ -1784,6 +1868,12 @@ bool InterpreterThread::step_one(Value& out_thread_result)
                     LOG_DEBUG("- Non-immediate return, do not advance yet");
                     return false;
                 }
+                if( m_thread.is_blocked )
+                {
+                    // The call will be made again when this thread is next scheduled
+                    LOG_DEBUG("- Blocked, retry later");
+                    return false;
+                }
             }
             // If a panic is in progress (in thread state), take the panic block instead
             if( m_thread.panic_active )
@@ -1946,24 +2036,15 @@ bool InterpreterThread::call_path(Value& ret, const ::HIR::Path& path, ::std::ve
     if( fcn.external.link_name != "" )
     {
         const auto& name = fcn.external.link_name;
-        if(name == "__rust_allocate"
-            || name == "__rust_reallocate"
-            )
+        // A function with both code and this link name
+        if(const auto* ext_fcn = fcn.external.impl_fcn)
         {
-            // Force using the `call_extern` version
-        }
-        else
-        {
-            // Search for a function with both code and this link name
-            if(const auto* ext_fcn = m_global.m_modtree.get_ext_function(name.c_str()))
-            {
-                LOG_DEBUG("Matched extern - `" << name << "`");
-                this->m_stack.push_back(StackFrame(*ext_fcn, ::std::move(args)));
-                return false;
-            }
+            LOG_DEBUG("Matched extern - `" << name << "`");
+            this->m_stack.push_back(StackFrame(*ext_fcn, ::std::move(args)));
+            return false;
         }
         // External function!
-        return this->call_extern(ret, name, fcn.external.link_abi, ::std::move(args));
+        return this->call_extern(ret, fcn.external.shim_idx, name, fcn.external.link_abi, ::std::move(args));
     }
 
     this->m_stack.push_back(StackFrame(fcn, ::std::move(args)));
@@ -7,12 +7,15 @@
  */
 #pragma once
 #include <cstdint>
+#include <memory>
 #include "module_tree.hpp"
 #include "value.hpp"
 
 struct ThreadState
 {
     static unsigned s_next_tls_key;
+    /// Thread ID (the `pthread_t` value), the main thread is `1`
+    uint64_t    thread_id;
     unsigned call_stack_depth;
     ::std::vector< ::std::pair<uint64_t, RelocationPtr> > tls_values;
 
@@ -20,10 +23,26 @@ struct ThreadState
     bool    panic_active;
     Value   panic_value;
 
-    ThreadState():
-        call_stack_depth(0)
+    /// Set by a shim that can't complete yet (e.g. waiting on a lock), the call is re-tried once other threads have run
+    bool    is_blocked;
+    /// Set by a shim to request that other threads get a chance to run (e.g. `sched_yield`)
+    bool    yield_requested;
+    /// Condition variable this thread is waiting on (and if it has been signalled yet)
+    const void* cond_waiting;
+    bool    cond_signalled;
+    /// The wait on `cond_waiting` has a deadline (so isn't a deadlock if nothing else can run)
+    bool    cond_timed;
+
+    ThreadState(uint64_t thread_id):
+        thread_id(thread_id)
+        ,call_stack_depth(0)
         ,panic_count(0)
         ,panic_active(false)
+        ,is_blocked(false)
+        ,yield_requested(false)
+        ,cond_waiting(nullptr)
+        ,cond_signalled(false)
+        ,cond_timed(false)
     {
     }
 
@@ -49,7 +68,41 @@ struct GlobalState
 
     std::map<RcString, override_handler_t*>  m_fcn_overrides;
 
+    // --- Threading
+    // Threads are co-operatively scheduled (see `run_main`), switching after a time slice or when a thread blocks.
+    // As only one thread runs at a time, atomic intrinsics need no extra handling.
+    struct ThreadInfo {
+        ::std::unique_ptr<InterpreterThread>    thread;
+        bool    is_complete = false;
+        bool    is_detached = false;
+        bool    is_joined = false;
+        Value   result;
+    };
+    /// All threads created, indexed by `thread_id - 1`
+    ::std::vector<ThreadInfo>   m_threads;
+    /// Locked mutexes (keyed by the address of the `pthread_mutex_t`)
+    struct MutexState {
+        uint64_t    owner = 0;
+        unsigned    count = 0;
+    };
+    ::std::map<const void*, MutexState> m_mutexes;
+    struct RwLockState {
+        uint64_t    writer = 0;
+        unsigned    readers = 0;
+    };
+    ::std::map<const void*, RwLockState>    m_rwlocks;
+    /// Clocks selected by `pthread_condattr_setclock` (keyed by the `pthread_condattr_t`), and the clocks used by
+    /// condition variables initialised with them (keyed by the `pthread_cond_t`, `CLOCK_REALTIME` if absent)
+    ::std::map<const void*, int>    m_condattr_clocks;
+    ::std::map<const void*, int>    m_cond_clocks;
+
     GlobalState(const ModuleTree& modtree);
+    ~GlobalState();
+
+    /// Create a new thread (not run until the scheduler gets to it), returning its ID
+    uint64_t create_thread(const ::HIR::Path& entry, ::std::vector<Value> args);
+    /// Run `entry` as the main thread (along with any threads it spawns), returning once the main thread completes
+    Value run_main(const RcString& entry, ::std::vector<Value> args);
 };
 
 struct VaArgsState {
@@ -72,6 +125,7 @@ struct VaArgsState {
 class InterpreterThread
 {
     friend struct MirHelpers;
+    friend struct GlobalState;
 
     struct StackFrame
     {
@@ -104,14 +158,20 @@ class InterpreterThread
     ::std::vector<StackFrame>   m_stack;
 
 public:
-    InterpreterThread(GlobalState& m_global):
+    InterpreterThread(GlobalState& m_global, uint64_t thread_id=1):
         m_global(m_global),
+        m_thread(thread_id),
         m_instruction_count(0)
     {
     }
     ~InterpreterThread();
 
-    void start(const RcString& p, ::std::vector<Value> args);
+    void start(const ::HIR::Path& p, ::std::vector<Value> args);
+
+    /// Look up the built-in implementation of an external function, returning zero if there isn't one
+    static unsigned resolve_extern(const ::std::string& link_name);
+    /// Print the number of calls to each external function
+    static void dump_extern_stats(::std::ostream& os);
     // Returns `true` if the call stack empties
     bool step_one(Value& out_thread_result);
 
@@ -121,7 +181,8 @@ private:
     // Returns true if the call was resolved instantly
     bool call_path(Value& ret_val, const HIR::Path& p, ::std::vector<Value> args);
     // Returns true if the call was resolved instantly
-    bool call_extern(Value& ret_val, const ::std::string& name, const ::std::string& abi, ::std::vector<Value> args);
+    // - `shim` is from `resolve_extern`
+    bool call_extern(Value& ret_val, unsigned shim, const ::std::string& name, const ::std::string& abi, ::std::vector<Value> args);
     // Returns true if the call was resolved instantly
     bool call_intrinsic(Value& ret_val, const ::HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& pp, ::std::vector<Value> args);
 
@@ -16,6 +16,7 @@
 #include "miri.hpp"
 #include <target_version.hpp>
 #include <cctype>
+#include <unordered_map>
 // VVV FFI
 #include <cstring>  // memrchr
 #include <sys/stat.h>
@@ -167,10 +168,181 @@ namespace FfiHelpers {
     return output.str();
 }
 
-bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, const ::std::string& abi, ::std::vector<Value> args)
+// Built-in implementations of external functions, as `_(ident, link_name)`
+// - Resolved once per function when the tree is loaded (see `GlobalState`), so calls don't search by name.
+#define EXTERN_SHIMS(_) \
+    _(rust_allocate, "__rust_allocate") \
+    _(rust_alloc, "__rust_alloc") \
+    _(rust_alloc_zeroed, "__rust_alloc_zeroed") \
+    _(rust_reallocate, "__rust_reallocate") \
+    _(rust_realloc, "__rust_realloc") \
+    _(rust_deallocate, "__rust_deallocate") \
+    _(rust_dealloc, "__rust_dealloc") \
+    _(rust_maybe_catch_panic, "__rust_maybe_catch_panic") \
+    _(panic_impl, "panic_impl") \
+    _(rust_start_panic, "__rust_start_panic") \
+    _(rust_begin_unwind, "rust_begin_unwind") \
+    _(Unwind_RaiseException, "_Unwind_RaiseException") \
+    _(Unwind_DeleteException, "_Unwind_DeleteException") \
+    _(AddVectoredExceptionHandler, "AddVectoredExceptionHandler") \
+    _(GetModuleHandleW, "GetModuleHandleW") \
+    _(GetProcAddress, "GetProcAddress") \
+    _(TlsAlloc, "TlsAlloc") \
+    _(TlsGetValue, "TlsGetValue") \
+    _(TlsSetValue, "TlsSetValue") \
+    _(InitializeCriticalSection, "InitializeCriticalSection") \
+    _(EnterCriticalSection, "EnterCriticalSection") \
+    _(TryEnterCriticalSection, "TryEnterCriticalSection") \
+    _(LeaveCriticalSection, "LeaveCriticalSection") \
+    _(DeleteCriticalSection, "DeleteCriticalSection") \
+    _(GetStdHandle, "GetStdHandle") \
+    _(GetConsoleMode, "GetConsoleMode") \
+    _(WriteConsoleW, "WriteConsoleW") \
+    _(write, "write") \
+    _(read, "read") \
+    _(open, "open") \
+    _(close, "close") \
+    _(isatty, "isatty") \
+    _(fcntl, "fcntl") \
+    _(prctl, "prctl") \
+    _(sysconf, "sysconf") \
+    _(mmap, "mmap") \
+    _(pipe, "pipe") \
+    _(pthread_self, "pthread_self") \
+    _(pthread_mutex_init, "pthread_mutex_init") \
+    _(pthread_mutex_lock, "pthread_mutex_lock") \
+    _(pthread_mutex_trylock, "pthread_mutex_trylock") \
+    _(pthread_mutex_unlock, "pthread_mutex_unlock") \
+    _(pthread_mutex_destroy, "pthread_mutex_destroy") \
+    _(pthread_rwlock_rdlock, "pthread_rwlock_rdlock") \
+    _(pthread_rwlock_wrlock, "pthread_rwlock_wrlock") \
+    _(pthread_rwlock_unlock, "pthread_rwlock_unlock") \
+    _(pthread_rwlock_destroy, "pthread_rwlock_destroy") \
+    _(pthread_mutexattr_init, "pthread_mutexattr_init") \
+    _(pthread_mutexattr_settype, "pthread_mutexattr_settype") \
+    _(pthread_mutexattr_destroy, "pthread_mutexattr_destroy") \
+    _(pthread_condattr_init, "pthread_condattr_init") \
+    _(pthread_condattr_destroy, "pthread_condattr_destroy") \
+    _(pthread_condattr_setclock, "pthread_condattr_setclock") \
+    _(pthread_attr_init, "pthread_attr_init") \
+    _(pthread_attr_destroy, "pthread_attr_destroy") \
+    _(pthread_getattr_np, "pthread_getattr_np") \
+    _(pthread_attr_setstacksize, "pthread_attr_setstacksize") \
+    _(pthread_attr_getguardsize, "pthread_attr_getguardsize") \
+    _(pthread_attr_getstack, "pthread_attr_getstack") \
+    _(pthread_create, "pthread_create") \
+    _(pthread_detach, "pthread_detach") \
+    _(pthread_cond_init, "pthread_cond_init") \
+    _(pthread_cond_destroy, "pthread_cond_destroy") \
+    _(pthread_cond_wait, "pthread_cond_wait") \
+    _(pthread_cond_timedwait, "pthread_cond_timedwait") \
+    _(pthread_cond_signal, "pthread_cond_signal") \
+    _(pthread_cond_broadcast, "pthread_cond_broadcast") \
+    _(pthread_join, "pthread_join") \
+    _(sched_yield, "sched_yield") \
+    _(pthread_key_create, "pthread_key_create") \
+    _(pthread_getspecific, "pthread_getspecific") \
+    _(pthread_setspecific, "pthread_setspecific") \
+    _(pthread_key_delete, "pthread_key_delete") \
+    _(clock_gettime, "clock_gettime") \
+    _(open64, "open64") \
+    _(stat64, "stat64") \
+    _(errno_location, "__errno_location") \
+    _(error, "__error") \
+    _(syscall, "syscall") \
+    _(dlsym, "dlsym") \
+    _(signal, "signal") \
+    _(sigaction, "sigaction") \
+    _(sigaltstack, "sigaltstack") \
+    _(atoi, "atoi") \
+    _(strtoll, "strtoll") \
+    _(strtol, "strtol") \
+    _(malloc, "malloc") \
+    _(calloc, "calloc") \
+    _(realloc, "realloc") \
+    _(free, "free") \
+    _(memcmp, "memcmp") \
+    _(memset, "memset") \
+    _(memcpy, "memcpy") \
+    _(memchr, "memchr") \
+    _(memrchr, "memrchr") \
+    _(strcpy, "strcpy") \
+    _(strlen, "strlen") \
+    _(strcmp, "strcmp") \
+    _(strncmp, "strncmp") \
+    _(strdup, "strdup") \
+    _(strndup, "strndup") \
+    _(getenv, "getenv") \
+    _(setenv, "setenv") \
+    _(strerror, "strerror") \
+    _(strerror_r, "strerror_r") \
+    _(printf, "printf") \
+    _(snprintf, "snprintf") \
+    _(vsnprintf, "vsnprintf") \
+    _(fopen, "fopen") \
+    _(fclose, "fclose") \
+    _(fseek, "fseek") \
+    _(ftell, "ftell") \
+    _(fread, "fread") \
+    _(setjmp, "setjmp") \
+    _(longjmp, "longjmp") \
+    _(isspace, "isspace") \
+    _(isalpha, "isalpha") \
+    _(isalnum, "isalnum")
+
+namespace {
+    enum class ExternShim : unsigned {
+        Unknown,
+#define _(ident, name)  ident,
+        EXTERN_SHIMS(_)
+#undef _
+        COUNT
+    };
+    const char* const s_extern_shim_names[] = {
+        "",
+#define _(ident, name)  name,
+        EXTERN_SHIMS(_)
+#undef _
+    };
+    /// Number of calls made to each shim (including `Unknown`)
+    uint64_t    s_extern_shim_calls[static_cast<unsigned>(ExternShim::COUNT)];
+}
+
+unsigned InterpreterThread::resolve_extern(const ::std::string& link_name)
+{
+    static ::std::unordered_map<::std::string, unsigned>  s_index;
+    if( s_index.empty() )
+    {
+        for(unsigned i = 1; i < static_cast<unsigned>(ExternShim::COUNT); i ++)
+            s_index.insert(::std::make_pair(s_extern_shim_names[i], i));
+    }
+    auto it = s_index.find(link_name);
+    return it != s_index.end() ? it->second : 0;
+}
+void InterpreterThread::dump_extern_stats(::std::ostream& os)
 {
-    if( link_name == "__rust_allocate" || link_name == "__rust_alloc" || link_name == "__rust_alloc_zeroed" )
+    ::std::vector<unsigned> order;
+    for(unsigned i = 0; i < static_cast<unsigned>(ExternShim::COUNT); i ++)
     {
+        if( s_extern_shim_calls[i] > 0 )
+            order.push_back(i);
+    }
+    ::std::sort(order.begin(), order.end(), [](unsigned a, unsigned b){ return s_extern_shim_calls[a] > s_extern_shim_calls[b]; });
+    os << "Extern calls:" << ::std::endl;
+    for(auto i : order)
+    {
+        os << ::std::setw(12) << s_extern_shim_calls[i] << " " << (i == 0 ? "(unknown)" : s_extern_shim_names[i]) << ::std::endl;
+    }
+}
+
+bool InterpreterThread::call_extern(Value& rv, unsigned shim, const ::std::string& link_name, const ::std::string& abi, ::std::vector<Value> args)
+{
+    s_extern_shim_calls[shim] += 1;
+    switch( static_cast<ExternShim>(shim) )
+    {
+    case ExternShim::rust_allocate:
+    case ExternShim::rust_alloc:
+    case ExternShim::rust_alloc_zeroed: {
         static unsigned s_alloc_count = 0;
 
         auto alloc_idx = s_alloc_count ++;
@@ -187,15 +359,15 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         LOG_TRACE("- alloc=" << alloc << " (" << alloc->size() << " bytes)");
         auto rty = ::HIR::TypeRef(RawType::Unit).wrap( TypeWrapper::Ty::Pointer, 0 );
 
-        if( link_name == "__rust_alloc_zeroed" )
+        if( static_cast<ExternShim>(shim) == ExternShim::rust_alloc_zeroed )
         {
             alloc->mark_bytes_valid(0, size);
         }
 
         rv = Value::new_pointer_ofs(rty, 0, RelocationPtr::new_alloc(::std::move(alloc)));
-    }
-    else if( link_name == "__rust_reallocate" || link_name == "__rust_realloc" )
-    {
+        } break;
+    case ExternShim::rust_reallocate:
+    case ExternShim::rust_realloc: {
         auto oldsize = args.at(1).read_usize(0);
         auto ptr = args.at(0).read_pointer_valref_mut(0, oldsize);
 
@@ -218,9 +390,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         alloc.resize(newsize);
 
         rv = ::std::move(args.at(0));
-    }
-    else if( link_name == "__rust_deallocate" || link_name == "__rust_dealloc" )
-    {
+        } break;
+    case ExternShim::rust_deallocate:
+    case ExternShim::rust_dealloc: {
         auto ptr = args.at(0).read_pointer_valref_mut(0, 0);
         LOG_ASSERT(ptr.m_offset == 0, "__rust_deallocate with offset pointer");
         LOG_DEBUG("__rust_deallocate(ptr=" << ptr.m_alloc << ")");
@@ -231,9 +403,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         alloc.mark_as_freed();
         // Just let it drop.
         rv = Value();
-    }
-    else if( link_name == "__rust_maybe_catch_panic" )
-    {
+        } break;
+    case ExternShim::rust_maybe_catch_panic: {
         auto fcn_path = args.at(0).read_pointer_fcn(0);
         auto& arg = args.at(1);
         auto data_ptr = args.at(2).read_pointer_valref_mut(0, POINTER_SIZE);
@@ -258,41 +429,34 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         {
             return false;
         }
-    }
-    else if( link_name == "panic_impl" )
-    {
+        } break;
+    case ExternShim::panic_impl: {
         LOG_TODO("panic_impl");
-    }
-    else if( link_name == "__rust_start_panic" )
-    {
+        } break;
+    case ExternShim::rust_start_panic: {
         LOG_TODO("__rust_start_panic");
-    }
-    else if( link_name == "rust_begin_unwind" )
-    {
+        } break;
+    case ExternShim::rust_begin_unwind: {
         LOG_TODO("rust_begin_unwind");
-    }
+        } break;
     // libunwind
-    else if( link_name == "_Unwind_RaiseException" )
-    {
+    case ExternShim::Unwind_RaiseException: {
         LOG_DEBUG("_Unwind_RaiseException(" << args.at(0) << ")");
         // Save the first argument in TLS, then return a status that indicates unwinding should commence.
         m_thread.panic_active = true;
         m_thread.panic_count += 1;
         m_thread.panic_value = ::std::move(args.at(0));
-    }
-    else if( link_name == "_Unwind_DeleteException" )
-    {
+        } break;
+    case ExternShim::Unwind_DeleteException: {
         LOG_DEBUG("_Unwind_DeleteException(" << args.at(0) << ")");
-    }
+        } break;
 #ifdef _WIN32
     // WinAPI functions used by libstd
-    else if( link_name == "AddVectoredExceptionHandler" )
-    {
+    case ExternShim::AddVectoredExceptionHandler: {
         LOG_DEBUG("Call `AddVectoredExceptionHandler` - Ignoring and returning non-null");
         rv = Value::new_usize(1);
-    }
-    else if( link_name == "GetModuleHandleW" )
-    {
+        } break;
+    case ExternShim::GetModuleHandleW: {
         const auto& tgt_alloc = args.at(0).get_relocation(0);
         const void* arg0 = (tgt_alloc ? tgt_alloc.alloc().data_ptr() : nullptr);
         //extern void* GetModuleHandleW(const void* s);
@@ -314,9 +478,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             rv.create_allocation("GetModuleHandleW");
             rv.write_usize(0,0);
         }
-    }
-    else if( link_name == "GetProcAddress" )
-    {
+        } break;
+    case ExternShim::GetProcAddress: {
         const auto& handle_alloc = args.at(0).get_relocation(0);
         const auto& sym_alloc = args.at(1).get_relocation(0);
 
@@ -345,16 +508,14 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             rv.create_allocation("GetProcAddress");
             rv.write_usize(0,0);
         }
-    }
+        } break;
     // --- Thread-local storage
-    else if( link_name == "TlsAlloc" )
-    {
+    case ExternShim::TlsAlloc: {
         auto key = ThreadState::s_next_tls_key ++;
 
         rv = Value::new_u32(key);
-    }
-    else if( link_name == "TlsGetValue" )
-    {
+        } break;
+    case ExternShim::TlsGetValue: {
         // LPVOID TlsGetValue( DWORD dwTlsIndex );
         auto key = args.at(0).read_u32(0);
 
@@ -373,9 +534,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             // Return zero until populated
             rv = Value::new_usize(0);
         }
-    }
-    else if( link_name == "TlsSetValue" )
-    {
+        } break;
+    case ExternShim::TlsSetValue: {
         // BOOL TlsSetValue( DWORD  dwTlsIndex, LPVOID lpTlsValue );
         auto key = args.at(0).read_u32(0);
         auto v = args.at(1).read_usize(0);
@@ -388,38 +548,31 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         m_thread.tls_values[key] = ::std::make_pair(v, v_reloc);
 
         rv = Value::new_i32(1);
-    }
+        } break;
     // ---
-    else if( link_name == "InitializeCriticalSection" )
-    {
+    case ExternShim::InitializeCriticalSection: {
         // HACK: Just ignore, no locks
-    }
-    else if( link_name == "EnterCriticalSection" )
-    {
+        } break;
+    case ExternShim::EnterCriticalSection: {
         // HACK: Just ignore, no locks
-    }
-    else if( link_name == "TryEnterCriticalSection" )
-    {
+        } break;
+    case ExternShim::TryEnterCriticalSection: {
         // HACK: Just ignore, no locks
         rv = Value::new_i32(1);
-    }
-    else if( link_name == "LeaveCriticalSection" )
-    {
+        } break;
+    case ExternShim::LeaveCriticalSection: {
         // HACK: Just ignore, no locks
-    }
-    else if( link_name == "DeleteCriticalSection" )
-    {
+        } break;
+    case ExternShim::DeleteCriticalSection: {
         // HACK: Just ignore, no locks
-    }
+        } break;
     // ---
-    else if( link_name == "GetStdHandle" )
-    {
+    case ExternShim::GetStdHandle: {
         // HANDLE WINAPI GetStdHandle( _In_ DWORD nStdHandle );
         auto val = args.at(0).read_u32(0);
         rv = Value::new_ffiptr(FFIPointer::new_void("HANDLE", GetStdHandle(val)));
-    }
-    else if( link_name == "GetConsoleMode" )
-    {
+        } break;
+    case ExternShim::GetConsoleMode: {
         // BOOL WINAPI GetConsoleMode( _In_  HANDLE  hConsoleHandle, _Out_ LPDWORD lpMode );
         auto hConsoleHandle = args.at(0).read_pointer_tagged_nonnull(0, "HANDLE");
         auto lpMode_vr = args.at(1).read_pointer_valref_mut(0, sizeof(DWORD)).to_write();
@@ -436,9 +589,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             LOG_DEBUG("= FALSE");
         }
         rv = Value::new_i32(rv_bool ? 1 : 0);
-    }
-    else if( link_name == "WriteConsoleW" )
-    {
+        } break;
+    case ExternShim::WriteConsoleW: {
         //BOOL WINAPI WriteConsole( _In_ HANDLE  hConsoleOutput, _In_ const VOID    *lpBuffer, _In_ DWORD   nNumberOfCharsToWrite,  _Out_ LPDWORD lpNumberOfCharsWritten, _Reserved_ LPVOID  lpReserved );
         auto hConsoleOutput = args.at(0).read_pointer_tagged_nonnull(0, "HANDLE");
         auto nNumberOfCharsToWrite = args.at(2).read_u32(0);
@@ -460,11 +612,10 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             LOG_DEBUG("= FALSE");
         }
         rv = Value::new_i32(rv_bool ? 1 : 0);
-    }
+        } break;
 #else
     // POSIX
-    else if( link_name == "write" )
-    {
+    case ExternShim::write: {
         auto fd = args.at(0).read_i32(0);
         auto count = args.at(2).read_isize(0);
         const auto* buf = args.at(1).read_pointer_const(0, count);
@@ -472,9 +623,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         ssize_t val = write(fd, buf, count);
 
         rv = Value::new_isize(val);
-    }
-    else if( link_name == "read" )
-    {
+        } break;
+    case ExternShim::read: {
         auto fd = args.at(0).read_i32(0);
         auto count = args.at(2).read_isize(0);
         auto buf_vr = args.at(1).read_pointer_valref_mut(0, count).to_write();
@@ -489,9 +639,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         }
 
         rv = Value::new_isize(val);
-    }
-    else if( link_name == "open" )
-    {
+        } break;
+    case ExternShim::open: {
         auto path = FfiHelpers::read_cstr(args.at(0), 0);
         auto flags = args.at(1).read_i32(0);
         // TODO: Emulate for windows?
@@ -514,24 +663,21 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         }
         rv = Value::new_i32(fd);
 #endif
-    }
-    else if( link_name == "close" )
-    {
+        } break;
+    case ExternShim::close: {
         auto fd = args.at(0).read_i32(0);
         LOG_DEBUG("close(" << fd << ")");
         // TODO: Ensure that this FD is from the set known by the FFI layer
         close(fd);
-    }
-    else if( link_name == "isatty" )
-    {
+        } break;
+    case ExternShim::isatty: {
         auto fd = args.at(0).read_i32(0);
         LOG_DEBUG("isatty(" << fd << ")");
         int rv_i = isatty(fd);
         LOG_DEBUG("= " << rv_i);
         rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "fcntl" )
-    {
+        } break;
+    case ExternShim::fcntl: {
         // `fcntl` has custom handling for the third argument, as some are pointers
         int fd = args.at(0).read_i32(0);
         int command = args.at(1).read_i32(0);
@@ -570,9 +716,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         LOG_DEBUG("= " << rv_i);
         rv = Value(::HIR::TypeRef(RawType::I32));
         rv.write_i32(0, rv_i);
-    }
-    else if( link_name == "prctl" )
-    {
+        } break;
+    case ExternShim::prctl: {
         auto option = args.at(0).read_i32(0);
         int rv_i;
         switch(option)
@@ -586,18 +731,16 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             LOG_TODO("prctl(" << option << ", ...");
         }
         rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "sysconf" )
-    {
+        } break;
+    case ExternShim::sysconf: {
         auto name = args.at(0).read_i32(0);
         LOG_DEBUG("FFI sysconf(" << name << ")");
 
         long val = sysconf(name);
 
         rv = Value::new_usize(val);
-    }
-    else if( link_name == "mmap" )
-    {
+        } break;
+    case ExternShim::mmap: {
         // void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
         auto& addr = args.at(0);
         auto length = args.at(1).read_usize(0);
@@ -612,9 +755,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             << ", offset=0x"<<std::hex<<offset
             );
         rv = std::move(addr);
-    }
-    else if( link_name == "pipe" )
-    {
+        } break;
+    case ExternShim::pipe: {
 #if 1   // TODO: `write_i32` doesn't directly work, need to grab allocation and handle
         auto dst = args.at(0).read_pointer_valref_mut(0, 2*4).to_write();
         int pipes[2];
@@ -631,49 +773,116 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 #else
         LOG_TODO("pipe");
 #endif
-    }
+        } break;
     // >>> pthread
-    else if( link_name == "pthread_self" )
-    {
+    case ExternShim::pthread_self: {
+        rv = Value::new_usize(m_thread.thread_id);
+        } break;
+    // NOTE: Threads are co-operatively scheduled, so locks only need to track their owner.
+    // A lock that can't be taken sets `is_blocked`, and the call is re-tried once other threads have run.
+    case ExternShim::pthread_mutex_init:
+    case ExternShim::pthread_mutex_destroy: {
+        m_global.m_mutexes.erase( args.at(0).read_pointer_const(0, 1) );
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_mutex_init"
-        || link_name == "pthread_mutex_lock"
-        || link_name == "pthread_mutex_trylock"
-        || link_name == "pthread_mutex_unlock"
-        || link_name == "pthread_mutex_destroy"
-        )
-    {
+        } break;
+    case ExternShim::pthread_mutex_lock:
+    case ExternShim::pthread_mutex_trylock: {
+        auto& m = m_global.m_mutexes[ args.at(0).read_pointer_const(0, 1) ];
+        // NOTE: The mutex type isn't tracked, so all mutexes are treated as recursive (needed for `ReentrantMutex`)
+        if( m.owner == 0 || m.owner == m_thread.thread_id )
+        {
+            m.owner = m_thread.thread_id;
+            m.count += 1;
+            rv = Value::new_i32(0);
+        }
+        else if( static_cast<ExternShim>(shim) == ExternShim::pthread_mutex_trylock )
+        {
+            rv = Value::new_i32(EBUSY);
+        }
+        else
+        {
+            LOG_DEBUG("pthread_mutex_lock: Held by thread " << m.owner);
+            m_thread.is_blocked = true;
+        }
+        } break;
+    case ExternShim::pthread_mutex_unlock: {
+        auto& m = m_global.m_mutexes[ args.at(0).read_pointer_const(0, 1) ];
+        LOG_ASSERT(m.owner == m_thread.thread_id, "pthread_mutex_unlock: Mutex not held by this thread (owner " << m.owner << ")");
+        if( --m.count == 0 )
+        {
+            m.owner = 0;
+        }
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_rwlock_rdlock" )
-    {
+        } break;
+    case ExternShim::pthread_rwlock_rdlock: {
+        auto& l = m_global.m_rwlocks[ args.at(0).read_pointer_const(0, 1) ];
+        if( l.writer == 0 )
+        {
+            l.readers += 1;
+            rv = Value::new_i32(0);
+        }
+        else
+        {
+            LOG_ASSERT(l.writer != m_thread.thread_id, "pthread_rwlock_rdlock: Lock already held for writing by this thread");
+            m_thread.is_blocked = true;
+        }
+        } break;
+    case ExternShim::pthread_rwlock_wrlock: {
+        auto& l = m_global.m_rwlocks[ args.at(0).read_pointer_const(0, 1) ];
+        if( l.writer == 0 && l.readers == 0 )
+        {
+            l.writer = m_thread.thread_id;
+            rv = Value::new_i32(0);
+        }
+        else
+        {
+            LOG_ASSERT(l.writer != m_thread.thread_id, "pthread_rwlock_wrlock: Lock already held for writing by this thread");
+            m_thread.is_blocked = true;
+        }
+        } break;
+    case ExternShim::pthread_rwlock_unlock: {
+        auto& l = m_global.m_rwlocks[ args.at(0).read_pointer_const(0, 1) ];
+        if( l.writer != 0 )
+        {
+            LOG_ASSERT(l.writer == m_thread.thread_id, "pthread_rwlock_unlock: Write lock held by another thread (" << l.writer << ")");
+            l.writer = 0;
+        }
+        else
+        {
+            // TODO: Check that this thread holds a read lock?
+            LOG_ASSERT(l.readers > 0, "pthread_rwlock_unlock: Lock not held");
+            l.readers -= 1;
+        }
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_rwlock_unlock" )
-    {
-        // TODO: Check that this thread holds the lock?
+        } break;
+    case ExternShim::pthread_rwlock_destroy: {
+        m_global.m_rwlocks.erase( args.at(0).read_pointer_const(0, 1) );
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_mutexattr_init" || link_name == "pthread_mutexattr_settype" || link_name == "pthread_mutexattr_destroy" )
-    {
+        } break;
+    case ExternShim::pthread_mutexattr_init:
+    case ExternShim::pthread_mutexattr_settype:
+    case ExternShim::pthread_mutexattr_destroy: {
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_condattr_init" || link_name == "pthread_condattr_destroy" || link_name == "pthread_condattr_setclock" )
-    {
+        } break;
+    case ExternShim::pthread_condattr_init:
+    case ExternShim::pthread_condattr_destroy: {
+        m_global.m_condattr_clocks.erase( args.at(0).read_pointer_const(0, 1) );
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_attr_init" || link_name == "pthread_attr_destroy" || link_name == "pthread_getattr_np" )
-    {
+        } break;
+    case ExternShim::pthread_condattr_setclock: {
+        m_global.m_condattr_clocks[ args.at(0).read_pointer_const(0, 1) ] = args.at(1).read_i32(0);
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_attr_setstacksize" )
-    {
+        } break;
+    case ExternShim::pthread_attr_init:
+    case ExternShim::pthread_attr_destroy:
+    case ExternShim::pthread_getattr_np: {
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_attr_setstacksize: {
         // Lie and return succeess
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_attr_getguardsize" )
-    {
+        } break;
+    case ExternShim::pthread_attr_getguardsize: {
         const auto attr_p = args.at(0).read_pointer_const(0, 1);
         auto out_size = args.at(1).deref(0, HIR::TypeRef(RawType::USize));
 
@@ -681,9 +890,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         out_size.m_alloc.alloc().write_usize(out_size.m_offset, 0x1000);
 
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_attr_getstack" )
-    {
+        } break;
+    case ExternShim::pthread_attr_getstack: {
         const auto attr_p = args.at(0).read_pointer_const(0, 1);
         auto out_ptr = args.at(2).deref(0, HIR::TypeRef(RawType::USize));
         auto out_size = args.at(2).deref(0, HIR::TypeRef(RawType::USize));
@@ -692,7 +900,7 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         out_size.m_alloc.alloc().write_usize(out_size.m_offset, 0x4000);
 
         rv = Value::new_i32(0);
-    }
+        } break;
     //else if( link_name == "pthread_get_stackaddr_np" ) {
     //    rv = Value::new_ffiptr(FFIPointer::new_const_bytes("pthread_get_stackaddr_np", "", 0));
     //}
@@ -700,63 +908,128 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     //    //rv = Value::new_usize(0x4000);
     //    rv = Value::new_usize(0);
     //}
-    else if( link_name == "pthread_create" )
-    {
+    case ExternShim::pthread_create: {
         auto thread_handle_out = args.at(0).read_pointer_valref_mut(0, sizeof(pthread_t));
         auto attrs = args.at(1).read_pointer_const(0, sizeof(pthread_attr_t));
         auto fcn_path = args.at(2).read_pointer_fcn(0);
         auto& arg = args.at(3);
-        LOG_NOTICE("TODO: pthread_create(" << thread_handle_out << ", " << attrs << ", " << fcn_path << ", " << arg << ")");
-        // TODO: Create a new interpreter context with this thread, use co-operative scheduling
-        // HACK: Just run inline
-        if( true )
+        LOG_DEBUG("pthread_create(" << thread_handle_out << ", " << attrs << ", " << fcn_path << ", " << arg << ")");
+
+        ::std::vector<Value>    thread_args;
+        thread_args.push_back(::std::move(arg));
+        auto id = m_global.create_thread(fcn_path, ::std::move(thread_args));
+        LOG_DEBUG("- Thread " << id);
+        thread_handle_out.m_alloc.alloc().write_usize( thread_handle_out.m_offset, id );
+
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_join: {
+        auto id = args.at(0).read_usize(0);
+        LOG_ASSERT(1 <= id && id <= m_global.m_threads.size(), "pthread_join: Invalid thread " << id);
+        auto& ti = m_global.m_threads[id-1];
+        LOG_ASSERT(!ti.is_detached && !ti.is_joined, "pthread_join: Thread " << id << " is detached or already joined");
+        if( !ti.is_complete )
         {
-            auto tls = ::std::move(m_thread.tls_values);
-            this->m_stack.push_back(StackFrame::make_wrapper([=](Value& out_rv, Value /*rv*/)mutable ->bool {
-                out_rv = Value::new_i32(0);
-                m_thread.tls_values = ::std::move(tls);
-                return true;
-                }));
-
-            // TODO: Catch the panic out of this.
-            ::std::vector<Value>    args;
-            args.push_back(std::move(arg));
-            if( this->call_path(rv, fcn_path, std::move(args)) )
-            {
-                bool v = this->pop_stack(rv);
-                assert( v == false );
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            m_thread.is_blocked = true;
+            break;
         }
-        else {
-            //this->m_parent.create_thread(fcn_path, arg);
-            rv = Value::new_i32(EPERM);
+        ti.is_joined = true;
+        if( args.at(1).read_usize(0) != 0 )
+        {
+            auto retval_out = args.at(1).read_pointer_valref_mut(0, POINTER_SIZE);
+            retval_out.m_alloc.alloc().write_value( retval_out.m_offset, ::std::move(ti.result) );
         }
-    }
-    else if( link_name == "pthread_detach" )
-    {
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_detach: {
         // "detach" - Prevent the need to explitly join a thread
+        auto id = args.at(0).read_usize(0);
+        LOG_ASSERT(1 <= id && id <= m_global.m_threads.size(), "pthread_detach: Invalid thread " << id);
+        m_global.m_threads[id-1].is_detached = true;
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_cond_init" || link_name == "pthread_cond_destroy" )
-    {
+        } break;
+    case ExternShim::sched_yield: {
+        m_thread.yield_requested = true;
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_key_create" )
-    {
+        } break;
+    case ExternShim::pthread_cond_init: {
+        const void* cond = args.at(0).read_pointer_const(0, 1);
+        m_global.m_cond_clocks.erase(cond);
+        if( args.at(1).read_usize(0) != 0 )
+        {
+            auto it = m_global.m_condattr_clocks.find( args.at(1).read_pointer_const(0, 1) );
+            if( it != m_global.m_condattr_clocks.end() )
+                m_global.m_cond_clocks[cond] = it->second;
+        }
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_cond_destroy: {
+        m_global.m_cond_clocks.erase( args.at(0).read_pointer_const(0, 1) );
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_cond_wait:
+    case ExternShim::pthread_cond_timedwait: {
+        const void* cond = args.at(0).read_pointer_const(0, 1);
+        auto& m = m_global.m_mutexes[ args.at(1).read_pointer_const(0, 1) ];
+        bool is_timed = static_cast<ExternShim>(shim) == ExternShim::pthread_cond_timedwait;
+        if( m_thread.cond_waiting != cond )
+        {
+            // First call: Release the mutex and start waiting
+            LOG_ASSERT(m.owner == m_thread.thread_id && m.count == 1, "pthread_cond_wait: Mutex not held (once) by this thread");
+            m.owner = 0;
+            m.count = 0;
+            m_thread.cond_waiting = cond;
+            m_thread.cond_signalled = false;
+            m_thread.cond_timed = is_timed;
+            m_thread.is_blocked = true;
+            break;
+        }
+        // Re-try: Wait for a signal (or for the deadline of a timed wait to pass), then re-acquire the mutex
+        bool timed_out = false;
+        if( is_timed && !m_thread.cond_signalled )
+        {
+            const auto* abstime = static_cast<const struct timespec*>(args.at(2).read_pointer_const(0, sizeof(struct timespec)));
+            auto it = m_global.m_cond_clocks.find(cond);
+            struct timespec now;
+            clock_gettime(it != m_global.m_cond_clocks.end() ? static_cast<clockid_t>(it->second) : CLOCK_REALTIME, &now);
+            timed_out = now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec);
+        }
+        if( (!m_thread.cond_signalled && !timed_out) || m.owner != 0 )
+        {
+            m_thread.is_blocked = true;
+            break;
+        }
+        m.owner = m_thread.thread_id;
+        m.count = 1;
+        rv = Value::new_i32(m_thread.cond_signalled ? 0 : ETIMEDOUT);
+        m_thread.cond_waiting = nullptr;
+        m_thread.cond_timed = false;
+        } break;
+    case ExternShim::pthread_cond_signal:
+    case ExternShim::pthread_cond_broadcast: {
+        const void* cond = args.at(0).read_pointer_const(0, 1);
+        bool is_broadcast = static_cast<ExternShim>(shim) == ExternShim::pthread_cond_broadcast;
+        for(auto& ti : m_global.m_threads)
+        {
+            auto& ts = ti.thread->m_thread;
+            if( !ti.is_complete && ts.cond_waiting == cond && !ts.cond_signalled )
+            {
+                ts.cond_signalled = true;
+                if( !is_broadcast )
+                    break;
+            }
+        }
+        rv = Value::new_i32(0);
+        } break;
+    case ExternShim::pthread_key_create: {
         auto key_ref = args.at(0).read_pointer_valref_mut(0, 4);
 
         auto key = ThreadState::s_next_tls_key ++;
         key_ref.m_alloc.alloc().write_u32( key_ref.m_offset, key );
 
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_getspecific" )
-    {
+        } break;
+    case ExternShim::pthread_getspecific: {
         auto key = args.at(0).read_u32(0);
 
         // Get a pointer-sized value from storage
@@ -774,9 +1047,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             // Return zero until populated
             rv = Value::new_usize(0);
         }
-    }
-    else if( link_name == "pthread_setspecific" )
-    {
+        } break;
+    case ExternShim::pthread_setspecific: {
         auto key = args.at(0).read_u32(0);
         auto v = args.at(1).read_u64(0);
         auto v_reloc = args.at(1).get_relocation(0);
@@ -788,14 +1060,12 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         m_thread.tls_values[key] = ::std::make_pair(v, v_reloc);
 
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "pthread_key_delete" )
-    {
+        } break;
+    case ExternShim::pthread_key_delete: {
         rv = Value::new_i32(0);
-    }
+        } break;
     // - Time
-    else if( link_name == "clock_gettime" )
-    {
+    case ExternShim::clock_gettime: {
         // int clock_gettime(clockid_t clk_id, struct timespec *tp);
         auto clk_id = (clockid_t) args.at(0).read_u32(0);
         auto tp_vr = args.at(1).read_pointer_valref_mut(0, sizeof(struct timespec)).to_write();
@@ -806,10 +1076,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             tp_vr.mark_bytes_valid(0, sizeof(struct timespec));
         LOG_DEBUG("= " << rv_i << " (" << tp_vr << ")");
         rv = Value::new_i32(rv_i);
-    }
+        } break;
     // - Linux extensions
-    else if( link_name == "open64" )
-    {
+    case ExternShim::open64: {
         const auto* path = FfiHelpers::read_cstr(args.at(0), 0);
         auto flags = args.at(1).read_i32(0);
         auto mode = (args.size() > 2 ? args.at(2).read_i32(0) : 0);
@@ -820,9 +1089,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 
         rv = Value(::HIR::TypeRef(RawType::I32));
         rv.write_i32(0, rv_i);
-    }
-    else if( link_name == "stat64" )
-    {
+        } break;
+    case ExternShim::stat64: {
         const auto* path = FfiHelpers::read_cstr(args.at(0), 0);
         auto outbuf_vr = args.at(1).read_pointer_valref_mut(0, sizeof(struct stat)).to_write();
 
@@ -838,60 +1106,53 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 
         rv = Value(::HIR::TypeRef(RawType::I32));
         rv.write_i32(0, rv_i);
-    }
-    else if( link_name == "__errno_location" || /*OSX*/ link_name == "__error" )
-    {
+        } break;
+    case ExternShim::errno_location:
+    case ExternShim::error: {   // OSX
         rv = Value::new_ffiptr(FFIPointer::new_const_bytes("errno", &errno, sizeof(errno)));
-    }
-    else if( link_name == "syscall" )
-    {
+        } break;
+    case ExternShim::syscall: {
         auto num = args.at(0).read_u32(0);
 
         LOG_DEBUG("syscall(" << num << ", ...) - hack return ENOSYS");
         errno = ENOSYS;
         rv = Value::new_i64(-1);
-    }
-    else if( link_name == "dlsym" )
-    {
+        } break;
+    case ExternShim::dlsym: {
         auto handle = args.at(0).read_usize(0);
         const char* name = FfiHelpers::read_cstr(args.at(1), 0);
 
         LOG_DEBUG("dlsym(0x" << ::std::hex << handle << ", '" << name << "')");
         LOG_NOTICE("dlsym stubbed to zero");
         rv = Value::new_usize(0);
-    }
+        } break;
 #endif
     // ----
     // C Standard Library
     // ----
     // 
     // <signal.h>
-    else if( link_name == "signal" )
-    {
+    case ExternShim::signal: {
         LOG_DEBUG("Call `signal` - Ignoring and returning SIG_IGN");
         rv = Value(::HIR::TypeRef(RawType::USize));
         rv.write_usize(0, 1);
-    }
-    else if( link_name == "sigaction" )
-    {
+        } break;
+    case ExternShim::sigaction: {
         rv = Value::new_i32(-1);
-    }
-    else if( link_name == "sigaltstack" )   // POSIX: Set alternate signal stack
-    {
+        } break;
+    case ExternShim::sigaltstack: {   // POSIX: Set alternate signal stack
         rv = Value::new_i32(-1);
-    }
+        } break;
     //
     // <stdlib.h>
     //
-    else if( link_name == "atoi" )
-    {
+    case ExternShim::atoi: {
         // extern int atoi(const char *nptr);
         size_t len = 0;
         const char* nptr = FfiHelpers::read_cstr(args.at(0), 0, &len);
         rv = Value::new_i32( atoi(nptr) );
-    }
-    else if( link_name == "strtoll" )
-    {
+        } break;
+    case ExternShim::strtoll: {
         // long long strtoll(const char *nptr, char **endptr, int base);
         size_t len = 0;
         const char* nptr = FfiHelpers::read_cstr(args.at(0), 0, &len);
@@ -906,9 +1167,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
                 .write_ptr(0, args.at(0).read_usize(0) + ofs, args.at(0).get_relocation(0));
         }
         rv = Value::new_i64(retval);
-    }
-    else if( link_name == "strtol" )
-    {
+        } break;
+    case ExternShim::strtol: {
         // long long strtoll(const char *nptr, char **endptr, int base);
         size_t len = 0;
         const char* nptr = FfiHelpers::read_cstr(args.at(0), 0, &len);
@@ -923,18 +1183,16 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
                 .write_ptr(0, args.at(0).read_usize(0) + ofs, args.at(0).get_relocation(0));
         }
         rv = Value::new_i64(retval);
-    }
-    else if( link_name == "malloc" )
-    {
+        } break;
+    case ExternShim::malloc: {
         auto size = args.at(0).read_usize(0);
 
         auto alloc = Allocation::new_alloc(size, "malloc");
         auto rty = ::HIR::TypeRef(RawType::Unit).wrap( TypeWrapper::Ty::Pointer, 0 );
 
         rv = Value::new_pointer_ofs(rty, 0, RelocationPtr::new_alloc(::std::move(alloc)));
-    }
-    else if( link_name == "calloc" )
-    {
+        } break;
+    case ExternShim::calloc: {
         auto nmemb = args.at(0).read_usize(0);
         auto size = args.at(1).read_usize(0);
 
@@ -944,9 +1202,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         alloc->mark_bytes_valid(0, size * nmemb);
 
         rv = Value::new_pointer_ofs(rty, 0, RelocationPtr::new_alloc(::std::move(alloc)));
-    }
-    else if( link_name == "realloc" )
-    {
+        } break;
+    case ExternShim::realloc: {
         auto size = args.at(1).read_usize(0);
         auto rty = ::HIR::TypeRef(RawType::Unit).wrap( TypeWrapper::Ty::Pointer, 0 );
         auto alloc = Allocation::new_alloc(size, "realloc");
@@ -966,9 +1223,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             old_alloc.mark_as_freed();
         }
         rv = Value::new_pointer_ofs(rty, 0, RelocationPtr::new_alloc(::std::move(alloc)));
-    }
-    else if( link_name == "free" )
-    {
+        } break;
+    case ExternShim::free: {
         // If `ptr` is NULL, no operation is performed
         if( args.at(0).read_usize(0) != 0 )
         {
@@ -983,12 +1239,11 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         }
 
         rv = Value();
-    }
+        } break;
     //
     // <string.h>
     //
-    else if( link_name == "memcmp" )
-    {
+    case ExternShim::memcmp: {
         auto n = args.at(2).read_usize(0);
         int rv_i;
         if( n > 0 )
@@ -1003,9 +1258,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             rv_i = 0;
         }
         rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "memset" )
-    {
+        } break;
+    case ExternShim::memset: {
         auto b = args.at(1).read_u8(0);
         auto n = args.at(2).read_usize(0);
         if( n > 0 )
@@ -1015,9 +1269,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             vr.mark_bytes_valid(0, n);
         }
         rv = std::move(args.at(0));
-    }
-    else if( link_name == "memcpy" )
-    {
+        } break;
+    case ExternShim::memcpy: {
         auto n = args.at(2).read_usize(0);
         if( n > 0 )
         {
@@ -1027,10 +1280,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             vr_dst.write_value(0, vr_src.read_value(0, n));
         }
         rv = std::move(args.at(0));
-    }
+        } break;
     // - `void *memchr(const void *s, int c, size_t n);`
-    else if( link_name == "memchr" )
-    {
+    case ExternShim::memchr: {
         auto ptr_alloc = args.at(0).get_relocation(0);
         auto c = args.at(1).read_i32(0);
         auto n = args.at(2).read_usize(0);
@@ -1048,9 +1300,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         {
             rv.write_usize(0, 0);
         }
-    }
-    else if( link_name == "memrchr" )
-    {
+        } break;
+    case ExternShim::memrchr: {
         auto ptr_alloc = args.at(0).get_relocation(0);
         auto c = args.at(1).read_i32(0);
         auto n = args.at(2).read_usize(0);
@@ -1068,8 +1319,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         {
             rv.write_usize(0, 0);
         }
-    }
-    else if( link_name == "strcpy" ) {
+        } break;
+    case ExternShim::strcpy: {
         // strlen - custom implementation to ensure validity
         size_t len = 0;
         auto src = FfiHelpers::read_cstr(args.at(1), 0, &len);
@@ -1078,9 +1329,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         memcpy(vr.data_ptr_mut(len+1), src, len+1);
         vr.mark_bytes_valid(0, len+1);
         rv = std::move(args.at(0));
-    }
-    else if( link_name == "strlen" )
-    {
+        } break;
+    case ExternShim::strlen: {
         // strlen - custom implementation to ensure validity
         size_t len = 0;
         FfiHelpers::read_cstr(args.at(0), 0, &len);
@@ -1088,9 +1338,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         //rv = Value::new_usize(len);
         rv = Value(::HIR::TypeRef(RawType::USize));
         rv.write_usize(0, len);
-    }
-    else if( link_name == "strcmp" )
-    {
+        } break;
+    case ExternShim::strcmp: {
         size_t len;
         const char* a = FfiHelpers::read_cstr(args.at(0), 0, &len);
         const char* b = FfiHelpers::read_cstr(args.at(1), 0, &len);
@@ -1098,9 +1347,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 
         int rv_i = strcmp(a, b);
         rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "strncmp" )
-    {
+        } break;
+    case ExternShim::strncmp: {
         size_t len;
         const char* a = FfiHelpers::read_cstr(args.at(0), 0, &len);
         const char* b = FfiHelpers::read_cstr(args.at(1), 0, &len);
@@ -1109,9 +1357,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 
         int rv_i = strncmp(a, b, max);
         rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "strdup" )
-    {
+        } break;
+    case ExternShim::strdup: {
         size_t len;
         const char* a = FfiHelpers::read_cstr(args.at(0), 0, &len);
 
@@ -1124,9 +1371,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             memcpy(vr.data_ptr_mut(len+1), a, len+1);
             vr.mark_bytes_valid(0, len+1);
         }
-    }
-    else if( link_name == "strndup" )
-    {
+        } break;
+    case ExternShim::strndup: {
         size_t max = args.at(1).read_usize(0);
         size_t len;
         const char* a = FfiHelpers::read_cstr(args.at(0), 0, &len, max);
@@ -1142,10 +1388,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             p[len] = 0;
             vr.mark_bytes_valid(0, len+1);
         }
-    }
+        } break;
     // --- ?
-    else if( link_name == "getenv" )
-    {
+    case ExternShim::getenv: {
         const auto* name = FfiHelpers::read_cstr(args.at(0), 0);
         LOG_DEBUG("getenv(\"" << name << "\")");
         const auto* ret_ptr = getenv(name);
@@ -1161,19 +1406,16 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             //rv.create_allocation("getenv");
             rv.write_usize(0,0);
         }
-    }
-    else if( link_name == "setenv" )
-    {
+        } break;
+    case ExternShim::setenv: {
         LOG_TODO("Allow `setenv` without incurring thread unsafety");
-    }
-    else if( link_name == "strerror" )
-    {
+        } break;
+    case ExternShim::strerror: {
         auto errnum = args.at(0).read_i32(0);
         auto s = strerror(errnum);
         rv = Value::new_ffiptr(FFIPointer::new_const_bytes("strerror", s, strlen(s)+1));
-    }
-    else if( link_name == "strerror_r" )
-    {
+        } break;
+    case ExternShim::strerror_r: {
         auto errnum = args.at(0).read_i32(0);
         auto len = args.at(2).read_usize(0);
         auto buf = args.at(1).read_pointer_valref_mut(0, len).to_write();
@@ -1195,16 +1437,14 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             // GNU targets only
             rv = std::move(args.at(1));
         }
-    }
-    else if( link_name == "printf" )
-    {
+        } break;
+    case ExternShim::printf: {
         const auto* fmt = FfiHelpers::read_cstr(args.at(0), 0);
         auto out = format_string(fmt, args, 1);
         ::std::cout << out;
         rv = Value::new_i32(static_cast<int32_t>(out.size()));
-    }
-    else if( link_name == "snprintf" )
-    {
+        } break;
+    case ExternShim::snprintf: {
         const auto* fmt = FfiHelpers::read_cstr(args.at(2), 0);
         auto out = format_string(fmt, args, 3);
         LOG_DEBUG("out = " << out);
@@ -1216,9 +1456,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             buf.write_u8( ::std::min(len-1, out.size()), 0 );
         }
         rv = Value::new_i32(static_cast<int32_t>(out.size()));
-    }
-    else if( link_name == "vsnprintf" )
-    {
+        } break;
+    case ExternShim::vsnprintf: {
         const auto* fmt = FfiHelpers::read_cstr(args.at(2), 0);
         const auto& va_args = VaArgsState::get_inner( args.at(3) );
         auto out = format_string(fmt, va_args.args, 0);
@@ -1231,12 +1470,11 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             buf.write_u8( ::std::min(len-1, out.size()), 0 );
         }
         rv = Value::new_i32(static_cast<int32_t>(out.size()));
-    }
+        } break;
     //
     // <stdio.h>
     //
-    else if( link_name == "fopen" )
-    {
+    case ExternShim::fopen: {
         const auto* path = FfiHelpers::read_cstr(args.at(0), 0);
         const auto* mode = FfiHelpers::read_cstr(args.at(1), 0);
         LOG_DEBUG("fopen(\"" << path << "\", \"" << mode << "\")");
@@ -1247,16 +1485,14 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         else {
             rv = Value::new_usize(0);
         }
-    }
-    else if( link_name == "fclose" )
-    {
+        } break;
+    case ExternShim::fclose: {
         FILE* fp = static_cast<FILE*>(args.at(0).read_pointer_tagged_nonnull(0, "FILE"));
         int retval = fclose(fp);
         args.at(0).get_relocation(0).ffi().release();
         rv = Value::new_i32(retval);
-    }
-    else if( link_name == "fseek" )
-    {
+        } break;
+    case ExternShim::fseek: {
         // int fseek(FILE *stream, long offset, int whence);
         FILE* fp = static_cast<FILE*>(args.at(0).read_pointer_tagged_nonnull(0, "FILE"));
         auto offset = args.at(1).read_i64(0);
@@ -1273,15 +1509,13 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         }
 
         rv = Value::new_i32( fseek(fp, static_cast<long>(offset), whence) );
-    }
-    else if( link_name == "ftell" )
-    {
+        } break;
+    case ExternShim::ftell: {
         // long ftell(FILE *stream);
         FILE* fp = static_cast<FILE*>(args.at(0).read_pointer_tagged_nonnull(0, "FILE"));
         rv = Value::new_i64( ftell(fp) );
-    }
-    else if( link_name == "fread")
-    {
+        } break;
+    case ExternShim::fread: {
         // size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
         FILE* fp = static_cast<FILE*>(args.at(3).read_pointer_tagged_nonnull(0, "FILE"));
         auto nmemb = args.at(2).read_usize(0);
@@ -1294,29 +1528,27 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             ptr.mark_bytes_valid(0, retval * size);
         }
         rv = Value::new_i64(retval);
-    }
+        } break;
     // --- setjmp.h
-    else if( link_name == "setjmp" )
-    {
+    case ExternShim::setjmp: {
         rv = Value::new_i32(0);
-    }
-    else if( link_name == "longjmp" )
-    {
+        } break;
+    case ExternShim::longjmp: {
         LOG_TODO("Call `longjmp`");
-    }
+        } break;
     // --- ctype.h
-    else if( link_name == "isspace" ) {
+    case ExternShim::isspace: {
         rv = Value::new_i32( isspace(args.at(0).read_i32(0)) );
-    }
-    else if( link_name == "isalpha" ) {
+        } break;
+    case ExternShim::isalpha: {
         rv = Value::new_i32( isalpha(args.at(0).read_i32(0)) );
-    }
-    else if( link_name == "isalnum" ) {
+        } break;
+    case ExternShim::isalnum: {
         rv = Value::new_i32( isalnum(args.at(0).read_i32(0)) );
-    }
-    else
-    {
+        } break;
+    default:
         LOG_TODO("Call external function " << link_name);
+        break;
     }
     return true;
 }
@@ -30,6 +30,12 @@ struct Function
     struct ExtInfo {
         ::std::string   link_name;
         ::std::string   link_abi;
+
+        // Call target, resolved by `GlobalState` (once, instead of on every call)
+        // - Function with code for the same link name (if any)
+        mutable const Function* impl_fcn = nullptr;
+        // - Index of the built-in shim (see `InterpreterThread::resolve_extern`), zero if there's no shim
+        mutable unsigned    shim_idx = 0;
     } external;
     ::MIR::Function m_mir;
 };
@@ -52,6 +52,55 @@ namespace {
             }
         }
     }
+    /// Check that all bits in `ofs .. ofs+len` are set (whole bytes/words are checked at once)
+    bool all_bits_set(const uint8_t* p, size_t ofs, size_t len)
+    {
+        size_t i = ofs;
+        size_t end = ofs + len;
+        for( ; i < end && i % 8 != 0; i ++)
+        {
+            if( !get_bit(p, i) )
+                return false;
+        }
+        for( ; i + 64 <= end; i += 64 )
+        {
+            uint64_t w;
+            ::std::memcpy(&w, p + i/8, sizeof(w));
+            if( w != ~uint64_t(0) )
+                return false;
+        }
+        for( ; i + 8 <= end; i += 8 )
+        {
+            if( p[i/8] != 0xFF )
+                return false;
+        }
+        for( ; i < end; i ++ )
+        {
+            if( !get_bit(p, i) )
+                return false;
+        }
+        return true;
+    }
+    /// Set all bits in `ofs .. ofs+len`
+    void set_bits(uint8_t* p, size_t ofs, size_t len)
+    {
+        size_t i = ofs;
+        size_t end = ofs + len;
+        for( ; i < end && i % 8 != 0; i ++)
+        {
+            set_bit(p, i, true);
+        }
+        if( i + 8 <= end )
+        {
+            size_t n_bytes = (end - i) / 8;
+            ::std::memset(p + i/8, 0xFF, n_bytes);
+            i += n_bytes * 8;
+        }
+        for( ; i < end; i ++ )
+        {
+            set_bit(p, i, true);
+        }
+    }
 };
 
 ::std::ostream& operator<<(::std::ostream& os, const Allocation* x)
@@ -425,22 +474,16 @@ void Allocation::check_bytes_valid(size_t ofs, size_t size) const
     if( !in_bounds(ofs, size, this->size()) ) {
         LOG_FATAL("Out of range - " << ofs << "+" << size << " > " << this->size());
     }
-    for(size_t i = ofs; i < ofs + size; i++)
+    if( !all_bits_set(this->m_mask.data(), ofs, size) )
     {
-        if( !(this->m_mask[i/8] & (1 << (i%8))) )
-        {
-            LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
-            throw "ERROR";
-        }
+        LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
+        throw "ERROR";
     }
 }
 void Allocation::mark_bytes_valid(size_t ofs, size_t size)
 {
     assert( ofs+size <= this->m_mask.size() * 8 );
-    for(size_t i = ofs; i < ofs + size; i++)
-    {
-        this->m_mask[i/8] |= (1 << (i%8));
-    }
+    set_bits(this->m_mask.data(), ofs, size);
 }
 Value Allocation::read_value(size_t ofs, size_t size) const
 {
@@ -451,26 +494,15 @@ Value Allocation::read_value(size_t ofs, size_t size) const
     LOG_ASSERT( in_bounds(ofs, size, this->size()), "Read out of bounds (" << ofs << "+" << size << " > " << this->size() << ")" );
 
     // Determine if this can become an inline allocation.
-    bool has_reloc = false;
-    for(const auto& r : this->relocations)
-    {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            // NOTE: A relocation at offset zero is allowed
-            if( r.slot_ofs == ofs )
-                continue ;
-            has_reloc = true;
-        }
-    }
+    // NOTE: A relocation at offset zero is allowed
+    auto relocs = this->relocations_in(ofs, size);
+    bool has_reloc = relocs.first != relocs.second && (relocs.first->first != ofs || ::std::next(relocs.first) != relocs.second);
     rv = Value::with_size(size, has_reloc);
     rv.write_bytes(0, this->data_ptr() + ofs, size);
 
-    for(const auto& r : this->relocations)
+    for(auto it = relocs.first; it != relocs.second; ++it)
     {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            rv.set_reloc(r.slot_ofs - ofs, /*r.size*/POINTER_SIZE, r.backing_alloc);
-        }
+        rv.set_reloc(it->first - ofs, /*r.size*/POINTER_SIZE, it->second);
     }
     // Copy the mask bits
     copy_bits(rv.get_mask_mut(), 0, m_mask.data(), ofs, size);
@@ -511,28 +543,20 @@ void Allocation::write_value(size_t ofs, Value v)
         size_t  v_size = src_alloc.size();
         assert(&src_alloc != this); // Shouldn't happen?
 
-        // Take a copy of the source mask
-        auto s_mask = src_alloc.m_mask;
-        // Save relocations first, because `Foo = Foo` is valid?
-        ::std::vector<Relocation>   new_relocs = src_alloc.relocations;
         // - write_bytes removes any relocations in this region.
         write_bytes(ofs, src_alloc.data_ptr(), v_size);
 
-        // Find any relocations that apply and copy those in.
-        // - Any relocations in the source within `v.meta.indirect_meta.offset` .. `v.meta.indirect_meta.offset + v_size`
-        if( !new_relocs.empty() )
+        // Copy the source relocations in (shifted by `ofs`)
+        // - They all land before the first relocation after the written region, so use that as the insert hint.
+        auto hint = this->relocations.lower_bound(ofs + v_size);
+        for(const auto& r : src_alloc.relocations)
         {
-            // 2. Move the new relocations into this allocation
-            for(auto& r : new_relocs)
-            {
-                //LOG_TRACE("Insert " << r.backing_alloc);
-                r.slot_ofs += ofs;
-                this->relocations.push_back( ::std::move(r) );
-            }
+            //LOG_TRACE("Insert " << r.second);
+            this->relocations.emplace_hint(hint, r.first + ofs, r.second);
         }
 
         // Set mask in destination
-        copy_bits(m_mask.data(), ofs,  s_mask.data(), 0,  v_size);
+        copy_bits(m_mask.data(), ofs,  src_alloc.m_mask.data(), 0,  v_size);
     }
     else
     {
@@ -562,19 +586,8 @@ void Allocation::write_bytes(size_t ofs, const void* src, size_t count)
 
 
     // - Remove any relocations already within this region
-    auto& this_relocs = this->relocations;
-    for(auto it = this_relocs.begin(); it != this_relocs.end(); )
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + count)
-        {
-            //LOG_TRACE("Delete " << it->backing_alloc);
-            it = this_relocs.erase(it);
-        }
-        else 
-        {
-            ++it;
-        }
-    }
+    auto relocs = this->relocations_in(ofs, count);
+    this->relocations.erase(relocs.first, relocs.second);
 
     ::std::memcpy(this->data_ptr() + ofs, src, count);
     mark_bytes_valid(ofs, count);
@@ -589,21 +602,12 @@ void Allocation::set_reloc(size_t ofs, size_t len, RelocationPtr reloc)
 {
     LOG_ASSERT(ofs % POINTER_SIZE == 0, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
     LOG_ASSERT(len == POINTER_SIZE, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
-    // Delete any existing relocation at this position
-    for(auto it = this->relocations.begin(); it != this->relocations.end();)
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + len )
-        {
-            // Slot starts in this updated region
-            // - TODO: Split in half?
-            it = this->relocations.erase(it);
-            continue ;
-        }
-        // TODO: What if the slot ends in the new region?
-        // What if the new region is in the middle of the slot
-        ++ it;
-    }
-    this->relocations.push_back(Relocation { ofs, /*len,*/ ::std::move(reloc) });
+    // Delete any existing relocation starting within this slot
+    // - TODO: What if the slot ends in the new region?
+    //   What if the new region is in the middle of the slot
+    auto relocs = this->relocations_in(ofs, len);
+    auto hint = this->relocations.erase(relocs.first, relocs.second);
+    this->relocations.emplace_hint(hint, ofs, /*len,*/ ::std::move(reloc));
 }
 ::std::ostream& operator<<(::std::ostream& os, const Allocation& x)
 {
@@ -628,9 +632,9 @@ void Allocation::set_reloc(size_t ofs, size_t len, RelocationPtr reloc)
     os << " {";
     for(const auto& r : x.relocations)
     {
-        if( /*0 <= r.slot_ofs &&*/ r.slot_ofs < x.size() )
+        if( /*0 <= r.first &&*/ r.first < x.size() )
         {
-            os << " @" << r.slot_ofs << "=" << r.backing_alloc;
+            os << " @" << r.first << "=" << r.second;
         }
     }
     os.flags(flags);
@@ -864,14 +868,17 @@ void Value::write_value(size_t ofs, Value v)
         // - Copy mask
         copy_bits(this->get_mask_mut(), ofs,  v.get_mask(), 0,  v.size());
 
-        // TODO: Faster way of knowing where there are relocations
-        for(size_t i = 0; i < v.size(); i ++)
+        if( v.m_inner.is_alloc )
         {
-            if( auto r = v.get_relocation(i) )
+            for(const auto& r : v.m_inner.alloc.alloc->relocations)
             {
-                this->set_reloc(ofs + i, POINTER_SIZE, r);
+                this->set_reloc(ofs + r.first, POINTER_SIZE, r.second);
             }
         }
+        else if( v.m_inner.direct.reloc_0 )
+        {
+            this->set_reloc(ofs, POINTER_SIZE, v.m_inner.direct.reloc_0);
+        }
     }
 }
 void Value::write_ptr(size_t ofs, size_t ptr_ofs, RelocationPtr reloc)
@@ -930,12 +937,10 @@ extern ::std::ostream& operator<<(::std::ostream& os, const ValueRef& v)
             os.flags(flags);
 
             os << " {";
-            for(const auto& r : alloc.relocations)
+            auto relocs = alloc.relocations_in(v.m_offset, v.m_size);
+            for(auto it = relocs.first; it != relocs.second; ++it)
             {
-                if( v.m_offset <= r.slot_ofs && r.slot_ofs < v.m_offset + v.m_size )
-                {
-                    os << " @" << (r.slot_ofs - v.m_offset) << "=" << r.backing_alloc;
-                }
+                os << " @" << (it->first - v.m_offset) << "=" << it->second;
             }
             os << " }";
             } break;
@@ -991,12 +996,10 @@ extern ::std::ostream& operator<<(::std::ostream& os, const ValueRef& v)
         os.flags(flags);
 
         os << " {";
-        for(const auto& r : alloc.relocations)
+        auto relocs = alloc.relocations_in(v.m_offset, v.m_size);
+        for(auto it = relocs.first; it != relocs.second; ++it)
         {
-            if( v.m_offset <= r.slot_ofs && r.slot_ofs < v.m_offset + v.m_size )
-            {
-                os << " @" << (r.slot_ofs - v.m_offset) << "=" << r.backing_alloc;
-            }
+            os << " @" << (it->first - v.m_offset) << "=" << it->second;
         }
         os << " }";
     }
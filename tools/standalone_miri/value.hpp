@@ -8,6 +8,8 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <memory>
 #include <cstdint>
 #include <cstring>	// memcpy
@@ -207,13 +209,9 @@ private:
         return reinterpret_cast<void*>( reinterpret_cast<uintptr_t>(m_ptr) & ~3 );
     }
 };
-struct Relocation
-{
-    // Offset within parent allocation where this relocation is performed.
-    // TODO: Size?
-    size_t  slot_ofs;
-    RelocationPtr   backing_alloc;
-};
+// Relocations within an allocation, keyed by the offset of the pointer slot they apply to.
+// - Ordered so that range queries (for reads, writes and copies) only touch the affected slots.
+typedef ::std::map<size_t, RelocationPtr>    RelocationMap;
 
 // TODO: Split write and read
 struct ValueCommonRead
@@ -329,7 +327,7 @@ class Allocation:
     ::std::vector<uint64_t> m_data;
 public:
     ::std::vector<uint8_t> m_mask;
-    ::std::vector<Relocation>   relocations;
+    RelocationMap   relocations;
 public:
     virtual ~Allocation() {}
     static AllocationHandle new_alloc(size_t size, ::std::string tag);
@@ -340,17 +338,19 @@ public:
     const ::std::string& tag() const { return m_tag; }
 
     RelocationPtr get_relocation(size_t ofs) const override {
-        for(const auto& r : relocations) {
-            if(r.slot_ofs == ofs)
-                return r.backing_alloc;
-        }
+        auto it = relocations.find(ofs);
+        if( it != relocations.end() )
+            return it->second;
         return RelocationPtr();
     }
+    /// Iterator range over the relocations with slots in `ofs .. ofs+size`
+    ::std::pair<RelocationMap::const_iterator, RelocationMap::const_iterator> relocations_in(size_t ofs, size_t size) const {
+        return ::std::make_pair(relocations.lower_bound(ofs), relocations.lower_bound(ofs + size));
+    }
     void mark_as_freed() {
         is_freed = true;
         relocations.clear();
-        for(auto& v : m_mask)
-            v = 0;
+        ::std::fill(m_mask.begin(), m_mask.end(), 0);
     }
 
     void resize(size_t new_size);
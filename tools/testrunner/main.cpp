@@ -45,6 +45,8 @@ struct Options
 
     const char* exceptions_file = nullptr;
     bool fail_fast = false;
+    /// Extra `-C` options passed to every compiler invocation (e.g. `opt-level=3`)
+    ::std::vector<const char*>  codegen_opts;
 
     int parse(int argc, const char* argv[]);
 
@@ -132,6 +134,12 @@ bool run_compiler(const Options& opts, const ::helpers::path& source_file, const
         args.push_back("-g");
     }
 
+    for(const auto* o : opts.codegen_opts)
+    {
+        args.push_back("-C");
+        args.push_back(o);
+    }
+
     for(const auto& d : opts.lib_dirs)
     {
         args.push_back("-L");
@@ -625,6 +633,13 @@ int Options::parse(int argc, const char* argv[])
                 }
                 this->lib_dirs.push_back( argv[++i] );
                 break;
+            case 'C':
+                if( i+1 == argc ) {
+                    this->usage_short();
+                    return 1;
+                }
+                this->codegen_opts.push_back( argv[++i] );
+                break;
 
             default:
                 this->usage_short();